@@ -1,8 +1,10 @@
 #include <cassert>
+#include <chrono>
 #include <iostream>
 #include <string>
 #include "TGraph.h"
 #include "NP.hh"
+#include "CETable.h"
 
 
 // from IPMTParamSvc.h
@@ -18,6 +20,7 @@ enum PMT_CATEGORY {
 struct PMTAngular
 {
     TGraph *gTT_MCP, *gAmp_MCP, *gCE_Dynode, *gCE_MCP, *gCE_R12860, *gCE_NNVTMCP, *gCE_NNVTMCP_HiQE ; 
+    CETable* ce_table ;     // one curve per pmtcat+1, theta in degrees  
 
     PMTAngular(); 
 
@@ -27,6 +30,8 @@ struct PMTAngular
 
     double get_pmt_ce(const std::string &ce_mode, const std::string &volname, double theta, bool pmt_type, bool qe_type, int &ce_cat) const ;
     double get_pmt_ce(int pmtcat, double theta, int& ce_cat) const ;
+    double get_pmt_ce_table(int pmtcat, double theta) const ;
+    void   check_table() const ;
 
     void   save_scan(const char* dir) const ;
     void   save(TGraph* g, const char* dir, const char* name) const ;
@@ -113,6 +118,12 @@ PMTAngular::PMTAngular()
   double ce_NNVTMCP_HiQE[9] = {1.0, 1.0, 0.9772, 0.9723, 0.9699, 0.9697, 0.9452, 0.9103, 0.734};
   gCE_NNVTMCP_HiQE = new TGraph(9, ce_angle_mcp, ce_NNVTMCP_HiQE);
 
+  ce_table = new CETable(0., 180., 1801) ; 
+  for(int pmtcat=kPMT_Unknown ; pmtcat <= kPMT_NNVT_HighQE ; pmtcat++)
+  {
+      unsigned curve = ce_table->add( [this, pmtcat](double theta){ int ce_cat = 0 ; return get_pmt_ce(pmtcat, theta, ce_cat) ; }, PV[pmtcat+1].c_str() ); 
+      assert( int(curve) == pmtcat + 1 ); 
+  }
 }
 
 
@@ -255,6 +266,58 @@ double PMTAngular::get_pmt_ce(int pmtcat, double theta, int& ce_cat) const
 
 }
 
+/**
+PMTAngular::get_pmt_ce_table
+------------------------------
+
+Same as get_pmt_ce(pmtcat, theta, ce_cat) from the dense table built in the ctor,
+without the string dispatch and TGraph::Eval. 
+
+**/
+
+double PMTAngular::get_pmt_ce_table(int pmtcat, double theta) const 
+{
+    return ce_table->get( pmtcat + 1, theta ); 
+}
+
+/**
+PMTAngular::check_table
+-------------------------
+
+Reports the deviation of the table from TGraph::Eval and the time per lookup of both. 
+
+**/
+
+void PMTAngular::check_table() const 
+{
+    std::cout << ce_table->desc() ; 
+
+    typedef std::chrono::steady_clock Clock ; 
+    unsigned num = 1000000 ; 
+    double sum[2] = {0., 0.} ; 
+    double sec[2] ; 
+    for(int m=0 ; m < 2 ; m++)
+    {
+        Clock::time_point t0 = Clock::now(); 
+        for(unsigned i=0 ; i < num ; i++)
+        {
+            int pmtcat = int(i % 4) ; 
+            double theta = 90.*double(i)/double(num) ; 
+            int ce_cat = 0 ; 
+            sum[m] += m == 0 ? get_pmt_ce(pmtcat, theta, ce_cat) : get_pmt_ce_table(pmtcat, theta) ; 
+        }
+        sec[m] = std::chrono::duration<double>(Clock::now() - t0).count() ; 
+    }
+    std::cout 
+        << "PMTAngular::check_table"
+        << " num " << num 
+        << " get_pmt_ce " << 1e9*sec[0]/double(num) << " ns" 
+        << " get_pmt_ce_table " << 1e9*sec[1]/double(num) << " ns" 
+        << " sum_diff " << sum[1] - sum[0] 
+        << std::endl
+        ; 
+}
+
 void PMTAngular::save_scan(const char* dir) const 
 {
     unsigned num_cat = 5 ; 
@@ -313,5 +376,6 @@ int main()
 {
     PMTAngular pa ; 
     pa.save("/tmp/PMTAngular"); 
+    pa.check_table(); 
     return 0 ; 
 }
@@ -34,6 +34,7 @@ mkdir -p /tmp/$name
 gcc $name.cc \
     -std=c++11 \
     -I$HOME/np \
+    -I../SProfileDemo \
     -I$ROOT_PREFIX/include \
     -L$ROOT_PREFIX/lib \
     -lstdc++ \
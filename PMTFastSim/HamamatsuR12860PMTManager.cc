@@ -28,6 +28,7 @@
 #include "HamamatsuR12860PMTManager.hh"
 #include "Hamamatsu_R12860_PMTSolid.hh"
 #include "ZSolid.h"
+#include "SpanTree.h"
 
 using namespace CLHEP;
 
@@ -160,13 +161,19 @@ HamamatsuR12860PMTManager::HamamatsuR12860PMTManager(const G4String& plabel )
     m_cover_mat(nullptr),
     m_simple(getenv("JUNO_PMT20INCH_SIMPLE") == nullptr ? false : true),
     m_profligate_tail_cut(getenv("JUNO_PMT20INCH_PROFLIGATE_TAIL_CUT") == nullptr ? false : true ),
-    m_pmt_equator_to_bottom(0.)
+    m_pmt_equator_to_bottom(0.),
+    m_share_dynode(false),
+    m_dynode_shared(false),
+    m_simplification_level(0),
+    m_make_dynode(true)
 {
     declProp("FastCover", m_fast_cover=false);
     declProp("FastCoverMaterial", m_cover_mat_str="Water");
     declProp("UsePMTOpticalModel", m_enable_optical_model=true); 
     declProp("UseNaturalGeometry", m_natural_geometry=false); 
     declProp("UseRealSurface", m_useRealSurface=true );
+    declProp("ShareDynodeLV", m_share_dynode=false );
+    declProp("SimplificationLevel", m_simplification_level=0 );
 }
 
 std::string HamamatsuR12860PMTManager::desc() const 
@@ -178,6 +185,9 @@ std::string HamamatsuR12860PMTManager::desc() const
          << " m_natural_geometry " << ( m_natural_geometry   ? "Y" : "N" )
          << " m_useRealSurface "    << ( m_useRealSurface ? "Y" : "N" )
          << " m_profligate_tail_cut " << ( m_profligate_tail_cut ? "Y" : "N" )
+         << " m_share_dynode " << ( m_share_dynode ? "Y" : "N" )
+         << " m_dynode_shared " << ( m_dynode_shared ? "Y" : "N" )
+         << " m_simplification_level " << m_simplification_level
          ;
 
     std::string s = ss.str(); 
@@ -197,6 +207,7 @@ HamamatsuR12860PMTManager::~HamamatsuR12860PMTManager() {
 
 // Helper Methods
 void HamamatsuR12860PMTManager::init() {
+    SpanTree::Span span("hama.init") ; 
 #ifdef PMTFASTSIM_STANDALONE
     std::cout << "HamamatsuR12860PMTManager::init" << std::endl ; 
 #else
@@ -208,6 +219,7 @@ void HamamatsuR12860PMTManager::init() {
     if(!expect) exit(EXIT_FAILURE); 
     
 #endif
+    init_simplification();
     init_material();
     init_variables();
     init_mirror_surface();
@@ -219,6 +231,55 @@ void HamamatsuR12860PMTManager::init() {
 }
 
 
+/**
+HamamatsuR12860PMTManager::init_simplification
+------------------------------------------------
+
+Option SimplificationLevel (envvar hama_SimplificationLevel) overrides 
+the other geometry switches to progressively remove volumes, levels are 
+cumulative. As all the switches change the physics implementation 
+as well as the navigation cost the levels must be compared with a benchmark 
+before use in production, see tests/SimplificationLevelTest.cc 
+
+0
+   no change 
+1
+   skip helper_make_dynode_volume, removing the 7 dynode structure volumes 
+2
+   UseNaturalGeometry : single inner vacuum volume instead of inner1/inner2 
+   and no FastSim region, requires the custom boundary process for the photocathode 
+3
+   UsePMTOpticalModel false : traditional photocathode surface on the inner volume 
+
+**/
+
+void HamamatsuR12860PMTManager::init_simplification()
+{
+    bool expect = m_simplification_level >= 0 && m_simplification_level <= 3 ; 
+    if(!expect) std::cerr 
+        << "HamamatsuR12860PMTManager::init_simplification" 
+        << " invalid SimplificationLevel " << m_simplification_level 
+        << " expect 0,1,2,3 " 
+        << std::endl 
+        ;
+    assert(expect); 
+    if(!expect) exit(EXIT_FAILURE); 
+
+    if( m_simplification_level >= 1 ) m_make_dynode = false ; 
+    if( m_simplification_level >= 2 ) m_natural_geometry = true ; 
+    if( m_simplification_level >= 3 ) m_enable_optical_model = false ; 
+
+    if( m_simplification_level > 0 ) std::cout 
+        << "HamamatsuR12860PMTManager::init_simplification"
+        << " level " << m_simplification_level 
+        << " m_make_dynode " << m_make_dynode 
+        << " m_natural_geometry " << m_natural_geometry 
+        << " m_enable_optical_model " << m_enable_optical_model 
+        << std::endl 
+        ;
+}
+
+
 /**
 HamamatsuR12860PMTManager::init_material
 ------------------------------------------
@@ -251,6 +312,7 @@ This corresponds to traditional Detection at photocathode behaviour.
 **/
 
 void HamamatsuR12860PMTManager::init_material() {
+    SpanTree::Span span("hama.init_material") ; 
 
      GlassMat = G4Material::GetMaterial("Pyrex");
      PMT_Vacuum = G4Material::GetMaterial("Vacuum"); 
@@ -280,6 +342,7 @@ void HamamatsuR12860PMTManager::init_material() {
 
 
 void HamamatsuR12860PMTManager::init_variables() {
+    SpanTree::Span span("hama.init_variables") ; 
     m_pmt_r = 254.*mm;
     m_pmt_h = 640.*mm;
     m_z_equator = 190.*mm; // From top to equator
@@ -328,6 +391,7 @@ void HamamatsuR12860PMTManager::init_variables() {
 void
  HamamatsuR12860PMTManager::init_mirror_surface() 
 {
+    SpanTree::Span span("hama.init_mirror_surface") ; 
     if( m_mirror_opsurf != nullptr ) return ;
  
         // construct a static mirror surface with idealized properties
@@ -358,6 +422,7 @@ void
 
 void HamamatsuR12860PMTManager::init_pmt() 
 {
+    SpanTree::Span span("hama.init_pmt") ; 
 
 #ifdef PMTFASTSIM_STANDALONE
   std::cout 
@@ -376,7 +441,7 @@ void HamamatsuR12860PMTManager::init_pmt()
 
 
 
-  if(m_enable_optical_model)
+  if(m_enable_optical_model && m_make_dynode)
   {
       helper_make_dynode_volume();
   }
@@ -457,6 +522,7 @@ m_enable_optical_model:true
 
 void HamamatsuR12860PMTManager::helper_make_solid() 
 {
+    SpanTree::Span span("hama.helper_make_solid") ; 
     double pmt_delta = 1E-3*mm ; 
     double inner_delta =  -5*mm ;  
     double body_delta = m_enable_optical_model == false ? 0. : inner_delta+1E-3*mm ; 
@@ -530,6 +596,7 @@ actually cuts the CSG tree, leading to a significant simplification.
 
 void HamamatsuR12860PMTManager::helper_make_solid_profligate_tail_cut()
 {
+    SpanTree::Span span("hama.helper_make_solid_profligate_tail_cut") ; 
     // inner2 
     std::cout << "HamamatsuR12860PMTManager::helper_make_solid_profligate_tail_cut" << std::endl ; 
 
@@ -711,6 +778,7 @@ void HamamatsuR12860PMTManager::obsolete_inner_cut()
 void
 HamamatsuR12860PMTManager::helper_make_logical_volume()
 {
+    SpanTree::Span span("hama.helper_make_logical_volume") ; 
     if( m_natural_geometry == false )
     {
         pmt_log = new G4LogicalVolume
@@ -777,6 +845,7 @@ HamamatsuR12860PMTManager::helper_make_logical_volume()
 
 void HamamatsuR12860PMTManager::helper_make_physical_volume()
 {
+    SpanTree::Span span("hama.helper_make_physical_volume") ; 
     
     G4ThreeVector equatorTranslation(0.,0.,m_z_equator);
     G4ThreeVector noTranslation(0.,0.,0.);
@@ -825,19 +894,194 @@ void HamamatsuR12860PMTManager::helper_make_physical_volume()
 
 }
 
+std::map<std::string, HamamatsuR12860PMTManager::DynodeLV> HamamatsuR12860PMTManager::SHARED_DYNODE = {} ; 
+
+/**
+HamamatsuR12860PMTManager::dynode_key
+---------------------------------------
+
+The dynode LVs depend only on DynodeMat and the tube height tube_hz, 
+the other dimensions are constants of helper_make_dynode_lv. 
+The tube height follows UseRealSurface and the PMT dimensions, so they 
+are covered by tube_hz. Other manager options do not change the dynode LVs, 
+so they are not part of the key. 
+
+**/
+
+std::string HamamatsuR12860PMTManager::dynode_key( G4double tube_hz ) const 
+{
+    std::stringstream ss ; 
+    ss << ( DynodeMat ? DynodeMat->GetName() : "-" ) 
+       << "_" << std::setprecision(17) << tube_hz 
+       ; 
+    std::string s = ss.str(); 
+    return s ; 
+}
+
+/**
+HamamatsuR12860PMTManager::ClearShared
+----------------------------------------
+
+Forgets the shared dynode LVs, called from PMTFastSim::ClearCache. 
+The objects are not deleted as they remain in the Geant4 stores. 
+
+**/
+
+void HamamatsuR12860PMTManager::ClearShared() // static
+{
+    SHARED_DYNODE.clear(); 
+}
+
 /**
 HamamatsuR12860PMTManager::helper_make_dynode_volume
 ------------------------------------------------------
 
 Creates solids, logical volumes and physical volumes placing them within *inner2_log* 
+(or *inner_log* with natural geometry) and adds the border surfaces. 
+
+With option ShareDynodeLV (envvar hama_ShareDynodeLV=1) the LVs, solids and 
+optical surfaces are shared between manager instances with the same dynode_key, 
+so only the placements and border surfaces are created per instance. 
+The shared LVs keep the names from the first instance. 
+
+Sharing is restricted to instances without a fast simulation region, 
+ie with UseNaturalGeometry (or SimplificationLevel 2). Without natural geometry 
+helper_fast_sim gives body_log a G4Region of its own, which 
+is propagated to the daughter LVs and a LV can only be in one region, 
+so dynode LVs shared between such instances would end up in the region 
+of whichever was scanned last. 
 
 **/
 
 void HamamatsuR12860PMTManager::helper_make_dynode_volume()
 {
+    SpanTree::Span span("hama.helper_make_dynode_volume") ; 
     G4LogicalVolume* parent_log = m_natural_geometry ? inner_log : inner2_log ;  
     G4PVPlacement*   parent_phys = m_natural_geometry ? inner_phys : inner2_phys ;
 
+    G4double plate_hz   = 1.*mm;
+    G4double edge_hz    = 20.*mm;
+    G4double grid_hz    = 1.*mm;
+    G4double tube_hz    = 80.*mm;
+    G4double dist       = 50.*mm;
+    G4double shield_d   = (210.-61.56)*mm;
+
+    /* THE CYLINDRICAL TUBE AT BOTTOM */
+    // Note: The backend of the tube need to be cut when the PMT back is cut
+    //       -- 27th Oct 2021, Tao Lin
+    if (m_useRealSurface) {
+        // the 5mm is the thickness of PMT
+        double new_tube_hz = (m_pmt_h-m_z_equator-5.*mm-(dist+edge_hz*2+plate_hz*2))/2;
+        LogInfo << "Option RealSurface is enabed. Reduce the height of tube_hz from "
+                << tube_hz << " to " << new_tube_hz << std::endl;
+        tube_hz = new_tube_hz; // reduce from 160mm to ~90. so the z will be at ~180mm.
+    }
+
+    DynodeLV d ; 
+    std::string key = dynode_key(tube_hz) ; 
+    bool fast_sim_region = m_enable_optical_model && !m_natural_geometry ;  // see init_pmt
+    bool shareable = m_share_dynode && !fast_sim_region ; 
+    m_dynode_shared = shareable && SHARED_DYNODE.count(key) == 1 ; 
+    if( m_dynode_shared )
+    {
+        d = SHARED_DYNODE[key] ; 
+    }
+    else
+    {
+        helper_make_dynode_lv(d, tube_hz); 
+        if(shareable) SHARED_DYNODE[key] = d ; 
+    }
+
+    G4PVPlacement *plate_phy = new G4PVPlacement
+        ( 0,
+          -G4ThreeVector(0., 0., dist+edge_hz*2+plate_hz),
+          d.plate_log,
+          GetName() + "_plate_phy",
+          parent_log,
+          false,
+          0,
+          false );
+
+    G4PVPlacement *outer_edge_phy = new G4PVPlacement
+        ( 0,
+          -G4ThreeVector(0., 0., dist+edge_hz),
+          d.outer_edge_log,
+          GetName() + "_outer_edge_phy",
+          parent_log,
+          false,
+          0,
+          false );
+
+    G4PVPlacement *inner_edge_phy = new G4PVPlacement
+        ( 0,
+          -G4ThreeVector(0., 0., dist+edge_hz),
+          d.inner_edge_log,
+          GetName() + "_inner_edge_phy",
+          parent_log,
+          false,
+          0,
+          false );
+
+    G4PVPlacement *inner_ring_phy = new G4PVPlacement
+        ( 0,
+          -G4ThreeVector(0., 0., dist+edge_hz),
+          d.inner_ring_log,
+          GetName() + "_inner_ring_phy",
+          parent_log,
+          false,
+          0,
+          false );
+
+    G4PVPlacement *tube_phy = new G4PVPlacement
+        ( 0,
+          -G4ThreeVector(0., 0., dist+edge_hz*2+plate_hz*2+tube_hz),
+          d.tube_log,
+          GetName() + "_dynode_tube_phy",
+          parent_log,
+          false,
+          0,
+          false );
+
+    G4PVPlacement *grid_phy = new G4PVPlacement
+        ( 0,
+          -G4ThreeVector(0., 0., dist+edge_hz*2+grid_hz),
+          d.grid_log,
+          GetName() + "_grid_phy",
+          parent_log,
+          false,
+          0,
+          false );
+
+    G4PVPlacement *shield_phy = new G4PVPlacement
+        ( 0,
+          -G4ThreeVector(0., 0., shield_d+5.*mm),
+          d.shield_log,
+          GetName() + "_shield_phy",
+          parent_log,
+          false,
+          0,
+          false );
+
+    new G4LogicalBorderSurface(GetName()+"_dynode_plate_opsurface", parent_phys, plate_phy, d.plate_opsurf);
+    new G4LogicalBorderSurface(GetName()+"_inner_ring_opsurface", parent_phys, inner_ring_phy, d.plate_opsurf);
+    new G4LogicalBorderSurface(GetName()+"_outer_edge_opsurface", parent_phys, outer_edge_phy, d.edge_opsurf);
+    new G4LogicalBorderSurface(GetName()+"_inner_edge_opsurface", parent_phys, inner_edge_phy, d.edge_opsurf);
+    new G4LogicalBorderSurface(GetName()+"_dynode_tube_opsurface", parent_phys, tube_phy, d.tube_opsurf);
+    new G4LogicalBorderSurface(GetName()+"_grid_opsurface", parent_phys, grid_phy, d.grid_opsurf);
+    new G4LogicalBorderSurface(GetName()+"_shield_opsurface", parent_phys, shield_phy, d.shield_opsurf);
+}
+
+/**
+HamamatsuR12860PMTManager::helper_make_dynode_lv
+--------------------------------------------------
+
+Creates the solids, LVs and optical surfaces of the dynode structure. 
+
+**/
+
+void HamamatsuR12860PMTManager::helper_make_dynode_lv( DynodeLV& d, G4double tube_hz )
+{
+    SpanTree::Span span("hama.helper_make_dynode_lv") ; 
 
     G4double thickness  = 1.*mm;
 
@@ -854,12 +1098,8 @@ void HamamatsuR12860PMTManager::helper_make_dynode_volume()
     G4double grid_hz    = 1.*mm;
 
     G4double tube_r     = 95.*mm;
-    G4double tube_hz    = 80.*mm;
-
-    G4double dist       = 50.*mm;
     
     G4double shield_r   = 150.4*mm;
-    G4double shield_d   = (210.-61.56)*mm;
 
     G4VisAttributes *visAtt;
 
@@ -873,24 +1113,14 @@ void HamamatsuR12860PMTManager::helper_make_dynode_volume()
           0.,
           2.*M_PI );
 
-    G4LogicalVolume *plate_log = new G4LogicalVolume
+    d.plate_log = new G4LogicalVolume
         ( plate_solid,
           DynodeMat,
           GetName() + "_plate_log" );
 
     visAtt = new G4VisAttributes(G4Color::Red());
-    plate_log->SetVisAttributes(visAtt);
+    d.plate_log->SetVisAttributes(visAtt);
 
-    G4PVPlacement *plate_phy = new G4PVPlacement
-        ( 0,
-          -G4ThreeVector(0., 0., dist+edge_hz*2+plate_hz),
-          plate_log,
-          GetName() + "_plate_phy",
-          parent_log,
-          false,
-          0,
-          false );
-    
     // PART II
     G4Tubs *outer_edge_solid = new G4Tubs
         ( GetName() + "_outer_edge_solid",
@@ -900,23 +1130,12 @@ void HamamatsuR12860PMTManager::helper_make_dynode_volume()
           0.,
           2.*M_PI );
 
-    G4LogicalVolume *outer_edge_log = new G4LogicalVolume
+    d.outer_edge_log = new G4LogicalVolume
         ( outer_edge_solid,
           DynodeMat,
           GetName() + "_outer_edge_log" );
     
-    outer_edge_log->SetVisAttributes(visAtt);
-
-    G4PVPlacement *outer_edge_phy = new G4PVPlacement
-        ( 0,
-          -G4ThreeVector(0., 0., dist+edge_hz),
-          outer_edge_log,
-          GetName() + "_outer_edge_phy",
-          parent_log,
-          false,
-          0,
-          false );
-
+    d.outer_edge_log->SetVisAttributes(visAtt);
 
     // PART III
     G4Tubs *inner_edge_solid = new G4Tubs
@@ -927,22 +1146,12 @@ void HamamatsuR12860PMTManager::helper_make_dynode_volume()
           0.,
           2.*M_PI );
 
-    G4LogicalVolume *inner_edge_log = new G4LogicalVolume
+    d.inner_edge_log = new G4LogicalVolume
         ( inner_edge_solid,
           DynodeMat,
           GetName() + "_inner_edge_log" );
 
-    inner_edge_log->SetVisAttributes(visAtt);
-
-    G4PVPlacement *inner_edge_phy = new G4PVPlacement
-        ( 0,
-          -G4ThreeVector(0., 0., dist+edge_hz),
-          inner_edge_log,
-          GetName() + "_inner_edge_phy",
-          parent_log,
-          false,
-          0,
-          false );
+    d.inner_edge_log->SetVisAttributes(visAtt);
 
     // PART IV
     G4Tubs *inner_ring_solid = new G4Tubs
@@ -953,35 +1162,14 @@ void HamamatsuR12860PMTManager::helper_make_dynode_volume()
           0.,
           2.*M_PI );
 
-    G4LogicalVolume *inner_ring_log = new G4LogicalVolume
+    d.inner_ring_log = new G4LogicalVolume
         ( inner_ring_solid,
           DynodeMat,
           GetName() + "_inner_ring_log" );
 
-    inner_ring_log->SetVisAttributes(visAtt);
-
-    G4PVPlacement *inner_ring_phy = new G4PVPlacement
-        ( 0,
-          -G4ThreeVector(0., 0., dist+edge_hz),
-          inner_ring_log,
-          GetName() + "_inner_ring_phy",
-          parent_log,
-          false,
-          0,
-          false );
+    d.inner_ring_log->SetVisAttributes(visAtt);
 
     /* THE CYLINDRICAL TUBE AT BOTTOM */
-    // Note: The backend of the tube need to be cut when the PMT back is cut
-    //       -- 27th Oct 2021, Tao Lin
-    if (m_useRealSurface) {
-        // the 5mm is the thickness of PMT
-        double new_tube_hz = (m_pmt_h-m_z_equator-5.*mm-(dist+edge_hz*2+plate_hz*2))/2;
-        LogInfo << "Option RealSurface is enabed. Reduce the height of tube_hz from "
-                << tube_hz << " to " << new_tube_hz << std::endl;
-        tube_hz = new_tube_hz; // reduce from 160mm to ~90. so the z will be at ~180mm.
-    }
-
-
     G4Tubs *tube_solid = new G4Tubs
         ( GetName() + "_dynode_tube_solid",
           tube_r - thickness,
@@ -990,23 +1178,13 @@ void HamamatsuR12860PMTManager::helper_make_dynode_volume()
           0.,
           2.*M_PI );
 
-    G4LogicalVolume *tube_log = new G4LogicalVolume
+    d.tube_log = new G4LogicalVolume
         ( tube_solid,
           DynodeMat,
           GetName() + "_dynode_tube_log" );
     
     visAtt = new G4VisAttributes(G4Color::Yellow());
-    tube_log->SetVisAttributes(visAtt);
-
-    G4PVPlacement *tube_phy = new G4PVPlacement
-        ( 0,
-          -G4ThreeVector(0., 0., dist+edge_hz*2+plate_hz*2+tube_hz),
-          tube_log,
-          GetName() + "_dynode_tube_phy",
-          parent_log,
-          false,
-          0,
-          false );
+    d.tube_log->SetVisAttributes(visAtt);
 
     // GRID
     G4Tubs *grid_solid = new G4Tubs
@@ -1017,23 +1195,13 @@ void HamamatsuR12860PMTManager::helper_make_dynode_volume()
           0.,
           2.*M_PI );
     
-    G4LogicalVolume *grid_log = new G4LogicalVolume
+    d.grid_log = new G4LogicalVolume
         ( grid_solid,
           DynodeMat,
           GetName() + "_grid_log" );
     
     visAtt = new G4VisAttributes(G4Color::Green());
-    grid_log->SetVisAttributes(visAtt);
-
-    G4PVPlacement *grid_phy = new G4PVPlacement
-        ( 0,
-          -G4ThreeVector(0., 0., dist+edge_hz*2+grid_hz),
-          grid_log,
-          GetName() + "_grid_phy",
-          parent_log,
-          false,
-          0,
-          false );
+    d.grid_log->SetVisAttributes(visAtt);
 
     // SHIELD
     G4Tubs *shield_solid = new G4Tubs
@@ -1044,23 +1212,13 @@ void HamamatsuR12860PMTManager::helper_make_dynode_volume()
           0.,
           2.*M_PI);
 
-    G4LogicalVolume *shield_log = new G4LogicalVolume
+    d.shield_log = new G4LogicalVolume
         ( shield_solid,
           DynodeMat,
           GetName() + "_shield_log" );
     
     visAtt = new G4VisAttributes(G4Color::Blue());
-    shield_log->SetVisAttributes(visAtt);
-
-    G4PVPlacement *shield_phy = new G4PVPlacement
-        ( 0,
-          -G4ThreeVector(0., 0., shield_d+5.*mm),
-          shield_log,
-          GetName() + "_shield_phy",
-          parent_log,
-          false,
-          0,
-          false );
+    d.shield_log->SetVisAttributes(visAtt);
 
     /* OPTICAL SURFACE */
     // PLATE SURFACE
@@ -1074,9 +1232,7 @@ void HamamatsuR12860PMTManager::helper_make_dynode_volume()
     plateOpSurface->SetModel(glisur);
     plateOpSurface->SetPolish(0.999);
     plateOpSurface->SetMaterialPropertiesTable(plateSurfaceMPT);
-
-    new G4LogicalBorderSurface(GetName()+"_dynode_plate_opsurface", parent_phys, plate_phy, plateOpSurface);
-    new G4LogicalBorderSurface(GetName()+"_inner_ring_opsurface", parent_phys, inner_ring_phy, plateOpSurface);
+    d.plate_opsurf = plateOpSurface ; 
 
     // EDGE SURFACE
     G4MaterialPropertiesTable *edgeSurfaceMPT = new G4MaterialPropertiesTable();
@@ -1089,9 +1245,7 @@ void HamamatsuR12860PMTManager::helper_make_dynode_volume()
     edgeOpSurface->SetModel(glisur);
     edgeOpSurface->SetPolish(0.999);
     edgeOpSurface->SetMaterialPropertiesTable(edgeSurfaceMPT);
-
-    new G4LogicalBorderSurface(GetName()+"_outer_edge_opsurface", parent_phys, outer_edge_phy, edgeOpSurface);
-    new G4LogicalBorderSurface(GetName()+"_inner_edge_opsurface", parent_phys, inner_edge_phy, edgeOpSurface);
+    d.edge_opsurf = edgeOpSurface ; 
 
     // CYLINDRICAL TUBE SURFACE
     G4MaterialPropertiesTable *tubeSurfaceMPT = new G4MaterialPropertiesTable();
@@ -1104,8 +1258,7 @@ void HamamatsuR12860PMTManager::helper_make_dynode_volume()
     tubeOpSurface->SetModel(glisur);
     tubeOpSurface->SetPolish(0.999);
     tubeOpSurface->SetMaterialPropertiesTable(tubeSurfaceMPT);
-
-    new G4LogicalBorderSurface(GetName()+"_dynode_tube_opsurface", parent_phys, tube_phy, tubeOpSurface);
+    d.tube_opsurf = tubeOpSurface ; 
 
     // GRID SURFACE
     G4MaterialPropertiesTable *gridSurfaceMPT = new G4MaterialPropertiesTable();
@@ -1118,8 +1271,7 @@ void HamamatsuR12860PMTManager::helper_make_dynode_volume()
     gridOpSurface->SetModel(glisur);
     gridOpSurface->SetPolish(0.999);
     gridOpSurface->SetMaterialPropertiesTable(gridSurfaceMPT);
-
-    new G4LogicalBorderSurface(GetName()+"_grid_opsurface", parent_phys, grid_phy, gridOpSurface);
+    d.grid_opsurf = gridOpSurface ; 
 
     // SHIELD SURFACE
     G4MaterialPropertiesTable *shieldSurfaceMPT = new G4MaterialPropertiesTable();
@@ -1132,8 +1284,7 @@ void HamamatsuR12860PMTManager::helper_make_dynode_volume()
     shieldOpSurface->SetModel(glisur);
     shieldOpSurface->SetPolish(0.999);
     shieldOpSurface->SetMaterialPropertiesTable(shieldSurfaceMPT);
-    
-    new G4LogicalBorderSurface(GetName()+"_shield_opsurface", parent_phys, shield_phy, shieldOpSurface);
+    d.shield_opsurf = shieldOpSurface ; 
 }
 
 
@@ -1203,6 +1354,7 @@ A: NO, because body volume is handled by FastSim when ModelTrigger:true
 
 void HamamatsuR12860PMTManager::helper_make_optical_surface()
 {
+    SpanTree::Span span("hama.helper_make_optical_surface") ; 
     if(m_natural_geometry == false)
     {
         new G4LogicalBorderSurface(GetName()+"_photocathode_logsurf1", inner1_phys, body_phys, Photocathode_opsurf); 
@@ -1299,6 +1451,7 @@ HamamatsuR12860PMTManager::helper_vis_attr()
 
 void
 HamamatsuR12860PMTManager::init_fast_cover() {
+    SpanTree::Span span("hama.init_fast_cover") ; 
     // solid
     double thickness = 1E-3*mm;
     G4double zPlane[] = {
@@ -18,6 +18,8 @@ HamamatsuR12860PMTManager.hh
 #include "IPMTSimParamSvc/IPMTSimParamSvc.h"
 #endif
 
+#include <map>
+#include <string>
 #include "globals.hh"
 #include "G4ThreeVector.hh"
 
@@ -62,6 +64,7 @@ public:
     G4String GetName() { return m_label;}
 private:
     void init();
+    void init_simplification();
     void init_material();
     void init_variables();
     char GetMirrorOpticalSurfacePrefix() const ; 
@@ -121,6 +124,34 @@ private:
     IPMTParamSvc* m_pmt_param_svc;
     IPMTSimParamSvc* m_pmt_sim_param_svc;
 #endif
+    /**
+    DynodeLV
+        internal dynode structure LVs and their optical surfaces, 
+        which only depend on DynodeMat and tube_hz, so they can be shared 
+        between manager instances without a fast simulation region, 
+        see ShareDynodeLV option and dynode_key
+    **/
+    struct DynodeLV
+    {
+        G4LogicalVolume* plate_log ; 
+        G4LogicalVolume* outer_edge_log ; 
+        G4LogicalVolume* inner_edge_log ; 
+        G4LogicalVolume* inner_ring_log ; 
+        G4LogicalVolume* tube_log ; 
+        G4LogicalVolume* grid_log ; 
+        G4LogicalVolume* shield_log ; 
+        G4OpticalSurface* plate_opsurf ; 
+        G4OpticalSurface* edge_opsurf ; 
+        G4OpticalSurface* tube_opsurf ; 
+        G4OpticalSurface* grid_opsurf ; 
+        G4OpticalSurface* shield_opsurf ; 
+    };
+    static std::map<std::string, DynodeLV> SHARED_DYNODE ; 
+public:
+    static void ClearShared(); 
+private:
+    std::string dynode_key( G4double tube_hz ) const ; 
+    void helper_make_dynode_lv( DynodeLV& d, G4double tube_hz ); 
     void helper_make_dynode_volume();
     void helper_make_optical_surface();
     void helper_fast_sim();
@@ -169,6 +200,18 @@ private:
     bool m_useRealSurface;
     bool m_profligate_tail_cut ; 
     G4double m_pmt_equator_to_bottom ; 
+    bool m_share_dynode ; 
+    bool m_dynode_shared ;   // true when this instance reused the LVs of another 
+
+    /**
+    SimplificationLevel
+        0 : geometry as configured by the other options
+        1 : no dynode structure volumes within the inner vacuum 
+        2 : also natural geometry : single inner vacuum without the FastSim region
+        3 : also no PMT optical model : traditional photocathode surface 
+    **/
+    int  m_simplification_level ; 
+    bool m_make_dynode ; 
 
 };
 
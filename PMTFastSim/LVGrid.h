@@ -0,0 +1,426 @@
+#pragma once
+/**
+LVGrid : many copies of an LV for navigation and fast simulation stress tests
+================================================================================
+
+Places copies of an LV within a vacuum world box sized from the extent of the LV,
+using one of three modes:
+
+PLACEMENT
+    one G4PVPlacement per copy, all copies sharing one name
+
+PARAMETERISED
+    single G4PVParameterised with LVGridParameterisation supplying the copy transforms
+
+REPLICA
+    three nested G4PVReplica along X, Y, Z slicing a container box into cells,
+    with the LV placed once at the center of the cell LV : only for GRID layout
+
+and one of two layouts:
+
+GRID
+    (2*nx+1)*(2*ny+1)*(2*nz+1) copies on a cubic lattice with pitch
+    from the largest dimension of the LV bounding box plus a gap,
+    the copies are offset so their bounding box centers are at the lattice points
+
+SPHERE
+    *num* copies on a Fibonacci lattice over a sphere shell with the local +Z
+    axis of each copy pointing at the center, like the PMTs of the JUNO ball.
+    When not specified the radius is chosen to make the mean lattice spacing 
+    20% more than the pitch. For example 17612 copies at radius 19434 mm
+    approximates the LPMT arrangement.
+
+Configuration from envvars (used by PMTSim::WrapLVGrid, PMTFastSim::WrapLVGrid)::
+
+    export LVGrid_MODE=placement       # placement/parameterised/replica
+    export LVGrid_LAYOUT=grid          # grid/sphere
+    export LVGrid_NUM=17612            # sphere copies
+    export LVGrid_RADIUS=19434         # sphere radius, 0 : auto
+    export LVGrid_GAP=10               # added to the LV extent for the pitch
+
+Usage::
+
+    LVGrid grid(lv, 10, 10, 10) ;
+    grid.mode = LVGrid::REPLICA ;
+    G4VPhysicalVolume* world_pv = grid.build() ;
+    std::cout << grid.desc() ;
+
+NB PMTSim/LVGrid.h and PMTFastSim/LVGrid.h are the same, keep them in sync.
+
+**/
+
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+
+#include "G4ThreeVector.hh"
+#include "G4RotationMatrix.hh"
+#include "G4Transform3D.hh"
+#include "G4VSolid.hh"
+#include "G4Box.hh"
+#include "G4Material.hh"
+#include "G4LogicalVolume.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4PVPlacement.hh"
+#include "G4PVParameterised.hh"
+#include "G4PVReplica.hh"
+#include "G4VPVParameterisation.hh"
+#include "G4PhysicalVolumeStore.hh"
+
+struct LVGrid
+{
+    enum { PLACEMENT, PARAMETERISED, REPLICA } ;
+    enum { GRID, SPHERE } ;
+
+    static const char* ModeName( int mode );
+    static int         Mode( const char* name );
+    static const char* LayoutName( int layout );
+    static int         Layout( const char* name );
+    static double      EnvDouble( const char* key, double fallback );
+    static LVGrid*     FromEnv( G4LogicalVolume* lv, int nx, int ny, int nz );
+
+    G4LogicalVolume* lv ;
+    int              mode ;
+    int              layout ;
+    int              nx, ny, nz ;
+    int              num ;        // SPHERE copies
+    double           radius ;     // SPHERE radius, 0 : auto
+    double           gap ;
+
+    G4ThreeVector    mn, mx ;     // LV bounding box
+    G4ThreeVector    center ;     // LV bounding box center
+    double           pitch ;
+    std::vector<G4ThreeVector>    pos ;  // SPHERE positions
+    std::vector<G4RotationMatrix> frot ; // SPHERE frame rotations (inverse of object rotations) as G4PVPlacement/SetRotation use
+
+    G4LogicalVolume*   world_lv ;
+    G4VPhysicalVolume* world_pv ;
+    size_t             num_pv_before ;
+    size_t             num_pv_after ;
+
+    LVGrid( G4LogicalVolume* lv, int nx, int ny, int nz, int mode=PLACEMENT, double gap=10. );
+    void setSphere( int num, double radius=0. );
+
+    int           num_copies() const ;
+    G4ThreeVector position( int copyNo ) const ;
+    G4RotationMatrix* frame_rotation( int copyNo ) const ;
+    double        halfside() const ;
+
+    G4Material*        vacuum() const ;
+    G4VPhysicalVolume* build();
+    void               build_placement();
+    void               build_parameterised();
+    void               build_replica();
+
+    std::string desc() const ;
+};
+
+/**
+LVGridParameterisation
+------------------------
+
+Supplies copy transforms from the LVGrid, the dimensions are not changed.
+Owns a copy of the LVGrid taken at build, so the LVGrid used to build 
+the geometry can be deleted once built.  
+
+**/
+
+struct LVGridParameterisation : public G4VPVParameterisation
+{
+    std::unique_ptr<const LVGrid> grid ;
+    LVGridParameterisation( const LVGrid& grid_ ) : grid(new LVGrid(grid_)) {}
+
+    void ComputeTransformation( const G4int copyNo, G4VPhysicalVolume* pv ) const override
+    {
+        pv->SetTranslation( grid->position(copyNo) );
+        pv->SetRotation( grid->frame_rotation(copyNo) );
+    }
+};
+
+
+inline const char* LVGrid::ModeName( int mode ) // static
+{
+    const char* s = nullptr ;
+    switch(mode)
+    {
+        case PLACEMENT:     s = "placement"     ; break ;
+        case PARAMETERISED: s = "parameterised" ; break ;
+        case REPLICA:       s = "replica"       ; break ;
+    }
+    return s ;
+}
+
+inline int LVGrid::Mode( const char* name ) // static
+{
+    int mode = PLACEMENT ;
+    if( name && strcmp(name, "parameterised") == 0 ) mode = PARAMETERISED ;
+    if( name && strcmp(name, "replica") == 0 )       mode = REPLICA ;
+    return mode ;
+}
+
+inline const char* LVGrid::LayoutName( int layout ) // static
+{
+    return layout == SPHERE ? "sphere" : "grid" ;
+}
+
+inline int LVGrid::Layout( const char* name ) // static
+{
+    return name && strcmp(name, "sphere") == 0 ? SPHERE : GRID ;
+}
+
+inline double LVGrid::EnvDouble( const char* key, double fallback ) // static
+{
+    const char* v = getenv(key);
+    return v ? strtod(v, nullptr) : fallback ;
+}
+
+inline LVGrid* LVGrid::FromEnv( G4LogicalVolume* lv, int nx, int ny, int nz ) // static
+{
+    int mode = Mode(getenv("LVGrid_MODE")) ;
+    double gap = EnvDouble("LVGrid_GAP", 10.) ;
+    LVGrid* grid = new LVGrid(lv, nx, ny, nz, mode, gap );
+    if( Layout(getenv("LVGrid_LAYOUT")) == SPHERE )
+    {
+        grid->setSphere( int(EnvDouble("LVGrid_NUM", 17612.)), EnvDouble("LVGrid_RADIUS", 0.) );
+    }
+    return grid ;
+}
+
+inline LVGrid::LVGrid( G4LogicalVolume* lv_, int nx_, int ny_, int nz_, int mode_, double gap_ )
+    :
+    lv(lv_),
+    mode(mode_),
+    layout(GRID),
+    nx(nx_),
+    ny(ny_),
+    nz(nz_),
+    num(0),
+    radius(0.),
+    gap(gap_),
+    pitch(0.),
+    world_lv(nullptr),
+    world_pv(nullptr),
+    num_pv_before(0),
+    num_pv_after(0)
+{
+    lv->GetSolid()->BoundingLimits(mn, mx);
+    G4ThreeVector ext = mx - mn ;
+    center = 0.5*(mn + mx) ;
+    pitch = std::max( std::max( ext.x(), ext.y() ), ext.z() ) + gap ;
+}
+
+/**
+LVGrid::setSphere
+-------------------
+
+Fibonacci lattice of *num* points, the mean spacing of which is
+sqrt(4 pi R^2/num). The auto radius makes that spacing 20% more than the pitch.
+The bounding box corner (not the origin) of the LV is used for the
+radial extent so the copies stay within the world box.
+
+**/
+
+inline void LVGrid::setSphere( int num_, double radius_ )
+{
+    layout = SPHERE ;
+    num = num_ ;
+    radius = radius_ > 0. ? radius_ : 1.2*pitch*std::sqrt( double(num)/(4.*M_PI) ) ;
+
+    pos.resize(num);
+    frot.resize(num);
+
+    double golden = M_PI*(3. - std::sqrt(5.)) ;
+    for(int i=0 ; i < num ; i++)
+    {
+        double z = 1. - 2.*(double(i) + 0.5)/double(num) ;
+        double r = std::sqrt( std::max(0., 1. - z*z) ) ;
+        double phi = golden*double(i) ;
+        G4ThreeVector dir( r*std::cos(phi), r*std::sin(phi), z );
+
+        pos[i] = radius*dir ;
+
+        G4ThreeVector inward = -dir ;   // local +Z points to center
+        G4RotationMatrix rot ;
+        rot.rotateY( std::acos(inward.z()) );
+        rot.rotateZ( std::atan2(inward.y(), inward.x()) );
+        frot[i] = rot.inverse() ;
+    }
+}
+
+inline int LVGrid::num_copies() const
+{
+    return layout == SPHERE ? num : (2*nx+1)*(2*ny+1)*(2*nz+1) ;
+}
+
+/**
+LVGrid::position
+------------------
+
+GRID copies are numbered with iz fastest::
+
+    copyNo = ((ix+nx)*(2*ny+1) + (iy+ny))*(2*nz+1) + (iz+nz)
+
+The REPLICA mode cells are numbered in the same way by the nested replica copy numbers.
+
+**/
+
+inline G4ThreeVector LVGrid::position( int copyNo ) const
+{
+    if( layout == SPHERE ) return pos[copyNo] ;
+
+    int NY = 2*ny+1 ;
+    int NZ = 2*nz+1 ;
+    int ix = copyNo/(NY*NZ) - nx ;
+    int iy = (copyNo/NZ) % NY - ny ;
+    int iz = copyNo % NZ - nz ;
+    return G4ThreeVector( pitch*double(ix), pitch*double(iy), pitch*double(iz) ) - center ;
+}
+
+inline G4RotationMatrix* LVGrid::frame_rotation( int copyNo ) const
+{
+    return layout == SPHERE ? const_cast<G4RotationMatrix*>(&frot[copyNo]) : nullptr ;
+}
+
+inline double LVGrid::halfside() const
+{
+    double lv_radius = std::max( mn.mag(), mx.mag() ) ;
+    double hs = 0. ;
+    if( layout == SPHERE )
+    {
+        hs = radius + lv_radius + gap ;
+    }
+    else
+    {
+        int n = std::max( std::max(nx, ny), nz ) ;
+        hs = pitch*(double(n) + 0.5) + gap ;
+    }
+    return hs ;
+}
+
+inline G4Material* LVGrid::vacuum() const
+{
+    G4Material* mat = G4Material::GetMaterial("Vacuum", false);
+    return mat ? mat : lv->GetMaterial() ;
+}
+
+/**
+LVGrid::build
+---------------
+
+Returns the world PV. The count of G4PhysicalVolumeStore entries created
+is recorded to allow memory comparisons between the modes.
+
+**/
+
+inline G4VPhysicalVolume* LVGrid::build()
+{
+    bool expect = !( mode == REPLICA && layout == SPHERE ) ;
+    if(!expect) std::cout << "LVGrid::build REPLICA mode requires GRID layout " << std::endl ;
+    assert(expect);
+    if(!expect) return nullptr ;
+
+    num_pv_before = G4PhysicalVolumeStore::GetInstance()->size() ;
+
+    double hs = halfside() ;
+    G4Box* world_so = new G4Box("World_so", hs, hs, hs );
+    world_lv = new G4LogicalVolume(world_so, vacuum(), "World_lv", 0,0,0);
+    world_pv = new G4PVPlacement(0, G4ThreeVector(), world_lv, "World_pv", 0, false, 0);
+
+    switch(mode)
+    {
+        case PLACEMENT:     build_placement()     ; break ;
+        case PARAMETERISED: build_parameterised() ; break ;
+        case REPLICA:       build_replica()       ; break ;
+    }
+
+    num_pv_after = G4PhysicalVolumeStore::GetInstance()->size() ;
+    return world_pv ;
+}
+
+inline void LVGrid::build_placement()
+{
+    G4String name = lv->GetName() + "_item" ;
+    int n = num_copies() ;
+    for(int i=0 ; i < n ; i++)
+    {
+        G4RotationMatrix* frame = frame_rotation(i) ;
+        G4RotationMatrix* rot = frame ? new G4RotationMatrix(*frame) : nullptr ;  // G4PVPlacement does not copy
+        G4VPhysicalVolume* pv_i = new G4PVPlacement(rot, position(i), lv, name, world_lv, false, i );
+        assert( pv_i );
+    }
+}
+
+inline void LVGrid::build_parameterised()
+{
+    G4String name = lv->GetName() + "_param" ;
+    G4VPVParameterisation* param = new LVGridParameterisation(*this) ;
+    G4VPhysicalVolume* pv = new G4PVParameterised(name, lv, world_lv, kUndefined, num_copies(), param );
+    assert(pv);
+}
+
+/**
+LVGrid::build_replica
+-----------------------
+
+Container box exactly filled by the replicas::
+
+    container_lv
+        slab_lv   : G4PVReplica along kXAxis (2*nx+1)
+            column_lv : G4PVReplica along kYAxis (2*ny+1)
+                cell_lv  : G4PVReplica along kZAxis (2*nz+1)
+                    lv   : single G4PVPlacement with bounding box at cell center
+
+**/
+
+inline void LVGrid::build_replica()
+{
+    G4Material* mat = vacuum() ;
+    G4String name = lv->GetName() ;
+    int NX = 2*nx+1 ;
+    int NY = 2*ny+1 ;
+    int NZ = 2*nz+1 ;
+    double h = 0.5*pitch ;
+
+    G4Box* container_so = new G4Box(name+"_container_so", h*NX, h*NY, h*NZ );
+    G4Box* slab_so      = new G4Box(name+"_slab_so",      h,    h*NY, h*NZ );
+    G4Box* column_so    = new G4Box(name+"_column_so",    h,    h,    h*NZ );
+    G4Box* cell_so      = new G4Box(name+"_cell_so",      h,    h,    h    );
+
+    G4LogicalVolume* container_lv = new G4LogicalVolume(container_so, mat, name+"_container_lv", 0,0,0 );
+    G4LogicalVolume* slab_lv      = new G4LogicalVolume(slab_so,      mat, name+"_slab_lv",      0,0,0 );
+    G4LogicalVolume* column_lv    = new G4LogicalVolume(column_so,    mat, name+"_column_lv",    0,0,0 );
+    G4LogicalVolume* cell_lv      = new G4LogicalVolume(cell_so,      mat, name+"_cell_lv",      0,0,0 );
+
+    new G4PVPlacement(0, G4ThreeVector(), container_lv, name+"_container_pv", world_lv, false, 0 );
+    new G4PVReplica(name+"_slab_pv",   slab_lv,   container_lv, kXAxis, NX, pitch );
+    new G4PVReplica(name+"_column_pv", column_lv, slab_lv,      kYAxis, NY, pitch );
+    new G4PVReplica(name+"_cell_pv",   cell_lv,   column_lv,    kZAxis, NZ, pitch );
+    new G4PVPlacement(0, -center, lv, name+"_item", cell_lv, false, 0 );
+}
+
+inline std::string LVGrid::desc() const
+{
+    std::stringstream ss ;
+    ss << "LVGrid::desc"
+       << " lv " << lv->GetName()
+       << " mode " << ModeName(mode)
+       << " layout " << LayoutName(layout)
+       << " num_copies " << num_copies()
+       << " pitch " << std::fixed << std::setprecision(3) << pitch
+       << " halfside " << std::fixed << std::setprecision(3) << halfside()
+       ;
+    if( layout == SPHERE ) ss << " radius " << std::fixed << std::setprecision(3) << radius ;
+    else ss << " nx " << nx << " ny " << ny << " nz " << nz ;
+    ss << " num_pv_created " << ( num_pv_after - num_pv_before ) ;
+    std::string s = ss.str();
+    return s ;
+}
+
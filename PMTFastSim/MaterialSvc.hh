@@ -36,11 +36,36 @@ The advantages are:
 +-------------------+-------------------------+-----------------+
 
 
+Property archive
+------------------
+
+Parsing the text property tables and growing each G4MaterialPropertyVector 
+one InsertValues at a time is repeated for every property at every job start. 
+With envvar MaterialSvc_ARCHIVE pointing to a directory this is done once:
+
+1. when $MaterialSvc_ARCHIVE/MaterialSvc.npy does not exist the double,double 
+   properties read from text are recorded and DetectorConstruction 
+   saves them with SaveArchive at the end of DefineMaterials 
+
+2. subsequently the archive is loaded once and the properties 
+   are served from it with the MPV constructed in bulk by ArchiveMPV
+
+The archive is a single (num_row, 2) double array with the property 
+names in the NP names member. Each property is a header row (num, index) 
+followed by *num* rows of (energy, value) with units applied,
+in the order of the text file.
+The metadata "digest" is SourceDigest of the text files of the recorded 
+properties, an archive with a different digest is ignored and recreated 
+so editing a table or changing JUNOTOP does not serve stale values. 
+
 **/
 
 class G4MaterialPropertiesTable ; 
+struct NP ; 
 #include "G4MaterialPropertyVector.hh" // typedef
 #include <string>
+#include <map>
+#include <vector>
 #include "IMCParamsSvc.hh"
 
 #include "PMTFASTSIM_API_EXPORT.hh"
@@ -54,4 +79,24 @@ struct PMTFASTSIM_API MaterialSvc : public IMCParamsSvc
     static G4MaterialPropertyVector* GetMPV(const char* path, bool dump=false); 
     static void AddProperty(G4MaterialPropertiesTable* MPT, const char* propName, const char* propPath); 
 
+    static constexpr const char* ARCHIVE_KEY = "MaterialSvc_ARCHIVE" ; 
+    static constexpr const char* ARCHIVE_NAME = "MaterialSvc.npy" ; 
+    static int                   ARCHIVE_STATE ;   // -1: unchecked, 0: recording, 1: loaded  
+    static NP*                   ARCHIVE ; 
+    static std::map<std::string, std::pair<int,int>> INDEX ;   // name -> (first data row, num rows)
+    static std::vector<std::string> RECORD_NAMES ; 
+    static std::vector<double>      RECORD_ROWS ; 
+
+    static bool GetProps(const std::string& param, vec_d2d& props); 
+    static bool LoadArchive(); 
+    static bool IndexArchive(const NP* a); 
+    static bool ArchiveGet(const std::string& param, vec_d2d& props); 
+    static G4MaterialPropertyVector* ArchiveMPV(const std::string& param, double scale=1.); 
+    static void Record(const std::string& param, const vec_d2d& props); 
+    static std::string SourceDigest(const std::vector<std::string>& params); 
+    static NP*  MakeArchive(); 
+    static bool SaveArchive(); 
+    static void ClearArchive(); 
+    static std::string DescArchive(); 
+
 };
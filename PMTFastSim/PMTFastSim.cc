@@ -4,6 +4,8 @@
 #include <iostream>
 #include <iomanip>
 #include <array>
+#include <chrono>
+#include <algorithm>
 
 #include "NP.hh"
 #include "SStr.hh"
@@ -30,6 +32,9 @@
 
 #include "DetectorConstruction.hh"
 #include "PMTFastSim.hh"
+#include "LVGrid.h"
+#include "SpanTree.h"
+#include "IGeomManager.h"
 
 #include <iostream>
 #include <streambuf>
@@ -39,13 +44,122 @@
 int PMTFastSim::LEVEL = SSys::getenvint("PMTFastSim", 0) ;   // using PLOG across packages needs investigation 
 
 PMTFastSim* PMTFastSim::INSTANCE = nullptr ; 
+
+std::recursive_mutex                      PMTFastSim::CACHE_MTX ; 
+std::map<std::string, PMTFastSim*>        PMTFastSim::INSTANCES = {} ; 
+std::map<std::string, G4LogicalVolume*>   PMTFastSim::LVS = {} ; 
+std::map<std::string, G4VPhysicalVolume*> PMTFastSim::PVS = {} ; 
+int PMTFastSim::NUM_HIT = 0 ; 
+int PMTFastSim::NUM_MISS = 0 ; 
+
+/**
+PMTFastSim::Get
+-----------------
+
+Returns the instance for the current options, constructing it the first time 
+the options are seen. Previously the single INSTANCE meant that only the 
+switches from the first name were used, now each distinct set of 
+SetEnvironmentSwitches options gets its own instance.  
+
+**/
+
 PMTFastSim* PMTFastSim::Get()
 { 
-    if(INSTANCE == nullptr) new PMTFastSim ; 
+    std::lock_guard<std::recursive_mutex> lock(CACHE_MTX); 
+    std::string key = OptionsKey() ; 
+    std::map<std::string, PMTFastSim*>::const_iterator it = INSTANCES.find(key) ; 
+    if( it != INSTANCES.end() ) 
+    {
+        INSTANCE = it->second ; 
+        return INSTANCE ; 
+    }
+    new PMTFastSim ; 
     assert(INSTANCE);  // set by ctor
+    INSTANCES[key] = INSTANCE ; 
     return INSTANCE ; 
 } 
 
+/**
+PMTFastSim::OptionsKey
+------------------------
+
+Sorted envvars that influence the geometry : the JUNO_ switches set by 
+SetEnvironmentSwitches and the manager property envvars "objName_key", 
+eg hama_SimplificationLevel, as selected by IGeomOptions::Key which is 
+also used by PMTSim::OptionsKey. 
+
+**/
+
+std::string PMTFastSim::OptionsKey() // static
+{
+    return IGeomOptions::Key() ; 
+}
+
+std::string PMTFastSim::CacheKey(const char* name) // static
+{
+    std::stringstream ss ; 
+    ss << name << "|" << OptionsKey() ; 
+    std::string s = ss.str(); 
+    return s ; 
+}
+
+/**
+PMTFastSim::ClearCache
+------------------------
+
+Forgets cached instances, LV, PV and the dynode LVs shared between 
+HamamatsuR12860PMTManager instances so subsequent requests construct new ones. 
+Nothing is deleted as the objects remain referenced from the Geant4 stores. 
+
+**/
+
+void PMTFastSim::ClearCache() // static
+{
+    std::lock_guard<std::recursive_mutex> lock(CACHE_MTX); 
+    INSTANCES.clear(); 
+    LVS.clear(); 
+    PVS.clear(); 
+    NUM_HIT = 0 ; 
+    NUM_MISS = 0 ; 
+    INSTANCE = nullptr ; 
+    HamamatsuR12860PMTManager::ClearShared(); 
+}
+
+std::string PMTFastSim::DescCache() // static
+{
+    std::lock_guard<std::recursive_mutex> lock(CACHE_MTX); 
+    std::stringstream ss ; 
+    ss << "PMTFastSim::DescCache"
+       << " instances " << INSTANCES.size()
+       << " lvs " << LVS.size()
+       << " pvs " << PVS.size()
+       << " hit " << NUM_HIT 
+       << " miss " << NUM_MISS 
+       << std::endl 
+       ;
+    for(std::map<std::string, PMTFastSim*>::const_iterator it=INSTANCES.begin() ; it != INSTANCES.end() ; it++) ss << it->second->descTiming() ; 
+    std::string s = ss.str(); 
+    return s ; 
+}
+
+std::string PMTFastSim::descTiming() const 
+{
+    std::stringstream ss ; 
+    double total = 0. ; 
+    ss << "PMTFastSim::descTiming" << std::endl ; 
+    for(unsigned i=0 ; i < m_timing.size() ; i++) 
+    {
+        ss << std::setw(10) << m_timing[i].first 
+           << " " << std::fixed << std::setw(10) << std::setprecision(4) << m_timing[i].second 
+           << std::endl 
+           ; 
+        total += m_timing[i].second ; 
+    }
+    ss << std::setw(10) << "TOTAL" << " " << std::fixed << std::setw(10) << std::setprecision(4) << total << std::endl ; 
+    std::string s = ss.str(); 
+    return s ; 
+}
+
 
 
 /**
@@ -108,18 +222,42 @@ void PMTFastSim::SetEnvironmentSwitches(const char* name)  // static
 G4LogicalVolume* PMTFastSim::GetLV(const char* name) // static
 {
     std::cout << "[ PMTFastSim::GetLV [" << name << "]" << std::endl ; 
-    PMTFastSim::SetEnvironmentSwitches(name); // CAUTION only switches from the first name get used  
-    PMTFastSim* pfs = PMTFastSim::Get() ; 
-    G4LogicalVolume* lv = pfs->getLV(name); 
+    std::lock_guard<std::recursive_mutex> lock(CACHE_MTX); 
+    PMTFastSim::SetEnvironmentSwitches(name); 
+    std::string key = CacheKey(name) ; 
+    G4LogicalVolume* lv = LVS.count(key) == 1 ? LVS[key] : nullptr ; 
+    if( lv ) 
+    {
+        NUM_HIT += 1 ; 
+    }
+    else
+    {
+        NUM_MISS += 1 ; 
+        PMTFastSim* pfs = PMTFastSim::Get() ; 
+        lv = pfs->getLV(name); 
+        if(lv) LVS[key] = lv ; 
+    }
     std::cout << "] PMTFastSim::GetLV [" << name << "]" << " lv " << ( lv ? "Y" : "N" ) << std::endl ; 
     return lv ; 
 }
 
 G4VPhysicalVolume* PMTFastSim::GetPV(const char* name) // static
 {
-    PMTFastSim::SetEnvironmentSwitches(name); // CAUTION only switches from the first name get used  
-    PMTFastSim* pfs = PMTFastSim::Get() ; 
-    G4VPhysicalVolume* pv = pfs->getPV(name); 
+    std::lock_guard<std::recursive_mutex> lock(CACHE_MTX); 
+    PMTFastSim::SetEnvironmentSwitches(name); 
+    std::string key = CacheKey(name) ; 
+    G4VPhysicalVolume* pv = PVS.count(key) == 1 ? PVS[key] : nullptr ; 
+    if( pv ) 
+    {
+        NUM_HIT += 1 ; 
+    }
+    else
+    {
+        NUM_MISS += 1 ; 
+        PMTFastSim* pfs = PMTFastSim::Get() ; 
+        pv = pfs->getPV(name); 
+        if(pv) PVS[key] = pv ; 
+    }
     return pv ; 
 }
 
@@ -139,9 +277,7 @@ PMTSim::GetPV
 
 G4VPhysicalVolume* PMTFastSim::GetPV(const char* name, std::vector<double>* tr, std::vector<G4VSolid*>* solids ) // static
 {
-    PMTFastSim::SetEnvironmentSwitches(name);  // CAUTION only switches from the first name get used 
-    PMTFastSim* pfs = PMTFastSim::Get() ; 
-    G4VPhysicalVolume* pv = pfs->getPV(name); 
+    G4VPhysicalVolume* pv = GetPV(name); 
 
     if(pv == nullptr)
     {
@@ -159,7 +295,8 @@ G4VPhysicalVolume* PMTFastSim::GetPV(const char* name, std::vector<double>* tr,
 
 junoPMTOpticalModel* PMTFastSim::GetPMTOpticalModel(const char* name) // static
 {
-    PMTFastSim::SetEnvironmentSwitches(name); // CAUTION only switches from the first name get used  
+    std::lock_guard<std::recursive_mutex> lock(CACHE_MTX); 
+    PMTFastSim::SetEnvironmentSwitches(name); 
     PMTFastSim* pfs = PMTFastSim::Get() ; 
     junoPMTOpticalModel* pom = pfs->getPMTOpticalModel(name); 
     return pom ; 
@@ -191,11 +328,18 @@ Instanciates residents with cout+cerr redirected to avoid the noise
 2. m_hama(HamamatsuR12860PMTManager)
 3. m_nnvt(NNVTMCPPMTManager)
 
+The construction time of each resident is recorded in m_timing
+and as SpanTree spans, see SpanTree.h for saving them. 
+
 **/
 
 void PMTFastSim::init()
 {
     INSTANCE = this ; 
+    SpanTree::Span span("PMTFastSim::init") ; 
+
+    typedef std::chrono::high_resolution_clock Clock ; 
+    Clock::time_point t0 = Clock::now(); 
 
     std::stringstream coutbuf;
     std::stringstream cerrbuf;
@@ -203,6 +347,7 @@ void PMTFastSim::init()
         cout_redirect out_(coutbuf.rdbuf());
         cerr_redirect err_(cerrbuf.rdbuf());
     
+        SpanTree::Span sp("dc") ; 
         m_dc = new DetectorConstruction ; 
 
         // TO SEE OUTPUT OF THE ABOVE WITHOUT SETTING VERBOSE : MOVE OUTSIDE THIS CAPTURE BLOCK
@@ -213,7 +358,16 @@ void PMTFastSim::init()
     std::string err = cerrbuf.str(); 
     std::cout << OutputMessage("PMTFastSim::init" , out, err, verbose ); 
 
-    m_hama = new HamamatsuR12860PMTManager(HAMA) ; 
+    Clock::time_point t1 = Clock::now(); 
+    m_timing.push_back( std::make_pair( std::string("dc"), std::chrono::duration<double>(t1 - t0).count() )); 
+
+    {
+        SpanTree::Span sp("hama.ctor") ; 
+        m_hama = new HamamatsuR12860PMTManager(HAMA) ; 
+    }
+
+    Clock::time_point t2 = Clock::now(); 
+    m_timing.push_back( std::make_pair( std::string("hama"), std::chrono::duration<double>(t2 - t1).count() )); 
 
     /*
     m_nnvt = new NNVTMCPPMTManager(NNVT) ; 
@@ -230,8 +384,12 @@ void PMTFastSim::init()
         << std::endl
         << " m_hama.desc " << ( m_hama ? m_hama->desc() : "-" )
         << std::endl
+        << descTiming()
         ;
 
+    SpanTree::SaveEnv(); 
+    IGeomOptions::SaveEnv(); 
+
 }
 
 
@@ -449,39 +607,22 @@ const char* PMTFastSim::Name(const char* prefix, int ix, int iy, int iz, const c
 
 /**
 PMTFastSim::WrapLVGrid
-------------------------
-
-Places the argument lv multiple times in a grid of placements configured by nx ny nz
-that are placed within world_so/world_lv/world_pv
+----------------------
 
-CAUTION: currently the grid scaling and dimensions of the world box 
-make unfounded assumptions regarding the size of the lv 
+Places the argument lv multiple times within a world volume using LVGrid, 
+which sizes the lattice and world box from the extent of the lv. 
+The LVGrid mode (placement/parameterised/replica) and layout (grid/sphere) 
+are configured by envvars, see LVGrid.h 
 
-The number of placements is (2*nx+1)*(2*ny+1)*(2*nz+1)
+With the default grid layout the number of copies is (2*nx+1)*(2*ny+1)*(2*nz+1)
 
 **/
 
 G4VPhysicalVolume* PMTFastSim::WrapLVGrid( G4LogicalVolume* lv, int nx, int ny, int nz  )
 {
-    std::cout << "PMTFastSim::WrapLVGrid " << nx << " " << ny << " " << nz << std::endl ; 
-
-    G4Material* vacuum = G4Material::GetMaterial("Vacuum"); 
-    int extent = std::max(std::max(nx, ny), nz); 
-    G4double sc = 500. ; 
-    G4double halfside = sc*extent*3. ; 
-    G4Box* world_so = new G4Box("World_so", halfside, halfside, halfside ); 
-    G4LogicalVolume* world_lv = new G4LogicalVolume(world_so,vacuum,"World_lv",0,0,0); 
-    G4VPhysicalVolume* world_pv = new G4PVPlacement(0,G4ThreeVector(),world_lv ,"World_pv",0,false,0);
-
-    for(int ix=-nx ; ix < nx+1 ; ix++)
-    for(int iy=-ny ; iy < ny+1 ; iy++)
-    for(int iz=-nz ; iz < nz+1 ; iz++)
-    {
-        const char* iname = Name("item", ix, iy, iz, "" );         
-        G4ThreeVector tla( sc*double(ix), sc*double(iy), sc*double(iz) ); 
-        G4VPhysicalVolume* pv_n = new G4PVPlacement(0, tla, lv ,iname,world_lv,false,0);
-        assert( pv_n ); 
-    }
+    std::unique_ptr<LVGrid> grid(LVGrid::FromEnv(lv, nx, ny, nz));   // parameterised mode keeps its own copy 
+    G4VPhysicalVolume* world_pv = grid->build(); 
+    std::cout << "PMTFastSim::WrapLVGrid " << grid->desc() << std::endl ; 
     return world_pv ; 
 }
 
@@ -12,6 +12,8 @@ depend on PMTFastSim package.
 #include <vector>
 #include <string>
 #include <array>
+#include <map>
+#include <mutex>
 
 struct NP ; 
 class G4VSolid ; 
@@ -38,6 +40,17 @@ struct PMTFASTSIM_API PMTFastSim
     static PMTFastSim* INSTANCE ; 
     static PMTFastSim* Get(); 
 
+    static std::recursive_mutex                      CACHE_MTX ; 
+    static std::map<std::string, PMTFastSim*>        INSTANCES ; 
+    static std::map<std::string, G4LogicalVolume*>   LVS ; 
+    static std::map<std::string, G4VPhysicalVolume*> PVS ; 
+    static int NUM_HIT ; 
+    static int NUM_MISS ; 
+    static std::string OptionsKey(); 
+    static std::string CacheKey(const char* name); 
+    static void ClearCache(); 
+    static std::string DescCache(); 
+
     static const char* HAMA ; 
     static const char* NNVT ; 
 
@@ -69,6 +82,9 @@ struct PMTFASTSIM_API PMTFastSim
     static bool HasManagerPrefix( const char* name ); 
     IGeomManager* getManager(const char* name); 
 
+    std::vector<std::pair<std::string, double>> m_timing ; 
+    std::string descTiming() const ; 
+
     PMTFastSim(); 
     void init(); 
 
@@ -0,0 +1,456 @@
+#pragma once
+/**
+StepProfile : stepping level time attribution to logical volumes and processes
+=================================================================================
+
+Charges the time taken by each step and the step count to the LV of the
+pre-step point and the process that defined the step (Transportation,
+OpBoundary, the fast simulation process, ...). Developed to find where
+the time goes in the natural vs unnatural PMT geometry comparison,
+see issues/blyth-88-merge-totalTime.rst
+
+The time of a step is the interval since the previous step of the same
+thread ended, or since the track started, so it includes the stepping
+manager, navigation, the process DoIt and SD ProcessHits of that step.
+
+Tables are per thread without locking, keyed by LV and process pointers.
+As other threads may still be stepping, reporting never reads those tables :
+each thread calls *publish* to copy its own table into a snapshot under
+the mutex, as with SProfileHist::publish, and the reports merge the
+published snapshots by LV name and process name.
+*save_env* is only done on the master, which in multi-threaded mode
+runs EndOfRunAction after the workers have finished their runs
+and published. It refuses with an error on worker threads.
+
+Hook into the user actions, unchanged when disabled::
+
+    void PreUserTrackingAction(const G4Track*)
+    {
+        if(StepProfile::Enabled()) StepProfile::Get()->track_begin() ;
+    }
+    void UserSteppingAction(const G4Step* step)
+    {
+        if(StepProfile::Enabled()) StepProfile::Get()->step(step) ;
+    }
+    void EndOfRunAction(const G4Run*)
+    {
+        if(!StepProfile::Enabled()) return ;
+        StepProfile::Get()->publish() ;     // every thread : snapshot of its own table
+        if(G4Threading::IsMasterThread()) StepProfile::Get()->save_env() ;
+    }
+
+Envvars
+    StepProfile
+        enables the profile
+    StepProfile_CLOCK=wall
+        use wall time rather than the default per thread CPU time
+    StepProfile_DIR
+        directory to write StepProfile.npy and StepProfile.txt
+        when save_env is called
+    StepProfile_TOP
+        number of rows in the text report, default 50
+
+NP array
+    shape (num_row, 4) with columns count, seconds, fraction, mean_us
+    rows sorted by descending seconds, names "lvname process"
+
+NB PMTSim/StepProfile.h and PMTFastSim/StepProfile.h are the same, keep them in sync.
+
+**/
+
+#include <algorithm>
+#include <cstdlib>
+#include <ctime>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "G4Threading.hh"
+#include "G4Step.hh"
+#include "G4StepPoint.hh"
+#include "G4VProcess.hh"
+#include "G4LogicalVolume.hh"
+#include "G4VPhysicalVolume.hh"
+
+#include "NP.hh"
+
+struct StepProfile
+{
+    struct Cell
+    {
+        unsigned long long count ;
+        double             seconds ;
+    };
+
+    typedef std::pair<const G4LogicalVolume*, const G4VProcess*> Key ;
+
+    struct KeyHash
+    {
+        size_t operator()( const Key& k ) const
+        {
+            size_t a = std::hash<const void*>()(k.first) ;
+            size_t b = std::hash<const void*>()(k.second) ;
+            return a ^ ( b + 0x9e3779b97f4a7c15ull + (a << 6) + (a >> 2) ) ;
+        }
+    };
+
+    typedef std::unordered_map<Key, Cell, KeyHash> Cells ;
+
+    struct Table
+    {
+        Cells  cells ;       // only touched by the owning thread
+        Cells  published ;   // snapshot of cells, guarded by mtx
+        double stamp ;
+    };
+
+    struct Row
+    {
+        std::string lv ;
+        std::string proc ;
+        Cell        cell ;
+    };
+
+    static constexpr const char* COLS = "count,seconds,fraction,mean_us" ;
+    static constexpr const char* NONE = "none" ;
+
+    static bool Enabled();
+    static StepProfile* Get();
+    static double Now(bool cpu);
+
+    bool                 cpu ;
+    mutable std::mutex   mtx ;
+    std::vector<Table*>  tables ;   // one per thread, never deleted as threads may outlive the report
+
+    StepProfile();
+
+    Table& table();
+    void   track_begin();
+    void   step( const G4Step* step );
+    void   add( const G4LogicalVolume* lv, const G4VProcess* proc, double seconds );
+    void   publish();
+    void   clear();
+
+    void   rows( std::vector<Row>& rr ) const ;
+    void   lv_rows( std::vector<Row>& rr ) const ;
+    NP*    array() const ;
+    std::string desc(int top=50) const ;
+    void   save(const char* dir) const ;
+    void   save_env() const ;
+};
+
+inline bool StepProfile::Enabled() // static
+{
+    static bool enabled = getenv("StepProfile") != nullptr ;
+    return enabled ;
+}
+
+inline StepProfile* StepProfile::Get() // static
+{
+    static StepProfile* INSTANCE = new StepProfile ;
+    return INSTANCE ;
+}
+
+/**
+StepProfile::Now
+------------------
+
+Seconds from CLOCK_THREAD_CPUTIME_ID, so time when the thread is descheduled
+is not charged, or from the steady clock with StepProfile_CLOCK=wall.
+
+**/
+
+inline double StepProfile::Now(bool cpu) // static
+{
+    if( cpu )
+    {
+        timespec ts ;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        return double(ts.tv_sec) + 1e-9*double(ts.tv_nsec) ;
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count() ;
+}
+
+inline StepProfile::StepProfile()
+    :
+    cpu( getenv("StepProfile_CLOCK") == nullptr || std::string(getenv("StepProfile_CLOCK")) != "wall" )
+{
+}
+
+inline StepProfile::Table& StepProfile::table()
+{
+    static thread_local Table* t = nullptr ;
+    if( t == nullptr )
+    {
+        t = new Table ;
+        t->stamp = Now(cpu) ;
+        std::lock_guard<std::mutex> lock(mtx);
+        tables.push_back(t);
+    }
+    return *t ;
+}
+
+inline void StepProfile::track_begin()
+{
+    table().stamp = Now(cpu) ;
+}
+
+/**
+StepProfile::step
+-------------------
+
+Called from UserSteppingAction, so at the end of the step.
+
+**/
+
+inline void StepProfile::step( const G4Step* step )
+{
+    Table& t = table() ;
+    double now = Now(cpu) ;
+
+    const G4VPhysicalVolume* pv = step->GetPreStepPoint()->GetPhysicalVolume() ;
+    const G4LogicalVolume* lv = pv ? pv->GetLogicalVolume() : nullptr ;
+    const G4VProcess* proc = step->GetPostStepPoint()->GetProcessDefinedStep() ;
+
+    Cell& c = t.cells[Key(lv, proc)] ;
+    c.count += 1 ;
+    c.seconds += now - t.stamp ;
+    t.stamp = now ;
+}
+
+inline void StepProfile::add( const G4LogicalVolume* lv, const G4VProcess* proc, double seconds )
+{
+    Cell& c = table().cells[Key(lv, proc)] ;
+    c.count += 1 ;
+    c.seconds += seconds ;
+}
+
+/**
+StepProfile::publish
+----------------------
+
+Copies the table of the calling thread into its snapshot, which is what
+the reports read. Call from each thread when it stops stepping,
+eg EndOfRunAction, or periodically for reports during the run.
+
+**/
+
+inline void StepProfile::publish()
+{
+    Table& t = table() ;
+    std::lock_guard<std::mutex> lock(mtx);
+    t.published = t.cells ;
+}
+
+/**
+StepProfile::clear
+--------------------
+
+Only call when no thread is stepping, eg at BeginOfRunAction on the master.
+
+**/
+
+inline void StepProfile::clear()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    for(unsigned i=0 ; i < tables.size() ; i++)
+    {
+        tables[i]->cells.clear() ;
+        tables[i]->published.clear() ;
+    }
+}
+
+/**
+StepProfile::rows
+-------------------
+
+Merges the published snapshots of all threads by LV name and process name,
+sorted by descending seconds.
+
+**/
+
+inline void StepProfile::rows( std::vector<Row>& rr ) const
+{
+    std::map<std::pair<std::string,std::string>, Cell> merged ;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        for(unsigned i=0 ; i < tables.size() ; i++)
+        {
+            const Cells& cells = tables[i]->published ;
+            for(Cells::const_iterator it=cells.begin() ; it != cells.end() ; it++)
+            {
+                const G4LogicalVolume* lv = it->first.first ;
+                const G4VProcess* proc = it->first.second ;
+                std::pair<std::string,std::string> k( lv ? lv->GetName() : NONE, proc ? proc->GetProcessName() : NONE ) ;
+                Cell& c = merged[k] ;    // value initialized
+                c.count += it->second.count ;
+                c.seconds += it->second.seconds ;
+            }
+        }
+    }
+
+    rr.clear();
+    for(std::map<std::pair<std::string,std::string>,Cell>::const_iterator it=merged.begin() ; it != merged.end() ; it++)
+    {
+        Row r ;
+        r.lv = it->first.first ;
+        r.proc = it->first.second ;
+        r.cell = it->second ;
+        rr.push_back(r);
+    }
+    std::stable_sort( rr.begin(), rr.end(), [](const Row& a, const Row& b){ return a.cell.seconds > b.cell.seconds ; } );
+}
+
+inline void StepProfile::lv_rows( std::vector<Row>& rr ) const
+{
+    std::vector<Row> all ;
+    rows(all);
+    std::map<std::string, Cell> merged ;
+    for(unsigned i=0 ; i < all.size() ; i++)
+    {
+        Cell& c = merged[all[i].lv] ;
+        c.count += all[i].cell.count ;
+        c.seconds += all[i].cell.seconds ;
+    }
+    rr.clear();
+    for(std::map<std::string,Cell>::const_iterator it=merged.begin() ; it != merged.end() ; it++)
+    {
+        Row r ;
+        r.lv = it->first ;
+        r.proc = "*" ;
+        r.cell = it->second ;
+        rr.push_back(r);
+    }
+    std::stable_sort( rr.begin(), rr.end(), [](const Row& a, const Row& b){ return a.cell.seconds > b.cell.seconds ; } );
+}
+
+inline NP* StepProfile::array() const
+{
+    std::vector<Row> rr ;
+    rows(rr);
+    double total = 0. ;
+    for(unsigned i=0 ; i < rr.size() ; i++) total += rr[i].cell.seconds ;
+
+    int ni = int(rr.size()) ;
+    NP* a = NP::Make<double>( ni, 4 );
+    double* aa = a->values<double>() ;
+    for(int i=0 ; i < ni ; i++)
+    {
+        const Cell& c = rr[i].cell ;
+        aa[i*4+0] = double(c.count) ;
+        aa[i*4+1] = c.seconds ;
+        aa[i*4+2] = total > 0. ? c.seconds/total : 0. ;
+        aa[i*4+3] = c.count > 0 ? 1e6*c.seconds/double(c.count) : 0. ;
+        a->names.push_back( rr[i].lv + " " + rr[i].proc ) ;
+    }
+    a->set_meta<std::string>("cols", COLS ) ;
+    a->set_meta<std::string>("clock", cpu ? "thread_cpu" : "wall" ) ;
+    return a ;
+}
+
+inline std::string StepProfile::desc(int top) const
+{
+    std::vector<Row> rr ;
+    rows(rr);
+    std::vector<Row> lr ;
+    lv_rows(lr);
+
+    double total = 0. ;
+    unsigned long long count = 0 ;
+    for(unsigned i=0 ; i < rr.size() ; i++)
+    {
+        total += rr[i].cell.seconds ;
+        count += rr[i].cell.count ;
+    }
+
+    size_t num_table = 0 ;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        num_table = tables.size() ;
+    }
+
+    std::stringstream ss ;
+    ss << "StepProfile::desc"
+       << " clock " << ( cpu ? "thread_cpu" : "wall" )
+       << " threads " << num_table
+       << " steps " << count
+       << " seconds " << std::fixed << std::setprecision(3) << total
+       << std::endl
+       ;
+
+    std::vector<const std::vector<Row>*> tabs = { &lr, &rr } ;
+    for(unsigned t=0 ; t < tabs.size() ; t++)
+    {
+        const std::vector<Row>& tab = *tabs[t] ;
+        ss << ( t == 0 ? "by LV" : "by LV and process" ) << std::endl ;
+        ss << std::setw(40) << "lv"
+           << " " << std::setw(30) << "process"
+           << " " << std::setw(12) << "count"
+           << " " << std::setw(10) << "seconds"
+           << " " << std::setw(7) << "frac"
+           << " " << std::setw(9) << "mean_us"
+           << std::endl
+           ;
+        for(int i=0 ; i < std::min(top, int(tab.size())) ; i++)
+        {
+            const Row& r = tab[i] ;
+            ss << std::setw(40) << r.lv
+               << " " << std::setw(30) << r.proc
+               << " " << std::setw(12) << r.cell.count
+               << " " << std::fixed << std::setw(10) << std::setprecision(4) << r.cell.seconds
+               << " " << std::fixed << std::setw(7) << std::setprecision(4) << ( total > 0. ? r.cell.seconds/total : 0. )
+               << " " << std::fixed << std::setw(9) << std::setprecision(3) << ( r.cell.count > 0 ? 1e6*r.cell.seconds/double(r.cell.count) : 0. )
+               << std::endl
+               ;
+        }
+    }
+    std::string s = ss.str();
+    return s ;
+}
+
+inline void StepProfile::save(const char* dir) const
+{
+    NP* a = array() ;
+    a->save(dir, "StepProfile.npy") ;
+
+    const char* top_ = getenv("StepProfile_TOP") ;
+    int top = top_ ? atoi(top_) : 50 ;
+
+    std::stringstream ss ;
+    ss << dir << "/StepProfile.txt" ;
+    std::string path = ss.str();
+    std::ofstream fp(path.c_str(), std::ios::out);
+    fp << desc(top) ;
+    fp.close();
+
+    std::cout << "StepProfile::save " << dir << " num_row " << a->shape[0] << std::endl ;
+}
+
+/**
+StepProfile::save_env
+-----------------------
+
+Saves to StepProfile_DIR when defined. Only on the master thread,
+after the workers have published.
+
+**/
+
+inline void StepProfile::save_env() const
+{
+    const char* dir = getenv("StepProfile_DIR") ;
+    if( dir == nullptr ) return ;
+    if( !G4Threading::IsMasterThread() )
+    {
+        std::cerr << "StepProfile::save_env ERROR : only call on the master thread, not saving" << std::endl ;
+        return ;
+    }
+    save(dir) ;
+}
+
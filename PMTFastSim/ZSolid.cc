@@ -16,12 +16,14 @@
 
 #include "ZCanvas.h"
 #include "ZSolid.h"
+#include "SpanTree.h"
 
 
 const bool ZSolid::verbose = getenv("ZSolid_verbose") != nullptr ; 
 
 G4VSolid* ZSolid::ApplyZCutTree( const G4VSolid* original, double zcut ) // static
 {
+    SpanTree::Span span("ZSolid::ApplyZCutTree") ; 
     if(verbose)
     std::cout << "[ ZSolid::ApplyZCutTree zcut " << zcut << " original.GetName " << original->GetName() << std::endl ; 
 
@@ -19,6 +19,11 @@ class G4DisplacedSolid ;
 ZSolid : CSG tree manipulations  
 =================================
 
+This is the PMTFastSim copy, which only provides the ApplyZCutTree 
+used by HamamatsuR12860PMTManager. The generalized plane and box cuts 
+of ZSolid::ApplyCutTree with ZCut.h and the tree height reduction 
+of ZSolid::Rebalance are only in PMTSim/ZSolid. 
+
 **/
 
 struct ZCanvas ; 
@@ -0,0 +1,86 @@
+/**
+ShareDynodeLVTest.cc
+======================
+
+Checks the HamamatsuR12860PMTManager ShareDynodeLV option by constructing
+manager instances for different options via PMTFastSim::GetLV and comparing
+the LV placed by their "_dynode_tube_phy"::
+
+    ShareDynodeLVTest
+
+1. natural geometry with ShareDynodeLV : the dynode LVs are built once
+2. option that does not affect the dynode (JUNO_PMT20INCH_PROFLIGATE_TAIL_CUT) : same LV
+3. UseRealSurface=0 changes tube_hz : different LV
+4. fast simulation region (no natural geometry) : never shared
+
+**/
+
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "G4LogicalVolume.hh"
+#include "G4VPhysicalVolume.hh"
+
+#include "PMTFastSim.hh"
+
+const G4LogicalVolume* FindDaughterLV( const G4LogicalVolume* lv, const char* suffix )
+{
+    size_t ls = strlen(suffix) ;
+    for(size_t i=0 ; i < lv->GetNoDaughters() ; i++)
+    {
+        const G4VPhysicalVolume* pv = lv->GetDaughter(i) ;
+        const std::string& name = pv->GetName() ;
+        if( name.size() >= ls && name.compare(name.size()-ls, ls, suffix) == 0 ) return pv->GetLogicalVolume() ;
+        const G4LogicalVolume* found = FindDaughterLV( pv->GetLogicalVolume(), suffix ) ;
+        if(found) return found ;
+    }
+    return nullptr ;
+}
+
+const G4LogicalVolume* GetDynodeTubeLV()
+{
+    G4LogicalVolume* lv = PMTFastSim::GetLV("hamaLogicalPMT") ;
+    assert(lv);
+    const G4LogicalVolume* tube = FindDaughterLV( lv, "_dynode_tube_phy" ) ;
+    assert(tube);
+    return tube ;
+}
+
+int main(int argc, char** argv)
+{
+    setenv("hama_ShareDynodeLV", "1", 1 );
+    setenv("hama_UseNaturalGeometry", "1", 1 );
+    const G4LogicalVolume* a = GetDynodeTubeLV() ;
+
+    setenv("JUNO_PMT20INCH_PROFLIGATE_TAIL_CUT", "1", 1 );
+    const G4LogicalVolume* b = GetDynodeTubeLV() ;
+    unsetenv("JUNO_PMT20INCH_PROFLIGATE_TAIL_CUT");
+
+    setenv("hama_UseRealSurface", "0", 1 );
+    const G4LogicalVolume* c = GetDynodeTubeLV() ;
+    unsetenv("hama_UseRealSurface");
+
+    setenv("hama_UseNaturalGeometry", "0", 1 );
+    const G4LogicalVolume* d0 = GetDynodeTubeLV() ;
+    setenv("JUNO_PMT20INCH_PROFLIGATE_TAIL_CUT", "1", 1 );
+    const G4LogicalVolume* d1 = GetDynodeTubeLV() ;
+    unsetenv("JUNO_PMT20INCH_PROFLIGATE_TAIL_CUT");
+
+    std::cout
+        << "ShareDynodeLVTest" << std::endl
+        << " a  " << a  << " " << a->GetName()  << std::endl
+        << " b  " << b  << " " << b->GetName()  << std::endl
+        << " c  " << c  << " " << c->GetName()  << std::endl
+        << " d0 " << d0 << " " << d0->GetName() << std::endl
+        << " d1 " << d1 << " " << d1->GetName() << std::endl
+        << PMTFastSim::DescCache()
+        ;
+
+    assert( a == b );    // unrelated option : shared
+    assert( a != c );    // different tube_hz
+    assert( d0 != a && d0 != d1 );   // fast sim region : not shared
+    return 0 ;
+}
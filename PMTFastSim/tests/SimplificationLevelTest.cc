@@ -0,0 +1,215 @@
+/**
+SimplificationLevelTest.cc
+============================
+
+Cost/accuracy benchmark of the HamamatsuR12860PMTManager SimplificationLevel option.
+For each level the PMT LV is placed into an LVGrid world with PMTFastSim::WrapLVGrid
+and the same sample of straight rays from the top face of the world is traced
+with G4Navigator, reporting per level:
+
+rays/s
+    navigation rate, the rays continue through the PMT interior to the world boundary
+steps
+    mean number of geometry limited steps (boundary crossings) per ray
+detect
+    fraction of rays whose first entry into PMT vacuum from Pyrex is in the
+    upper (photocathode) hemisphere of the PMT : a proxy for the detection
+    probability, the deviation from level 0 is given in binomial sigma
+touchables/bytes
+    expanded volume count and memory estimate of one PMT from GeomAudit
+
+This is a geometry only benchmark, the optical physics is not run,
+so the choice of level for production still needs validation of the hit
+distributions with the full simulation::
+
+    SimplificationLevelTest
+    LEVELS=0,2 NUM=100000 SimplificationLevelTest
+    N=5 LVGrid_MODE=parameterised SimplificationLevelTest
+
+**/
+
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "G4Navigator.hh"
+#include "G4Box.hh"
+#include "G4Material.hh"
+#include "G4LogicalVolume.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4AffineTransform.hh"
+
+#include "PMTFastSim.hh"
+#include "GeomAudit.h"
+
+struct Result
+{
+    int    level ;
+    size_t num_ray ;
+    double seconds ;
+    size_t steps ;
+    size_t detect ;
+    size_t touchables ;
+    size_t bytes ;
+};
+
+/**
+make_rays
+-----------
+
+Origins uniform over the top face of the world box (shrunk slightly to
+stay inside) with directions into the lower hemisphere, biased downwards.
+Stored as 6 doubles per ray in units of the world half sizes, so the same
+sample can be used with the worlds of all levels.
+
+**/
+
+void make_rays( std::vector<double>& rays, size_t num, unsigned seed )
+{
+    std::mt19937_64 rng(seed) ;
+    std::uniform_real_distribution<double> uni(0., 1.) ;
+    rays.resize(num*6) ;
+    for(size_t i=0 ; i < num ; i++)
+    {
+        double ct = -std::sqrt(uni(rng)) ;   // cos(theta) in [-1,0)
+        double st = std::sqrt(1. - ct*ct) ;
+        double ph = 2.*M_PI*uni(rng) ;
+        double* r = rays.data() + i*6 ;
+        r[0] = 2.*uni(rng) - 1. ;
+        r[1] = 2.*uni(rng) - 1. ;
+        r[2] = 1. ;
+        r[3] = st*std::cos(ph) ;
+        r[4] = st*std::sin(ph) ;
+        r[5] = ct ;
+    }
+}
+
+bool is_cathode_entry( G4Navigator& nav, const G4VPhysicalVolume* pv, const G4ThreeVector& pos )
+{
+    const G4LogicalVolume* lv = pv->GetLogicalVolume() ;
+    const G4LogicalVolume* mother = pv->GetMotherLogical() ;
+    bool glass_to_vacuum = mother
+                         && lv->GetMaterial()->GetName() == "Vacuum"
+                         && mother->GetMaterial()->GetName() == "Pyrex" ;
+    if(!glass_to_vacuum) return false ;
+    G4ThreeVector local = nav.GetGlobalToLocalTransform().TransformPoint(pos) ;   // inner volumes are not offset within the PMT
+    return local.z() > 0. ;
+}
+
+Result run_level( int level, int n, const std::vector<double>& rays, int max_step )
+{
+    std::stringstream ss ;
+    ss << level ;
+    std::string lvl = ss.str();
+    setenv("hama_SimplificationLevel", lvl.c_str(), 1 );   // different PMTFastSim instance for each level
+
+    G4LogicalVolume* lv = PMTFastSim::GetLV("hamaLogicalPMT") ;
+    assert(lv);
+    G4VPhysicalVolume* world = PMTFastSim::WrapLVGrid(lv, n, n, 0 ) ;
+    const G4Box* box = dynamic_cast<const G4Box*>(world->GetLogicalVolume()->GetSolid()) ;
+    assert(box);
+    G4ThreeVector half( 0.999*box->GetXHalfLength(), 0.999*box->GetYHalfLength(), 0.999*box->GetZHalfLength() );
+
+    GeomAudit audit ;
+    audit.add(lvl.c_str(), lv );
+
+    Result res ;
+    res.level = level ;
+    res.num_ray = rays.size()/6 ;
+    res.steps = 0 ;
+    res.detect = 0 ;
+    res.touchables = audit.entries[0].touchables ;
+    res.bytes = audit.entries[0].bytes() ;
+
+    G4Navigator nav ;
+    nav.SetWorldVolume(world) ;
+
+    typedef std::chrono::high_resolution_clock Clock ;
+    Clock::time_point t0 = Clock::now();
+    for(size_t i=0 ; i < res.num_ray ; i++)
+    {
+        const double* r = rays.data() + i*6 ;
+        G4ThreeVector pos( r[0]*half.x(), r[1]*half.y(), r[2]*half.z() );
+        G4ThreeVector dir( r[3], r[4], r[5] );
+
+        G4VPhysicalVolume* pv = nav.LocateGlobalPointAndSetup(pos, &dir, false, false) ;
+        bool detected = false ;
+        for(int s=0 ; pv && s < max_step ; s++)
+        {
+            G4double safety = 0. ;
+            G4double step = nav.ComputeStep(pos, dir, kInfinity, safety) ;
+            if( step == kInfinity ) break ;
+            pos += step*dir ;
+            res.steps += 1 ;
+            nav.SetGeometricallyLimitedStep();
+            pv = nav.LocateGlobalPointAndSetup(pos, &dir, true) ;
+            if( pv && !detected && is_cathode_entry(nav, pv, pos) ) detected = true ;
+        }
+        if(detected) res.detect += 1 ;
+    }
+    res.seconds = std::chrono::duration<double>(Clock::now() - t0).count() ;
+    return res ;
+}
+
+int main(int argc, char** argv)
+{
+    const char* levels_ = getenv("LEVELS") ;
+    const char* num_ = getenv("NUM") ;
+    const char* n_ = getenv("N") ;
+    std::string levels = levels_ ? levels_ : "0,1,2,3" ;
+    size_t num = num_ ? strtoul(num_, nullptr, 10) : 10000 ;
+    int n = n_ ? atoi(n_) : 3 ;
+    int max_step = 1000 ;
+
+    std::vector<double> rays ;
+    make_rays(rays, num, 42u );
+
+    std::vector<Result> results ;
+    std::stringstream ls(levels) ;
+    std::string tok ;
+    while(std::getline(ls, tok, ',')) if(!tok.empty()) results.push_back( run_level(atoi(tok.c_str()), n, rays, max_step) ) ;
+
+    std::cout
+        << "SimplificationLevelTest"
+        << " rays " << num
+        << " grid " << (2*n+1) << "x" << (2*n+1)
+        << std::endl
+        << std::setw(6) << "level"
+        << std::setw(12) << "rays/s"
+        << std::setw(10) << "steps"
+        << std::setw(10) << "detect"
+        << std::setw(10) << "ddetect"
+        << std::setw(8) << "sigma"
+        << std::setw(12) << "touchables"
+        << std::setw(12) << "bytes"
+        << std::endl
+        ;
+
+    double p0 = results.empty() ? 0. : double(results[0].detect)/double(results[0].num_ray) ;
+    for(unsigned i=0 ; i < results.size() ; i++)
+    {
+        const Result& r = results[i] ;
+        double p = double(r.detect)/double(r.num_ray) ;
+        double dp = p - p0 ;
+        double err = std::sqrt( ( p0*(1.-p0) + p*(1.-p) )/double(r.num_ray) ) ;
+        std::cout
+            << std::setw(6) << r.level
+            << std::setw(12) << std::fixed << std::setprecision(0) << double(r.num_ray)/r.seconds
+            << std::setw(10) << std::fixed << std::setprecision(2) << double(r.steps)/double(r.num_ray)
+            << std::setw(10) << std::fixed << std::setprecision(4) << p
+            << std::setw(10) << std::fixed << std::setprecision(4) << dp
+            << std::setw(8) << std::fixed << std::setprecision(1) << ( err > 0. ? dp/err : 0. )
+            << std::setw(12) << r.touchables
+            << std::setw(12) << GeomAudit::Bytes(r.bytes)
+            << std::endl
+            ;
+    }
+    return 0 ;
+}
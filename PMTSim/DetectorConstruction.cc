@@ -37,6 +37,7 @@ DetectorConstruction::DetectorConstruction()
 {
    std::cout << "[ DetectorConstruction::DetectorConstruction " << std::endl ; 
    DefineMaterials();
+   MaterialSvc::SaveArchive(); 
    std::cout << "] DetectorConstruction::DetectorConstruction " << std::endl ; 
 }
 
@@ -47,6 +48,14 @@ void DetectorConstruction::DefineMaterials()
 
 bool DetectorConstruction::helper_mpt(G4MaterialPropertiesTable* MPT, const std::string& mname,  IMCParamsSvc* params, const std::string& name , double scale )
 {
+    // bulk construct when the archive is loaded, only when *params* is the archive backed MaterialSvc 
+    G4MaterialPropertyVector* avec = dynamic_cast<MaterialSvc*>(params) ? MaterialSvc::ArchiveMPV(name, scale) : nullptr ;  
+    if( avec )
+    {
+        MPT->AddProperty(mname.c_str(), avec);
+        return true ; 
+    }
+
     IMCParamsSvc::vec_d2d props;
     bool st = params->Get(name, props);
     if (!st) {
@@ -0,0 +1,417 @@
+#pragma once
+/**
+GeomAudit : memory footprint report for constructed LV hierarchies
+=====================================================================
+
+Walks the volume tree below each added LV collecting the unique
+solids (including the constituents of booleans and displaced solids),
+LVs, PVs and PV rotations and estimates the bytes they occupy.
+
+Estimates
+    sizeof of the concrete type found by dynamic_cast, plus the
+    variable size parts that are easily accessible : the G4Polycone
+    corners, faces and original parameters, the transforms of
+    G4DisplacedSolid, the daughter vector of G4LogicalVolume
+    and the rotation of G4PVPlacement.
+    Materials, surfaces, vis attributes and G4 navigation voxels
+    are not included, so the bytes are a lower bound useful
+    for comparisons between managers and variants.
+
+Touchables
+    number of volumes in the expanded tree, ie counting every
+    placement path, which is what the navigator sees.
+
+Entries are labelled, typically "manager/variant". As the collections are
+sets of pointers the union row counts objects shared between entries once,
+so "shared" (the sum of entries minus the union) shows the saving from
+sharing LV subtrees between variants, see eg HamamatsuR12860PMTManager
+option ShareDynodeLV.
+
+The projection multiplies the per placement cost (one G4PVPlacement and rotation)
+by the number of placements, comparing the case where all placements share
+the LV tree with one tree per placement.
+
+Usage::
+
+    GeomAudit audit ;
+    audit.add("hama/natural", lv0 );
+    audit.add("hama/default", lv1 );
+    std::cout << audit.desc() ;
+    std::cout << audit.projection(17612) ;
+    NP* a = audit.array() ;
+
+NB PMTSim/GeomAudit.h and PMTFastSim/GeomAudit.h are the same, keep them in sync.
+
+**/
+
+#include <cstddef>
+#include <iomanip>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "G4VSolid.hh"
+#include "G4Box.hh"
+#include "G4Tubs.hh"
+#include "G4Cons.hh"
+#include "G4Sphere.hh"
+#include "G4Torus.hh"
+#include "G4Ellipsoid.hh"
+#include "G4Polycone.hh"
+#include "G4PolyconeSide.hh"
+#include "G4BooleanSolid.hh"
+#include "G4UnionSolid.hh"
+#include "G4SubtractionSolid.hh"
+#include "G4IntersectionSolid.hh"
+#include "G4DisplacedSolid.hh"
+#include "G4AffineTransform.hh"
+#include "G4RotationMatrix.hh"
+#include "G4LogicalVolume.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4PVPlacement.hh"
+
+#include "NP.hh"
+
+struct GeomAudit
+{
+    struct Entry
+    {
+        std::string                        label ;
+        const G4LogicalVolume*             top ;
+        std::set<const G4VSolid*>          solids ;
+        std::set<const G4LogicalVolume*>   lvs ;
+        std::set<const G4VPhysicalVolume*> pvs ;
+        std::set<const G4RotationMatrix*>  rots ;
+        size_t                             touchables ;
+
+        size_t solid_bytes() const ;
+        size_t lv_bytes() const ;
+        size_t pv_bytes() const ;
+        size_t bytes() const ;
+        void   merge( const Entry& other );
+    };
+
+    static constexpr const char* COLS = "solids,lvs,pvs,rots,touchables,solid_bytes,lv_bytes,pv_bytes,bytes" ;
+    enum { NUM_COL = 9 } ;
+
+    static size_t SolidBytes( const G4VSolid* so );
+    static size_t LVBytes( const G4LogicalVolume* lv );
+    static size_t PVBytes( const G4VPhysicalVolume* pv );
+    static size_t PlacementBytes();
+    static void   CollectSolid( Entry& e, const G4VSolid* so );
+    static size_t Collect( Entry& e, const G4LogicalVolume* lv );
+    static std::string Bytes( size_t bytes );
+
+    std::vector<Entry> entries ;
+
+    void  add( const char* label, const G4LogicalVolume* lv );
+    Entry combined() const ;
+    size_t sum_bytes() const ;
+
+    NP*   array() const ;
+    std::string desc_entry( const Entry& e ) const ;
+    std::string desc() const ;
+    std::string projection( size_t num_placement ) const ;
+};
+
+
+/**
+GeomAudit::SolidBytes
+-----------------------
+
+Concrete types are tested most derived first, as G4Polycone etc..
+are not related to the others this is only relevant for the booleans.
+
+**/
+
+inline size_t GeomAudit::SolidBytes( const G4VSolid* so ) // static
+{
+    if( so == nullptr ) return 0 ;
+    size_t bytes = 0 ;
+
+    const G4Polycone* pc = dynamic_cast<const G4Polycone*>(so) ;
+    const G4DisplacedSolid* ds = dynamic_cast<const G4DisplacedSolid*>(so) ;
+
+    if(      dynamic_cast<const G4Box*>(so) )              bytes = sizeof(G4Box) ;
+    else if( dynamic_cast<const G4Tubs*>(so) )             bytes = sizeof(G4Tubs) ;
+    else if( dynamic_cast<const G4Cons*>(so) )             bytes = sizeof(G4Cons) ;
+    else if( dynamic_cast<const G4Sphere*>(so) )           bytes = sizeof(G4Sphere) ;
+    else if( dynamic_cast<const G4Torus*>(so) )            bytes = sizeof(G4Torus) ;
+    else if( dynamic_cast<const G4Ellipsoid*>(so) )        bytes = sizeof(G4Ellipsoid) ;
+    else if( dynamic_cast<const G4UnionSolid*>(so) )       bytes = sizeof(G4UnionSolid) ;
+    else if( dynamic_cast<const G4SubtractionSolid*>(so) ) bytes = sizeof(G4SubtractionSolid) ;
+    else if( dynamic_cast<const G4IntersectionSolid*>(so) ) bytes = sizeof(G4IntersectionSolid) ;
+    else if( pc )
+    {
+        int num_corner = pc->GetNumRZCorner() ;
+        int num_face = num_corner + ( pc->IsOpen() ? 2 : 0 ) ;
+        const G4PolyconeHistorical* orig = pc->GetOriginalParameters() ;
+        int num_zplane = orig ? orig->Num_z_planes : 0 ;
+
+        bytes = sizeof(G4Polycone)
+              + num_corner*sizeof(G4PolyconeSideRZ)
+              + num_face*( sizeof(G4PolyconeSide) + sizeof(G4VCSGface*) )
+              + 3*num_zplane*sizeof(G4double)
+              ;
+    }
+    else if( ds )
+    {
+        bytes = sizeof(G4DisplacedSolid) + 2*sizeof(G4AffineTransform) ;
+    }
+    else
+    {
+        bytes = sizeof(G4VSolid) ;   // unknown type : lower bound
+    }
+    return bytes ;
+}
+
+inline size_t GeomAudit::LVBytes( const G4LogicalVolume* lv ) // static
+{
+    size_t num_daughter = lv->GetNoDaughters() ;
+    return sizeof(G4LogicalVolume) + num_daughter*sizeof(G4VPhysicalVolume*) ;
+}
+
+inline size_t GeomAudit::PVBytes( const G4VPhysicalVolume* pv ) // static
+{
+    return dynamic_cast<const G4PVPlacement*>(pv) ? sizeof(G4PVPlacement) : sizeof(G4VPhysicalVolume) ;
+}
+
+inline size_t GeomAudit::PlacementBytes() // static
+{
+    return sizeof(G4PVPlacement) + sizeof(G4RotationMatrix) ;
+}
+
+inline void GeomAudit::CollectSolid( Entry& e, const G4VSolid* so ) // static
+{
+    if( so == nullptr || e.solids.count(so) == 1 ) return ;
+    e.solids.insert(so);
+
+    const G4BooleanSolid* bo = dynamic_cast<const G4BooleanSolid*>(so) ;
+    const G4DisplacedSolid* ds = dynamic_cast<const G4DisplacedSolid*>(so) ;
+    if( bo )
+    {
+        CollectSolid(e, bo->GetConstituentSolid(0) );
+        CollectSolid(e, bo->GetConstituentSolid(1) );
+    }
+    else if( ds )
+    {
+        CollectSolid(e, ds->GetConstituentMovedSolid() );
+    }
+}
+
+/**
+GeomAudit::Collect
+--------------------
+
+Returns the number of touchables in the expanded tree below and including *lv*.
+The multiplicity of replicas and parameterised PVs is honoured.
+
+**/
+
+inline size_t GeomAudit::Collect( Entry& e, const G4LogicalVolume* lv ) // static
+{
+    e.lvs.insert(lv);
+    CollectSolid(e, lv->GetSolid() );
+
+    size_t touchables = 1 ;
+    for(size_t i=0 ; i < lv->GetNoDaughters() ; i++)
+    {
+        const G4VPhysicalVolume* pv = lv->GetDaughter(i) ;
+        e.pvs.insert(pv);
+        const G4RotationMatrix* rot = pv->GetRotation() ;
+        if( rot ) e.rots.insert(rot);
+
+        size_t multiplicity = pv->GetMultiplicity() ;
+        touchables += multiplicity*Collect(e, pv->GetLogicalVolume() ) ;
+    }
+    return touchables ;
+}
+
+inline std::string GeomAudit::Bytes( size_t bytes ) // static
+{
+    std::stringstream ss ;
+    if( bytes < 10*1024 )              ss << bytes << " B" ;
+    else if( bytes < 10*1024*1024 )    ss << std::fixed << std::setprecision(1) << double(bytes)/1024. << " kB" ;
+    else                               ss << std::fixed << std::setprecision(1) << double(bytes)/(1024.*1024.) << " MB" ;
+    std::string s = ss.str();
+    return s ;
+}
+
+inline size_t GeomAudit::Entry::solid_bytes() const
+{
+    size_t bytes = 0 ;
+    for(std::set<const G4VSolid*>::const_iterator it=solids.begin() ; it != solids.end() ; it++) bytes += SolidBytes(*it) ;
+    return bytes ;
+}
+inline size_t GeomAudit::Entry::lv_bytes() const
+{
+    size_t bytes = 0 ;
+    for(std::set<const G4LogicalVolume*>::const_iterator it=lvs.begin() ; it != lvs.end() ; it++) bytes += LVBytes(*it) ;
+    return bytes ;
+}
+inline size_t GeomAudit::Entry::pv_bytes() const
+{
+    size_t bytes = rots.size()*sizeof(G4RotationMatrix) ;
+    for(std::set<const G4VPhysicalVolume*>::const_iterator it=pvs.begin() ; it != pvs.end() ; it++) bytes += PVBytes(*it) ;
+    return bytes ;
+}
+inline size_t GeomAudit::Entry::bytes() const
+{
+    return solid_bytes() + lv_bytes() + pv_bytes() ;
+}
+
+inline void GeomAudit::Entry::merge( const Entry& other )
+{
+    solids.insert( other.solids.begin(), other.solids.end() );
+    lvs.insert(    other.lvs.begin(),    other.lvs.end() );
+    pvs.insert(    other.pvs.begin(),    other.pvs.end() );
+    rots.insert(   other.rots.begin(),   other.rots.end() );
+    touchables += other.touchables ;
+}
+
+inline void GeomAudit::add( const char* label, const G4LogicalVolume* lv )
+{
+    if( lv == nullptr ) return ;
+    Entry e ;
+    e.label = label ;
+    e.top = lv ;
+    e.touchables = 0 ;
+    e.touchables = Collect(e, lv );
+    entries.push_back(e);
+}
+
+inline GeomAudit::Entry GeomAudit::combined() const
+{
+    Entry u ;
+    u.label = "union" ;
+    u.top = nullptr ;
+    u.touchables = 0 ;
+    for(unsigned i=0 ; i < entries.size() ; i++) u.merge(entries[i]) ;
+    return u ;
+}
+
+inline size_t GeomAudit::sum_bytes() const
+{
+    size_t bytes = 0 ;
+    for(unsigned i=0 ; i < entries.size() ; i++) bytes += entries[i].bytes() ;
+    return bytes ;
+}
+
+/**
+GeomAudit::array
+------------------
+
+Shape (num_entry+1, 9) with the union as the last row,
+entry labels in the names and columns in the "cols" metadata.
+
+**/
+
+inline NP* GeomAudit::array() const
+{
+    std::vector<Entry> rows(entries) ;
+    rows.push_back(combined());
+
+    int ni = int(rows.size()) ;
+    NP* a = NP::Make<double>( ni, NUM_COL );
+    double* aa = a->values<double>() ;
+    for(int i=0 ; i < ni ; i++)
+    {
+        const Entry& e = rows[i] ;
+        double* r = aa + i*NUM_COL ;
+        r[0] = e.solids.size() ;
+        r[1] = e.lvs.size() ;
+        r[2] = e.pvs.size() ;
+        r[3] = e.rots.size() ;
+        r[4] = e.touchables ;
+        r[5] = e.solid_bytes() ;
+        r[6] = e.lv_bytes() ;
+        r[7] = e.pv_bytes() ;
+        r[8] = e.bytes() ;
+        a->names.push_back(e.label) ;
+    }
+    a->set_meta<std::string>("cols", COLS ) ;
+    return a ;
+}
+
+inline std::string GeomAudit::desc_entry( const Entry& e ) const
+{
+    std::stringstream ss ;
+    ss << std::setw(30) << e.label
+       << " " << std::setw(7) << e.solids.size()
+       << " " << std::setw(7) << e.lvs.size()
+       << " " << std::setw(7) << e.pvs.size()
+       << " " << std::setw(7) << e.rots.size()
+       << " " << std::setw(10) << e.touchables
+       << " " << std::setw(10) << Bytes(e.solid_bytes())
+       << " " << std::setw(10) << Bytes(e.lv_bytes())
+       << " " << std::setw(10) << Bytes(e.pv_bytes())
+       << " " << std::setw(10) << Bytes(e.bytes())
+       ;
+    std::string s = ss.str();
+    return s ;
+}
+
+inline std::string GeomAudit::desc() const
+{
+    std::stringstream ss ;
+    ss << "GeomAudit::desc num_entry " << entries.size() << std::endl ;
+    ss << std::setw(30) << "label"
+       << " " << std::setw(7) << "solids"
+       << " " << std::setw(7) << "lvs"
+       << " " << std::setw(7) << "pvs"
+       << " " << std::setw(7) << "rots"
+       << " " << std::setw(10) << "touchables"
+       << " " << std::setw(10) << "solid"
+       << " " << std::setw(10) << "lv"
+       << " " << std::setw(10) << "pv"
+       << " " << std::setw(10) << "total"
+       << std::endl
+       ;
+    for(unsigned i=0 ; i < entries.size() ; i++) ss << desc_entry(entries[i]) << std::endl ;
+
+    Entry u = combined() ;
+    size_t sum = sum_bytes() ;
+    size_t uni = u.bytes() ;
+    ss << desc_entry(u) << std::endl ;
+    ss << "sum of entries " << Bytes(sum)
+       << " union " << Bytes(uni)
+       << " shared " << Bytes(sum - uni)
+       << std::endl
+       ;
+    std::string s = ss.str();
+    return s ;
+}
+
+/**
+GeomAudit::projection
+-----------------------
+
+For each entry compares *num_placement* placements of the top LV sharing
+one LV tree with the cost of one LV tree per placement.
+
+**/
+
+inline std::string GeomAudit::projection( size_t num_placement ) const
+{
+    std::stringstream ss ;
+    ss << "GeomAudit::projection num_placement " << num_placement
+       << " placement " << PlacementBytes() << " B"
+       << std::endl
+       ;
+    for(unsigned i=0 ; i < entries.size() ; i++)
+    {
+        const Entry& e = entries[i] ;
+        size_t shared = e.bytes() + num_placement*PlacementBytes() ;
+        size_t unshared = num_placement*( e.bytes() + PlacementBytes() ) ;
+        ss << std::setw(30) << e.label
+           << " shared " << std::setw(10) << Bytes(shared)
+           << " unshared " << std::setw(10) << Bytes(unshared)
+           << " touchables " << std::setw(12) << num_placement*e.touchables
+           << std::endl
+           ;
+    }
+    std::string s = ss.str();
+    return s ;
+}
+
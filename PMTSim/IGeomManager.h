@@ -19,13 +19,29 @@ are IGeomManager when they are compiled with the PMTSIM_STANDALONE switch::
 The methods cannot easily be const as the underlying Manager 
 use lazy instanciation. 
 
+Option values for declProp come from IGeomOptions, a snapshot of the 
+environment parsed once into a hashed store keyed by "prefix_key" 
+with typed values cached per key, instead of getenv and istringstream 
+for every declared property of every manager instance. 
+The IGeomManager ctor calls IGeomOptions::Sync which compares the 
+environment with the snapshot and reparses only when it has changed, 
+so managers constructed after setenv/unsetenv see the new values. 
+
 **/
 
+#include <cassert>
 #include <string>
+#include <algorithm>
 #include <vector>
+#include <map>
+#include <unordered_map>
+#include <mutex>
+#include <fstream>
 #include <iostream>
 #include <iomanip>
+#include <sstream>
 #include <cstdlib>
+#include <cstring>
 
 #include "NP.hh"
 #include "NPX.h"
@@ -42,31 +58,340 @@ class IDetElementPos ;
 //class junoPMTOpticalModel ; 
 
 
+/**
+IGeomOptions
+--------------
+
+Snapshot of the environment used by IGeomManager::declProp. 
+
+Get
+    instance with the environment parsed on first use 
+Refresh
+    reparse the environment, invalidating the typed values 
+Sync
+    Refresh only when the environment differs from the snapshot 
+find<T>
+    typed value for "prefix_key" parsed with istringstream once per generation 
+record
+    notes the value resolved by declProp, from the environment or the default 
+Key
+    sorted "name=value;" of the envvars that can change the geometry, see below 
+desc 
+    table of the resolved values
+exports
+    resolved values as "export prefix_key=value" lines that reproduce the configuration 
+SaveEnv
+    writes exports to the path in envvar IGeomOptions_DUMP when defined 
+
+**/
+
+struct IGeomOptions
+{
+    struct Resolved
+    {
+        std::string value ; 
+        std::string dflt ; 
+        bool        from_env ; 
+    };
+
+    std::unordered_map<std::string, std::string> env ; 
+    std::map<std::string, Resolved>              resolved ; 
+    int                                          generation ; 
+    mutable std::recursive_mutex                 mtx ; 
+
+    static IGeomOptions* Get(); 
+    static void Refresh(); 
+    static void Sync(); 
+    static void SaveEnv(); 
+    static const std::vector<std::string>& Prefixes(); 
+    static std::string Key(); 
+
+    template<typename T>
+    static std::unordered_map<std::string, std::pair<int,T>>& Typed(); 
+
+    IGeomOptions(); 
+    void snapshot(); 
+    bool stale() const ; 
+
+    bool find_str(const std::string& ekey, std::string& val) const ; 
+    template<typename T> bool find(const std::string& ekey, T& var) ; 
+    void record(const std::string& ekey, const std::string& value, const std::string& dflt, bool from_env ); 
+    bool declared(const std::string& ekey) const ; 
+
+    std::string desc() const ; 
+    std::string exports() const ; 
+};
+
+inline IGeomOptions* IGeomOptions::Get() // static
+{
+    static IGeomOptions* INSTANCE = new IGeomOptions ; 
+    return INSTANCE ; 
+}
+
+inline void IGeomOptions::Refresh() // static
+{
+    Get()->snapshot(); 
+}
+
+inline void IGeomOptions::Sync() // static
+{
+    IGeomOptions* opts = Get() ; 
+    std::lock_guard<std::recursive_mutex> lock(opts->mtx); 
+    if(opts->stale()) opts->snapshot(); 
+}
+
+inline void IGeomOptions::SaveEnv() // static
+{
+    const char* path = getenv("IGeomOptions_DUMP") ; 
+    if( path == nullptr ) return ; 
+    std::ofstream fp(path, std::ios::out); 
+    fp << Get()->exports() ; 
+    fp.close(); 
+}
+
+/**
+IGeomOptions::Prefixes
+------------------------
+
+objName of the managers, the declProp envvars are named "objName_key"
+
+**/
+
+inline const std::vector<std::string>& IGeomOptions::Prefixes() // static
+{
+    static const std::vector<std::string> PREFIXES = { 
+        "hama", "nnvt", "hmsk", "nmsk", "lchi", "tub3", 
+        "xjac", "xjfc", "sjcl", "sjfx", "sjrc", "sjrf", "facr" 
+     } ; 
+    return PREFIXES ; 
+}
+
+/**
+IGeomOptions::Key
+-------------------
+
+Sorted "name=value;" of the current environment (not the snapshot) 
+restricted to the envvars that can change the geometry: 
+
+* "JUNO_" switches, eg those set by PMTSim::SetEnvironmentSwitches
+* "PMTSim_" options other than PMTSim_CACHE 
+* names containing "Manager_" 
+* manager properties "objName_key" with objName from Prefixes 
+* any other "objName_key" that declProp has recorded
+
+The declared names cover managers with an objName not in Prefixes, 
+but only once they have been constructed, so list new managers in Prefixes. 
+This is the key of the PMTSim and PMTFastSim instances and of ZSolidCache.  
+
+**/
+
+inline std::string IGeomOptions::Key() // static
+{
+    extern char** environ ; 
+    const std::vector<std::string>& prefixes = Prefixes() ; 
+    IGeomOptions* opts = Get() ; 
+
+    std::vector<std::string> kvs ; 
+    for(char** e=environ ; e && *e ; e++)
+    {
+        const char* kv = *e ; 
+        const char* eq = strchr(kv, '=') ; 
+        if( eq == nullptr ) continue ; 
+        std::string k(kv, eq - kv) ; 
+
+        bool select = 
+            ( k.compare(0, 5, "JUNO_") == 0 ) || 
+            ( k.compare(0, 7, "PMTSim_") == 0 && k != "PMTSim_CACHE" ) || 
+            ( k.find("Manager_") != std::string::npos ) 
+            ; 
+
+        for(size_t i=0 ; i < prefixes.size() && !select ; i++) 
+        {
+            const std::string& p = prefixes[i] ; 
+            select = k.size() > p.size() && k.compare(0, p.size(), p) == 0 && k[p.size()] == '_' ; 
+        }
+        if(!select) select = opts->declared(k) ; 
+        if(select) kvs.push_back(kv) ; 
+    }
+    std::sort( kvs.begin(), kvs.end() ); 
+
+    std::string s ; 
+    for(size_t i=0 ; i < kvs.size() ; i++) 
+    {
+        s += kvs[i] ; 
+        s += ";" ; 
+    }
+    return s ; 
+}
+
+template<typename T>
+inline std::unordered_map<std::string, std::pair<int,T>>& IGeomOptions::Typed() // static
+{
+    static std::unordered_map<std::string, std::pair<int,T>> typed ; 
+    return typed ; 
+}
+
+inline IGeomOptions::IGeomOptions()
+    :
+    generation(-1)
+{
+    snapshot(); 
+}
+
+inline void IGeomOptions::snapshot()
+{
+    extern char** environ ; 
+    std::lock_guard<std::recursive_mutex> lock(mtx); 
+    env.clear(); 
+    for(char** e=environ ; e && *e ; e++)
+    {
+        const char* kv = *e ; 
+        const char* eq = strchr(kv, '=') ; 
+        if( eq == nullptr ) continue ; 
+        env[std::string(kv, eq - kv)] = std::string(eq + 1) ; 
+    }
+    generation += 1 ; 
+}
+
+/**
+IGeomOptions::stale
+---------------------
+
+Compares the environment with the snapshot without allocating, 
+true when any envvar was added, removed or changed. 
+
+**/
+
+inline bool IGeomOptions::stale() const 
+{
+    extern char** environ ; 
+    std::lock_guard<std::recursive_mutex> lock(mtx); 
+    size_t num = 0 ; 
+    std::string k ; 
+    for(char** e=environ ; e && *e ; e++)
+    {
+        const char* kv = *e ; 
+        const char* eq = strchr(kv, '=') ; 
+        if( eq == nullptr ) continue ; 
+        k.assign(kv, eq - kv) ; 
+        std::unordered_map<std::string, std::string>::const_iterator it = env.find(k) ; 
+        if( it == env.end() || it->second.compare(eq + 1) != 0 ) return true ; 
+        num += 1 ; 
+    }
+    return num != env.size() ; 
+}
+
+inline bool IGeomOptions::find_str(const std::string& ekey, std::string& val) const 
+{
+    std::lock_guard<std::recursive_mutex> lock(mtx); 
+    std::unordered_map<std::string, std::string>::const_iterator it = env.find(ekey) ; 
+    if( it == env.end() ) return false ; 
+    val = it->second ; 
+    return true ; 
+}
+
+/**
+IGeomOptions::find
+--------------------
+
+Parsing as the former IGeomManager::Envv : istringstream >> var 
+of the whole value, with the result cached for the snapshot generation.
+
+**/
+
+template<typename T>
+inline bool IGeomOptions::find(const std::string& ekey, T& var)
+{
+    std::lock_guard<std::recursive_mutex> lock(mtx); 
+    std::unordered_map<std::string, std::pair<int,T>>& typed = Typed<T>() ; 
+    typename std::unordered_map<std::string, std::pair<int,T>>::const_iterator it = typed.find(ekey) ; 
+    if( it != typed.end() && it->second.first == generation ) 
+    {
+        var = it->second.second ; 
+        return true ; 
+    }
+
+    std::string s ; 
+    if(!find_str(ekey, s)) return false ; 
+    std::istringstream iss(s);
+    iss >> var ; 
+    typed[ekey] = std::make_pair( generation, var ); 
+    return true ; 
+}
+
+inline void IGeomOptions::record(const std::string& ekey, const std::string& value, const std::string& dflt, bool from_env )
+{
+    std::lock_guard<std::recursive_mutex> lock(mtx); 
+    Resolved& r = resolved[ekey] ; 
+    r.value = value ; 
+    r.dflt = dflt ; 
+    r.from_env = from_env ; 
+}
+
+inline bool IGeomOptions::declared(const std::string& ekey) const 
+{
+    std::lock_guard<std::recursive_mutex> lock(mtx); 
+    return resolved.count(ekey) == 1 ; 
+}
+
+inline std::string IGeomOptions::desc() const 
+{
+    std::lock_guard<std::recursive_mutex> lock(mtx); 
+    std::stringstream ss ; 
+    ss << "IGeomOptions::desc generation " << generation << " env " << env.size() << " resolved " << resolved.size() << std::endl ; 
+    for(std::map<std::string, Resolved>::const_iterator it=resolved.begin() ; it != resolved.end() ; it++)
+    {
+        const Resolved& r = it->second ; 
+        ss << std::setw(40) << it->first 
+           << " " << std::setw(20) << r.value 
+           << " default " << std::setw(20) << r.dflt 
+           << " " << ( r.from_env ? "ENV" : "DEFAULT" ) 
+           << std::endl 
+           ;
+    }
+    std::string s = ss.str(); 
+    return s ; 
+}
+
+inline std::string IGeomOptions::exports() const 
+{
+    std::lock_guard<std::recursive_mutex> lock(mtx); 
+    std::stringstream ss ; 
+    for(std::map<std::string, Resolved>::const_iterator it=resolved.begin() ; it != resolved.end() ; it++)
+    {
+        ss << "export " << it->first << "=" << it->second.value << std::endl ; 
+    }
+    std::string s = ss.str(); 
+    return s ; 
+}
+
+
 struct PMTSIM_API IGeomManager
 {
     static constexpr const int LEVEL = 0 ;  // using PLOG across projects inconvenient ?
     static constexpr const char* PREFIX = "0123" ; 
 
     const std::string& m_objName;
-    char*              m_geom ;
-    char*              m_head ;
-    char*              m_tail ;
+    std::string        m_geom ;
+    std::string        m_head ;
+    std::string        m_tail ;
+    bool               m_has_tail ; 
     std::vector<std::pair<std::string, double>> m_values ;
 
 
 
     IGeomManager( const std::string& objName ); 
 
-    static const char* EnvKey(const std::string& prefix, const std::string& key, char sep='_' ); 
+    static std::string EnvKey(const std::string& prefix, const std::string& key, char sep='_' ); 
     template<typename T>
-    static bool  Envv(const char* ekey, T& var ); 
+    static bool  Envv(const std::string& ekey, T& var ); 
 
     template<typename Type>
     bool declProp(const std::string& key, Type& var); 
 
 
 
-    static void Chop( char** head, char** tail, const char* delim, const char* str );
+    static bool Chop( std::string& head, std::string& tail, const char* delim, const char* str );
     void setGeom(const char* geom); 
 
     const std::string& objName() { return m_objName; }
@@ -94,31 +419,25 @@ struct PMTSIM_API IGeomManager
 inline IGeomManager::IGeomManager( const std::string& objName )
     :
     m_objName(objName), 
-    m_geom(nullptr),
-    m_head(nullptr),
-    m_tail(nullptr)
+    m_has_tail(false)
 {
+    IGeomOptions::Sync(); 
 }
 
-inline const char* IGeomManager::EnvKey(const std::string& prefix, const std::string& key, char sep ) // static
+inline std::string IGeomManager::EnvKey(const std::string& prefix, const std::string& key, char sep ) // static
 {
-    std::stringstream ss ; 
-    ss << prefix << sep << key ; 
-    std::string s = ss.str(); 
-    return strdup(s.c_str()); 
+    std::string s ; 
+    s.reserve( prefix.size() + 1 + key.size() ); 
+    s += prefix ; 
+    s += sep ; 
+    s += key ; 
+    return s ; 
 } 
 
 template<typename T>
-inline bool  IGeomManager::Envv(const char* ekey, T& var )
+inline bool  IGeomManager::Envv(const std::string& ekey, T& var )
 {
-    char* v = getenv(ekey);
-    if(v == nullptr) return false ; 
-
-    std::string s(v);
-    std::istringstream iss(s);
-    iss >> var ; 
-
-    return true ; 
+    return IGeomOptions::Get()->find(ekey, var) ; 
 }
 
 
@@ -142,6 +461,8 @@ The values given above act as the defaults, but they may be changed via envvars
     export hama_UsePMTOpticalModel=1
 
 The "hama" prefix comes from the IGeomManager ctor objName parameter.  
+The envvars are read from the IGeomOptions snapshot and the resolved 
+values are recorded there, see IGeomOptions::desc and IGeomOptions::exports
 
 **/
 
@@ -149,9 +470,14 @@ template<typename Type>
 inline bool IGeomManager::declProp(const std::string& key, Type& var)
 {
     Type var0 = var ; 
-    const char* ekey = EnvKey(m_objName, key, '_' ) ; 
+    std::string ekey = EnvKey(m_objName, key, '_' ) ; 
     bool set_from_envvar = Envv( ekey, var ); 
 
+    std::stringstream vs, ds ; 
+    vs << var ; 
+    ds << var0 ; 
+    IGeomOptions::Get()->record( ekey, vs.str(), ds.str(), set_from_envvar ); 
+
     //if(LEVEL > 0) 
     std::cout 
         << "IGeomManager::declProp"
@@ -171,16 +497,17 @@ inline bool IGeomManager::declProp(const std::string& key, Type& var)
 IGeomManager::Chop
 --------------------
 
-Chop *str* into *head* and *tail* delimited by *delim*
+Chop *str* into *head* and *tail* delimited by *delim*, 
+returning false with empty tail when *delim* is not found. 
 
 **/
 
-inline void IGeomManager::Chop( char** head, char** tail, const char* delim, const char* str ) // static
+inline bool IGeomManager::Chop( std::string& head, std::string& tail, const char* delim, const char* str ) // static
 {   
-    *head = strdup(str); 
-    char* p = strstr(*head, delim);  // pointer to first occurence of delim in str or null if not found
-    if(p) p[0] = '\0' ; 
-    *tail = p ? p + strlen(delim) : nullptr ;
+    const char* p = strstr(str, delim);  // pointer to first occurence of delim in str or null if not found
+    head = p ? std::string(str, p - str) : std::string(str) ; 
+    tail = p ? std::string(p + strlen(delim)) : std::string() ; 
+    return p != nullptr ; 
 }
 
 /**
@@ -197,32 +524,30 @@ argument.
 
 inline void IGeomManager::setGeom( const char* geom )
 {
-    assert( geom ); 
-    m_geom = strdup(geom) ; 
-    Chop( &m_head, &m_tail, "__" , m_geom + strlen(PREFIX) );
+    assert( geom && strlen(geom) >= strlen(PREFIX) ); 
+    m_geom = geom ; 
+    m_has_tail = Chop( m_head, m_tail, "__" , geom + strlen(PREFIX) );
   
     if(LEVEL > 0) std::cout 
         << "IGeomManager::setGeom "
-        << " m_geom " << ( m_geom ? m_geom : "-" )
-        << " m_head " << ( m_head ? m_head : "-" )
-        << " m_tail " << ( m_tail ? m_tail : "-" )
+        << " m_geom " << m_geom 
+        << " m_head " << m_head 
+        << " m_tail " << ( m_has_tail ? m_tail : "-" )
         << std::endl 
         ;   
-
-    assert( m_head );  
 }
-inline const char* IGeomManager::getGeom() const { return m_geom ; }
-inline const char* IGeomManager::getHead() const { return m_head ; }
-inline const char* IGeomManager::getTail() const { return m_tail ; }
+inline const char* IGeomManager::getGeom() const { return m_geom.empty() ? nullptr : m_geom.c_str() ; }
+inline const char* IGeomManager::getHead() const { return m_geom.empty() ? nullptr : m_head.c_str() ; }
+inline const char* IGeomManager::getTail() const { return m_has_tail ? m_tail.c_str() : nullptr ; }
 
 inline bool IGeomManager::hasOpt(const char* q) const 
 {
-    bool has = q && m_tail && strlen(q) <= strlen(m_tail) && strstr( m_tail, q ) != nullptr ; 
+    bool has = q && m_has_tail && m_tail.find(q) != std::string::npos ; 
     
     if(LEVEL > 2) std::cout 
         << "IGeomManager::hasOpt" 
         << " q " << ( q  ? q : "-" )
-        << " m_tail " << ( m_tail ? m_tail : "-" )
+        << " m_tail " << ( m_has_tail ? m_tail : "-" )
         << " has " << ( has ? "YES" : "NO" )
         << std::endl
         ; 
@@ -250,9 +575,9 @@ inline NP* IGeomManager::getValues(const char* contains)
         << std::endl 
         ;  
 
-    if(vv && m_geom) vv->set_meta<std::string>("geom", m_geom) ; 
-    if(vv && m_head) vv->set_meta<std::string>("head", m_head) ; 
-    if(vv && m_tail) vv->set_meta<std::string>("tail", m_tail) ; 
+    if(vv && !m_geom.empty()) vv->set_meta<std::string>("geom", m_geom) ; 
+    if(vv && !m_geom.empty()) vv->set_meta<std::string>("head", m_head) ; 
+    if(vv && m_has_tail)      vv->set_meta<std::string>("tail", m_tail) ; 
     return vv ; 
 }
 
@@ -0,0 +1,214 @@
+#pragma once
+/**
+InitScheduler : startup task runner with timeline and critical path reporting
+===============================================================================
+
+Tasks are added with a function and the indices of tasks they depend on.
+They run in the calling thread in the order added, the dependencies
+must refer to tasks already added so they are always satisfied.
+
+There is no thread pool. Everything done by PMTSim::init writes to the
+unlocked Geant4 stores (G4SolidStore, G4LogicalVolumeStore,
+G4PhysicalVolumeStore, surface tables, materials), the solids register
+themselves in G4SolidStore from their ctors, so no part of the
+construction can run concurrently.
+
+The dependencies record which tasks could overlap if the construction
+became thread safe. After run the timeline shows the start and duration
+of each task with the tasks of the critical path marked with "*".
+The critical path is the chain of dependencies with the largest summed
+duration, its total is the lower bound on the startup time that
+concurrent construction could reach.
+
+Usage::
+
+    InitScheduler sched ;
+    int a = sched.add("a", [&](){ ... } );
+    int b = sched.add("b", [&](){ ... } );
+    int c = sched.add("c", [&](){ ... }, {a, b} );
+    sched.run();
+    std::cout << sched.timeline() ;
+
+**/
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct InitScheduler
+{
+    enum { PENDING, DONE } ;
+
+    typedef std::chrono::high_resolution_clock Clock ;
+
+    struct Task
+    {
+        std::string           name ;
+        std::vector<int>      deps ;
+        std::function<void()> fn ;
+        int                   state ;
+        double                t0 ;       // seconds from start of run
+        double                t1 ;
+    };
+
+    std::vector<Task>  tasks ;
+    Clock::time_point  start ;
+
+    int  add( const char* name, std::function<void()> fn, const std::vector<int>& deps=std::vector<int>() );
+    int  find( const char* name ) const ;
+    void run();
+
+    double duration(int i) const ;
+    double total() const ;
+    void   critical_path( std::vector<int>& path ) const ;
+    double critical_total() const ;
+    std::string timeline(int width=60) const ;
+};
+
+/**
+InitScheduler::add
+--------------------
+
+Dependencies must refer to tasks already added, which
+guarantees the tasks can be run in the order added.
+
+**/
+
+inline int InitScheduler::add( const char* name, std::function<void()> fn, const std::vector<int>& deps )
+{
+    int idx = int(tasks.size()) ;
+    for(unsigned i=0 ; i < deps.size() ; i++)
+    {
+        bool expect = deps[i] >= 0 && deps[i] < idx ;
+        assert(expect);
+        if(!expect) exit(EXIT_FAILURE);
+    }
+    Task t ;
+    t.name = name ;
+    t.deps = deps ;
+    t.fn = fn ;
+    t.state = PENDING ;
+    t.t0 = 0. ;
+    t.t1 = 0. ;
+    tasks.push_back(t);
+    return idx ;
+}
+
+inline int InitScheduler::find( const char* name ) const
+{
+    for(unsigned i=0 ; i < tasks.size() ; i++) if(tasks[i].name.compare(name) == 0) return i ;
+    return -1 ;
+}
+
+inline void InitScheduler::run()
+{
+    start = Clock::now() ;
+    for(unsigned i=0 ; i < tasks.size() ; i++)
+    {
+        Task& t = tasks[i] ;
+        t.t0 = std::chrono::duration<double>(Clock::now() - start).count() ;
+        t.fn();
+        t.t1 = std::chrono::duration<double>(Clock::now() - start).count() ;
+        t.state = DONE ;
+    }
+}
+
+inline double InitScheduler::duration(int i) const
+{
+    return tasks[i].t1 - tasks[i].t0 ;
+}
+
+inline double InitScheduler::total() const
+{
+    double t = 0. ;
+    for(unsigned i=0 ; i < tasks.size() ; i++) if( tasks[i].t1 > t ) t = tasks[i].t1 ;
+    return t ;
+}
+
+/**
+InitScheduler::critical_path
+------------------------------
+
+Populates *path* with the task indices of the dependency chain with the
+largest summed duration, in execution order. As dependencies always
+have lower indices a single pass in the order added gives the chain
+ending at each task, and the walk back only ever goes to lower indices.
+
+**/
+
+inline void InitScheduler::critical_path( std::vector<int>& path ) const
+{
+    path.clear();
+    int num = int(tasks.size()) ;
+    std::vector<double> chain(num, 0.) ;
+    std::vector<int>    prev(num, -1) ;
+    int last = -1 ;
+    for(int i=0 ; i < num ; i++)
+    {
+        const Task& t = tasks[i] ;
+        for(unsigned j=0 ; j < t.deps.size() ; j++)
+        {
+            int d = t.deps[j] ;
+            if( prev[i] == -1 || chain[d] > chain[prev[i]] ) prev[i] = d ;
+        }
+        chain[i] = duration(i) + ( prev[i] > -1 ? chain[prev[i]] : 0. ) ;
+        if( last == -1 || chain[i] > chain[last] ) last = i ;
+    }
+    for(int cur=last ; cur > -1 ; cur = prev[cur] ) path.insert( path.begin(), cur );
+}
+
+inline double InitScheduler::critical_total() const
+{
+    std::vector<int> path ;
+    critical_path(path);
+    double t = 0. ;
+    for(unsigned i=0 ; i < path.size() ; i++) t += duration(path[i]) ;
+    return t ;
+}
+
+inline std::string InitScheduler::timeline(int width) const
+{
+    std::vector<int> path ;
+    critical_path(path);
+    std::vector<bool> crit(tasks.size(), false) ;
+    for(unsigned i=0 ; i < path.size() ; i++) crit[path[i]] = true ;
+
+    double tot = total() ;
+    double scale = tot > 0. ? double(width)/tot : 0. ;
+
+    std::stringstream ss ;
+    ss << "InitScheduler::timeline"
+       << " tasks " << tasks.size()
+       << " total " << std::fixed << std::setprecision(4) << tot
+       << std::endl
+       ;
+    for(unsigned i=0 ; i < tasks.size() ; i++)
+    {
+        const Task& t = tasks[i] ;
+        int b0 = int(t.t0*scale) ;
+        int b1 = std::max( b0 + 1, int(t.t1*scale) ) ;
+        std::string bar(width+1, ' ') ;
+        for(int b=b0 ; b < b1 && b <= width ; b++) bar[b] = '=' ;
+
+        ss << ( crit[i] ? "*" : " " )
+           << " " << std::setw(12) << t.name
+           << " " << std::fixed << std::setw(8) << std::setprecision(4) << t.t0
+           << " " << std::fixed << std::setw(8) << std::setprecision(4) << duration(i)
+           << " |" << bar << "|"
+           << std::endl
+           ;
+    }
+
+    ss << "critical path :" ;
+    for(unsigned i=0 ; i < path.size() ; i++) ss << " " << tasks[path[i]].name ;
+    ss << " (" << std::fixed << std::setprecision(4) << critical_total() << ")" << std::endl ;
+
+    std::string s = ss.str();
+    return s ;
+}
@@ -7,23 +7,27 @@ MaterialSvc.cc
 **/
 
 #include <cassert>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <iomanip>
 #include <vector>
+#include <algorithm>
 #include <boost/tuple/tuple.hpp>
 
 #include "G4MaterialPropertyVector.hh"
 #include "G4MaterialPropertiesTable.hh"
 #include "G4SystemOfUnits.hh"
+#include "NP.hh"
 #include "utils.hh"
 
 #include "MaterialSvc.hh"
+#include "SpanTree.h"
 
 
 bool MaterialSvc::Get(const std::string& param, vec_d2d& props)
 {  
-    const std::string path = GetPath( param.c_str() );
-    return get_implv1(path, props); 
+    return GetProps(param, props); 
 }
 
 bool MaterialSvc::Get(const std::string& param, vec_s2d& props)
@@ -68,11 +72,12 @@ const char* MaterialSvc::GetPath(const char* propPath) // static
 
 G4MaterialPropertyVector* MaterialSvc::GetMPV(const char* path, bool dump)  // static
 {
+    SpanTree::Span span("MaterialSvc::GetMPV") ; 
     typedef boost::tuple<double, double> elem_d2d; // double, double
     typedef std::vector<elem_d2d> vec_d2d;
 
     vec_d2d props ; 
-    get_implv1(path, props); 
+    get_implv2(path, props); 
 
     if(dump) std::cout  
         << "path " << path  
@@ -113,11 +118,262 @@ After::
 
 void MaterialSvc::AddProperty(G4MaterialPropertiesTable* MPT, const char* propName, const char* propPath) // static
 {
-    const char* path = GetPath(propPath); 
-    bool dump = false ; 
-    G4MaterialPropertyVector* mpv = GetMPV(path, dump); 
+    SpanTree::Span span("MaterialSvc::AddProperty") ; 
+    G4MaterialPropertyVector* mpv = ArchiveMPV(propPath) ; 
+    if( mpv == nullptr )
+    {
+        vec_d2d props ; 
+        GetProps(propPath, props); 
+        mpv = new G4MaterialPropertyVector(0,0,0);
+        for (unsigned i = 0; i < props.size(); ++i) mpv->InsertValues(props[i].get<0>(), props[i].get<1>() );
+    }
     MPT->AddProperty(propName, mpv);
 }
 
 
+int MaterialSvc::ARCHIVE_STATE = -1 ; 
+NP* MaterialSvc::ARCHIVE = nullptr ; 
+std::map<std::string, std::pair<int,int>> MaterialSvc::INDEX = {} ; 
+std::vector<std::string> MaterialSvc::RECORD_NAMES = {} ; 
+std::vector<double>      MaterialSvc::RECORD_ROWS = {} ; 
+
+/**
+MaterialSvc::GetProps
+-----------------------
+
+Appends the double,double properties of *param* from the archive when loaded, 
+otherwise parses the text table and records the properties for the archive. 
+
+**/
+
+bool MaterialSvc::GetProps(const std::string& param, vec_d2d& props) // static
+{
+    if(ArchiveGet(param, props)) return true ; 
+
+    const std::string path = GetPath( param.c_str() );
+    unsigned num0 = props.size() ; 
+    bool st = get_implv2(path, props); 
+    if( st && props.size() > num0 ) 
+    {
+        vec_d2d added(props.begin() + num0, props.end()) ; 
+        Record(param, added); 
+    }
+    return st ; 
+}
+
+/**
+MaterialSvc::LoadArchive
+--------------------------
+
+Checks for the archive once, returning true when it is loaded. 
+Archives that do not index or with a digest that does not match 
+the current text files are not loaded, leaving the state recording 
+so SaveArchive replaces them. 
+
+**/
+
+bool MaterialSvc::LoadArchive() // static
+{
+    if( ARCHIVE_STATE > -1 ) return ARCHIVE_STATE == 1 ; 
+    ARCHIVE_STATE = 0 ; 
+
+    const char* dir = getenv(ARCHIVE_KEY) ; 
+    if( dir == nullptr || !NP::Exists(dir, ARCHIVE_NAME) ) return false ; 
+
+    NP* a = NP::Load(dir, ARCHIVE_NAME) ; 
+    bool ok = IndexArchive(a) ; 
+    if(!ok) 
+    {
+        std::cerr << "MaterialSvc::LoadArchive invalid archive in " << dir << " : delete it to recreate " << std::endl ; 
+        INDEX.clear(); 
+        return false ; 
+    }
+
+    std::string digest = SourceDigest(a->names) ; 
+    std::string adigest = a->get_meta<std::string>("digest", "") ; 
+    if( digest != adigest )
+    {
+        std::cerr 
+            << "MaterialSvc::LoadArchive stale archive in " << dir 
+            << " digest " << adigest << " sources " << digest 
+            << " : recording to recreate " 
+            << std::endl 
+            ; 
+        INDEX.clear(); 
+        return false ; 
+    }
+    ARCHIVE = a ; 
+    ARCHIVE_STATE = 1 ; 
+    return true ; 
+}
+
+bool MaterialSvc::IndexArchive(const NP* a) // static
+{
+    if( a == nullptr || a->shape.size() != 2 || a->shape[1] != 2 ) return false ; 
+    const double* aa = a->cvalues<double>() ; 
+    int num_row = a->shape[0] ; 
+    int num_name = a->names.size() ; 
+
+    INDEX.clear(); 
+    int row = 0 ; 
+    while( row < num_row )
+    {
+        int num = int(aa[row*2+0]) ; 
+        int idx = int(aa[row*2+1]) ; 
+        bool expect = num >= 0 && row + 1 + num <= num_row && idx >= 0 && idx < num_name ; 
+        if(!expect) return false ; 
+        INDEX[a->names[idx]] = std::make_pair( row + 1, num ) ; 
+        row += 1 + num ; 
+    }
+    return int(INDEX.size()) == num_name ; 
+}
+
+bool MaterialSvc::ArchiveGet(const std::string& param, vec_d2d& props) // static
+{
+    if(!LoadArchive()) return false ; 
+    std::map<std::string, std::pair<int,int>>::const_iterator it = INDEX.find(param) ; 
+    if( it == INDEX.end() ) return false ; 
+
+    const double* aa = ARCHIVE->cvalues<double>() ; 
+    int row0 = it->second.first ; 
+    int num = it->second.second ; 
+    for(int i=0 ; i < num ; i++) props.push_back( elem_d2d( aa[(row0+i)*2+0], aa[(row0+i)*2+1] ) ); 
+    return true ; 
+}
+
+/**
+MaterialSvc::ArchiveMPV
+-------------------------
+
+Returns nullptr when the archive is not loaded or does not have *param*. 
+The vector is constructed in one go from energy ordered arrays. 
+InsertValues places each value with std::lower_bound, before any existing 
+equal energy, so points with duplicated energies end up in reverse file 
+order. The sort orders by energy and then by decreasing file index 
+to give the same vector as InsertValues in file order. 
+
+**/
+
+G4MaterialPropertyVector* MaterialSvc::ArchiveMPV(const std::string& param, double scale) // static
+{
+    if(!LoadArchive()) return nullptr ; 
+    std::map<std::string, std::pair<int,int>>::const_iterator it = INDEX.find(param) ; 
+    if( it == INDEX.end() ) return nullptr ; 
+
+    const double* aa = ARCHIVE->cvalues<double>() + 2*it->second.first ; 
+    int num = it->second.second ; 
+
+    std::vector<int> order(num) ; 
+    for(int i=0 ; i < num ; i++) order[i] = i ; 
+    std::sort( order.begin(), order.end(), [aa](int a, int b){ return aa[a*2+0] < aa[b*2+0] || ( aa[a*2+0] == aa[b*2+0] && a > b ) ; } ); 
+
+    std::vector<double> energies(num) ; 
+    std::vector<double> values(num) ; 
+    for(int i=0 ; i < num ; i++)
+    {
+        energies[i] = aa[order[i]*2+0] ; 
+        values[i]   = aa[order[i]*2+1]*scale ; 
+    }
+    return new G4MaterialPropertyVector( energies.data(), values.data(), num ); 
+}
+
+void MaterialSvc::Record(const std::string& param, const vec_d2d& props) // static
+{
+    if( ARCHIVE_STATE == 1 ) return ; 
+    if( std::find(RECORD_NAMES.begin(), RECORD_NAMES.end(), param) != RECORD_NAMES.end() ) return ; 
+
+    RECORD_ROWS.push_back( props.size() ); 
+    RECORD_ROWS.push_back( RECORD_NAMES.size() ); 
+    RECORD_NAMES.push_back(param); 
+    for(unsigned i=0 ; i < props.size() ; i++)
+    {
+        RECORD_ROWS.push_back( props[i].get<0>() ); 
+        RECORD_ROWS.push_back( props[i].get<1>() ); 
+    }
+}
+
+NP* MaterialSvc::MakeArchive() // static
+{
+    int num_row = RECORD_ROWS.size()/2 ; 
+    NP* a = NP::Make<double>( num_row, 2 ); 
+    double* aa = a->values<double>() ; 
+    for(unsigned i=0 ; i < RECORD_ROWS.size() ; i++) aa[i] = RECORD_ROWS[i] ; 
+    a->names = RECORD_NAMES ; 
+    a->set_meta<std::string>("digest", SourceDigest(RECORD_NAMES) ); 
+    return a ; 
+}
+
+/**
+MaterialSvc::SourceDigest
+---------------------------
+
+FNV-1a hex digest of the paths and bytes of the text files of the *params*, 
+with missing files contributing only their path. 
+
+**/
+
+std::string MaterialSvc::SourceDigest(const std::vector<std::string>& params) // static
+{
+    uint64_t h = 0xcbf29ce484222325ull ; 
+    auto add = [&h](const char* p, size_t n){ for(size_t i=0 ; i < n ; i++) { h ^= (unsigned char)p[i] ; h *= 0x100000001b3ull ; } } ; 
+
+    for(unsigned i=0 ; i < params.size() ; i++)
+    {
+        const char* path = GetPath( params[i].c_str() ); 
+        add( path, strlen(path) + 1 ); 
+        utils_detail::MappedFile mf(path); 
+        if( mf.data ) add( mf.data, mf.size ); 
+        add( mf.good() ? "+" : "-", 1 ); 
+        free((void*)path); 
+    }
+
+    std::stringstream ss ; 
+    ss << std::hex << std::setw(16) << std::setfill('0') << h ; 
+    std::string s = ss.str(); 
+    return s ; 
+}
+
+/**
+MaterialSvc::SaveArchive
+--------------------------
+
+Saves the recorded properties when envvar MaterialSvc_ARCHIVE is set 
+and the archive was not loaded. 
+
+**/
+
+bool MaterialSvc::SaveArchive() // static
+{
+    const char* dir = getenv(ARCHIVE_KEY) ; 
+    if( dir == nullptr || ARCHIVE_STATE == 1 || RECORD_NAMES.size() == 0 ) return false ; 
+    NP* a = MakeArchive(); 
+    a->save(dir, ARCHIVE_NAME); 
+    std::cout << "MaterialSvc::SaveArchive " << dir << "/" << ARCHIVE_NAME << " " << a->sstr() << " num_prop " << RECORD_NAMES.size() << std::endl ; 
+    return true ; 
+}
+
+void MaterialSvc::ClearArchive() // static
+{
+    ARCHIVE_STATE = -1 ; 
+    ARCHIVE = nullptr ; 
+    INDEX.clear(); 
+    RECORD_NAMES.clear(); 
+    RECORD_ROWS.clear(); 
+}
+
+std::string MaterialSvc::DescArchive() // static
+{
+    std::stringstream ss ; 
+    ss << "MaterialSvc::DescArchive"
+       << " " << ARCHIVE_KEY << " " << ( getenv(ARCHIVE_KEY) ? getenv(ARCHIVE_KEY) : "-" )
+       << " state " << ARCHIVE_STATE 
+       << " archive " << ( ARCHIVE ? ARCHIVE->sstr() : "-" )
+       << " index " << INDEX.size()
+       << " recorded " << RECORD_NAMES.size()
+       ;
+    std::string s = ss.str(); 
+    return s ; 
+}
+
+
 
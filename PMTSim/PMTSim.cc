@@ -4,6 +4,8 @@
 #include <iostream>
 #include <iomanip>
 #include <array>
+#include <chrono>
+#include <functional>
 
 #include "NP.hh"
 #include "ssys.h"
@@ -49,6 +51,13 @@
 #include "DetectorConstruction.hh"
 #include "PMTSim.hh"
 #include "ZSolid.h"
+#include "ZCut.h"
+#include "ZSolidRegistry.h"
+#include "ZSolidCache.h"
+#include "LVGrid.h"
+#include "InitScheduler.h"
+#include "SpanTree.h"
+#include "IGeomManager.h"
 #include "SVolume.h"
 
 
@@ -228,6 +237,30 @@ Example names::
 When the name is of form "maker_body_solid_zcut-183.2246" with cut 
 value at the end of the name it is extracted.
 
+When the PMTSim_CUT envvar holds a ZCut specification such as 
+"zplane:-183.2246" or "box:0,0,0,300,300,200" the generalized 
+cut ZSolid::ApplyCutTree is applied. 
+
+When the name contains "rebalance" the solid (after any zcut) is 
+replaced with a height reduced equivalent using ZSolid::Rebalance.
+Rebalance does not handle rotations, so it is skipped with an error 
+message after a PMTSim_CUT that is not axis aligned, as those cuts 
+intersect with rotated boxes. 
+
+When PMTSim_CACHE is defined the final solid (after any zcut, cut and rebalance) 
+is loaded from the ZSolidCache directory when an entry for the name and current 
+geometry options exists, otherwise it is built with BuildSolid and saved there. 
+Note that cache loads skip the manager construction, so manager values 
+are not available for solids loaded from the cache.  
+
+When PMTSim_DEDUPE is defined the solid is interned into the process wide 
+ZSolidRegistry so structurally identical subtrees are shared between 
+the solids from all managers. Interning is copy on write, so the solids 
+held by the managers and by ZSolidCache are not changed.  
+
+Solids are cached in SOLIDS keyed by CacheKey, so repeated requests 
+for the same name and options return the same solid. 
+
 **/
 
 G4VSolid* PMTSim::GetSolid(const char* name) // static
@@ -236,6 +269,47 @@ G4VSolid* PMTSim::GetSolid(const char* name) // static
 
     PMTSim::SetEnvironmentSwitches(name);  
 
+    std::lock_guard<std::recursive_mutex> lock(CACHE_MTX); 
+    std::string key = CacheKey(name) ; 
+    std::map<std::string, G4VSolid*>::const_iterator it = SOLIDS.find(key) ; 
+    if( it != SOLIDS.end() )
+    {
+        NUM_HIT += 1 ; 
+        return it->second ; 
+    }
+    NUM_MISS += 1 ; 
+
+    G4VSolid* solid = ZSolidCache::Load(name) ; 
+    if( solid == nullptr )
+    {
+        typedef std::chrono::high_resolution_clock Clock ; 
+        Clock::time_point t0 = Clock::now(); 
+        solid = BuildSolid(name); 
+        Clock::time_point t1 = Clock::now(); 
+        ZSolidCache::Save(name, solid, std::chrono::duration<double>(t1 - t0).count() ); 
+    }
+
+    if( solid != nullptr && getenv("PMTSim_DEDUPE") != nullptr )
+    {
+        solid = ZSolidRegistry::Get()->intern(solid) ; 
+        if(LEVEL > 0) std::cout << ZSolidRegistry::Get()->desc() ; 
+    }
+
+    if( solid != nullptr ) SOLIDS[key] = solid ; 
+    return solid ; 
+}
+
+/**
+PMTSim::BuildSolid
+--------------------
+
+Builds the solid and applies any zcut, PMTSim_CUT and rebalance 
+as described for GetSolid.
+
+**/
+
+G4VSolid* PMTSim::BuildSolid(const char* name) // static
+{
     G4VSolid* solid = GetSolid_(name); 
 
     if( solid == nullptr )
@@ -264,6 +338,35 @@ G4VSolid* PMTSim::GetSolid(const char* name) // static
         solid = zcut_solid ; 
     }
 
+    const char* cutspec = ssys::getenvvar("PMTSim_CUT") ; 
+    ZCut cut ; 
+    bool rotated_cut = false ; 
+    if( solid != nullptr && ZCut::Parse(cut, cutspec) )
+    {
+        G4VSolid* cut_solid = ZSolid::ApplyCutTree(solid, cut); 
+        if(cut_solid) solid = cut_solid ; 
+        rotated_cut = cut_solid != nullptr && !cut.is_aligned() ; 
+    }
+
+    if( solid != nullptr && Contains(name, "rebalance") )
+    {
+        if( rotated_cut )
+        {
+            std::cerr 
+                << "PMTSim::BuildSolid"
+                << " ERROR : rebalance SKIPPED for name " << name 
+                << " as the PMTSim_CUT " << cutspec << " is not axis aligned " 
+                << " and ZSolid::Rebalance does not handle the rotated cut boxes " 
+                << std::endl 
+                ;
+        }
+        else
+        {
+            G4VSolid* rebal_solid = ZSolid::Rebalance(solid); 
+            solid = rebal_solid ; 
+        }
+    }
+
     return solid ; 
 }
 
@@ -593,8 +696,8 @@ NP*         PMTSim::GetLastManagerSolidValues(){ return LastManagerSolidValues ;
 
 G4VSolid* PMTSim::GetManagerSolid(const char* name) // static
 {
-    if(LEVEL > 0) std::cout << "[ PMTSim::GetManagerSolid " << name << " instanciate PMTSim " << std::endl ;      
-    PMTSim* ps = new PMTSim ; 
+    if(LEVEL > 0) std::cout << "[ PMTSim::GetManagerSolid " << name << " get PMTSim " << std::endl ;      
+    PMTSim* ps = Get() ; 
     if(LEVEL > 0) std::cout << "[ PMTSim::GetManagerSolid PMTSim::getSolid " << name << std::endl ;      
     G4VSolid* solid = ps->getSolid(name); 
     NP* values = ps->getValues(name) ; 
@@ -622,7 +725,7 @@ NP* PMTSim::GetManagerValues(const char* name) // static
     }
     else
     {
-        PMTSim* ps = new PMTSim ; 
+        PMTSim* ps = Get() ; 
         vv = ps->getValues(name) ; 
     }
     return vv ; 
@@ -632,7 +735,7 @@ std::string PMTSim::Desc(const char* name) // static
 {
     std::cout << "[ PMTSim::Desc [" << name << "]" << std::endl ; 
     PMTSim::SetEnvironmentSwitches(name);  
-    PMTSim* ps = new PMTSim ; 
+    PMTSim* ps = Get() ; 
     std::string msg = ps->desc(name); 
     std::cout << "] PMTSim::Desc [" << name << "]" << std::endl ; 
     return msg ; 
@@ -641,18 +744,25 @@ G4LogicalVolume* PMTSim::GetLV(const char* name) // static
 {
     std::cout << "[ PMTSim::GetLV [" << name << "]" << std::endl ; 
     PMTSim::SetEnvironmentSwitches(name);  
-    PMTSim* ps = new PMTSim ; 
-    G4LogicalVolume* lv = ps->getLV(name); 
+
+    std::lock_guard<std::recursive_mutex> lock(CACHE_MTX); 
+    std::string key = CacheKey(name) ; 
+    G4LogicalVolume* lv = LVS.count(key) == 1 ? LVS[key] : nullptr ; 
+    NUM_HIT += int(lv != nullptr) ; 
+    if( lv == nullptr )
+    {
+        NUM_MISS += 1 ; 
+        PMTSim* ps = Get() ; 
+        lv = ps->getLV(name); 
+        if(lv) LVS[key] = lv ; 
+    }
     std::cout << "] PMTSim::GetLV [" << name << "]" << " lv " << ( lv ? "Y" : "N" ) << std::endl ; 
     return lv ; 
 }
 
 G4VPhysicalVolume* PMTSim::GetPV(const char* name) // static
 {
-    PMTSim::SetEnvironmentSwitches(name);  
-    PMTSim* ps = new PMTSim ; 
-    G4VPhysicalVolume* pv = ps->getPV(name); 
-    SVolume::Traverse(pv, nullptr, nullptr); 
+    G4VPhysicalVolume* pv = GetPV(name, nullptr, nullptr); 
     //DumpSolids(); 
     return pv ; 
 }
@@ -672,8 +782,17 @@ G4VPhysicalVolume* PMTSim::GetPV(const char* name, std::vector<double>* tr, std:
     if(LEVEL > 0 ) std::cout << "PMTSim::GetPV with transforms : name [" << ( name ? name : "-" ) << "]" << std::endl ; 
     PMTSim::SetEnvironmentSwitches(name);  
 
-    PMTSim* ps = new PMTSim ; 
-    G4VPhysicalVolume* pv = ps->getPV(name); 
+    std::lock_guard<std::recursive_mutex> lock(CACHE_MTX); 
+    std::string key = CacheKey(name) ; 
+    G4VPhysicalVolume* pv = PVS.count(key) == 1 ? PVS[key] : nullptr ; 
+    NUM_HIT += int(pv != nullptr) ; 
+    if( pv == nullptr )
+    {
+        NUM_MISS += 1 ; 
+        PMTSim* ps = Get() ; 
+        pv = ps->getPV(name); 
+        if(pv) PVS[key] = pv ; 
+    }
 
     if(pv == nullptr)
     {
@@ -688,6 +807,117 @@ G4VPhysicalVolume* PMTSim::GetPV(const char* name, std::vector<double>* tr, std:
 }
 
 
+std::recursive_mutex                       PMTSim::CACHE_MTX ; 
+std::map<std::string, PMTSim*>             PMTSim::INSTANCES = {} ; 
+std::map<std::string, G4VSolid*>           PMTSim::SOLIDS = {} ; 
+std::map<std::string, G4LogicalVolume*>    PMTSim::LVS = {} ; 
+std::map<std::string, G4VPhysicalVolume*>  PMTSim::PVS = {} ; 
+int PMTSim::NUM_HIT = 0 ; 
+int PMTSim::NUM_MISS = 0 ; 
+
+/**
+PMTSim::OptionsKey
+--------------------
+
+Digest of the geometry options in the environment selected by IGeomOptions::Key : 
+the JUNO_PMT20INCH switches set from the name by SetEnvironmentSwitches 
+and the manager property envvars "objName_key" such as hama_SimplificationLevel 
+or lchi_Reflectivity. PMTFastSim::OptionsKey and ZSolidCache use the same selection. 
+
+**/
+
+std::string PMTSim::OptionsKey() // static
+{
+    return ZSolidCache::OptionsKey("") ; 
+}
+
+std::string PMTSim::CacheKey(const char* name) // static
+{
+    return ZSolidCache::OptionsKey(name) ; 
+}
+
+/**
+PMTSim::Get
+-------------
+
+Returns the PMTSim instance for the current options, constructing it 
+(and all the managers) the first time the options are seen. 
+The IGeomManager ctor syncs the IGeomOptions snapshot used by declProp 
+with the environment, see IGeomOptions::Sync 
+
+**/
+
+PMTSim* PMTSim::Get() // static
+{
+    std::lock_guard<std::recursive_mutex> lock(CACHE_MTX); 
+    std::string key = OptionsKey() ; 
+    std::map<std::string, PMTSim*>::const_iterator it = INSTANCES.find(key) ; 
+    if( it != INSTANCES.end() ) return it->second ; 
+
+    PMTSim* ps = new PMTSim ; 
+    INSTANCES[key] = ps ; 
+    return ps ; 
+}
+
+/**
+PMTSim::ClearCache
+--------------------
+
+Forgets all cached instances and geometry objects, so subsequent 
+requests construct new ones. The forgotten objects are not deleted 
+as they remain referenced from the Geant4 stores and possibly by callers. 
+
+**/
+
+void PMTSim::ClearCache() // static
+{
+    std::lock_guard<std::recursive_mutex> lock(CACHE_MTX); 
+    INSTANCES.clear(); 
+    SOLIDS.clear(); 
+    LVS.clear(); 
+    PVS.clear(); 
+    NUM_HIT = 0 ; 
+    NUM_MISS = 0 ; 
+    LastManagerSolidName = nullptr ; 
+    LastManagerSolidValues = nullptr ; 
+}
+
+std::string PMTSim::DescCache() // static
+{
+    std::lock_guard<std::recursive_mutex> lock(CACHE_MTX); 
+    std::stringstream ss ; 
+    ss << "PMTSim::DescCache"
+       << " instances " << INSTANCES.size()
+       << " solids " << SOLIDS.size()
+       << " lvs " << LVS.size()
+       << " pvs " << PVS.size()
+       << " hit " << NUM_HIT 
+       << " miss " << NUM_MISS 
+       << std::endl 
+       ;
+    for(std::map<std::string, PMTSim*>::const_iterator it=INSTANCES.begin() ; it != INSTANCES.end() ; it++) ss << it->second->descTiming() ; 
+    std::string s = ss.str(); 
+    return s ; 
+}
+
+std::string PMTSim::descTiming() const 
+{
+    std::stringstream ss ; 
+    double total = 0. ; 
+    ss << "PMTSim::descTiming" << std::endl ; 
+    for(unsigned i=0 ; i < m_timing.size() ; i++) 
+    {
+        ss << std::setw(10) << m_timing[i].first 
+           << " " << std::fixed << std::setw(10) << std::setprecision(4) << m_timing[i].second 
+           << std::endl 
+           ; 
+        total += m_timing[i].second ; 
+    }
+    ss << std::setw(10) << "TOTAL" << " " << std::fixed << std::setw(10) << std::setprecision(4) << total << std::endl ; 
+    std::string s = ss.str(); 
+    return s ; 
+}
+
 PMTSim::PMTSim()
     :
     verbose(getenv("VERBOSE")!=nullptr),
@@ -729,65 +959,70 @@ Instanciates residents with cout+cerr redirected to avoid the noise
 1. m_dc(DetectorConstruction)
 2. m_hama(HamamatsuR12860PMTManager)
 3. m_nnvt(NNVTMCPPMTManager)
+...
+
+The residents are constructed by InitScheduler in the calling thread. 
+getLV writes to the G4 stores and the ctors write to std::cout from 
+IGeomManager::declProp, which is redirected to a std::stringstream 
+while the tasks run, so none of them can be run concurrently. 
+The dependencies of each getLV on the DetectorConstruction and its 
+manager ctor are recorded, so the timeline reports the critical path : 
+the startup time that concurrent construction could reach. 
+The task times are recorded in m_timing.
+SpanTree spans cover each task, see SpanTree.h for saving them. 
+As PMTSim::Get caches instances this happens once for each set of options. 
 
 **/
 
 void PMTSim::init()
 {
+    SpanTree::Span span("PMTSim::init") ; 
+    InitScheduler sched ; 
+    typedef std::function<void()> Fn ; 
+
+    auto manager = [&](const char* label, int dc, Fn ctor, Fn lv)
+    {
+        std::string ctor_label = std::string(label) + ".ctor" ; 
+        int c = sched.add( ctor_label.c_str(), [=](){ SpanTree::Span sp(ctor_label.c_str()) ; ctor() ; } ); 
+        sched.add( label, [=](){ SpanTree::Span sp(label) ; lv() ; }, {dc, c} ); 
+    }; 
+
+    int dc = sched.add( "dc", [&](){ SpanTree::Span sp("dc") ; m_dc = new DetectorConstruction ; } ); 
+
+    manager( "hama", dc, [&](){ m_hama = new HamamatsuR12860PMTManager(HAMA) ; },     [&](){ m_hama->getLV() ; } ); 
+    manager( "nnvt", dc, [&](){ m_nnvt = new NNVTMCPPMTManager(NNVT) ; },             [&](){ m_nnvt->getLV() ; } ); 
+    manager( "hmsk", dc, [&](){ m_hmsk = new HamamatsuMaskManager(HMSK_STR) ; },      [&](){ m_hmsk->getLV() ; } ); 
+    manager( "nmsk", dc, [&](){ m_nmsk = new NNVTMaskManager(NMSK_STR) ; },           [&](){ m_nmsk->getLV() ; } ); 
+    manager( "lchi", dc, [&](){ m_lchi = new LowerChimney(LCHI_STR) ; },              [&](){ m_lchi->getLV() ; } ); 
+    manager( "tub3", dc, [&](){ m_tub3 = new Tub3inchPMTV3Manager(TUB3_STR) ; },      [&](){ m_tub3->getLV() ; } ); 
+    manager( "xjac", dc, [&](){ m_xjac = new XJanchorConstruction(XJAC_STR) ; },      [&](){ m_xjac->getLV() ; } ); 
+    manager( "xjfc", dc, [&](){ m_xjfc = new XJfixtureConstruction(XJFC_STR) ; },     [&](){ m_xjfc->getLV() ; } ); 
+    manager( "sjcl", dc, [&](){ m_sjcl = new SJCLSanchorConstruction(SJCL_STR) ; },   [&](){ m_sjcl->getLV() ; } ); 
+    manager( "sjfx", dc, [&](){ m_sjfx = new SJFixtureConstruction(SJFX_STR) ; },     [&](){ m_sjfx->getLV() ; } ); 
+    manager( "sjrc", dc, [&](){ m_sjrc = new SJReceiverConstruction(SJRC_STR) ; },    [&](){ m_sjrc->getLV() ; } ); 
+    manager( "sjrf", dc, [&](){ m_sjrf = new SJReceiverFasternConstruction(SJRF_STR) ; }, [&](){ m_sjrf->getLV() ; } ); 
+    manager( "facr", dc, [&](){ m_facr = new FastenerAcrylicConstruction(FACR_STR) ; },   [&](){ m_facr->getLV() ; } ); 
+
     std::stringstream coutbuf;
     std::stringstream cerrbuf;
     {   
         cout_redirect out_(coutbuf.rdbuf());
         cerr_redirect err_(cerrbuf.rdbuf());
-    
-        m_dc = new DetectorConstruction ; 
-
-        m_hama = new HamamatsuR12860PMTManager(HAMA) ; 
-        m_hama->getLV(); 
-
-        m_nnvt = new NNVTMCPPMTManager(NNVT) ; 
-        m_nnvt->getLV() ; 
-
-        m_hmsk = new HamamatsuMaskManager(HMSK_STR); 
-        m_hmsk->getLV(); 
-
-        m_nmsk = new NNVTMaskManager(NMSK_STR) ;   
-        m_nmsk->getLV(); 
 
-        m_lchi = new LowerChimney(LCHI_STR) ;   
-        m_lchi->getLV(); 
-
-        m_tub3 = new Tub3inchPMTV3Manager(TUB3_STR) ;   
-        m_tub3->getLV(); 
-
-        m_xjac = new XJanchorConstruction(XJAC_STR) ; 
-        m_xjac->getLV(); 
-
-        m_xjfc = new XJfixtureConstruction(XJFC_STR) ; 
-        m_xjfc->getLV() ; 
-
-        m_sjcl = new SJCLSanchorConstruction(SJCL_STR) ; 
-        m_sjcl->getLV(); 
-
-        m_sjfx = new SJFixtureConstruction(SJFX_STR) ; 
-        m_sjfx->getLV(); 
-
-        m_sjrc = new SJReceiverConstruction(SJRC_STR) ;
-        m_sjrc->getLV(); 
-
-        m_sjrf = new SJReceiverFasternConstruction(SJRF_STR) ; 
-        m_sjrf->getLV(); 
-
-        m_facr = new FastenerAcrylicConstruction(FACR_STR) ; 
-        m_facr->getLV(); 
+        sched.run(); 
 
         // TO SEE OUTPUT IF THE ABOVE WITHOUT SETTING VERBOSE : MOVE OUTSIDE THIS CAPTURE BLOCK
         // dtors of the redirect structs reset back to standard cout/cerr streams  
     }    
 
+    for(unsigned i=0 ; i < sched.tasks.size() ; i++) m_timing.push_back( std::make_pair( sched.tasks[i].name, sched.duration(i) )); 
+
     std::string out = coutbuf.str(); 
     std::string err = cerrbuf.str(); 
     std::cout << OutputMessage("PMTSim::init" , out, err, verbose ); 
+    std::cout << sched.timeline() ; 
+    SpanTree::SaveEnv(); 
+    IGeomOptions::SaveEnv(); 
 
     if(LEVEL > 0) std::cout 
         << "PMTSim::init"
@@ -1083,39 +1318,22 @@ const char* PMTSim::Name(const char* prefix, int ix, int iy, int iz, const char*
 
 /**
 PMTSim::WrapLVGrid
---------------------
-
-Places the argument lv multiple times in a grid of placements configured by nx ny nz
-that are placed within world_so/world_lv/world_pv
+------------------
 
-CAUTION: currently the grid scaling and dimensions of the world box 
-make unfounded assumptions regarding the size of the lv 
+Places the argument lv multiple times within a world volume using LVGrid, 
+which sizes the lattice and world box from the extent of the lv. 
+The LVGrid mode (placement/parameterised/replica) and layout (grid/sphere) 
+are configured by envvars, see LVGrid.h 
 
-The number of placements is (2*nx+1)*(2*ny+1)*(2*nz+1)
+With the default grid layout the number of copies is (2*nx+1)*(2*ny+1)*(2*nz+1)
 
 **/
 
 G4VPhysicalVolume* PMTSim::WrapLVGrid( G4LogicalVolume* lv, int nx, int ny, int nz  )
 {
-    std::cout << "PMTSim::WrapLVGrid " << nx << " " << ny << " " << nz << std::endl ; 
-
-    G4Material* vacuum = G4Material::GetMaterial("Vacuum"); 
-    int extent = std::max(std::max(nx, ny), nz); 
-    G4double sc = 500. ; 
-    G4double halfside = sc*extent*3. ; 
-    G4Box* world_so = new G4Box("World_so", halfside, halfside, halfside ); 
-    G4LogicalVolume* world_lv = new G4LogicalVolume(world_so,vacuum,"World_lv",0,0,0); 
-    G4VPhysicalVolume* world_pv = new G4PVPlacement(0,G4ThreeVector(),world_lv ,"World_pv",0,false,0);
-
-    for(int ix=-nx ; ix < nx+1 ; ix++)
-    for(int iy=-ny ; iy < ny+1 ; iy++)
-    for(int iz=-nz ; iz < nz+1 ; iz++)
-    {
-        const char* iname = Name("item", ix, iy, iz, "" );         
-        G4ThreeVector tla( sc*double(ix), sc*double(iy), sc*double(iz) ); 
-        G4VPhysicalVolume* pv_n = new G4PVPlacement(0, tla, lv ,iname,world_lv,false,0);
-        assert( pv_n ); 
-    }
+    std::unique_ptr<LVGrid> grid(LVGrid::FromEnv(lv, nx, ny, nz));   // parameterised mode keeps its own copy 
+    G4VPhysicalVolume* world_pv = grid->build(); 
+    std::cout << "PMTSim::WrapLVGrid " << grid->desc() << std::endl ; 
     return world_pv ; 
 }
 
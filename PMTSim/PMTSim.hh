@@ -3,6 +3,8 @@
 #include <vector>
 #include <string>
 #include <array>
+#include <map>
+#include <mutex>
 
 struct NP ; 
 class G4VSolid ; 
@@ -78,6 +80,24 @@ struct PMTSIM_API PMTSim
 
     const std::string FACR_STR ;  
 
+    // process wide cache : PMTSim instances keyed by options, geometry objects keyed by name and options 
+    static std::recursive_mutex                       CACHE_MTX ; 
+    static std::map<std::string, PMTSim*>             INSTANCES ; 
+    static std::map<std::string, G4VSolid*>           SOLIDS ; 
+    static std::map<std::string, G4LogicalVolume*>    LVS ; 
+    static std::map<std::string, G4VPhysicalVolume*>  PVS ; 
+    static int NUM_HIT ; 
+    static int NUM_MISS ; 
+
+    static std::string OptionsKey(); 
+    static std::string CacheKey(const char* name); 
+    static PMTSim*     Get(); 
+    static void        ClearCache(); 
+    static std::string DescCache(); 
+
+    std::vector<std::pair<std::string, double>> m_timing ;   // manager construction seconds 
+    std::string descTiming() const ; 
+
     static G4VSolid* GetSolid();  // arg from GEOM envvar  
     static G4VSolid* GetSolid(const char* name); 
     static NP*       GetValues(const char* name); 
@@ -89,6 +109,7 @@ struct PMTSIM_API PMTSim
 
 
 
+    static G4VSolid* BuildSolid(const char* name); 
     static G4VSolid* GetSolid_(const char* name); 
     static G4VSolid* GetDebugSolid(const char* name); 
     static G4VSolid* GetMakerSolid(const char* name); 
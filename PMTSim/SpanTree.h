@@ -0,0 +1,299 @@
+#pragma once
+/**
+SpanTree : lightweight nested scoped timers for startup instrumentation
+==========================================================================
+
+A SpanTree::Span records the wall time between its construction and destruction
+into the process wide SpanTree. Spans opened while another span of the same
+thread is open become its children, giving a tree per thread::
+
+    void HamamatsuR12860PMTManager::init_pmt()
+    {
+        SpanTree::Span span("hama.init_pmt") ;
+        ...
+    }
+
+Records are appended under a mutex so spans may be used from any thread,
+the nesting stack is thread local.
+
+*clear* starts a new generation. The stacks of all threads are tagged with the 
+generation they were filled in and are emptied at their next use, spans still 
+open from before the clear are not recorded when closed. So no stale index 
+can become a parent or be written to. 
+
+Exports
+    array()
+        NP array of shape (num_span, 6) with columns
+        t0, t1, dur (microseconds from first use), parent, depth, thread
+        and the span names in the NP names member
+
+    chrome_trace()
+        Chrome trace event JSON with "X" complete events, view
+        with chrome://tracing or https://ui.perfetto.dev
+
+    save(dir)
+        writes dir/SpanTree.npy and dir/SpanTree.json
+
+PMTSim::init and PMTFastSim::init call SpanTree::SaveEnv which saves when
+envvar SpanTree_DIR is set. Recording is disabled with SpanTree_DISABLE.
+
+NB PMTSim/SpanTree.h and PMTFastSim/SpanTree.h are the same, keep them in sync.
+
+**/
+
+#include <cstdlib>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "NP.hh"
+
+struct SpanTree
+{
+    typedef std::chrono::high_resolution_clock Clock ;
+
+    struct Rec
+    {
+        std::string name ;
+        int         parent ;
+        int         depth ;
+        int         thread ;
+        double      t0 ;      // microseconds from epoch
+        double      t1 ;
+    };
+
+    struct Span
+    {
+        int idx ;
+        int gen ;
+        Span(const char* name) ;
+        ~Span() ;
+    };
+
+    static constexpr const char* DIR_KEY = "SpanTree_DIR" ;
+    static SpanTree* Get();
+    static std::vector<int>& Stack();
+    static int& StackGeneration();
+    static void SaveEnv();
+
+    bool                         enabled ;
+    Clock::time_point            epoch ;
+    mutable std::mutex           mtx ;
+    std::vector<Rec>             recs ;
+    std::map<std::thread::id,int> threads ;
+    int                          generation ;   // incremented by clear
+
+    SpanTree();
+
+    std::vector<int>& stack_() ;
+    int  open(const char* name, int* gen=nullptr);
+    void close(int idx, int gen);
+    void clear();
+
+    NP*  array() const ;
+    std::string chrome_trace() const ;
+    std::string desc() const ;
+    void save(const char* dir) const ;
+};
+
+inline SpanTree* SpanTree::Get() // static
+{
+    static SpanTree* INSTANCE = new SpanTree ;   // never deleted, so usable from static dtors
+    return INSTANCE ;
+}
+
+inline std::vector<int>& SpanTree::Stack() // static
+{
+    static thread_local std::vector<int> stack ;
+    return stack ;
+}
+
+inline int& SpanTree::StackGeneration() // static
+{
+    static thread_local int gen = 0 ;
+    return gen ;
+}
+
+inline void SpanTree::SaveEnv() // static
+{
+    const char* dir = getenv(DIR_KEY) ;
+    if( dir ) Get()->save(dir) ;
+}
+
+inline SpanTree::SpanTree()
+    :
+    enabled(getenv("SpanTree_DISABLE") == nullptr),
+    epoch(Clock::now()),
+    generation(0)
+{
+}
+
+/**
+SpanTree::stack_
+------------------
+
+Returns the stack of the calling thread, emptied when filled before the last clear. 
+Call with mtx held. 
+
+**/
+
+inline std::vector<int>& SpanTree::stack_()
+{
+    std::vector<int>& stack = Stack() ;
+    int& gen = StackGeneration() ;
+    if( gen != generation )
+    {
+        stack.clear();
+        gen = generation ;
+    }
+    return stack ;
+}
+
+inline int SpanTree::open(const char* name, int* gen)
+{
+    if(!enabled) return -1 ;
+    double t0 = std::chrono::duration<double, std::micro>(Clock::now() - epoch).count() ;
+
+    std::lock_guard<std::mutex> lock(mtx);
+    std::vector<int>& stack = stack_() ;
+    if(gen) *gen = generation ;
+    std::thread::id tid = std::this_thread::get_id() ;
+    if( threads.count(tid) == 0 ) threads[tid] = int(threads.size()) ;
+
+    Rec r ;
+    r.name = name ;
+    r.parent = stack.empty() ? -1 : stack.back() ;
+    r.depth = int(stack.size()) ;
+    r.thread = threads[tid] ;
+    r.t0 = t0 ;
+    r.t1 = t0 ;
+
+    int idx = int(recs.size()) ;
+    recs.push_back(r);
+    stack.push_back(idx);
+    return idx ;
+}
+
+inline void SpanTree::close(int idx, int gen)
+{
+    if( idx < 0 ) return ;
+    double t1 = std::chrono::duration<double, std::micro>(Clock::now() - epoch).count() ;
+
+    std::lock_guard<std::mutex> lock(mtx);
+    if( gen != generation ) return ;   // opened before clear
+    std::vector<int>& stack = stack_() ;
+    if( !stack.empty() && stack.back() == idx ) stack.pop_back() ;
+    recs[idx].t1 = t1 ;
+}
+
+inline void SpanTree::clear()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    recs.clear();
+    generation += 1 ;
+}
+
+inline NP* SpanTree::array() const
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    int num = int(recs.size()) ;
+    NP* a = NP::Make<double>( num, 6 );
+    double* aa = a->values<double>() ;
+    for(int i=0 ; i < num ; i++)
+    {
+        const Rec& r = recs[i] ;
+        aa[i*6+0] = r.t0 ;
+        aa[i*6+1] = r.t1 ;
+        aa[i*6+2] = r.t1 - r.t0 ;
+        aa[i*6+3] = r.parent ;
+        aa[i*6+4] = r.depth ;
+        aa[i*6+5] = r.thread ;
+        a->names.push_back(r.name) ;
+    }
+    a->set_meta<std::string>("cols", "t0,t1,dur,parent,depth,thread") ;
+    a->set_meta<std::string>("units", "microseconds") ;
+    return a ;
+}
+
+inline std::string SpanTree::chrome_trace() const
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    std::stringstream ss ;
+    ss << "{\"traceEvents\":[" << std::endl ;
+    for(unsigned i=0 ; i < recs.size() ; i++)
+    {
+        const Rec& r = recs[i] ;
+        std::string name ;
+        for(unsigned j=0 ; j < r.name.size() ; j++)
+        {
+            char c = r.name[j] ;
+            if( c == '"' || c == '\\' ) name += '\\' ;
+            name += c ;
+        }
+        ss << "{\"name\":\"" << name << "\",\"ph\":\"X\""
+           << ",\"ts\":" << std::fixed << std::setprecision(3) << r.t0
+           << ",\"dur\":" << std::fixed << std::setprecision(3) << ( r.t1 - r.t0 )
+           << ",\"pid\":0,\"tid\":" << r.thread
+           << ",\"args\":{\"depth\":" << r.depth << ",\"parent\":" << r.parent << "}}"
+           << ( i < recs.size() - 1 ? "," : "" )
+           << std::endl
+           ;
+    }
+    ss << "]}" << std::endl ;
+    std::string s = ss.str();
+    return s ;
+}
+
+inline std::string SpanTree::desc() const
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    std::stringstream ss ;
+    ss << "SpanTree::desc num_span " << recs.size() << " num_thread " << threads.size() << std::endl ;
+    for(unsigned i=0 ; i < recs.size() ; i++)
+    {
+        const Rec& r = recs[i] ;
+        ss << std::setw(2) << r.thread
+           << " " << std::fixed << std::setw(12) << std::setprecision(1) << ( r.t1 - r.t0 )
+           << " " << std::string(2*r.depth, ' ') << r.name
+           << std::endl
+           ;
+    }
+    std::string s = ss.str();
+    return s ;
+}
+
+inline void SpanTree::save(const char* dir) const
+{
+    NP* a = array() ;
+    a->save(dir, "SpanTree.npy") ;
+
+    std::stringstream ss ;
+    ss << dir << "/SpanTree.json" ;
+    std::string path = ss.str();
+    std::ofstream fp(path.c_str(), std::ios::out);
+    fp << chrome_trace() ;
+    fp.close();
+
+    std::cout << "SpanTree::save " << dir << " num_span " << a->shape[0] << std::endl ;
+}
+
+inline SpanTree::Span::Span(const char* name)
+    :
+    idx(-1),
+    gen(0)
+{
+    idx = SpanTree::Get()->open(name, &gen) ;
+}
+
+inline SpanTree::Span::~Span()
+{
+    SpanTree::Get()->close(idx, gen);
+}
+
@@ -0,0 +1,239 @@
+#pragma once
+
+/**
+ZCut : generalized cut specification used by ZSolid::ApplyCutTree
+====================================================================
+
+PLANE
+   keeps the half space where normal.dot(p) >= d, so ZCut::ZPlane(zcut)
+   keeps z >= zcut matching the ZSolid::ApplyZCutTree convention.
+   Normal and d are both divided by the length of the normal given,
+   so "plane:0,0,2,200" is the same cut as "plane:0,0,1,100"
+
+BOX
+   keeps the inside of a box with center, halfside and rotation
+   that takes box frame axes into the tree frame,
+   identity rotation for axis aligned boxes
+
+Classification of axis aligned bounding boxes uses the same
+values as ZSolid::INCLUDE/STRADDLE/EXCLUDE.
+
+Parse accepts specification strings such as::
+
+    zplane:-183.2246
+    plane:0,0.707,0.707,-100
+    box:0,0,0,300,300,200
+    obox:0,0,0,300,300,200,0,0,1,45      # last four : rotation axis and angle in degrees
+
+**/
+
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include <sstream>
+
+#include "G4ThreeVector.hh"
+#include "G4RotationMatrix.hh"
+
+struct ZCut
+{
+    enum { PLANE, BOX } ;
+    enum { INCLUDE=1<<0, STRADDLE=1<<1, EXCLUDE=1<<2 } ;  // same values as ZSolid enum
+
+    int              type ;
+    G4ThreeVector    normal ;
+    double           d ;
+    G4ThreeVector    center ;
+    G4ThreeVector    halfside ;
+    G4RotationMatrix rot ;
+
+    static ZCut ZPlane( double zcut );
+    static ZCut Plane( const G4ThreeVector& normal, double d );
+    static ZCut Box( const G4ThreeVector& center, const G4ThreeVector& halfside );
+    static ZCut OrientedBox( const G4ThreeVector& center, const G4ThreeVector& halfside, const G4RotationMatrix& rot );
+    static bool Parse( ZCut& cut, const char* spec );
+
+    ZCut();
+
+    bool is_aligned() const ;
+    bool is_zplane( double& zcut, bool& keep_above ) const ;
+    int  classify( const G4ThreeVector& mn, const G4ThreeVector& mx ) const ;
+    std::string desc() const ;
+};
+
+inline ZCut::ZCut()
+    :
+    type(PLANE),
+    normal(0.,0.,1.),
+    d(0.),
+    center(0.,0.,0.),
+    halfside(0.,0.,0.)
+{
+}
+
+inline ZCut ZCut::ZPlane( double zcut ) // static
+{
+    return Plane( G4ThreeVector(0.,0.,1.), zcut );
+}
+
+inline ZCut ZCut::Plane( const G4ThreeVector& normal, double d ) // static
+{
+    double mag = normal.mag() ;
+    bool expect = mag > 0. ;
+    assert( expect && "ZCut::Plane normal must be non-zero" );
+    if(!expect) exit(EXIT_FAILURE);
+
+    ZCut cut ;
+    cut.type = PLANE ;
+    cut.normal = normal/mag ;
+    cut.d = d/mag ;
+    return cut ;
+}
+
+inline ZCut ZCut::Box( const G4ThreeVector& center, const G4ThreeVector& halfside ) // static
+{
+    G4RotationMatrix rot ;
+    return OrientedBox(center, halfside, rot );
+}
+
+inline ZCut ZCut::OrientedBox( const G4ThreeVector& center, const G4ThreeVector& halfside, const G4RotationMatrix& rot ) // static
+{
+    ZCut cut ;
+    cut.type = BOX ;
+    cut.center = center ;
+    cut.halfside = halfside ;
+    cut.rot = rot ;
+    return cut ;
+}
+
+inline bool ZCut::Parse( ZCut& cut, const char* spec ) // static
+{
+    if(spec == nullptr) return false ;
+    double v[10] ;
+    bool ok = true ;
+    if(strncmp(spec, "zplane:", 7) == 0 && sscanf(spec+7, "%lf", v) == 1 )
+    {
+        cut = ZPlane(v[0]) ;
+    }
+    else if(strncmp(spec, "plane:", 6) == 0 && sscanf(spec+6, "%lf,%lf,%lf,%lf", v, v+1, v+2, v+3) == 4
+            && ( v[0] != 0. || v[1] != 0. || v[2] != 0. ) )
+    {
+        cut = Plane( G4ThreeVector(v[0],v[1],v[2]), v[3] ) ;
+    }
+    else if(strncmp(spec, "box:", 4) == 0 && sscanf(spec+4, "%lf,%lf,%lf,%lf,%lf,%lf", v, v+1, v+2, v+3, v+4, v+5 ) == 6 )
+    {
+        cut = Box( G4ThreeVector(v[0],v[1],v[2]), G4ThreeVector(v[3],v[4],v[5]) ) ;
+    }
+    else if(strncmp(spec, "obox:", 5) == 0 && sscanf(spec+5, "%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf", v, v+1, v+2, v+3, v+4, v+5, v+6, v+7, v+8, v+9 ) == 10 )
+    {
+        G4RotationMatrix rot ;
+        rot.rotate( v[9]*M_PI/180., G4ThreeVector(v[6],v[7],v[8]) );
+        cut = OrientedBox( G4ThreeVector(v[0],v[1],v[2]), G4ThreeVector(v[3],v[4],v[5]), rot ) ;
+    }
+    else
+    {
+        ok = false ;
+    }
+    return ok ;
+}
+
+inline bool ZCut::is_aligned() const
+{
+    if( type == BOX ) return rot.isIdentity() ;
+    int nzero = ( normal.x() == 0. ) + ( normal.y() == 0. ) + ( normal.z() == 0. ) ;
+    return nzero == 2 ;
+}
+
+/**
+ZCut::is_zplane
+-----------------
+
+Returns true for PLANE cuts with normal along +Z or -Z setting
+*zcut* and *keep_above* accordingly.
+
+**/
+
+inline bool ZCut::is_zplane( double& zcut, bool& keep_above ) const
+{
+    bool zplane = type == PLANE && normal.x() == 0. && normal.y() == 0. ;
+    if(zplane)
+    {
+        keep_above = normal.z() > 0. ;
+        zcut = keep_above ? d : -d ;
+    }
+    return zplane ;
+}
+
+/**
+ZCut::classify
+----------------
+
+Classifies the axis aligned box mn:mx (in the tree frame)
+against the cut. As the box encloses the solid EXCLUDE and INCLUDE
+are conservative : only given when all of the box is on one side.
+
+**/
+
+inline int ZCut::classify( const G4ThreeVector& mn, const G4ThreeVector& mx ) const
+{
+    int cls = STRADDLE ;
+    if( type == PLANE )
+    {
+        double lo = 0. ;
+        double hi = 0. ;
+        for(int i=0 ; i < 8 ; i++)
+        {
+            G4ThreeVector c( i & 1 ? mx.x() : mn.x(), i & 2 ? mx.y() : mn.y(), i & 4 ? mx.z() : mn.z() );
+            double nd = normal.dot(c) ;
+            if( i == 0 || nd < lo ) lo = nd ;
+            if( i == 0 || nd > hi ) hi = nd ;
+        }
+        if( lo >= d )      cls = INCLUDE ;
+        else if( hi <= d ) cls = EXCLUDE ;
+    }
+    else if( type == BOX )
+    {
+        // AABB of the corners in the box frame
+        G4RotationMatrix irot = rot.inverse() ;
+        G4ThreeVector bmn, bmx ;
+        for(int i=0 ; i < 8 ; i++)
+        {
+            G4ThreeVector c( i & 1 ? mx.x() : mn.x(), i & 2 ? mx.y() : mn.y(), i & 4 ? mx.z() : mn.z() );
+            G4ThreeVector q = irot*(c - center) ;
+            for(int j=0 ; j < 3 ; j++)
+            {
+                if( i == 0 || q[j] < bmn[j] ) bmn[j] = q[j] ;
+                if( i == 0 || q[j] > bmx[j] ) bmx[j] = q[j] ;
+            }
+        }
+        bool inside = true ;
+        bool disjoint = false ;
+        for(int j=0 ; j < 3 ; j++)
+        {
+            if( bmn[j] < -halfside[j] || bmx[j] > halfside[j] ) inside = false ;
+            if( bmn[j] >= halfside[j] || bmx[j] <= -halfside[j] ) disjoint = true ;
+        }
+        if( inside )        cls = INCLUDE ;
+        else if( disjoint ) cls = EXCLUDE ;
+    }
+    return cls ;
+}
+
+inline std::string ZCut::desc() const
+{
+    std::stringstream ss ;
+    if( type == PLANE )
+    {
+        ss << "ZCut::PLANE normal " << normal << " d " << d ;
+    }
+    else if( type == BOX )
+    {
+        ss << "ZCut::BOX center " << center << " halfside " << halfside << " aligned " << is_aligned() ;
+    }
+    std::string s = ss.str();
+    return s ;
+}
+
@@ -0,0 +1,530 @@
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <random>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+
+#include "G4VSolid.hh"
+#include "G4Box.hh"
+#include "G4Tubs.hh"
+#include "G4DisplacedSolid.hh"
+#include "G4AffineTransform.hh"
+#include "G4GeometryTolerance.hh"
+#include "G4ThreeVector.hh"
+
+#include "ZSolid.h"
+#include "ZProgram.h"
+
+const size_t ZProgram::BATCH = 1024 ; 
+const size_t ZProgram::CHUNK = 1 << 20 ; 
+
+ZProgram* ZProgram::Compile( const G4VSolid* root ) // static
+{
+    return new ZProgram(root) ; 
+}
+
+ZProgram::ZProgram( const G4VSolid* root_ )
+    :
+    root(root_),
+    max_stack(0),
+    num_serial(0)
+{
+    for(int op=0 ; op < 4 ; op++) MakeLUT( lut[op], op ); 
+
+    double identity[12] = { 1., 0., 0.,   0., 1., 0.,   0., 0., 1.,   0., 0., 0. } ; 
+    int sp = 0 ; 
+    compile_r( root, identity, 0, sp ); 
+    assert( sp == 1 ); 
+
+    if(ZSolid::verbose) std::cout << desc() ; 
+}
+
+/**
+ZProgram::compile_r
+---------------------
+
+Postorder traversal collecting codes and primitives. The transform *tr* 
+takes tree frame points into the frame of *node_*, any G4DisplacedSolid 
+transform of *node_* is composed on top. The G4AffineTransform is applied 
+to the origin and basis vectors to avoid depending on its storage conventions. 
+
+**/
+
+void ZProgram::compile_r( const G4VSolid* node_, const double* tr, int depth, int& sp )
+{
+    double ntr[12] ; 
+    const G4VSolid* node = node_ ; 
+    const G4DisplacedSolid* disp = dynamic_cast<const G4DisplacedSolid*>(node_) ; 
+    if( disp )
+    {
+        G4AffineTransform T = disp->GetTransform() ;   // parent frame to constituent frame 
+        G4ThreeVector t0 = T.TransformPoint( G4ThreeVector(0., 0., 0.) ); 
+        G4ThreeVector c[3] = { 
+             T.TransformPoint( G4ThreeVector(1., 0., 0.) ) - t0, 
+             T.TransformPoint( G4ThreeVector(0., 1., 0.) ) - t0, 
+             T.TransformPoint( G4ThreeVector(0., 0., 1.) ) - t0 
+          } ; 
+
+        for(int r=0 ; r < 3 ; r++)
+        {
+            for(int k=0 ; k < 3 ; k++) ntr[r*3+k] = c[0][r]*tr[0*3+k] + c[1][r]*tr[1*3+k] + c[2][r]*tr[2*3+k] ; 
+            ntr[9+r] = c[0][r]*tr[9] + c[1][r]*tr[10] + c[2][r]*tr[11] + t0[r] ; 
+        }
+        node = disp->GetConstituentMovedSolid() ; 
+    }
+    else
+    {
+        for(int i=0 ; i < 12 ; i++) ntr[i] = tr[i] ; 
+    }
+
+    if( ZSolid::Boolean(node) )
+    {
+        compile_r( ZSolid::Left(node),  ntr, depth+1, sp ); 
+        compile_r( ZSolid::Right(node), ntr, depth+1, sp ); 
+
+        int op = -1 ; 
+        switch(ZSolid::EntityType(node))
+        {
+            case ZSolid::_G4UnionSolid:        op = UNION        ; break ; 
+            case ZSolid::_G4IntersectionSolid: op = INTERSECTION ; break ; 
+            case ZSolid::_G4SubtractionSolid:  op = SUBTRACTION  ; break ; 
+        }
+        bool expect = op > -1 ; 
+        assert(expect); 
+        if(!expect) exit(EXIT_FAILURE); 
+
+        code.push_back(op); 
+        arg.push_back(-1); 
+        sp -= 1 ; 
+    }
+    else
+    {
+        Prim prim ; 
+        prim.solid = node ; 
+        prim.kind = KernelKind( node, prim.par ); 
+        prim.sidx = prim.kind == K_G4_SERIAL ? num_serial++ : -1 ; 
+        for(int i=0 ; i < 12 ; i++) prim.tr[i] = ntr[i] ; 
+
+        code.push_back(PRIM); 
+        arg.push_back(prims.size()); 
+        prims.push_back(prim); 
+        sp += 1 ; 
+        max_stack = std::max( max_stack, sp ); 
+    }
+}
+
+int ZProgram::KernelKind( const G4VSolid* prim, double* par ) // static
+{
+    G4GeometryTolerance* tol = G4GeometryTolerance::GetInstance() ; 
+    double halfCarTolerance = 0.5*tol->GetSurfaceTolerance() ; 
+    double halfRadTolerance = 0.5*tol->GetRadialTolerance() ; 
+    double halfAngTolerance = 0.5*tol->GetAngularTolerance() ; 
+
+    for(int i=0 ; i < 6 ; i++) par[i] = 0. ; 
+    int kind = K_G4 ; 
+    switch(ZSolid::EntityType(prim))
+    {
+        case ZSolid::_G4Box:
+        {
+            const G4Box* box = dynamic_cast<const G4Box*>(prim) ; 
+            kind = K_BOX ; 
+            par[0] = box->GetXHalfLength() ; 
+            par[1] = box->GetYHalfLength() ; 
+            par[2] = box->GetZHalfLength() ; 
+            par[3] = halfCarTolerance ; 
+        }
+        break ; 
+        case ZSolid::_G4Tubs:
+        {
+            const G4Tubs* tubs = dynamic_cast<const G4Tubs*>(prim) ; 
+            bool full_phi = tubs->GetDeltaPhiAngle() >= 2.*M_PI - halfAngTolerance ; 
+            kind = full_phi ? K_TUBS : K_G4 ; 
+            par[0] = tubs->GetInnerRadius() ; 
+            par[1] = tubs->GetOuterRadius() ; 
+            par[2] = tubs->GetZHalfLength() ; 
+            par[3] = halfCarTolerance ; 
+            par[4] = halfRadTolerance ; 
+        }
+        break ; 
+        case ZSolid::_G4Polycone:
+        case ZSolid::_G4Other:
+            kind = K_G4_SERIAL ; 
+        break ; 
+    }
+    return kind ; 
+}
+
+/**
+ZProgram::Combine
+-------------------
+
+Combination of constituent classifications following G4UnionSolid::Inside, 
+G4IntersectionSolid::Inside and G4SubtractionSolid::Inside. 
+Returns UNRESOLVED when G4 would compare surface normals or when an 
+UNRESOLVED input could change the result. 
+
+**/
+
+int ZProgram::Combine( int op, int a, int b ) // static
+{
+    int amin = a == UNRESOLVED ? OUTSIDE : a ; 
+    int amax = a == UNRESOLVED ? INSIDE  : a ; 
+    int bmin = b == UNRESOLVED ? OUTSIDE : b ; 
+    int bmax = b == UNRESOLVED ? INSIDE  : b ; 
+
+    int result = -1 ; 
+    for(int ia=amin ; ia <= amax ; ia++)
+    for(int ib=bmin ; ib <= bmax ; ib++)
+    {
+        int r = -1 ; 
+        switch(op)
+        {
+            case UNION:
+                if(      ia == INSIDE )  r = INSIDE ; 
+                else if( ia == OUTSIDE ) r = ib ; 
+                else if( ib == INSIDE )  r = INSIDE ; 
+                else if( ib == OUTSIDE ) r = SURFACE ; 
+                else                     r = UNRESOLVED ;   // both surface : normals decide kInside/kSurface
+                break ; 
+            case INTERSECTION:
+                if(      ia == OUTSIDE ) r = OUTSIDE ; 
+                else if( ia == INSIDE )  r = ib ; 
+                else if( ib == OUTSIDE ) r = OUTSIDE ; 
+                else                     r = SURFACE ; 
+                break ; 
+            case SUBTRACTION:
+                if(      ia == OUTSIDE ) r = OUTSIDE ; 
+                else if( ib == OUTSIDE ) r = ia ; 
+                else if( ib == INSIDE )  r = OUTSIDE ; 
+                else if( ia == INSIDE )  r = SURFACE ; 
+                else                     r = UNRESOLVED ;   // both surface : normals decide kOutside/kSurface
+                break ; 
+        }
+        if( result == -1 ) result = r ; 
+        else if( result != r ) result = UNRESOLVED ; 
+    }
+    return result ; 
+}
+
+void ZProgram::MakeLUT( unsigned char* lut, int op ) // static
+{
+    for(int a=0 ; a < 4 ; a++)
+    for(int b=0 ; b < 4 ; b++)
+    {
+        lut[a*4+b] = op == PRIM ? UNRESOLVED : Combine(op, a, b) ; 
+    }
+}
+
+/**
+ZProgram::Sample
+------------------
+
+Uniform random points within the bounding box of *solid* enlarged by *margin* fraction. 
+
+**/
+
+void ZProgram::Sample( std::vector<double>& xyz, const G4VSolid* solid, size_t num, unsigned seed, double margin ) // static
+{
+    G4ThreeVector mn, mx ; 
+    solid->BoundingLimits(mn, mx); 
+    G4ThreeVector mg = margin*(mx - mn) ; 
+    mn -= mg ; 
+    mx += mg ; 
+
+    std::mt19937 engine(seed) ; 
+    std::uniform_real_distribution<double> ux(mn.x(), mx.x()) ; 
+    std::uniform_real_distribution<double> uy(mn.y(), mx.y()) ; 
+    std::uniform_real_distribution<double> uz(mn.z(), mx.z()) ; 
+
+    xyz.resize(3*num); 
+    for(size_t i=0 ; i < num ; i++)
+    {
+        xyz[3*i+0] = ux(engine) ; 
+        xyz[3*i+1] = uy(engine) ; 
+        xyz[3*i+2] = uz(engine) ; 
+    }
+}
+
+/**
+ZProgram::classify
+--------------------
+
+Classifies *num* points with coordinates *xyz* writing EInside values into *out*.
+Points are processed in chunks of CHUNK : serial primitives are evaluated 
+for the chunk in the calling thread then BATCH sized pieces 
+of the chunk are evaluated by *nthread* threads (0: hardware concurrency). 
+
+**/
+
+void ZProgram::classify( unsigned char* out, const double* xyz, size_t num, int nthread ) const 
+{
+    if( nthread <= 0 ) nthread = std::max( 1u, std::thread::hardware_concurrency() ) ; 
+
+    std::vector<unsigned char> serial ; 
+
+    for(size_t c0=0 ; c0 < num ; c0 += CHUNK)
+    {
+        size_t n = std::min( CHUNK, num - c0 ) ; 
+        const double* cxyz = xyz + 3*c0 ; 
+        unsigned char* cout = out + c0 ; 
+
+        serial.resize( num_serial*n ); 
+        classify_serial_prims( serial.data(), cxyz, n ); 
+
+        size_t num_batch = (n + BATCH - 1)/BATCH ; 
+        std::atomic<size_t> next(0) ; 
+
+        auto worker = [&]()
+        {
+            Workspace ws ; 
+            size_t b ; 
+            while( (b = next++) < num_batch )
+            {
+                size_t i0 = b*BATCH ; 
+                size_t m = std::min( BATCH, n - i0 ) ; 
+                classify_batch( cout + i0, cxyz + 3*i0, m, serial.data() + i0, n, ws ); 
+            }
+        }; 
+
+        int num_thread = std::min( size_t(nthread), num_batch ) ; 
+        std::vector<std::thread> threads ; 
+        for(int t=1 ; t < num_thread ; t++) threads.push_back( std::thread(worker) ); 
+        worker(); 
+        for(unsigned t=0 ; t < threads.size() ; t++) threads[t].join(); 
+    }
+
+    size_t num_unresolved = resolve( out, xyz, num ); 
+
+    if(ZSolid::verbose) std::cout 
+        << "ZProgram::classify"
+        << " root " << root->GetName()
+        << " num " << num 
+        << " nthread " << nthread 
+        << " num_unresolved " << num_unresolved
+        << std::endl 
+        ;
+}
+
+void ZProgram::classify_serial_prims( unsigned char* serial, const double* xyz, size_t num ) const 
+{
+    Workspace ws ; 
+    for(unsigned p=0 ; p < prims.size() ; p++)
+    {
+        const Prim& prim = prims[p] ; 
+        if( prim.kind != K_G4_SERIAL ) continue ; 
+        for(size_t i0=0 ; i0 < num ; i0 += BATCH)
+        {
+            size_t m = std::min( BATCH, num - i0 ) ; 
+            prim_kernel( serial + prim.sidx*num + i0, prim, xyz + 3*i0, m, ws ); 
+        }
+    }
+}
+
+/**
+ZProgram::classify_batch
+--------------------------
+
+Stack machine evaluation of the postorder program for up to BATCH points. 
+Each stack entry is a column of classifications for all points of the batch. 
+
+**/
+
+void ZProgram::classify_batch( unsigned char* out, const double* xyz, size_t num, const unsigned char* serial, size_t serial_stride, Workspace& ws ) const 
+{
+    ws.stack.resize( max_stack*BATCH ); 
+    unsigned char* stack = ws.stack.data() ; 
+    int sp = 0 ; 
+
+    for(unsigned k=0 ; k < code.size() ; k++)
+    {
+        int op = code[k] ; 
+        if( op == PRIM )
+        {
+            const Prim& prim = prims[arg[k]] ; 
+            unsigned char* col = stack + sp*BATCH ; 
+            if( prim.kind == K_G4_SERIAL )
+            {
+                memcpy( col, serial + prim.sidx*serial_stride, num ); 
+            }
+            else
+            {
+                prim_kernel( col, prim, xyz, num, ws ); 
+            }
+            sp += 1 ; 
+        }
+        else
+        {
+            unsigned char* a = stack + (sp-2)*BATCH ; 
+            const unsigned char* b = stack + (sp-1)*BATCH ; 
+            const unsigned char* t = lut[op] ; 
+            for(size_t i=0 ; i < num ; i++) a[i] = t[a[i]*4 + b[i]] ; 
+            sp -= 1 ; 
+        }
+    }
+    assert( sp == 1 ); 
+    memcpy( out, stack, num ); 
+}
+
+/**
+ZProgram::prim_kernel
+-----------------------
+
+Transforms the points into the primitive frame then classifies them. 
+The K_BOX and K_TUBS kernels follow G4Box::Inside and the full phi 
+branch of G4Tubs::Inside. 
+
+**/
+
+void ZProgram::prim_kernel( unsigned char* col, const Prim& prim, const double* xyz, size_t num, Workspace& ws ) const 
+{
+    ws.lx.resize(BATCH); 
+    ws.ly.resize(BATCH); 
+    ws.lz.resize(BATCH); 
+    double* lx = ws.lx.data() ; 
+    double* ly = ws.ly.data() ; 
+    double* lz = ws.lz.data() ; 
+
+    const double* tr = prim.tr ; 
+    for(size_t i=0 ; i < num ; i++)
+    {
+        double x = xyz[3*i+0] ; 
+        double y = xyz[3*i+1] ; 
+        double z = xyz[3*i+2] ; 
+        lx[i] = tr[0]*x + tr[1]*y + tr[2]*z + tr[9] ; 
+        ly[i] = tr[3]*x + tr[4]*y + tr[5]*z + tr[10] ; 
+        lz[i] = tr[6]*x + tr[7]*y + tr[8]*z + tr[11] ; 
+    }
+
+    const double* par = prim.par ; 
+    switch(prim.kind)
+    {
+        case K_BOX:
+        {
+            double dx = par[0], dy = par[1], dz = par[2], delta = par[3] ; 
+            for(size_t i=0 ; i < num ; i++)
+            {
+                double dist = std::max( std::max( std::abs(lx[i]) - dx, std::abs(ly[i]) - dy ), std::abs(lz[i]) - dz ) ; 
+                col[i] = dist > delta ? OUTSIDE : ( dist > -delta ? SURFACE : INSIDE ) ; 
+            }
+        }
+        break ; 
+        case K_TUBS:
+        {
+            double rmin = par[0], rmax = par[1], dz = par[2], hct = par[3], hrt = par[4] ; 
+            double tmin = rmin > 0. ? rmin + hrt : 0. ; 
+            double tmax = rmax - hrt ; 
+            double gmin = std::max( rmin - hrt, 0. ) ; 
+            double gmax = rmax + hrt ; 
+            double tmin2 = tmin*tmin, tmax2 = tmax*tmax, gmin2 = gmin*gmin, gmax2 = gmax*gmax ; 
+            for(size_t i=0 ; i < num ; i++)
+            {
+                double az = std::abs(lz[i]) ; 
+                double r2 = lx[i]*lx[i] + ly[i]*ly[i] ; 
+                bool tight    = r2 >= tmin2 && r2 <= tmax2 ; 
+                bool generous = r2 >= gmin2 && r2 <= gmax2 ; 
+                unsigned char in_z  = tight ? INSIDE : ( generous ? SURFACE : OUTSIDE ) ; 
+                unsigned char on_z  = generous ? SURFACE : OUTSIDE ; 
+                col[i] = az <= dz - hct ? in_z : ( az <= dz + hct ? on_z : OUTSIDE ) ; 
+            }
+        }
+        break ; 
+        default:
+        {
+            const G4VSolid* solid = prim.solid ; 
+            for(size_t i=0 ; i < num ; i++) col[i] = solid->Inside( G4ThreeVector(lx[i], ly[i], lz[i]) ) ; 
+        }
+        break ; 
+    }
+}
+
+size_t ZProgram::resolve( unsigned char* out, const double* xyz, size_t num ) const 
+{
+    size_t count = 0 ; 
+    for(size_t i=0 ; i < num ; i++)
+    {
+        if( out[i] != UNRESOLVED ) continue ; 
+        out[i] = root->Inside( G4ThreeVector( xyz[3*i+0], xyz[3*i+1], xyz[3*i+2] ) ); 
+        count += 1 ; 
+    }
+    return count ; 
+}
+
+/**
+ZProgram::compare
+-------------------
+
+Returns the number of points for which *out* differs from the G4VSolid::Inside of the root.
+
+**/
+
+size_t ZProgram::compare( const unsigned char* out, const double* xyz, size_t num ) const 
+{
+    size_t mismatch = 0 ; 
+    for(size_t i=0 ; i < num ; i++)
+    {
+        EInside in = root->Inside( G4ThreeVector( xyz[3*i+0], xyz[3*i+1], xyz[3*i+2] ) ); 
+        if( int(in) != int(out[i]) ) mismatch += 1 ; 
+    }
+    return mismatch ; 
+}
+
+const char* ZProgram::OpName( int op ) // static
+{
+    const char* s = nullptr ; 
+    switch(op)
+    {
+        case PRIM:         s = "PRIM"         ; break ; 
+        case UNION:        s = "UNION"        ; break ; 
+        case INTERSECTION: s = "INTERSECTION" ; break ; 
+        case SUBTRACTION:  s = "SUBTRACTION"  ; break ; 
+    }
+    return s ; 
+}
+
+const char* ZProgram::KindName( int kind ) // static
+{
+    const char* s = nullptr ; 
+    switch(kind)
+    {
+        case K_G4:        s = "K_G4"        ; break ; 
+        case K_G4_SERIAL: s = "K_G4_SERIAL" ; break ; 
+        case K_BOX:       s = "K_BOX"       ; break ; 
+        case K_TUBS:      s = "K_TUBS"      ; break ; 
+    }
+    return s ; 
+}
+
+std::string ZProgram::desc() const 
+{
+    std::stringstream ss ; 
+    ss << "ZProgram::desc"
+       << " root " << root->GetName()
+       << " num_code " << code.size()
+       << " num_prim " << prims.size()
+       << " num_serial " << num_serial
+       << " max_stack " << max_stack
+       << std::endl 
+       ;
+    for(unsigned k=0 ; k < code.size() ; k++)
+    {
+        ss << std::setw(4) << k << " " << std::setw(12) << OpName(code[k]) ; 
+        if( code[k] == PRIM )
+        {
+            const Prim& prim = prims[arg[k]] ; 
+            ss << " " << std::setw(12) << KindName(prim.kind)
+               << " " << std::setw(30) << prim.solid->GetName()
+               << " t (" << prim.tr[9] << "," << prim.tr[10] << "," << prim.tr[11] << ")" 
+               ;
+        }
+        ss << std::endl ; 
+    }
+    std::string s = ss.str(); 
+    return s ; 
+}
+
@@ -0,0 +1,111 @@
+#pragma once
+/**
+ZProgram : flattened postorder CSG program compiled from a G4 boolean tree
+=============================================================================
+
+The tree is compiled into a postorder sequence of PRIM and operator codes
+with every primitive holding the full transform from the tree frame
+into its local frame. This allows point containment classification
+without recursing through G4BooleanSolid and G4DisplacedSolid.
+
+Points are classified in batches : each PRIM fills a column of
+classifications for all points of the batch onto a stack and each operator
+combines the top two columns with a lookup table.
+Primitive kernels and the combination loops are simple branch free loops
+over contiguous arrays, allowing the compiler to vectorize them.
+Batches are shared between threads.
+
+Kernels
+    G4Box and full phi G4Tubs have native kernels that replicate the
+    G4 Inside tolerance logic.
+
+    Other primitives call the G4VSolid::Inside of the primitive on
+    local frame points.  G4Polycone and unknown types are evaluated
+    serially in the calling thread before the threaded batches, as the
+    G4VCSGfaceted thread local sub-instance data is not available
+    on threads that are not G4 workers.
+
+Matching G4VSolid::Inside
+    The G4 boolean Inside result is determined by the constituent
+    results except when a point is on the surface of both constituents
+    of a union or subtraction, where the surface normals are compared.
+    Those points are marked UNRESOLVED during the batch evaluation and
+    are then classified with the G4VSolid::Inside of the root, so the
+    results match G4 exactly.
+
+Usage::
+
+    ZProgram* prog = ZProgram::Compile(solid) ;
+
+    std::vector<double> xyz ;
+    ZProgram::Sample(xyz, solid, 1000000 );
+    std::vector<unsigned char> cls(xyz.size()/3) ;
+    prog->classify( cls.data(), xyz.data(), cls.size() );
+
+**/
+
+class G4VSolid ;
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#ifdef PMTSIM_STANDALONE
+#include "PMTSIM_API_EXPORT.hh"
+struct PMTSIM_API ZProgram
+{
+#else
+struct ZProgram
+{
+#endif
+    enum { PRIM=0, UNION=1, INTERSECTION=2, SUBTRACTION=3 } ;
+    enum { K_G4=0, K_G4_SERIAL=1, K_BOX=2, K_TUBS=3 } ;
+    enum { OUTSIDE=0, SURFACE=1, INSIDE=2, UNRESOLVED=3 } ;  // first three match EInside
+
+    static const size_t BATCH ;
+    static const size_t CHUNK ;
+
+    struct Prim
+    {
+        int             kind ;
+        int             sidx ;     // index into serially evaluated columns, -1 when not K_G4_SERIAL
+        const G4VSolid* solid ;    // local frame solid, never a G4DisplacedSolid
+        double          tr[12] ;   // tree frame to local frame : 3x3 row major rotation then translation
+        double          par[6] ;   // kernel parameters
+    };
+
+    struct Workspace
+    {
+        std::vector<unsigned char> stack ;
+        std::vector<double>        lx, ly, lz ;
+    };
+
+    const G4VSolid*   root ;
+    std::vector<int>  code ;
+    std::vector<int>  arg ;
+    std::vector<Prim> prims ;
+    int               max_stack ;
+    int               num_serial ;
+    unsigned char     lut[4][16] ;
+
+    static ZProgram* Compile( const G4VSolid* root );
+    static int       KernelKind( const G4VSolid* prim, double* par );
+    static void      MakeLUT( unsigned char* lut, int op );
+    static int       Combine( int op, int a, int b );
+    static void      Sample( std::vector<double>& xyz, const G4VSolid* solid, size_t num, unsigned seed=0, double margin=0.1 );
+    static const char* OpName( int op );
+    static const char* KindName( int kind );
+
+    ZProgram( const G4VSolid* root );
+    void compile_r( const G4VSolid* node_, const double* tr, int depth, int& sp );
+
+    void   classify( unsigned char* out, const double* xyz, size_t num, int nthread=0 ) const ;
+    void   classify_serial_prims( unsigned char* serial, const double* xyz, size_t num ) const ;
+    void   classify_batch( unsigned char* out, const double* xyz, size_t num, const unsigned char* serial, size_t serial_stride, Workspace& ws ) const ;
+    void   prim_kernel( unsigned char* col, const Prim& prim, const double* xyz, size_t num, Workspace& ws ) const ;
+    size_t resolve( unsigned char* out, const double* xyz, size_t num ) const ;
+    size_t compare( const unsigned char* out, const double* xyz, size_t num ) const ;
+
+    std::string desc() const ;
+};
+
@@ -3,6 +3,12 @@
 #include <sstream>
 #include <iomanip>
 #include <cstdlib>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <mutex>
 
 #include "G4SolidStore.hh"
 #include "G4UnionSolid.hh"
@@ -12,16 +18,47 @@
 #include "G4Tubs.hh"
 #include "G4Polycone.hh"
 #include "G4Torus.hh"
+#include "G4Box.hh"
+#include "G4Cons.hh"
+#include "G4Sphere.hh"
 #include "G4RotationMatrix.hh"
+#include "G4Transform3D.hh"
+
+#ifdef G4MULTITHREADED
+#include "G4PolyconeSide.hh"
+#include "G4PolyhedraSide.hh"
+#endif
 
 #include "ZCanvas.h"
+#include "ZCut.h"
 #include "ZSolid.h"
+#include "SpanTree.h"
 
 
 const bool ZSolid::verbose = getenv("ZSolid_verbose") != nullptr ; 
 
+/**
+ZSolid::StoreMutex
+--------------------
+
+ZSolid instances keep all tree analysis state in their own maps and vectors, 
+so separate trees can be processed concurrently. The only shared mutable state 
+is within Geant4 : solid ctors and dtors register with the G4SolidStore and 
+the placement new replacements used to edit trees deregister from it. 
+All ZSolid methods that create, replace or deregister solids hold this 
+recursive mutex, allowing nested use. 
+
+**/
+
+std::recursive_mutex& ZSolid::StoreMutex() // static
+{
+    static std::recursive_mutex mtx ; 
+    return mtx ; 
+}
+
 G4VSolid* ZSolid::ApplyZCutTree( const G4VSolid* original, double zcut ) // static
 {
+    SpanTree::Span span("ZSolid::ApplyZCutTree") ; 
     if(verbose)
     std::cout << "[ ZSolid::ApplyZCutTree zcut " << zcut << " original.GetName " << original->GetName() << std::endl ; 
 
@@ -49,6 +86,92 @@ void ZSolid::Draw(const G4VSolid* original, const char* msg ) // static
 
 }
 
+/**
+ZSolid::InitWorkerThread
+--------------------------
+
+With multithreaded Geant4 the G4PolyconeSide and G4PolyhedraSide data 
+is split into thread local sub-instance arrays which are only setup 
+for G4 worker threads. Threads that construct or navigate polycones 
+must copy the sub-instance arrays first, as done by G4WorkerThread::BuildGeometryAndPhysicsVector.
+
+**/
+
+void ZSolid::InitWorkerThread() // static
+{
+#ifdef G4MULTITHREADED
+    std::lock_guard<std::recursive_mutex> lock(StoreMutex()); 
+    const_cast<G4PlSideManager&>(G4PolyconeSide::GetSubInstanceManager()).SlaveCopySubInstanceArray();
+    const_cast<G4PhSideManager&>(G4PolyhedraSide::GetSubInstanceManager()).SlaveCopySubInstanceArray();
+#endif
+}
+
+/**
+ZSolid::ApplyZCutTreeBatch
+----------------------------
+
+Runs ApplyZCutTree for each job using *nthread* threads (0: hardware concurrency)
+setting the result, the wall time and the thread index of each job. 
+Jobs are taken in order from a shared counter, so larger trees placed first 
+improve the load balance. 
+
+The tree analysis (classification, z ranges, pruning decisions) runs concurrently, 
+the solid creation and replacement steps are serialized by StoreMutex. 
+The *original* solids are only read, they may be shared between jobs. 
+
+**/
+
+void ZSolid::ApplyZCutTreeBatch( std::vector<Job>& jobs, int nthread ) // static
+{
+    if( nthread <= 0 ) nthread = std::max( 1u, std::thread::hardware_concurrency() ) ; 
+    int num_job = jobs.size() ; 
+    int num_thread = std::min( nthread, num_job ) ; 
+
+    std::atomic<int> next(0) ; 
+    auto worker = [&](int t)
+    {
+        if( t > 0 ) InitWorkerThread(); 
+        int j ; 
+        while( (j = next++) < num_job )
+        {
+            Job& job = jobs[j] ; 
+            std::chrono::time_point<std::chrono::high_resolution_clock> t0 = std::chrono::high_resolution_clock::now(); 
+            job.result = ApplyZCutTree( job.original, job.zcut ); 
+            std::chrono::time_point<std::chrono::high_resolution_clock> t1 = std::chrono::high_resolution_clock::now(); 
+            job.seconds = std::chrono::duration<double>(t1 - t0).count() ; 
+            job.thread = t ; 
+        }
+    }; 
+
+    std::vector<std::thread> threads ; 
+    for(int t=1 ; t < num_thread ; t++) threads.push_back( std::thread(worker, t) ); 
+    worker(0);  
+    for(unsigned t=0 ; t < threads.size() ; t++) threads[t].join(); 
+}
+
+std::string ZSolid::DescBatch( const std::vector<Job>& jobs ) // static
+{
+    std::stringstream ss ; 
+    ss << "ZSolid::DescBatch num_job " << jobs.size() << std::endl ; 
+    double total = 0. ; 
+    for(unsigned i=0 ; i < jobs.size() ; i++)
+    {
+        const Job& job = jobs[i] ; 
+        ss << std::setw(4) << i 
+           << " " << std::setw(30) << job.original->GetName()
+           << " zcut " << std::fixed << std::setw(10) << std::setprecision(4) << job.zcut 
+           << " thread " << std::setw(3) << job.thread 
+           << " seconds " << std::fixed << std::setw(10) << std::setprecision(6) << job.seconds 
+           << " result " << ( job.result ? job.result->GetName() : G4String("-") ) 
+           << std::endl 
+           ;
+        total += job.seconds ; 
+    }
+    ss << " sum of job seconds " << std::fixed << std::setw(10) << std::setprecision(6) << total << std::endl ; 
+    std::string s = ss.str(); 
+    return s ; 
+}
+
 ZSolid::ZSolid(const G4VSolid* original_ ) 
     :
     original(original_),
@@ -931,6 +1054,9 @@ const char* ZSolid::G4UnionSolid_         = "Uni" ;
 const char* ZSolid::G4SubtractionSolid_   = "Sub" ;
 const char* ZSolid::G4IntersectionSolid_  = "Int" ;
 const char* ZSolid::G4DisplacedSolid_     = "Dis" ;
+const char* ZSolid::G4Box_                = "Box" ;
+const char* ZSolid::G4Cons_               = "Con" ;
+const char* ZSolid::G4Sphere_             = "Sph" ;
 
 
 const char* ZSolid::DirtyEntityTag_( const G4VSolid* node )
@@ -957,6 +1083,10 @@ const char* ZSolid::EntityTag_( const G4VSolid* solid )
        case _G4SubtractionSolid:  s = G4SubtractionSolid_  ; break ; 
        case _G4IntersectionSolid: s = G4IntersectionSolid_ ; break ; 
        case _G4DisplacedSolid:    s = G4DisplacedSolid_    ; break ; 
+
+       case _G4Box:               s = G4Box_               ; break ; 
+       case _G4Cons:              s = G4Cons_              ; break ; 
+       case _G4Sphere:            s = G4Sphere_            ; break ; 
     }
     return s ; 
 }
@@ -979,6 +1109,10 @@ int ZSolid::EntityType(const G4VSolid* solid)   // static
     if( strcmp(name, "G4SubtractionSolid") == 0 )  type = _G4SubtractionSolid ; 
     if( strcmp(name, "G4IntersectionSolid") == 0 ) type = _G4IntersectionSolid ; 
     if( strcmp(name, "G4DisplacedSolid") == 0 )    type = _G4DisplacedSolid ; 
+
+    if( strcmp(name, "G4Box") == 0 )               type = _G4Box ; 
+    if( strcmp(name, "G4Cons") == 0 )              type = _G4Cons ; 
+    if( strcmp(name, "G4Sphere") == 0 )            type = _G4Sphere ; 
     return type ; 
 }
 
@@ -1435,6 +1569,7 @@ void ZSolid::collectNodes_r( std::vector<const G4VSolid*>& nodes, const G4VSolid
 
 void ZSolid::ApplyZCut( G4VSolid* node_, double local_zcut ) // static
 {
+    std::lock_guard<std::recursive_mutex> lock(StoreMutex()); 
     G4VSolid* node = Moved_(node_ ); 
     if(verbose) std::cout << "ZSolid::ApplyZCut " << EntityTypeName(node) << std::endl ; 
     switch(EntityType(node))
@@ -1804,6 +1939,7 @@ which appear to make properly independent copies
 
 G4VSolid* ZSolid::DeepClone( const  G4VSolid* solid )  // static 
 {
+    std::lock_guard<std::recursive_mutex> lock(StoreMutex()); 
     G4RotationMatrix* rot = nullptr ; 
     G4ThreeVector* tla = nullptr ; 
     int depth = 0 ; 
@@ -1875,38 +2011,29 @@ G4VSolid* ZSolid::BooleanClone( const  G4VSolid* solid, int depth, G4RotationMat
 {
     if(verbose) std::cout << "ZSolid::BooleanClone" << std::endl ; 
 
-    // HMM : rot and tla arguments were not used and they are not always null ... 
-    // that suggests there is a lack of generality here for booleans of booleans etc... 
-    // with translations that apply on top of translations. 
-    // However for JUNO PMTs are not expecting any rotations
-    // and are not expecting more than one level of translation. 
-
-    G4ThreeVector zero(0., 0., 0.); 
-    double epsilon = 1e-6 ; 
+    // The rot and tla arguments are not used here : they are set by the Moved 
+    // within the DeepClone_r of this node and are used by the BooleanClone 
+    // of the parent when it reconstructs its right hand side. 
+    // So booleans of booleans with translations that apply on top of translations 
+    // are handled, as needed to clone the trees created by ZSolid::Rebalance. 
+    // However for JUNO PMTs are not expecting any rotations. 
 
     bool expect_rot = rot == nullptr || rot->isIdentity() ;   
     if(!expect_rot) std::cout << "ZSolid::BooleanClone expect_rot ERROR " << std::endl ; 
     assert( expect_rot ); 
     if(!expect_rot) exit(EXIT_FAILURE); 
 
-    bool expect_tla = tla == nullptr || tla->isNear(zero, epsilon) ; 
-    if(!expect_tla) 
-    {
-        std::cout << "ZSolid::BooleanClone expect_tla ERROR (not expecting more than one level of translation) " << std::endl ; 
-        if(tla) std::cout 
-            << "ZSolid::BooleanClone" 
-            << " tla( " 
-            << tla->x() 
-            << " " 
-            << tla->y() 
-            << " " 
-            << tla->z() 
-            << ") " 
-            << std::endl
-            ; 
-    }
-    assert( expect_tla ); 
-    if(!expect_tla) exit(EXIT_FAILURE); 
+    if(verbose && tla) std::cout 
+        << "ZSolid::BooleanClone" 
+        << " tla( " 
+        << tla->x() 
+        << " " 
+        << tla->y() 
+        << " " 
+        << tla->z() 
+        << ") " 
+        << std::endl
+        ; 
 
     G4String name = solid->GetName() ; 
     G4RotationMatrix lrot, rrot ;  
@@ -2074,6 +2201,7 @@ The reason is that the transform ctor allocates, so will normally get a differen
 
 void ZSolid::PlacementNewDupe( G4VSolid* solid) // static
 {
+    std::lock_guard<std::recursive_mutex> lock(StoreMutex()); 
     G4BooleanSolid* src = dynamic_cast<G4BooleanSolid*>(solid) ; 
     assert( src ); 
 
@@ -2122,6 +2250,7 @@ to G4BooleanSolid ctors.
 
 void ZSolid::SetRight(  G4VSolid* node, G4VSolid* right, G4RotationMatrix* rrot, G4ThreeVector* rtla )
 {
+    std::lock_guard<std::recursive_mutex> lock(StoreMutex()); 
     assert( dynamic_cast<G4DisplacedSolid*>(node) == nullptr ) ; 
     assert( dynamic_cast<G4DisplacedSolid*>(right) == nullptr ) ; 
 
@@ -2162,6 +2291,7 @@ This is implemented using placement new trickery to replace the
 
 void ZSolid::SetLeft(  G4VSolid* node, G4VSolid* left)  // static 
 {
+    std::lock_guard<std::recursive_mutex> lock(StoreMutex()); 
     assert( dynamic_cast<G4DisplacedSolid*>(node) == nullptr ) ; 
     assert( dynamic_cast<G4DisplacedSolid*>(left) == nullptr ) ; 
 
@@ -2219,6 +2349,21 @@ G4VSolid* ZSolid::PrimitiveClone( const  G4VSolid* solid )  // static
         const G4Torus* torus = dynamic_cast<const G4Torus*>(solid) ; 
         clone = new G4Torus(*torus) ;  
     }
+    else if( type == _G4Box )
+    {
+        const G4Box* box = dynamic_cast<const G4Box*>(solid) ; 
+        clone = new G4Box(*box) ;  
+    }
+    else if( type == _G4Cons )
+    {
+        const G4Cons* cons = dynamic_cast<const G4Cons*>(solid) ; 
+        clone = new G4Cons(*cons) ;  
+    }
+    else if( type == _G4Sphere )
+    {
+        const G4Sphere* sphere = dynamic_cast<const G4Sphere*>(solid) ; 
+        clone = new G4Sphere(*sphere) ;  
+    }
     else
     {
         std::cout 
@@ -2279,7 +2424,8 @@ double ZSolid::getZ( const G4VSolid* node ) const
 bool ZSolid::CanZ( const G4VSolid* solid ) // static
 {
     int type = EntityType(solid) ; 
-    bool can = type == _G4Ellipsoid || type == _G4Tubs || type == _G4Polycone || type == _G4Torus ; 
+    bool can = type == _G4Ellipsoid || type == _G4Tubs || type == _G4Polycone || type == _G4Torus || 
+               type == _G4Box || type == _G4Cons || type == _G4Sphere ; 
     G4String name = solid->GetName(); 
 
     if( can == false && verbose )
@@ -2302,6 +2448,9 @@ void ZSolid::ZRange( double& z0, double& z1, const G4VSolid* solid) // static
         case _G4Tubs:      GetZRange( dynamic_cast<const G4Tubs*>(solid)    ,  z0, z1 );  break ; 
         case _G4Polycone:  GetZRange( dynamic_cast<const G4Polycone*>(solid),  z0, z1 );  break ; 
         case _G4Torus:     GetZRange( dynamic_cast<const G4Torus*>(solid),     z0, z1 );  break ; 
+        case _G4Box:       GetZRange( dynamic_cast<const G4Box*>(solid),       z0, z1 );  break ; 
+        case _G4Cons:      GetZRange( dynamic_cast<const G4Cons*>(solid),      z0, z1 );  break ; 
+        case _G4Sphere:    GetZRange( dynamic_cast<const G4Sphere*>(solid),    z0, z1 );  break ; 
         case _G4Other:    { std::cout << "ZSolid::GetZ FATAL : not implemented for entityType " << EntityTypeName(solid) << std::endl ; assert(0) ; } ; break ;  
     }
 }
@@ -2339,6 +2488,22 @@ void ZSolid::GetZRange( const G4Torus* const torus, double& _z0, double& _z1 )
     _z1 = rmax ; 
     _z0 = -rmax ;  
 }
+void ZSolid::GetZRange( const G4Box* const box, double& _z0, double& _z1 )  // static 
+{
+    _z1 = box->GetZHalfLength() ; 
+    _z0 = -_z1 ;  
+}
+void ZSolid::GetZRange( const G4Cons* const cons, double& _z0, double& _z1 )  // static 
+{
+    _z1 = cons->GetZHalfLength() ; 
+    _z0 = -_z1 ;  
+}
+void ZSolid::GetZRange( const G4Sphere* const sphere, double& _z0, double& _z1 )  // static 
+{
+    G4double rmax = sphere->GetOuterRadius() ; 
+    _z1 = rmax ; 
+    _z0 = -rmax ;  
+}
 
 
 
@@ -2465,3 +2630,1057 @@ Simpler way,  notice the top and bottom line equations, add or subtract and rear
 
 **/
 
+
+
+/**
+ZSolid::GetParams
+-------------------
+
+Collects the shape parameters of supported primitives into *par*, 
+for unsupported primitives *par* is left empty. 
+
+**/
+
+void ZSolid::GetParams( std::vector<double>& par, const G4VSolid* prim ) // static
+{
+    par.clear(); 
+    switch(EntityType(prim))
+    {
+        case _G4Ellipsoid:
+        {
+            const G4Ellipsoid* ellipsoid = dynamic_cast<const G4Ellipsoid*>(prim) ; 
+            par.push_back( ellipsoid->GetSemiAxisMax(0) ); 
+            par.push_back( ellipsoid->GetSemiAxisMax(1) ); 
+            par.push_back( ellipsoid->GetSemiAxisMax(2) ); 
+            par.push_back( ellipsoid->GetZBottomCut() ); 
+            par.push_back( ellipsoid->GetZTopCut() ); 
+        }
+        break ; 
+        case _G4Tubs:
+        {
+            const G4Tubs* tubs = dynamic_cast<const G4Tubs*>(prim) ; 
+            par.push_back( tubs->GetRMin() ); 
+            par.push_back( tubs->GetRMax() ); 
+            par.push_back( tubs->GetDz() ); 
+            par.push_back( tubs->GetSPhi() ); 
+            par.push_back( tubs->GetDPhi() ); 
+        }
+        break ; 
+        case _G4Polycone:
+        {
+            const G4Polycone* polycone = dynamic_cast<const G4Polycone*>(prim) ; 
+            G4PolyconeHistorical* pars = polycone->GetOriginalParameters(); 
+            int num_z = pars->Num_z_planes ; 
+            par.push_back( pars->Start_angle ); 
+            par.push_back( pars->Opening_angle ); 
+            par.push_back( num_z ); 
+            for(int i=0 ; i < num_z ; i++) par.push_back( pars->Z_values[i] ); 
+            for(int i=0 ; i < num_z ; i++) par.push_back( pars->Rmin[i] ); 
+            for(int i=0 ; i < num_z ; i++) par.push_back( pars->Rmax[i] ); 
+        }
+        break ; 
+        case _G4Torus:
+        {
+            const G4Torus* torus = dynamic_cast<const G4Torus*>(prim) ; 
+            par.push_back( torus->GetRmin() ); 
+            par.push_back( torus->GetRmax() ); 
+            par.push_back( torus->GetRtor() ); 
+            par.push_back( torus->GetSPhi() ); 
+            par.push_back( torus->GetDPhi() ); 
+        }
+        break ; 
+        case _G4Box:
+        {
+            const G4Box* box = dynamic_cast<const G4Box*>(prim) ; 
+            par.push_back( box->GetXHalfLength() ); 
+            par.push_back( box->GetYHalfLength() ); 
+            par.push_back( box->GetZHalfLength() ); 
+        }
+        break ; 
+        case _G4Cons:
+        {
+            const G4Cons* cons = dynamic_cast<const G4Cons*>(prim) ; 
+            par.push_back( cons->GetInnerRadiusMinusZ() ); 
+            par.push_back( cons->GetOuterRadiusMinusZ() ); 
+            par.push_back( cons->GetInnerRadiusPlusZ() ); 
+            par.push_back( cons->GetOuterRadiusPlusZ() ); 
+            par.push_back( cons->GetZHalfLength() ); 
+            par.push_back( cons->GetStartPhiAngle() ); 
+            par.push_back( cons->GetDeltaPhiAngle() ); 
+        }
+        break ; 
+        case _G4Sphere:
+        {
+            const G4Sphere* sphere = dynamic_cast<const G4Sphere*>(prim) ; 
+            par.push_back( sphere->GetInnerRadius() ); 
+            par.push_back( sphere->GetOuterRadius() ); 
+            par.push_back( sphere->GetStartPhiAngle() ); 
+            par.push_back( sphere->GetDeltaPhiAngle() ); 
+            par.push_back( sphere->GetStartThetaAngle() ); 
+            par.push_back( sphere->GetDeltaThetaAngle() ); 
+        }
+        break ; 
+    }
+}
+
+/**
+ZSolid::MakePrimitive
+-----------------------
+
+Inverse of GetParams : creates a primitive of *type* from *num_par* 
+parameters in the GetParams order. Returns nullptr when the type 
+is not supported or the number of parameters is inconsistent.
+
+**/
+
+G4VSolid* ZSolid::MakePrimitive( int type, const G4String& name, const double* par, int num_par ) // static
+{
+    G4VSolid* prim = nullptr ; 
+    switch(type)
+    {
+        case _G4Ellipsoid: 
+            if( num_par == 5 ) prim = new G4Ellipsoid( name, par[0], par[1], par[2], par[3], par[4] ); 
+            break ; 
+        case _G4Tubs: 
+            if( num_par == 5 ) prim = new G4Tubs( name, par[0], par[1], par[2], par[3], par[4] ); 
+            break ; 
+        case _G4Polycone:
+        {
+            int num_z = num_par > 2 ? int(par[2]) : 0 ; 
+            if( num_z > 0 && num_par == 3 + 3*num_z ) 
+            {
+                const double* z    = par + 3 ; 
+                const double* rmin = par + 3 + num_z ; 
+                const double* rmax = par + 3 + 2*num_z ; 
+                prim = new G4Polycone( name, par[0], par[1], num_z, z, rmin, rmax ); 
+            }
+        }
+        break ; 
+        case _G4Torus: 
+            if( num_par == 5 ) prim = new G4Torus( name, par[0], par[1], par[2], par[3], par[4] ); 
+            break ; 
+        case _G4Box: 
+            if( num_par == 3 ) prim = new G4Box( name, par[0], par[1], par[2] ); 
+            break ; 
+        case _G4Cons: 
+            if( num_par == 7 ) prim = new G4Cons( name, par[0], par[1], par[2], par[3], par[4], par[5], par[6] ); 
+            break ; 
+        case _G4Sphere: 
+            if( num_par == 6 ) prim = new G4Sphere( name, par[0], par[1], par[2], par[3], par[4], par[5] ); 
+            break ; 
+    }
+    if( prim == nullptr ) std::cout 
+        << "ZSolid::MakePrimitive"
+        << " FAILED type " << type 
+        << " name " << name 
+        << " num_par " << num_par 
+        << std::endl 
+        ;
+    return prim ; 
+}
+
+/**
+ZSolid::CanonicalBytes
+------------------------
+
+Unlike GetBooleanBytes which copies the object memory (including pointers) 
+this encodes the structure of the tree in a form that is the same for 
+all trees with identical shape, irrespective of names and addresses:
+
+* preorder sequence of entity types 
+* boolean right hand transforms 
+* primitive parameters from GetParams 
+
+Unsupported primitives encode their address so they are never 
+considered identical to anything but themselves. 
+
+**/
+
+void ZSolid::CanonicalBytes( std::string& bytes, const G4VSolid* node ) // static
+{
+    bytes.clear(); 
+    CanonicalBytes_r( bytes, node ); 
+}
+
+void ZSolid::CanonicalBytes_r( std::string& bytes, const G4VSolid* node_ ) // static
+{
+    G4RotationMatrix rot ; 
+    G4ThreeVector    tla(0., 0., 0.) ; 
+    const G4VSolid* node = Moved( &rot, &tla, node_ ); 
+
+    int type = EntityType(node) ; 
+    bytes.append( (const char*)&type, sizeof(int) ); 
+
+    if( Boolean(node) )
+    {
+        G4RotationMatrix rrot ; 
+        G4ThreeVector    rtla(0., 0., 0.) ; 
+        const G4VSolid* right = Moved( &rrot, &rtla, Right(node) ); 
+
+        CanonicalBytes_r( bytes, Left(node) ); 
+        AppendTransformBytes( bytes, rrot, rtla ); 
+        CanonicalBytes_r( bytes, right ); 
+    }
+    else
+    {
+        AppendPrimitiveBytes( bytes, node ); 
+    }
+}
+
+void ZSolid::AppendTransformBytes( std::string& bytes, const G4RotationMatrix& rot, const G4ThreeVector& tla ) // static
+{
+    double tr[12] = { 
+        rot.xx(), rot.xy(), rot.xz(), 
+        rot.yx(), rot.yy(), rot.yz(), 
+        rot.zx(), rot.zy(), rot.zz(),
+        tla.x(),  tla.y(),  tla.z() 
+    } ; 
+    for(int i=0 ; i < 12 ; i++) if( tr[i] == 0. ) tr[i] = 0. ;  // -0. and 0. must encode the same 
+    bytes.append( (const char*)tr, sizeof(tr) ); 
+}
+
+void ZSolid::AppendPrimitiveBytes( std::string& bytes, const G4VSolid* prim ) // static
+{
+    std::vector<double> par ; 
+    GetParams( par, prim ); 
+    if( par.size() == 0 )
+    {
+        const G4VSolid* addr = prim ; 
+        bytes.append( (const char*)&addr, sizeof(const G4VSolid*) ); 
+    }
+    else
+    {
+        for(unsigned i=0 ; i < par.size() ; i++) if( par[i] == 0. ) par[i] = 0. ; 
+        int num_par = par.size() ; 
+        bytes.append( (const char*)&num_par, sizeof(int) ); 
+        bytes.append( (const char*)par.data(), sizeof(double)*par.size() ); 
+    }
+}
+
+/**
+ZSolid::Hash
+--------------
+
+64 bit FNV-1a hash of the bytes
+
+**/
+
+uint64_t ZSolid::Hash( const std::string& bytes ) // static
+{
+    uint64_t h = 0xcbf29ce484222325ull ; 
+    for(unsigned i=0 ; i < bytes.size() ; i++)
+    {
+        h ^= (unsigned char)bytes[i] ; 
+        h *= 0x100000001b3ull ; 
+    }
+    return h ; 
+}
+
+uint64_t ZSolid::Digest( const G4VSolid* node ) // static
+{
+    std::string bytes ; 
+    CanonicalBytes( bytes, node ); 
+    return Hash(bytes) ; 
+}
+
+/**
+ZSolid::ApproxBytes
+---------------------
+
+Approximate memory of a single node, not including its constituents. 
+For booleans with a right transform this includes the internal 
+G4DisplacedSolid and its transforms. G4Polycone internals scale with 
+the number of Z planes. 
+
+**/
+
+size_t ZSolid::ApproxBytes( const G4VSolid* node_ ) // static
+{
+    const G4VSolid* node = Moved(node_) ; 
+    size_t sz = 0 ; 
+    switch(EntityType(node))
+    {
+        case _G4Ellipsoid:         sz = sizeof(G4Ellipsoid)         ; break ; 
+        case _G4Tubs:              sz = sizeof(G4Tubs)              ; break ; 
+        case _G4Torus:             sz = sizeof(G4Torus)             ; break ; 
+        case _G4Box:               sz = sizeof(G4Box)               ; break ; 
+        case _G4Cons:              sz = sizeof(G4Cons)              ; break ; 
+        case _G4Sphere:            sz = sizeof(G4Sphere)            ; break ; 
+        case _G4Polycone:          
+        {
+            const G4Polycone* polycone = dynamic_cast<const G4Polycone*>(node) ; 
+            int num_z = polycone->GetOriginalParameters()->Num_z_planes ; 
+            sz = sizeof(G4Polycone) + num_z*( 3*sizeof(double) + 256 ) ;   // historical params + faces 
+        }
+        break ; 
+        case _G4UnionSolid:        sz = sizeof(G4UnionSolid)        ; break ; 
+        case _G4SubtractionSolid:  sz = sizeof(G4SubtractionSolid)  ; break ; 
+        case _G4IntersectionSolid: sz = sizeof(G4IntersectionSolid) ; break ; 
+        default:                   sz = 256                         ; break ; 
+    }
+    if( Boolean(node) && Displaced(Right(node)) ) sz += sizeof(G4DisplacedSolid) + 2*sizeof(G4AffineTransform) ; 
+    return sz ; 
+}
+
+
+/**
+ZSolid::ApplyCutTree
+----------------------
+
+Generalization of ApplyZCutTree to the PLANE and BOX cuts described in ZCut.h 
+Returns a new tree, the original is not changed. The returned tree 
+matches the original within the region kept by the cut. 
+
+Every node is classified using its bounding box in the tree frame:
+
+EXCLUDE
+    subtree is pruned, with the parent operator deciding the consequence : 
+    union with an excluded side becomes the other side, 
+    intersection with an excluded side is excluded, 
+    subtraction with excluded right becomes the left and 
+    subtraction with excluded left is excluded  
+
+INCLUDE
+    subtree is cloned unchanged 
+
+STRADDLE
+    booleans are recursed into, primitives are cut with CutPrimitive
+
+Returns nullptr when the entire tree is excluded. 
+When the survivor of the root is offset (eg when the left of a root union is 
+excluded) the returned root is a G4DisplacedSolid holding that offset. 
+
+**/
+
+G4VSolid* ZSolid::ApplyCutTree( const G4VSolid* original, const ZCut& cut ) // static
+{
+    std::lock_guard<std::recursive_mutex> lock(StoreMutex()); 
+    if(verbose) std::cout 
+        << "[ ZSolid::ApplyCutTree " 
+        << " original.GetName " << original->GetName() 
+        << " cut " << cut.desc() 
+        << std::endl
+        ; 
+
+    G4ThreeVector off(0., 0., 0.) ; 
+    G4VSolid* root = CutClone_r( original, G4ThreeVector(0.,0.,0.), cut, off, 0 ); 
+
+    if( root == nullptr )
+    {
+        std::cout 
+            << "ZSolid::ApplyCutTree"
+            << " entire tree excluded by cut " << cut.desc()
+            << " original.GetName " << original->GetName()
+            << std::endl 
+            ;
+        return nullptr ; 
+    }
+
+    if( !off.isNear( G4ThreeVector(0.,0.,0.), 1e-6 ))
+    {
+        G4RotationMatrix rot ; 
+        G4String name = root->GetName() + "_displaced" ; 
+        root = new G4DisplacedSolid( name, root, G4Transform3D(rot, off) ); 
+    }
+
+    if(verbose) std::cout 
+        << "] ZSolid::ApplyCutTree " 
+        << " num_node " << NumNode_r(original, 0) 
+        << " -> " << NumNode_r(root, 0)
+        << std::endl
+        ; 
+
+    return root ; 
+}
+
+/**
+ZSolid::CutClone_r
+--------------------
+
+Returns clone of *node* with *cut* applied or nullptr when excluded. 
+The frame of *node* has translation *tla* within the tree frame
+and *off* is set to the translation to be applied to the 
+returned solid to place it within the frame of *node*. 
+
+**/
+
+G4VSolid* ZSolid::CutClone_r( const G4VSolid* node_, const G4ThreeVector& tla, const ZCut& cut, G4ThreeVector& off, int depth ) // static
+{
+    const G4VSolid* node = Moved(node_) ; 
+    off.set(0., 0., 0.) ; 
+
+    int cls = ClassifyCut( node, tla, cut ); 
+
+    if(verbose) std::cout 
+        << "ZSolid::CutClone_r"
+        << " depth " << std::setw(2) << depth 
+        << " type " << std::setw(20) << EntityTypeName(node)
+        << " name " << std::setw(30) << node->GetName()
+        << " cls " << ClassifyName(cls) 
+        << std::endl
+        ; 
+
+    if( cls == EXCLUDE ) return nullptr ; 
+    if( cls == INCLUDE ) return DeepClone(node) ; 
+    if( !Boolean(node) ) return CutPrimitive( node, tla, cut, off ); 
+
+    G4RotationMatrix rrot ; 
+    G4ThreeVector    rtla(0., 0., 0.) ; 
+    const G4VSolid* right_ = Moved( &rrot, &rtla, Right(node) ); 
+
+    bool expect_rrot = rrot.isIdentity() ; // simplifying assumption, as elsewhere 
+    assert( expect_rrot ); 
+    if(!expect_rrot) exit(EXIT_FAILURE); 
+
+    G4ThreeVector loff, roff ; 
+    G4VSolid* left  = CutClone_r( Left(node), tla,        cut, loff, depth+1 ); 
+    G4VSolid* right = CutClone_r( right_,     tla + rtla, cut, roff, depth+1 ); 
+    roff += rtla ; 
+
+    int type = EntityType(node) ; 
+    G4String name = node->GetName() ; 
+
+    G4VSolid* result = nullptr ; 
+    if( left && right )
+    {
+        result = MakeBoolean( type, name, left, right, roff - loff ); 
+        off = loff ; 
+    }
+    else if( left && !right && type != _G4IntersectionSolid )   // union or subtraction with excluded right 
+    {
+        result = left ; 
+        off = loff ; 
+    }
+    else if( !left && right && type == _G4UnionSolid )
+    {
+        result = right ; 
+        off = roff ; 
+    }
+    return result ; 
+}
+
+int ZSolid::ClassifyCut( const G4VSolid* node, const G4ThreeVector& tla, const ZCut& cut ) // static
+{
+    G4ThreeVector mn, mx ; 
+    node->BoundingLimits(mn, mx); 
+    return cut.classify( mn + tla, mx + tla ); 
+}
+
+/**
+ZSolid::CutPrimitive
+---------------------
+
+For axis aligned cuts the parameters of supported primitives are changed 
+with ClipPrimitive, avoiding any increase in the number of nodes. 
+Otherwise the primitive is intersected with a G4Box representing the 
+kept region local to the primitive with IntersectCut.
+
+**/
+
+G4VSolid* ZSolid::CutPrimitive( const G4VSolid* prim, const G4ThreeVector& tla, const ZCut& cut, G4ThreeVector& off ) // static
+{
+    G4VSolid* clipped = nullptr ; 
+    off.set(0., 0., 0.) ; 
+
+    if( cut.is_aligned() )
+    {
+        G4ThreeVector lo(-kInfinity, -kInfinity, -kInfinity) ; 
+        G4ThreeVector hi( kInfinity,  kInfinity,  kInfinity) ; 
+
+        if( cut.type == ZCut::PLANE )
+        {
+            for(int j=0 ; j < 3 ; j++)
+            {
+                if( cut.normal[j] > 0. ) lo[j] =  cut.d - tla[j] ; 
+                if( cut.normal[j] < 0. ) hi[j] = -cut.d - tla[j] ;
+            }
+        }
+        else if( cut.type == ZCut::BOX )
+        {
+            lo = cut.center - cut.halfside - tla ; 
+            hi = cut.center + cut.halfside - tla ; 
+        }
+        clipped = ClipPrimitive( prim, lo, hi, off ); 
+    }
+
+    if( clipped == nullptr )
+    {
+        clipped = IntersectCut( prim, tla, cut ); 
+        off.set(0., 0., 0.) ; 
+    }
+    return clipped ; 
+}
+
+/**
+ZSolid::ClipPrimitive
+-----------------------
+
+Returns a clone of *prim* clipped to the local frame range lo:hi
+with *off* set to any offset needed for symmetrically defined 
+primitives (G4Box, G4Tubs, G4Cons) to stay in place, see ApplyZCut_G4Tubs.  
+G4Box is clipped on all axes, the others only in Z 
+so nullptr is returned if X or Y clipping is needed or for 
+unsupported primitives. 
+
+**/
+
+G4VSolid* ZSolid::ClipPrimitive( const G4VSolid* prim, const G4ThreeVector& lo, const G4ThreeVector& hi, G4ThreeVector& off ) // static
+{
+    int type = EntityType(prim) ; 
+    G4ThreeVector mn, mx ; 
+    prim->BoundingLimits(mn, mx); 
+
+    off.set(0., 0., 0.) ; 
+    G4VSolid* clone = nullptr ; 
+
+    if( type == _G4Box )
+    {
+        const G4Box* box = dynamic_cast<const G4Box*>(prim) ; 
+        G4ThreeVector h( box->GetXHalfLength(), box->GetYHalfLength(), box->GetZHalfLength() ); 
+        G4ThreeVector nh ; 
+        for(int j=0 ; j < 3 ; j++)
+        {
+            double a = std::max( -h[j], lo[j] ) ; 
+            double b = std::min(  h[j], hi[j] ) ; 
+            bool expect = b > a ; 
+            assert(expect); 
+            if(!expect) exit(EXIT_FAILURE); 
+            nh[j] = (b - a)/2. ; 
+            off[j] = (b + a)/2. ; 
+        }
+        G4Box* nbox = new G4Box(*box); 
+        nbox->SetXHalfLength(nh.x()); 
+        nbox->SetYHalfLength(nh.y()); 
+        nbox->SetZHalfLength(nh.z()); 
+        return nbox ; 
+    }
+
+    bool xy_covered = lo.x() <= mn.x() && hi.x() >= mx.x() && lo.y() <= mn.y() && hi.y() >= mx.y() ; 
+    if(!xy_covered) return nullptr ; 
+
+    double z0 = 0. ; 
+    double z1 = 0. ; 
+    if(CanZ(prim)) ZRange(z0, z1, prim) ; 
+
+    if( type == _G4Ellipsoid )
+    {
+        const G4Ellipsoid* ellipsoid = dynamic_cast<const G4Ellipsoid*>(prim) ; 
+        G4Ellipsoid* nell = new G4Ellipsoid(*ellipsoid) ; 
+        nell->SetZCuts( std::max(z0, lo.z()), std::min(z1, hi.z()) ); 
+        clone = nell ; 
+    }
+    else if( type == _G4Tubs )
+    {
+        const G4Tubs* tubs = dynamic_cast<const G4Tubs*>(prim) ; 
+        double a = std::max(z0, lo.z()) ; 
+        double b = std::min(z1, hi.z()) ; 
+        G4Tubs* ntubs = new G4Tubs(*tubs) ; 
+        ntubs->SetZHalfLength( (b - a)/2. ); 
+        off.setZ( (b + a)/2. ); 
+        clone = ntubs ; 
+    }
+    else if( type == _G4Cons )
+    {
+        const G4Cons* cons = dynamic_cast<const G4Cons*>(prim) ; 
+        double hz = cons->GetZHalfLength() ; 
+        double a = std::max(z0, lo.z()) ; 
+        double b = std::min(z1, hi.z()) ; 
+        double fa = (a + hz)/(2.*hz) ; 
+        double fb = (b + hz)/(2.*hz) ; 
+
+        double rmin_m = cons->GetInnerRadiusMinusZ() ; 
+        double rmax_m = cons->GetOuterRadiusMinusZ() ; 
+        double rmin_p = cons->GetInnerRadiusPlusZ() ; 
+        double rmax_p = cons->GetOuterRadiusPlusZ() ; 
+
+        G4Cons* ncons = new G4Cons(*cons) ; 
+        ncons->SetInnerRadiusMinusZ( rmin_m + fa*(rmin_p - rmin_m) ); 
+        ncons->SetOuterRadiusMinusZ( rmax_m + fa*(rmax_p - rmax_m) ); 
+        ncons->SetInnerRadiusPlusZ(  rmin_m + fb*(rmin_p - rmin_m) ); 
+        ncons->SetOuterRadiusPlusZ(  rmax_m + fb*(rmax_p - rmax_m) ); 
+        ncons->SetZHalfLength( (b - a)/2. ); 
+        off.setZ( (b + a)/2. ); 
+        clone = ncons ; 
+    }
+    else if( type == _G4Polycone )
+    {
+        const G4Polycone* polycone = dynamic_cast<const G4Polycone*>(prim) ; 
+        clone = ClipPolycone( polycone, lo.z(), hi.z() ); 
+    }
+    return clone ; 
+}
+
+/**
+ZSolid::ClipPolycone
+----------------------
+
+Creates a new G4Polycone from the original parameters restricted 
+to the Z range lo:hi with radii interpolated at the clipped ends.  
+Unlike ApplyZCut_G4Polycone this can clip from above or below 
+and does not use placement new. 
+
+**/
+
+G4VSolid* ZSolid::ClipPolycone( const G4Polycone* polycone, double lo, double hi ) // static
+{
+    G4PolyconeHistorical* pars = polycone->GetOriginalParameters(); 
+    int num_z = pars->Num_z_planes ; 
+    const double* z = pars->Z_values ; 
+
+    std::vector<double> zz, r0, r1 ; 
+    for(int i=0 ; i < num_z - 1 ; i++)
+    {
+        double za = z[i] ; 
+        double zb = z[i+1] ; 
+
+        double a0 = pars->Rmin[i] ; 
+        double b0 = pars->Rmin[i+1] ; 
+        double a1 = pars->Rmax[i] ; 
+        double b1 = pars->Rmax[i+1] ; 
+
+        if( za == zb )  // step in radius, only kept when strictly within lo:hi 
+        {
+            if( za > lo && za < hi )
+            {
+                zz.push_back(za) ; r0.push_back(a0) ; r1.push_back(a1) ; 
+                zz.push_back(zb) ; r0.push_back(b0) ; r1.push_back(b1) ; 
+            }
+            continue ; 
+        }
+
+        double ca = std::max(za, lo) ; 
+        double cb = std::min(zb, hi) ; 
+        if( cb <= ca ) continue ; 
+
+        double fa = (ca - za)/(zb - za) ; 
+        double fb = (cb - za)/(zb - za) ; 
+
+        double ra0 = a0 + fa*(b0 - a0) ; 
+        double ra1 = a1 + fa*(b1 - a1) ; 
+        double rb0 = a0 + fb*(b0 - a0) ; 
+        double rb1 = a1 + fb*(b1 - a1) ; 
+
+        bool dupe = zz.size() > 0 && zz.back() == ca && r0.back() == ra0 && r1.back() == ra1 ; 
+        if(!dupe) { zz.push_back(ca) ; r0.push_back(ra0) ; r1.push_back(ra1) ; }
+        zz.push_back(cb) ; r0.push_back(rb0) ; r1.push_back(rb1) ; 
+    }
+
+    bool expect = zz.size() >= 2 ; 
+    assert(expect); 
+    if(!expect) exit(EXIT_FAILURE); 
+
+    G4Polycone* clone = new G4Polycone(
+                               polycone->GetName(), 
+                               pars->Start_angle, 
+                               pars->Opening_angle, 
+                               zz.size(), 
+                               zz.data(), 
+                               r0.data(), 
+                               r1.data() 
+                               ); 
+
+    return clone ; 
+}
+
+/**
+ZSolid::IntersectCut
+----------------------
+
+Exact cut of any primitive by intersecting it with a G4Box that 
+covers the part of the primitive bounding sphere within the kept region. 
+For PLANE cuts the box Z axis is along the plane normal, for BOX 
+cuts the box is the cut box.  
+
+As the box is rotated for non-aligned cuts the resulting tree 
+has rotations, which the DeepClone based ZSolid methods do not support.  
+
+**/
+
+G4VSolid* ZSolid::IntersectCut( const G4VSolid* prim, const G4ThreeVector& tla, const ZCut& cut ) // static
+{
+    G4ThreeVector mn, mx ; 
+    prim->BoundingLimits(mn, mx); 
+
+    G4ThreeVector c = (mn + mx)/2. + tla ;      // bounding sphere center in tree frame 
+    double R = (mx - mn).mag()/2. + 1. ;       // +1mm margin  
+
+    G4RotationMatrix rot ; 
+    G4ThreeVector    half ; 
+    G4ThreeVector    center ; 
+
+    if( cut.type == ZCut::PLANE )
+    {
+        const G4ThreeVector& n = cut.normal ; 
+        double cn = n.dot(c) ; 
+        double bot = std::max( cut.d, cn - R ) ; 
+        double top = cn + R ; 
+
+        G4ThreeVector u = n.orthogonal().unit() ; 
+        G4ThreeVector w = n.cross(u) ; 
+        rot = G4RotationMatrix( u, w, n ) ;   // columns : box frame X,Y,Z axes within tree frame
+        half.set( R, R, (top - bot)/2. ); 
+        center = c + ((top + bot)/2. - cn)*n ; 
+    }
+    else if( cut.type == ZCut::BOX )
+    {
+        rot = cut.rot ; 
+        half = cut.halfside ; 
+        center = cut.center ; 
+    }
+
+    G4String name = prim->GetName() ; 
+    G4VSolid* clip = new G4Box( name + "_clip", half.x(), half.y(), half.z() ); 
+    G4VSolid* clone = PrimitiveClone(prim) ; 
+
+    G4Transform3D tr( rot, center - tla ); 
+    G4VSolid* result = new G4IntersectionSolid( name + "_cut", clone, clip, tr ); 
+    return result ; 
+}
+
+
+/**
+ZSolid::Rebalance
+-------------------
+
+Returns a new tree equivalent to *original* but with reduced height, 
+the original is not changed. The tree is cloned as it is rebuilt so 
+the same assumptions as DeepClone apply : no rotations and 
+only the supported primitives. 
+
+Maximal chains of the same associative operator are flattened into 
+their leaves and rebuilt as balanced binary trees:
+
+* union chains :        ((((a+b)+c)+d)+e)   ->  ((a+b)+c)+(d+e) 
+* intersection chains : same as union 
+* subtraction chains :  (((a-b)-c)-d)       ->  a-((b+c)+d)   
+
+The leaves of each chain are themselves rebalanced, so chains 
+below other operators are also handled, for example the 20inch PMT 
+union chain that is beneath an intersection with a tubs 
+(see notes/issues/hama-exceeding-tree-limit.rst) 
+which the Opticks NTreeBalance was unable to balance. 
+
+As the leftmost leaf of every chain stays leftmost the frame of the 
+root is unchanged. 
+
+**/
+
+G4VSolid* ZSolid::Rebalance( const G4VSolid* original ) // static
+{
+    std::lock_guard<std::recursive_mutex> lock(StoreMutex()); 
+    G4ThreeVector off(0., 0., 0.) ; 
+    G4VSolid* root = Rebalance_r( original, off, 0 ); 
+
+    bool expect = off.isNear( G4ThreeVector(0., 0., 0.), 1e-6 ) ; 
+    assert(expect && "leftmost leaf is expected to keep the root frame" ); 
+    if(!expect) exit(EXIT_FAILURE); 
+
+    if(verbose) std::cout 
+        << "ZSolid::Rebalance"
+        << " original.GetName " << original->GetName()
+        << " height " << Height_r(original, 0) 
+        << " -> " << Height_r(root, 0)
+        << " num_node " << NumNode_r(original, 0)
+        << " -> " << NumNode_r(root, 0)
+        << std::endl 
+        ; 
+
+    return root ; 
+}
+
+/**
+ZSolid::Rebalance_r
+---------------------
+
+Returns a clone of the subtree *node_* rebalanced, setting *off* to the 
+translation that must be applied to the returned solid to place it in the 
+frame of *node_*. Any G4DisplacedSolid transform of *node_* itself is 
+not included, the caller collects that. 
+
+**/
+
+G4VSolid* ZSolid::Rebalance_r( const G4VSolid* node_, G4ThreeVector& off, int depth ) // static
+{
+    const G4VSolid* node = Moved(node_) ; 
+    int type = EntityType(node); 
+    G4String name = node->GetName() ; 
+
+    off.set(0., 0., 0.) ; 
+    if(!Boolean(node)) return PrimitiveClone(node) ; 
+
+    G4VSolid* rebal = nullptr ; 
+
+    if( type == _G4UnionSolid || type == _G4IntersectionSolid )
+    {
+        std::vector<const G4VSolid*> leaves ; 
+        std::vector<G4ThreeVector>   leaf_offs ; 
+        CollectChain_r( leaves, leaf_offs, node, G4ThreeVector(0.,0.,0.), type ); 
+
+        std::vector<G4VSolid*>     solids(leaves.size()) ; 
+        std::vector<G4ThreeVector> offs(leaves.size()) ; 
+        for(unsigned i=0 ; i < leaves.size() ; i++)
+        {
+            G4ThreeVector loff ; 
+            solids[i] = Rebalance_r( leaves[i], loff, depth+1 ); 
+            offs[i] = leaf_offs[i] + loff ; 
+        }
+        rebal = BuildBalanced( type, name, solids, offs, 0, solids.size(), off ); 
+    }
+    else if( type == _G4SubtractionSolid )
+    {
+        // walk down the left spine of subtractions, collecting the subtrahends 
+        std::vector<const G4VSolid*> subs ; 
+        std::vector<G4ThreeVector>   sub_offs ; 
+
+        const G4VSolid* base = node ; 
+        while( EntityType(base) == _G4SubtractionSolid )
+        {
+            G4RotationMatrix rrot ; 
+            G4ThreeVector    rtla(0., 0., 0.) ; 
+            const G4VSolid* right = Moved( &rrot, &rtla, Right(base) ); 
+            bool expect_rrot = rrot.isIdentity() ; 
+            assert( expect_rrot ); 
+            if(!expect_rrot) exit(EXIT_FAILURE); 
+
+            CollectChain_r( subs, sub_offs, right, rtla, _G4UnionSolid );   // subtrahends that are unions join the union  
+            base = Left(base) ; 
+        }
+
+        G4ThreeVector base_off ; 
+        G4VSolid* base_solid = Rebalance_r( base, base_off, depth+1 ); 
+
+        std::vector<G4VSolid*>     solids(subs.size()) ; 
+        std::vector<G4ThreeVector> offs(subs.size()) ; 
+        for(unsigned i=0 ; i < subs.size() ; i++)
+        {
+            G4ThreeVector loff ; 
+            solids[i] = Rebalance_r( subs[i], loff, depth+1 ); 
+            offs[i] = sub_offs[i] + loff ; 
+        }
+
+        G4ThreeVector sub_off ; 
+        G4String sub_name = name + "_sub" ; 
+        G4VSolid* sub_solid = BuildBalanced( _G4UnionSolid, sub_name, solids, offs, 0, solids.size(), sub_off ); 
+
+        rebal = MakeBoolean( _G4SubtractionSolid, name, base_solid, sub_solid, sub_off - base_off ); 
+        off = base_off ; 
+    }
+
+    bool expect = rebal != nullptr ; 
+    if(!expect) std::cout << "ZSolid::Rebalance_r FATAL unhandled type " << EntityTypeName(node) << std::endl ; 
+    assert(expect); 
+    if(!expect) exit(EXIT_FAILURE); 
+    return rebal ; 
+}
+
+/**
+ZSolid::CollectChain_r
+------------------------
+
+Inorder collection of the leaves of the maximal subtree of *node* that has operator *op*, 
+together with the translation of each leaf relative to the frame in which *node* has 
+translation *off*. 
+
+**/
+
+void ZSolid::CollectChain_r( std::vector<const G4VSolid*>& leaves, std::vector<G4ThreeVector>& offs, const G4VSolid* node, const G4ThreeVector& off, int op ) // static
+{
+    if( EntityType(node) == op )
+    {
+        G4RotationMatrix rrot ; 
+        G4ThreeVector    rtla(0., 0., 0.) ; 
+        const G4VSolid* right = Moved( &rrot, &rtla, Right(node) ); 
+
+        bool expect_rrot = rrot.isIdentity() ; // simplifying assumption, as elsewhere 
+        assert( expect_rrot ); 
+        if(!expect_rrot) exit(EXIT_FAILURE); 
+
+        CollectChain_r( leaves, offs, Left(node), off, op ); 
+        CollectChain_r( leaves, offs, right, off + rtla, op ); 
+    }
+    else
+    {
+        leaves.push_back(node); 
+        offs.push_back(off); 
+    }
+}
+
+/**
+ZSolid::BuildBalanced
+-----------------------
+
+Recursively combines solids[i0:i1] placed at offs[i0:i1] with operator *op* 
+splitting the range in half at each level. The frame of the returned solid 
+is that of its leftmost leaf, the translation of which is returned in *off*. 
+
+**/
+
+G4VSolid* ZSolid::BuildBalanced( int op, const G4String& name, const std::vector<G4VSolid*>& solids, const std::vector<G4ThreeVector>& offs, int i0, int i1, G4ThreeVector& off ) // static
+{
+    assert( i1 > i0 ); 
+    if( i1 - i0 == 1 )
+    {
+        off = offs[i0] ; 
+        return solids[i0] ; 
+    }
+    int im = (i0 + i1 + 1)/2 ;   // left heavy split 
+
+    G4ThreeVector loff, roff ; 
+    G4VSolid* left  = BuildBalanced( op, name, solids, offs, i0, im, loff ); 
+    G4VSolid* right = BuildBalanced( op, name, solids, offs, im, i1, roff ); 
+
+    bool top = i0 == 0 && i1 == int(solids.size()) ; 
+    std::stringstream ss ; 
+    ss << name ; 
+    if(!top) ss << "_" << i0 << "_" << i1 ; 
+    std::string nm = ss.str(); 
+
+    off = loff ; 
+    return MakeBoolean( op, nm, left, right, roff - loff ); 
+}
+
+G4VSolid* ZSolid::MakeBoolean( int op, const G4String& name, G4VSolid* left, G4VSolid* right, const G4ThreeVector& rtla, const G4RotationMatrix* rrot_ ) // static
+{
+    G4RotationMatrix rrot ; 
+    if(rrot_) rrot = *rrot_ ; 
+    G4VSolid* solid = nullptr ; 
+    switch(op)
+    {
+        case _G4UnionSolid        : solid = new G4UnionSolid(        name, left, right, &rrot, rtla ) ; break ; 
+        case _G4SubtractionSolid  : solid = new G4SubtractionSolid(  name, left, right, &rrot, rtla ) ; break ;
+        case _G4IntersectionSolid : solid = new G4IntersectionSolid( name, left, right, &rrot, rtla ) ; break ; 
+    }
+    bool expect = solid != nullptr ; 
+    assert(expect); 
+    if(!expect) exit(EXIT_FAILURE); 
+    return solid ; 
+}
+
+/**
+ZSolid::Height_r
+------------------
+
+Unlike Maxdepth_r this sees thru G4DisplacedSolid so displaced 
+booleans on the right are not counted as leaves. 
+
+**/
+
+int ZSolid::Height_r( const G4VSolid* node_, int depth ) // static
+{
+    const G4VSolid* node = Moved(node_) ; 
+    return Boolean(node) ? std::max( Height_r(Left(node), depth+1), Height_r(Right(node), depth+1)) : depth ; 
+}
+
+/**
+ZSolid::CompareInside
+-----------------------
+
+Samples *num* random points within the bounding box of *a* enlarged by 10 percent 
+and returns the number of points for which a->Inside and b->Inside disagree. 
+Used to check that tree manipulations such as Rebalance do not change the shape.  
+
+**/
+
+int ZSolid::CompareInside( const G4VSolid* a, const G4VSolid* b, int num, unsigned seed ) // static
+{
+    G4ThreeVector mn, mx ; 
+    a->BoundingLimits(mn, mx); 
+    G4ThreeVector margin = 0.1*(mx - mn) ; 
+    mn -= margin ; 
+    mx += margin ; 
+
+    std::mt19937 engine(seed) ; 
+    std::uniform_real_distribution<double> ux(mn.x(), mx.x()) ; 
+    std::uniform_real_distribution<double> uy(mn.y(), mx.y()) ; 
+    std::uniform_real_distribution<double> uz(mn.z(), mx.z()) ; 
+
+    int mismatch = 0 ; 
+    int count[3] = {0, 0, 0} ; 
+    for(int i=0 ; i < num ; i++)
+    {
+        G4ThreeVector p( ux(engine), uy(engine), uz(engine) ); 
+        EInside ia = a->Inside(p) ; 
+        EInside ib = b->Inside(p) ; 
+        count[ia] += 1 ; 
+        if( ia != ib ) 
+        {
+            mismatch += 1 ;  
+            if(verbose) std::cout 
+                << "ZSolid::CompareInside mismatch " 
+                << " p " << p 
+                << " ia " << ia 
+                << " ib " << ib 
+                << std::endl 
+                ; 
+        }
+    }
+
+    std::cout 
+        << "ZSolid::CompareInside"
+        << " a " << a->GetName()
+        << " b " << b->GetName()
+        << " num " << num 
+        << " outside " << count[kOutside]
+        << " surface " << count[kSurface]
+        << " inside " << count[kInside]
+        << " mismatch " << mismatch 
+        << std::endl 
+        ;
+
+    return mismatch ; 
+}
+
+/**
+ZSolid::TimeNavigation
+------------------------
+
+Returns the time in seconds for *num* random point and direction queries 
+of Inside followed by DistanceToIn or DistanceToOut as appropriate. 
+The same points and directions are used for a given *seed* enabling 
+comparison of trees before and after manipulations. 
+
+**/
+
+double ZSolid::TimeNavigation( const G4VSolid* solid, int num, unsigned seed ) // static
+{
+    G4ThreeVector mn, mx ; 
+    solid->BoundingLimits(mn, mx); 
+    G4ThreeVector margin = 0.1*(mx - mn) ; 
+    mn -= margin ; 
+    mx += margin ; 
+
+    std::mt19937 engine(seed) ; 
+    std::uniform_real_distribution<double> ux(mn.x(), mx.x()) ; 
+    std::uniform_real_distribution<double> uy(mn.y(), mx.y()) ; 
+    std::uniform_real_distribution<double> uz(mn.z(), mx.z()) ; 
+    std::uniform_real_distribution<double> uc(-1., 1.) ; 
+    std::uniform_real_distribution<double> up(0., 2.*M_PI) ; 
+
+    double sum = 0. ; 
+    std::chrono::time_point<std::chrono::steady_clock> t0 = std::chrono::steady_clock::now(); 
+    for(int i=0 ; i < num ; i++)
+    {
+        G4ThreeVector p( ux(engine), uy(engine), uz(engine) ); 
+        double ct = uc(engine) ; 
+        double st = sqrt(1. - ct*ct) ; 
+        double ph = up(engine) ; 
+        G4ThreeVector v( st*cos(ph), st*sin(ph), ct ); 
+
+        EInside in = solid->Inside(p) ; 
+        double d = in == kInside ? solid->DistanceToOut(p, v) : solid->DistanceToIn(p, v) ; 
+        if( d < kInfinity ) sum += d ;   // prevent optimizing away 
+    }
+    std::chrono::time_point<std::chrono::steady_clock> t1 = std::chrono::steady_clock::now(); 
+    double dt = std::chrono::duration<double>(t1 - t0).count() ; 
+
+    if(verbose) std::cout 
+        << "ZSolid::TimeNavigation"
+        << " solid " << solid->GetName()
+        << " num " << num
+        << " dt " << std::fixed << std::setprecision(4) << dt 
+        << " sum " << sum 
+        << std::endl 
+        ;
+
+    return dt ; 
+}
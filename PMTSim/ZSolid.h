@@ -5,14 +5,20 @@ class G4Ellipsoid ;
 class G4Tubs ; 
 class G4Polycone ; 
 class G4Torus ; 
+class G4Box ; 
+class G4Cons ; 
+class G4Sphere ; 
 class G4DisplacedSolid ; 
 
 #include "G4RotationMatrix.hh" 
 #include "G4ThreeVector.hh" 
+#include "G4String.hh" 
 
+#include <cstdint>
 #include <string>
 #include <map>
 #include <vector>
+#include <mutex>
 
 
 /**
@@ -31,6 +37,7 @@ the API_EXPORT is needed
 **/
 
 struct ZCanvas ; 
+struct ZCut ; 
 
 #ifdef PMTSIM_STANDALONE
 #include "PMTSIM_API_EXPORT.hh"
@@ -45,6 +52,20 @@ struct ZSolid
     static G4VSolid* ApplyZCutTree( const G4VSolid* original, double zcut ); 
     static void Draw(const G4VSolid* original, const char* msg="ZSolid::Draw" ); 
 
+    // concurrent processing of multiple trees 
+    struct Job 
+    {
+        const G4VSolid* original ; 
+        double          zcut ; 
+        G4VSolid*       result ; 
+        double          seconds ;   // wall time of the job 
+        int             thread ;    // index of the worker thread that ran the job
+    }; 
+    static std::recursive_mutex& StoreMutex(); 
+    static void InitWorkerThread(); 
+    static void ApplyZCutTreeBatch( std::vector<Job>& jobs, int nthread=0 ); 
+    static std::string DescBatch( const std::vector<Job>& jobs ); 
+
     // members
     const G4VSolid* original ; 
     G4VSolid*       root ;     // DeepClone of original, which is identical to original AND fully independent from it 
@@ -195,7 +216,10 @@ struct ZSolid
         _G4UnionSolid, 
         _G4SubtractionSolid, 
         _G4IntersectionSolid, 
-        _G4DisplacedSolid 
+        _G4DisplacedSolid,
+        _G4Box, 
+        _G4Cons, 
+        _G4Sphere 
      }; 
 
     static const char* G4Ellipsoid_ ; 
@@ -206,6 +230,9 @@ struct ZSolid
     static const char* G4SubtractionSolid_  ;
     static const char* G4IntersectionSolid_ ;
     static const char* G4DisplacedSolid_    ;
+    static const char* G4Box_      ;
+    static const char* G4Cons_     ;
+    static const char* G4Sphere_   ;
 
     static const char* DirtyEntityTag_( const G4VSolid* node );
     static const char* EntityTag_( const G4VSolid* solid );
@@ -256,6 +283,9 @@ struct ZSolid
     static void GetZRange( const G4Tubs*      const tubs     , double& z0, double& z1 ); 
     static void GetZRange( const G4Polycone*  const polycone , double& z0, double& z1 ); 
     static void GetZRange( const G4Torus*     const torus,     double& z0, double& z1 ); 
+    static void GetZRange( const G4Box*       const box,       double& z0, double& z1 ); 
+    static void GetZRange( const G4Cons*      const cons,      double& z0, double& z1 ); 
+    static void GetZRange( const G4Sphere*    const sphere,    double& z0, double& z1 ); 
 
     // tree cloning methods
     static G4VSolid* DeepClone(    const G4VSolid* solid ); 
@@ -283,5 +313,37 @@ struct ZSolid
 
     static const char* CommonPrefix(const std::vector<std::string>* a); 
 
+    // structural hashing 
+    static void      GetParams( std::vector<double>& par, const G4VSolid* prim ); 
+    static G4VSolid* MakePrimitive( int type, const G4String& name, const double* par, int num_par ); 
+    static void      CanonicalBytes( std::string& bytes, const G4VSolid* node ); 
+    static void      CanonicalBytes_r( std::string& bytes, const G4VSolid* node_ ); 
+    static void      AppendTransformBytes( std::string& bytes, const G4RotationMatrix& rot, const G4ThreeVector& tla ); 
+    static void      AppendPrimitiveBytes( std::string& bytes, const G4VSolid* prim ); 
+    static uint64_t  Hash( const std::string& bytes ); 
+    static uint64_t  Digest( const G4VSolid* node ); 
+    static size_t    ApproxBytes( const G4VSolid* node ); 
+
+    // generalized cuts 
+    static G4VSolid* ApplyCutTree( const G4VSolid* original, const ZCut& cut ); 
+    static G4VSolid* CutClone_r( const G4VSolid* node, const G4ThreeVector& tla, const ZCut& cut, G4ThreeVector& off, int depth ); 
+    static int       ClassifyCut( const G4VSolid* prim, const G4ThreeVector& tla, const ZCut& cut ); 
+    static G4VSolid* CutPrimitive( const G4VSolid* prim, const G4ThreeVector& tla, const ZCut& cut, G4ThreeVector& off ); 
+    static G4VSolid* ClipPrimitive( const G4VSolid* prim, const G4ThreeVector& lo, const G4ThreeVector& hi, G4ThreeVector& off ); 
+    static G4VSolid* ClipPolycone( const G4Polycone* polycone, double lo, double hi ); 
+    static G4VSolid* IntersectCut( const G4VSolid* prim, const G4ThreeVector& tla, const ZCut& cut ); 
+
+    // tree rebalancing 
+    static G4VSolid* Rebalance( const G4VSolid* original ); 
+    static G4VSolid* Rebalance_r( const G4VSolid* node_, G4ThreeVector& off, int depth ); 
+    static void      CollectChain_r( std::vector<const G4VSolid*>& leaves, std::vector<G4ThreeVector>& offs, const G4VSolid* node, const G4ThreeVector& off, int op ); 
+    static G4VSolid* BuildBalanced( int op, const G4String& name, const std::vector<G4VSolid*>& solids, const std::vector<G4ThreeVector>& offs, int i0, int i1, G4ThreeVector& off ); 
+    static G4VSolid* MakeBoolean( int op, const G4String& name, G4VSolid* left, G4VSolid* right, const G4ThreeVector& rtla, const G4RotationMatrix* rrot=nullptr ); 
+    static int       Height_r( const G4VSolid* node_, int depth ); 
+
+    // sampling checks 
+    static int       CompareInside( const G4VSolid* a, const G4VSolid* b, int num, unsigned seed=0 ); 
+    static double    TimeNavigation( const G4VSolid* solid, int num, unsigned seed=0 ); 
+
 }; 
 
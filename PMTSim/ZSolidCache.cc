@@ -0,0 +1,386 @@
+#include <cassert>
+#include <cstring>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <algorithm>
+
+#include "NP.hh"
+
+#include "G4VSolid.hh"
+#include "G4UnionSolid.hh"
+#include "G4IntersectionSolid.hh"
+#include "G4SubtractionSolid.hh"
+#include "G4DisplacedSolid.hh"
+
+#include "ZSolid.h"
+#include "ZSolidCache.h"
+#include "IGeomManager.h"
+
+const char* ZSolidCache::DIR_KEY = "PMTSim_CACHE" ; 
+std::vector<ZSolidCache::Record> ZSolidCache::RECORDS = {} ; 
+
+const char* ZSolidCache::Dir() // static
+{
+    return getenv(DIR_KEY) ; 
+}
+
+bool ZSolidCache::Enabled() // static
+{
+    return Dir() != nullptr ; 
+}
+
+/**
+ZSolidCache::EnvOptions
+-------------------------
+
+Geometry options from the environment that can change the trees, 
+the JUNO_PMT20INCH switches set from tags in the name and the manager 
+properties overridden by envvars named "objName_key", eg hama_SimplificationLevel. 
+The selection of envvars is shared with the PMTSim instances, see IGeomOptions::Key 
+
+**/
+
+std::string ZSolidCache::EnvOptions() // static
+{
+    return IGeomOptions::Key() ; 
+}
+
+/**
+ZSolidCache::OptionsKey
+-------------------------
+
+Hex digest of the name and VERSION together with the EnvOptions. 
+
+**/
+
+std::string ZSolidCache::OptionsKey( const char* name ) // static
+{
+    std::string bytes = name ; 
+    bytes += "|v" ; 
+    bytes += std::to_string(VERSION) ; 
+    bytes += "|" ; 
+    bytes += EnvOptions() ; 
+
+    std::stringstream ss ; 
+    ss << std::hex << std::setw(16) << std::setfill('0') << ZSolid::Hash(bytes) ; 
+    std::string s = ss.str(); 
+    return s ; 
+}
+
+std::string ZSolidCache::Path( const char* name ) // static
+{
+    std::string nm = name ; 
+    std::replace( nm.begin(), nm.end(), '/', '_' ); 
+
+    std::stringstream ss ; 
+    ss << Dir() << "/" << nm << "_" << OptionsKey(name) ; 
+    std::string s = ss.str(); 
+    return s ; 
+}
+
+/**
+ZSolidCache::Serialize
+------------------------
+
+Returns false when the tree contains primitives not supported by ZSolid::GetParams.
+
+**/
+
+bool ZSolidCache::Serialize( NP** nodes, NP** par, const G4VSolid* root ) // static
+{
+    std::vector<double> nn ; 
+    std::vector<double> pp ; 
+    std::vector<std::string> names ; 
+
+    int root_idx = Serialize_r( nn, pp, names, root ); 
+    if( root_idx < 0 ) return false ; 
+
+    int num_node = nn.size()/NODE_VALUES ; 
+    assert( root_idx == num_node - 1 ); 
+
+    *nodes = NP::Make<double>( num_node, 5, 4 ); 
+    memcpy( (*nodes)->values<double>(), nn.data(), nn.size()*sizeof(double) ); 
+    (*nodes)->names = names ; 
+
+    *par = NP::Make<double>( pp.size() ); 
+    if( pp.size() > 0 ) memcpy( (*par)->values<double>(), pp.data(), pp.size()*sizeof(double) ); 
+
+    return true ; 
+}
+
+int ZSolidCache::Serialize_r( std::vector<double>& nodes, std::vector<double>& par, std::vector<std::string>& names, const G4VSolid* node_ ) // static
+{
+    G4RotationMatrix rot ; 
+    G4ThreeVector    tla(0., 0., 0.) ; 
+    const G4VSolid* node = ZSolid::Moved( &rot, &tla, node_ ); 
+    bool displaced = node != node_ ; 
+
+    int type = ZSolid::EntityType(node) ; 
+    int left = -1 ; 
+    int right = -1 ; 
+    int par_offset = par.size() ; 
+    int num_par = 0 ; 
+
+    if( ZSolid::Boolean(node) )
+    {
+        left = Serialize_r( nodes, par, names, ZSolid::Left(node) ); 
+        if( left < 0 ) return -1 ; 
+        right = Serialize_r( nodes, par, names, ZSolid::Right(node) ); 
+        if( right < 0 ) return -1 ; 
+    }
+    else
+    {
+        std::vector<double> pp ; 
+        ZSolid::GetParams( pp, node ); 
+        if( pp.size() == 0 )
+        {
+            std::cout 
+                << "ZSolidCache::Serialize_r"
+                << " unsupported primitive " << ZSolid::EntityTypeName(node) 
+                << " name " << node->GetName()
+                << std::endl 
+                ;
+            return -1 ; 
+        }
+        num_par = pp.size() ; 
+        par.insert( par.end(), pp.begin(), pp.end() ); 
+    }
+
+    int idx = nodes.size()/NODE_VALUES ; 
+    double vv[NODE_VALUES] = { 
+         double(type),     double(left),      double(right),     double(par_offset), 
+         double(num_par),  double(displaced), 0.,                0., 
+         rot.xx(),         rot.xy(),          rot.xz(),          tla.x(), 
+         rot.yx(),         rot.yy(),          rot.yz(),          tla.y(), 
+         rot.zx(),         rot.zy(),          rot.zz(),          tla.z() 
+      }; 
+    nodes.insert( nodes.end(), vv, vv + NODE_VALUES ); 
+
+    names.push_back( node->GetName() ); 
+    names.push_back( displaced ? node_->GetName() : G4String("-") ); 
+
+    return idx ; 
+}
+
+void ZSolidCache::GetTransform( G4RotationMatrix& rot, G4ThreeVector& tla, const double* n ) // static
+{
+    rot.set( CLHEP::HepRep3x3( n[8], n[9], n[10], n[12], n[13], n[14], n[16], n[17], n[18] ) ); 
+    tla.set( n[11], n[15], n[19] ); 
+}
+
+/**
+ZSolidCache::Deserialize
+--------------------------
+
+Nodes are in postorder so a single pass creates every node 
+after its constituents. Right hand transforms are passed to the G4BooleanSolid 
+ctor as done by ZSolid::BooleanClone, any other displaced nodes (displaced left 
+or root as can come from ZSolid::ApplyCutTree) are wrapped explicitly. 
+
+**/
+
+G4VSolid* ZSolidCache::Deserialize( const NP* nodes, const NP* par ) // static
+{
+    std::lock_guard<std::recursive_mutex> lock(ZSolid::StoreMutex()); 
+
+    int num_node = nodes->shape[0] ; 
+    bool expect = nodes->shape.size() == 3 && nodes->shape[1]*nodes->shape[2] == NODE_VALUES && int(nodes->names.size()) == 2*num_node ; 
+    if(!expect) std::cout << "ZSolidCache::Deserialize unexpected nodes " << nodes->sstr() << " num_names " << nodes->names.size() << std::endl ; 
+    if(!expect) return nullptr ; 
+
+    const double* nn = nodes->cvalues<double>() ; 
+    const double* pp = par->cvalues<double>() ; 
+
+    std::vector<G4VSolid*> built(num_node, nullptr) ; 
+    G4RotationMatrix rot ; 
+    G4ThreeVector    tla(0., 0., 0.) ; 
+
+    for(int i=0 ; i < num_node ; i++)
+    {
+        const double* n = nn + i*NODE_VALUES ; 
+        int type = int(n[0]) ; 
+        int left = int(n[1]) ; 
+        int right = int(n[2]) ; 
+        int par_offset = int(n[3]) ; 
+        int num_par = int(n[4]) ; 
+        const G4String name = nodes->names[2*i] ; 
+
+        G4VSolid* solid = nullptr ; 
+        if( left > -1 && right > -1 )
+        {
+            const double* ln = nn + left*NODE_VALUES ; 
+            const double* rn = nn + right*NODE_VALUES ; 
+
+            G4VSolid* l = built[left] ; 
+            if( ln[5] != 0. )
+            {
+                GetTransform( rot, tla, ln ); 
+                l = new G4DisplacedSolid( nodes->names[2*left+1], l, &rot, tla ); 
+            }
+
+            G4VSolid* r = built[right] ; 
+            bool rdisp = rn[5] != 0. ; 
+            if( rdisp ) GetTransform( rot, tla, rn ); 
+
+            switch(type)
+            {
+                case ZSolid::_G4UnionSolid:        solid = rdisp ? new G4UnionSolid(        name, l, r, &rot, tla ) : new G4UnionSolid(        name, l, r ) ; break ; 
+                case ZSolid::_G4IntersectionSolid: solid = rdisp ? new G4IntersectionSolid( name, l, r, &rot, tla ) : new G4IntersectionSolid( name, l, r ) ; break ; 
+                case ZSolid::_G4SubtractionSolid:  solid = rdisp ? new G4SubtractionSolid(  name, l, r, &rot, tla ) : new G4SubtractionSolid(  name, l, r ) ; break ; 
+            }
+        }
+        else
+        {
+            solid = ZSolid::MakePrimitive( type, name, pp + par_offset, num_par ); 
+        }
+        if( solid == nullptr ) return nullptr ; 
+        built[i] = solid ; 
+    }
+
+    G4VSolid* root = built[num_node-1] ; 
+    const double* rootn = nn + (num_node-1)*NODE_VALUES ; 
+    if( rootn[5] != 0. )
+    {
+        GetTransform( rot, tla, rootn ); 
+        root = new G4DisplacedSolid( nodes->names[2*(num_node-1)+1], root, &rot, tla ); 
+    }
+    return root ; 
+}
+
+bool ZSolidCache::Save( const char* name, const G4VSolid* solid, double build_time ) // static
+{
+    if( !Enabled() || solid == nullptr ) return false ; 
+
+    NP* nodes = nullptr ; 
+    NP* par = nullptr ; 
+    bool ok = Serialize( &nodes, &par, solid ); 
+    if(!ok) return false ; 
+
+    std::string path = Path(name) ; 
+    nodes->set_meta<std::string>("name", name ); 
+    nodes->set_meta<std::string>("key", OptionsKey(name) ); 
+    nodes->set_meta<int>("version", VERSION ); 
+    nodes->set_meta<double>("build_time", build_time ); 
+    nodes->save( path.c_str(), "nodes.npy" ); 
+    par->save(   path.c_str(), "par.npy" ); 
+
+    if(ZSolid::verbose) std::cout 
+        << "ZSolidCache::Save"
+        << " name " << name 
+        << " path " << path 
+        << " nodes " << nodes->sstr()
+        << " par " << par->sstr()
+        << std::endl 
+        ;
+
+    delete nodes ; 
+    delete par ; 
+    return true ; 
+}
+
+/**
+ZSolidCache::Load
+-------------------
+
+Returns nullptr when the cache is not enabled or there is no entry 
+for the name and current options, otherwise reconstructs the tree 
+and records the load time together with the build time from the entry.   
+Entries with a version other than VERSION also return nullptr, 
+so the caller rebuilds the solid and Save replaces the entry. 
+
+**/
+
+G4VSolid* ZSolidCache::Load( const char* name ) // static
+{
+    if( !Enabled() ) return nullptr ; 
+    std::string path = Path(name) ; 
+    if( !NP::Exists( path.c_str(), "nodes.npy" ) || !NP::Exists( path.c_str(), "par.npy" ) ) return nullptr ; 
+
+    typedef std::chrono::high_resolution_clock Clock ; 
+    Clock::time_point t0 = Clock::now(); 
+
+    NP* nodes = NP::Load( path.c_str(), "nodes.npy" ); 
+    NP* par   = NP::Load( path.c_str(), "par.npy" ); 
+
+    int version = nodes ? nodes->get_meta<int>("version", -1) : -1 ; 
+    if( version != VERSION )
+    {
+        std::cout 
+            << "ZSolidCache::Load"
+            << " name " << name 
+            << " STALE entry version " << version 
+            << " expect " << VERSION 
+            << " : rebuilding " 
+            << std::endl 
+            ;
+        delete nodes ; 
+        delete par ; 
+        return nullptr ; 
+    }
+
+    G4VSolid* solid = nodes && par ? Deserialize( nodes, par ) : nullptr ; 
+
+    Clock::time_point t1 = Clock::now(); 
+
+    Record rec ; 
+    rec.name = name ; 
+    rec.build_time = nodes ? nodes->get_meta<double>("build_time", 0.) : 0. ; 
+    rec.load_time = std::chrono::duration<double>(t1 - t0).count() ; 
+
+    if( solid ) RECORDS.push_back(rec); 
+
+    std::cout 
+        << "ZSolidCache::Load"
+        << " name " << std::setw(30) << name 
+        << ( solid ? " " : " FAILED " )
+        << " build_time " << std::fixed << std::setw(10) << std::setprecision(4) << rec.build_time 
+        << " load_time "  << std::fixed << std::setw(10) << std::setprecision(4) << rec.load_time 
+        << " saved "      << std::fixed << std::setw(10) << std::setprecision(4) << rec.build_time - rec.load_time 
+        << std::endl 
+        ;
+
+    delete nodes ; 
+    delete par ; 
+    return solid ; 
+}
+
+/**
+ZSolidCache::Desc
+-------------------
+
+Startup time saved per solid and in total by cache loads in this process. 
+Solid names start with the manager prefix (hama/nnvt/hmsk/nmsk/...).
+
+**/
+
+std::string ZSolidCache::Desc() // static
+{
+    std::stringstream ss ; 
+    ss << "ZSolidCache::Desc dir " << ( Dir() ? Dir() : "-" ) << " num_load " << RECORDS.size() << std::endl ; 
+    double tot_build = 0. ; 
+    double tot_load = 0. ; 
+    for(unsigned i=0 ; i < RECORDS.size() ; i++)
+    {
+        const Record& r = RECORDS[i] ; 
+        ss << std::setw(30) << r.name 
+           << " build_time " << std::fixed << std::setw(10) << std::setprecision(4) << r.build_time 
+           << " load_time "  << std::fixed << std::setw(10) << std::setprecision(4) << r.load_time 
+           << " saved "      << std::fixed << std::setw(10) << std::setprecision(4) << r.build_time - r.load_time 
+           << std::endl 
+           ;
+        tot_build += r.build_time ; 
+        tot_load += r.load_time ; 
+    }
+    ss << std::setw(30) << "TOTAL"
+       << " build_time " << std::fixed << std::setw(10) << std::setprecision(4) << tot_build 
+       << " load_time "  << std::fixed << std::setw(10) << std::setprecision(4) << tot_load 
+       << " saved "      << std::fixed << std::setw(10) << std::setprecision(4) << tot_build - tot_load 
+       << std::endl 
+       ;
+    std::string s = ss.str(); 
+    return s ; 
+}
+
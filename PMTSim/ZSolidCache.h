@@ -0,0 +1,97 @@
+#pragma once
+/**
+ZSolidCache : persistent NP cache of final ZSolid processed trees
+====================================================================
+
+Building solids via the managers and then applying ZSolid::ApplyZCutTree, 
+DeepClone etc.. is repeated by every job. The cache serializes 
+the final G4VSolid trees into NP arrays so subsequent jobs can 
+reconstruct the trees directly, skipping manager construction 
+and the zcut analysis and cloning. 
+
+Enabled by setting the PMTSim_CACHE envvar to a directory. 
+Each solid is saved into a subdirectory named from the solid name 
+and a digest of the geometry options (see OptionsKey) containing:
+
+nodes.npy
+    shape (num_node, 5, 4) in postorder, so children precede parents 
+    and the root is last::
+
+        q0 : type, left, right, par_offset    (left, right -1 for primitives)
+        q1 : num_par, displaced, 0, 0 
+        q2 : xx xy xz tx          frame rotation rows and object translation 
+        q3 : yx yy yz ty          of the G4DisplacedSolid wrapping the node
+        q4 : zx zy zz tz          (identity when not displaced) 
+
+    Metadata records the build time of the original tree. 
+    The names (two per node : node name, G4DisplacedSolid name or "-") 
+    are saved by NP alongside the array. 
+
+par.npy
+    primitive parameters in ZSolid::GetParams order 
+
+Trees with primitives not supported by ZSolid::GetParams are not cached. 
+
+The entries only depend on the options, not on the code that built the trees, 
+so VERSION must be incremented with any change to the geometry code 
+(managers, ZSolid cutting) or the serialization that changes the trees. 
+VERSION is part of the OptionsKey and recorded in the metadata, entries 
+from other versions are not loaded and the solids are rebuilt. 
+
+Usage::
+
+    G4VSolid* solid = ZSolidCache::Load(name) ;   // nullptr when not cached
+    if(solid == nullptr)
+    {
+        solid = build(name) ; 
+        ZSolidCache::Save(name, solid, build_time ); 
+    }
+    std::cout << ZSolidCache::Desc() ;   
+
+**/
+
+class G4VSolid ;
+struct NP ;
+
+#include <string>
+#include <vector>
+
+#include "G4ThreeVector.hh"
+#include "G4RotationMatrix.hh"
+
+#ifdef PMTSIM_STANDALONE
+#include "PMTSIM_API_EXPORT.hh"
+struct PMTSIM_API ZSolidCache
+{
+#else
+struct ZSolidCache
+{
+#endif
+    static const char* DIR_KEY ;
+    static constexpr const int VERSION = 1 ;     // increment when the geometry code changes the trees
+    static constexpr const int NODE_VALUES = 5*4 ;
+
+    struct Record
+    {
+        std::string name ;
+        double      build_time ;
+        double      load_time ;
+    };
+    static std::vector<Record> RECORDS ;
+
+    static const char* Dir();
+    static bool        Enabled();
+    static std::string EnvOptions();
+    static std::string OptionsKey( const char* name );
+    static std::string Path( const char* name );
+
+    static bool      Serialize( NP** nodes, NP** par, const G4VSolid* root );
+    static int       Serialize_r( std::vector<double>& nodes, std::vector<double>& par, std::vector<std::string>& names, const G4VSolid* node_ );
+    static G4VSolid* Deserialize( const NP* nodes, const NP* par );
+    static void      GetTransform( G4RotationMatrix& rot, G4ThreeVector& tla, const double* node );
+
+    static bool      Save( const char* name, const G4VSolid* solid, double build_time );
+    static G4VSolid* Load( const char* name );
+    static std::string Desc();
+};
+
@@ -0,0 +1,218 @@
+#include <cassert>
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+
+#include "G4VSolid.hh"
+#include "G4BooleanSolid.hh"
+#include "G4DisplacedSolid.hh"
+#include "G4RotationMatrix.hh"
+#include "G4ThreeVector.hh"
+
+#include "ZSolid.h"
+#include "ZSolidRegistry.h"
+
+ZSolidRegistry* ZSolidRegistry::INSTANCE = nullptr ;
+
+ZSolidRegistry* ZSolidRegistry::Get() // static
+{
+    static std::mutex get_mtx ;
+    std::lock_guard<std::mutex> lock(get_mtx);
+    if(INSTANCE == nullptr) INSTANCE = new ZSolidRegistry ;
+    return INSTANCE ;
+}
+
+ZSolidRegistry::ZSolidRegistry()
+    :
+    num_tree(0),
+    num_visit(0),
+    num_unique(0),
+    num_copy(0),
+    num_shared_prim(0),
+    num_shared_bool(0),
+    bytes_unique(0),
+    bytes_saved(0)
+{
+}
+
+/**
+ZSolidRegistry::intern
+------------------------
+
+Returns the canonical tree for *root*, which may be *root* itself
+(with some subtrees replaced by previously registered ones) or a
+previously registered tree when the entire tree was seen before.
+
+A G4DisplacedSolid root (as can be returned by ZSolid::ApplyCutTree)
+is interned via its moved solid and rewrapped when that changes.
+
+**/
+
+G4VSolid* ZSolidRegistry::intern( G4VSolid* root )
+{
+    if(root == nullptr) return nullptr ;
+    std::lock_guard<std::mutex> lock(mtx);
+    num_tree += 1 ;
+
+    G4RotationMatrix rot ;
+    G4ThreeVector    tla(0., 0., 0.) ;
+    G4VSolid* node = ZSolid::Moved_( &rot, &tla, root );
+
+    std::string bytes ;
+    G4VSolid* canon = intern_r( node, bytes, 0 );
+
+    G4VSolid* result = root ;
+    if( node == root )
+    {
+        result = canon ;
+    }
+    else if( canon != node )
+    {
+        result = new G4DisplacedSolid( root->GetName(), canon, &rot, tla );
+    }
+
+    if(ZSolid::verbose) std::cout
+        << "ZSolidRegistry::intern"
+        << " root " << root->GetName()
+        << " result " << result->GetName()
+        << " digest " << std::hex << ZSolid::Hash(bytes) << std::dec
+        << std::endl
+        ;
+
+    return result ;
+}
+
+/**
+ZSolidRegistry::intern_r
+--------------------------
+
+Postorder traversal : children are interned first so that the
+*bytes* of this node are assembled from those of the children
+in the same layout as ZSolid::CanonicalBytes_r without re-traversal.
+
+When a child is replaced by a previously registered node the boolean is
+not changed in place, a new boolean referencing the canonical children is
+created instead (unless an identical one was registered already).
+So the trees passed to *intern*, which may be held by their managers,
+by ZSolidCache or by other callers, are never mutated.
+
+**/
+
+G4VSolid* ZSolidRegistry::intern_r( G4VSolid* node, std::string& bytes, int depth )
+{
+    assert( !ZSolid::Displaced(node) );
+    int type = ZSolid::EntityType(node) ;
+    bytes.clear();
+    bytes.append( (const char*)&type, sizeof(int) );
+
+    if( ZSolid::Boolean(node) )
+    {
+        G4VSolid* left = ZSolid::Left_(node) ;
+        G4RotationMatrix rrot ;
+        G4ThreeVector    rtla(0., 0., 0.) ;
+        G4VSolid* right = ZSolid::Moved_( &rrot, &rtla, ZSolid::Right_(node) );
+
+        std::string lbytes ;
+        std::string rbytes ;
+        G4VSolid* cl = intern_r( left,  lbytes, depth+1 );
+        G4VSolid* cr = intern_r( right, rbytes, depth+1 );
+
+        bytes += lbytes ;
+        ZSolid::AppendTransformBytes( bytes, rrot, rtla );
+        bytes += rbytes ;
+
+        if( (cl != left || cr != right) && canonical.count(bytes) == 0 ) 
+        {
+            node = ZSolid::MakeBoolean( type, node->GetName(), cl, cr, rtla, &rrot );   // copy on write : the original is not changed
+            num_copy += 1 ;
+        }
+    }
+    else
+    {
+        ZSolid::AppendPrimitiveBytes( bytes, node );
+    }
+
+    num_visit += 1 ;
+
+    G4VSolid* canon = nullptr ;
+    std::unordered_map<std::string, G4VSolid*>::const_iterator it = canonical.find(bytes) ;
+    if( it != canonical.end() )
+    {
+        canon = it->second ;
+        if( canon != node )
+        {
+            if(ZSolid::Boolean(node)) num_shared_bool += 1 ;
+            else                      num_shared_prim += 1 ;
+            bytes_saved += ZSolid::ApproxBytes(node) ;
+        }
+    }
+    else
+    {
+        canon = node ;
+        canonical[bytes] = node ;
+        digests[node] = ZSolid::Hash(bytes) ;
+        num_unique += 1 ;
+        bytes_unique += ZSolid::ApproxBytes(node) ;
+    }
+
+    if(ZSolid::verbose) std::cout
+        << "ZSolidRegistry::intern_r"
+        << " depth " << std::setw(2) << depth
+        << " name " << std::setw(40) << node->GetName()
+        << " canon " << std::setw(40) << canon->GetName()
+        << ( canon == node ? "" : " SHARED" )
+        << std::endl
+        ;
+
+    return canon ;
+}
+
+bool ZSolidRegistry::has_digest( const G4VSolid* solid ) const
+{
+    return digests.count(solid) == 1 ;
+}
+
+uint64_t ZSolidRegistry::digest( const G4VSolid* solid ) const
+{
+    std::map<const G4VSolid*, uint64_t>::const_iterator it = digests.find(solid) ;
+    return it == digests.end() ? ZSolid::Digest(solid) : it->second ;
+}
+
+int ZSolidRegistry::num_shared() const
+{
+    return num_shared_prim + num_shared_bool ;
+}
+
+void ZSolidRegistry::clear()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    canonical.clear();
+    digests.clear();
+    num_tree = 0 ;
+    num_visit = 0 ;
+    num_unique = 0 ;
+    num_copy = 0 ;
+    num_shared_prim = 0 ;
+    num_shared_bool = 0 ;
+    bytes_unique = 0 ;
+    bytes_saved = 0 ;
+}
+
+std::string ZSolidRegistry::desc() const
+{
+    std::stringstream ss ;
+    ss << "ZSolidRegistry::desc" << std::endl
+       << " num_tree        " << std::setw(10) << num_tree << std::endl
+       << " num_visit       " << std::setw(10) << num_visit << std::endl
+       << " num_unique      " << std::setw(10) << num_unique << std::endl
+       << " num_copy        " << std::setw(10) << num_copy << std::endl
+       << " num_shared      " << std::setw(10) << num_shared() << std::endl
+       << " num_shared_prim " << std::setw(10) << num_shared_prim << std::endl
+       << " num_shared_bool " << std::setw(10) << num_shared_bool << std::endl
+       << " bytes_unique    " << std::setw(10) << bytes_unique << " (approx)" << std::endl
+       << " bytes_saved     " << std::setw(10) << bytes_saved  << " (approx)" << std::endl
+       ;
+    std::string s = ss.str();
+    return s ;
+}
+
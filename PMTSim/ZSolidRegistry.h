@@ -0,0 +1,69 @@
+#pragma once
+/**
+ZSolidRegistry : dedupes structurally identical CSG subtrees
+================================================================
+
+Trees are interned in postorder : each node is keyed by its
+ZSolid::CanonicalBytes (types, right transforms and primitive parameters
+but not names or addresses) and when an identical node has been seen before,
+from the same or any other tree, the parent is replaced by a new boolean
+referencing the previously registered node (copy on write), so the
+trees passed in are never mutated and callers may keep holding them.
+
+As Geant4 boolean trees reference constituents by pointer, sharing
+constituents between trees is fine. Note however that names of shared
+nodes come from the first registration.
+
+The digest of registered nodes allows downstream consumers
+(eg GPU translation, caching) to treat identical subtrees once.
+
+Usage::
+
+    G4VSolid* solid = ZSolidRegistry::Get()->intern(solid) ;
+    std::cout << ZSolidRegistry::Get()->desc() ;
+
+**/
+
+class G4VSolid ;
+
+#include <cstdint>
+#include <string>
+#include <map>
+#include <unordered_map>
+#include <mutex>
+
+#ifdef PMTSIM_STANDALONE
+#include "PMTSIM_API_EXPORT.hh"
+struct PMTSIM_API ZSolidRegistry
+{
+#else
+struct ZSolidRegistry
+{
+#endif
+    static ZSolidRegistry* INSTANCE ;
+    static ZSolidRegistry* Get();
+
+    std::mutex                                  mtx ;
+    std::unordered_map<std::string, G4VSolid*>  canonical ;
+    std::map<const G4VSolid*, uint64_t>         digests ;
+
+    int    num_tree ;
+    int    num_visit ;
+    int    num_unique ;
+    int    num_copy ;       // booleans created to reference shared children
+    int    num_shared_prim ;
+    int    num_shared_bool ;
+    size_t bytes_unique ;
+    size_t bytes_saved ;
+
+    ZSolidRegistry();
+
+    G4VSolid*   intern( G4VSolid* root );
+    G4VSolid*   intern_r( G4VSolid* node, std::string& bytes, int depth );
+    bool        has_digest( const G4VSolid* solid ) const ;
+    uint64_t    digest( const G4VSolid* solid ) const ;
+    int         num_shared() const ;
+    void        clear();
+    std::string desc() const ;
+};
+
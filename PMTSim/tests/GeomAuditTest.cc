@@ -0,0 +1,66 @@
+/**
+GeomAuditTest.cc
+==================
+
+Memory footprint report of the LVs of several managers and option variants,
+variants are created by separate PMTSim instances (see PMTSim::Get) so the
+union row shows how much is shared between them::
+
+    GeomAuditTest
+    LVNAMES=hamaLogicalPMT,hamaLogicalPMT:nurs,hamaLogicalPMT:prtc GeomAuditTest
+    GeomAuditTest_FOLD=/tmp/$USER/GeomAuditTest GeomAuditTest   # save NP array
+
+**/
+
+#include <cassert>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "ssys.h"
+#include "G4LogicalVolume.hh"
+
+#include "PMTSim.hh"
+#include "GeomAudit.h"
+
+int main(int argc, char** argv)
+{
+    const char* lvnames = ssys::getenvvar("LVNAMES", "hamaLogicalPMT,hamaLogicalPMT:nurs,nnvtLogicalPMT" );
+    const char* fold = ssys::getenvvar("GeomAuditTest_FOLD");
+
+    std::vector<std::string> names ;
+    std::stringstream ss(lvnames) ;
+    std::string name ;
+    while(std::getline(ss, name, ',')) if(!name.empty()) names.push_back(name) ;
+
+    GeomAudit audit ;
+    for(unsigned i=0 ; i < names.size() ; i++)
+    {
+        G4LogicalVolume* lv = PMTSim::GetLV(names[i].c_str()) ;
+        if( lv == nullptr ) std::cerr << "GeomAuditTest.main FAILED to get LV " << names[i] << std::endl ;
+        audit.add( names[i].c_str(), lv );
+    }
+
+    std::cout << audit.desc() ;
+    std::cout << audit.projection(17612) ;   // LPMT
+    std::cout << audit.projection(25600) ;   // SPMT
+
+    GeomAudit::Entry u = audit.combined() ;
+    size_t sum_solids = 0 ;
+    for(unsigned i=0 ; i < audit.entries.size() ; i++)
+    {
+        const GeomAudit::Entry& e = audit.entries[i] ;
+        assert( e.lvs.count(e.top) == 1 );
+        assert( e.touchables >= e.lvs.size() );
+        sum_solids += e.solids.size() ;
+    }
+    assert( u.solids.size() <= sum_solids );
+    assert( u.bytes() <= audit.sum_bytes() );
+
+    NP* a = audit.array() ;
+    std::cout << "GeomAuditTest.main " << a->sstr() << std::endl ;
+    if(fold) a->save(fold, "GeomAudit.npy") ;
+
+    return 0 ;
+}
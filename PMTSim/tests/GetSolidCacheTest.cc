@@ -0,0 +1,89 @@
+/**
+GetSolidCacheTest.cc
+======================
+
+Checks the process wide cache of PMTSim : repeated requests 
+with the same name and options return the same objects, 
+the managers are constructed once for each set of options 
+PMTSim::ClearCache forces construction of new objects and 
+changing a manager property envvar gives a cache miss::
+
+    GetSolidCacheTest
+    GEOM=hmskSolidMask GetSolidCacheTest
+
+**/
+
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include "ssys.h"
+#include "PMTSim.hh"
+
+typedef std::chrono::high_resolution_clock Clock ; 
+
+double Seconds( Clock::time_point t0 )
+{
+    return std::chrono::duration<double>(Clock::now() - t0).count() ; 
+}
+
+int main(int argc, char** argv)
+{
+    const char* geom = ssys::getenvvar("GEOM", "nnvtBodySolid" );
+    const char* lvname = ssys::getenvvar("LVNAME", "nnvtLogicalPMT" );
+
+    Clock::time_point t0 = Clock::now(); 
+    const G4VSolid* s0 = PMTSim::GetSolid(geom); 
+    double dt0 = Seconds(t0); 
+
+    Clock::time_point t1 = Clock::now(); 
+    const G4VSolid* s1 = PMTSim::GetSolid(geom); 
+    double dt1 = Seconds(t1); 
+
+    PMTSim* ps0 = PMTSim::Get(); 
+    PMTSim* ps1 = PMTSim::Get(); 
+
+    G4LogicalVolume* lv0 = PMTSim::GetLV(lvname); 
+    G4LogicalVolume* lv1 = PMTSim::GetLV(lvname); 
+
+    std::cout 
+        << "GetSolidCacheTest.main"
+        << " geom " << geom 
+        << " first " << dt0 
+        << " second " << dt1 
+        << std::endl 
+        << PMTSim::DescCache() 
+        ;
+
+    assert( s0 && s0 == s1 ); 
+    assert( ps0 == ps1 ); 
+    assert( lv0 && lv0 == lv1 ); 
+    assert( PMTSim::NUM_HIT >= 2 ); 
+
+    PMTSim::ClearCache(); 
+
+    const G4VSolid* s2 = PMTSim::GetSolid(geom); 
+    PMTSim* ps2 = PMTSim::Get(); 
+
+    std::cout << "GetSolidCacheTest.main after ClearCache " << PMTSim::DescCache() ; 
+
+    assert( s2 && s2 != s0 ); 
+    assert( ps2 != ps0 ); 
+
+    // manager property "objName_key" envvars are part of the key 
+    int miss0 = PMTSim::NUM_MISS ; 
+    setenv("lchi_Reflectivity", "0.5", 1 ); 
+    const G4VSolid* s3 = PMTSim::GetSolid(geom); 
+    PMTSim* ps3 = PMTSim::Get(); 
+
+    std::cout << "GetSolidCacheTest.main after setenv lchi_Reflectivity " << PMTSim::DescCache() ; 
+
+    assert( PMTSim::NUM_MISS == miss0 + 1 ); 
+    assert( s3 && s3 != s2 ); 
+    assert( ps3 != ps2 ); 
+
+    unsetenv("lchi_Reflectivity"); 
+    const G4VSolid* s4 = PMTSim::GetSolid(geom); 
+    assert( s4 == s2 ); 
+
+    return 0 ; 
+}
@@ -0,0 +1,82 @@
+/**
+IGeomOptionsTest.cc
+=====================
+
+Checks IGeomManager::declProp resolution from the IGeomOptions snapshot: 
+envvars override defaults, later setenv is seen by managers constructed 
+afterwards as the ctor syncs the snapshot, an unchanged environment does 
+not reparse, the geom chopping and the resolved values are dumped::
+
+    IGeomOptionsTest
+    IGeomOptions_DUMP=/tmp/IGeomOptionsTest.sh IGeomOptionsTest
+
+**/
+
+#include <cassert>
+#include <cstdlib>
+#include <string>
+#include <iostream>
+#include "IGeomManager.h"
+
+struct DemoManager : public IGeomManager
+{
+    bool        m_flag ; 
+    double      m_scale ; 
+    std::string m_mat ; 
+
+    DemoManager(const std::string& name) : IGeomManager(name) 
+    {
+        declProp("Flag",  m_flag=false ); 
+        declProp("Scale", m_scale=1.5 ); 
+        declProp("Material", m_mat="Water" ); 
+    }
+
+    std::string      desc() const { return "DemoManager" ; }
+    G4LogicalVolume* getLV(){ return nullptr ; }
+    G4LogicalVolume* getLV(const char* ){ return nullptr ; }
+    G4PVPlacement*   getPV(const char* ){ return nullptr ; }
+    G4VSolid*        getSolid(const char* ){ return nullptr ; }
+};
+
+int main(int argc, char** argv)
+{
+    setenv("demo_Scale", "2.5", 1 ); 
+    setenv("demo_Material", "Cheese", 1 ); 
+    IGeomOptions::Refresh(); 
+
+    std::string name = "demo" ; 
+    DemoManager m0(name) ; 
+    assert( m0.m_flag == false ); 
+    assert( m0.m_scale == 2.5 ); 
+    assert( m0.m_mat == "Cheese" ); 
+
+    setenv("demo_Flag", "1", 1 ); 
+    DemoManager m1(name) ; 
+    assert( m1.m_flag == true );   // ctor synced the snapshot 
+
+    int gen = IGeomOptions::Get()->generation ; 
+    DemoManager m2(name) ; 
+    assert( m2.m_flag == true ); 
+    assert( IGeomOptions::Get()->generation == gen );   // unchanged environment not reparsed 
+
+    unsetenv("demo_Flag"); 
+    DemoManager m3(name) ; 
+    assert( m3.m_flag == false ); 
+    assert( IGeomOptions::Get()->generation == gen + 1 ); 
+
+    m3.setGeom("0123demoSolid__tail_opt"); 
+    assert( std::string(m3.getHead()) == "demoSolid" ); 
+    assert( std::string(m3.getTail()) == "tail_opt" ); 
+    assert( m3.hasOpt("opt") && !m3.hasOpt("other") ); 
+    m3.setGeom("0123demoSolid"); 
+    assert( std::string(m3.getHead()) == "demoSolid" ); 
+    assert( m3.getTail() == nullptr && !m3.hasOpt("opt") ); 
+
+    assert( IGeomManager::EnvKey("demo", "Flag") == "demo_Flag" ); 
+
+    std::cout << IGeomOptions::Get()->desc() ; 
+    std::cout << IGeomOptions::Get()->exports() ; 
+    IGeomOptions::SaveEnv(); 
+
+    return 0 ; 
+}
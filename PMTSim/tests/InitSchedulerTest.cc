@@ -0,0 +1,82 @@
+/**
+InitSchedulerTest.cc
+======================
+
+Synthetic startup with sleeping tasks checking the tasks run in the order
+added with their dependencies done, and that the critical path follows
+the longest dependency chain. Zero duration tasks check that the walk
+back terminates::
+
+    InitSchedulerTest
+
+**/
+
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include "InitScheduler.h"
+
+void Sleep(int ms){ std::this_thread::sleep_for(std::chrono::milliseconds(ms)) ; }
+
+void test_sleep()
+{
+    InitScheduler sched ;
+    int dc = sched.add("dc", [](){ Sleep(20) ; } );
+    const char* labels[4] = { "hama", "nnvt", "hmsk", "nmsk" } ;
+    for(int i=0 ; i < 4 ; i++)
+    {
+        std::string ctor = std::string(labels[i]) + ".ctor" ;
+        int c = sched.add(ctor.c_str(), [](){ Sleep(30) ; } );
+        sched.add(labels[i], [](){ Sleep(10) ; }, {dc, c} );
+    }
+    sched.run();
+    std::cout << sched.timeline() ;
+
+    for(unsigned i=0 ; i < sched.tasks.size() ; i++)
+    {
+        const InitScheduler::Task& t = sched.tasks[i] ;
+        assert( t.state == InitScheduler::DONE );
+        for(unsigned j=0 ; j < t.deps.size() ; j++) assert( sched.tasks[t.deps[j]].t1 <= t.t0 );
+        if( i > 0 ) assert( sched.tasks[i-1].t1 <= t.t0 );
+    }
+
+    // longest chain is a 30ms ctor followed by its 10ms getLV, not the 20ms dc
+    std::vector<int> path ;
+    sched.critical_path(path);
+    assert( path.size() == 2 );
+    const std::string& first = sched.tasks[path[0]].name ;
+    assert( first.size() > 5 && first.compare(first.size()-5, 5, ".ctor") == 0 );
+    assert( path[1] == path[0] + 1 );
+    assert( sched.critical_total() < sched.total() );
+
+    std::cout
+        << "InitSchedulerTest.test_sleep"
+        << " total " << sched.total()
+        << " critical " << sched.critical_total()
+        << std::endl
+        ;
+}
+
+void test_zero_duration()
+{
+    InitScheduler sched ;
+    int a = sched.add("a", [](){} );
+    int b = sched.add("b", [](){}, {a} );
+    sched.add("c", [](){} );
+    sched.add("d", [](){}, {a, b} );
+    sched.run();
+
+    std::vector<int> path ;
+    sched.critical_path(path);
+    assert( path.size() >= 1 && path.size() <= sched.tasks.size() );
+    for(unsigned i=1 ; i < path.size() ; i++) assert( path[i-1] < path[i] );
+    std::cout << sched.timeline() ;
+}
+
+int main(int argc, char** argv)
+{
+    test_sleep();
+    test_zero_duration();
+    return 0 ;
+}
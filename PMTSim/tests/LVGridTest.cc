@@ -0,0 +1,89 @@
+/**
+LVGridTest.cc
+===============
+
+Builds LVGrid worlds of copies of an LV in each mode, then locates random 
+points with G4Navigator comparing the number of points within the LV 
+copies between modes together with the location time and the number of 
+physical volumes created::
+
+    LVGridTest
+    GEOM=nnvtLogicalPMT LVGridTest 
+    N=10 NUM=1000000 LVGridTest        # (2*10+1)^3 = 9261 copies 
+    LAYOUT=sphere LVGrid_NUM=17612 LVGridTest 
+
+**/
+
+#include <cassert>
+#include <cstdio>
+#include <chrono>
+#include <random>
+#include <iostream>
+
+#include "ssys.h"
+#include "G4NistManager.hh"
+#include "G4Navigator.hh"
+#include "G4Ellipsoid.hh"
+#include "G4Tubs.hh"
+#include "G4UnionSolid.hh"
+#include "G4LogicalVolume.hh"
+#include "G4VPhysicalVolume.hh"
+
+#include "PMTSim.hh"
+#include "LVGrid.h"
+
+G4LogicalVolume* make_lv()
+{
+    G4Material* mat = G4NistManager::Instance()->FindOrBuildMaterial("G4_Galactic"); 
+    G4VSolid* ell  = new G4Ellipsoid("ell", 254., 254., 190., -190., 190. ); 
+    G4VSolid* neck = new G4Tubs(     "neck", 0., 50., 100., 0., 2.*CLHEP::pi ); 
+    G4VSolid* pmt  = new G4UnionSolid("pmt", ell, neck, 0, G4ThreeVector(0., 0., -250.) ); 
+    return new G4LogicalVolume(pmt, mat, "pmt_lv", 0,0,0 ); 
+}
+
+void test_mode(G4LogicalVolume* lv, int mode, int layout, int n, int num)
+{
+    LVGrid grid(lv, n, n, n, mode ); 
+    if( layout == LVGrid::SPHERE ) grid.setSphere( ssys::getenvint("LVGrid_NUM", 17612) ); 
+
+    G4VPhysicalVolume* world_pv = grid.build(); 
+    assert( world_pv ); 
+
+    G4Navigator nav ; 
+    nav.SetWorldVolume(world_pv); 
+
+    double hs = grid.halfside() ; 
+    std::mt19937 engine(0) ; 
+    std::uniform_real_distribution<double> u(-hs, hs) ; 
+
+    typedef std::chrono::high_resolution_clock Clock ; 
+    Clock::time_point t0 = Clock::now(); 
+    int count = 0 ; 
+    for(int i=0 ; i < num ; i++)
+    {
+        G4ThreeVector p( u(engine), u(engine), u(engine) ); 
+        G4VPhysicalVolume* pv = nav.LocateGlobalPointAndSetup(p, nullptr, false, true ); 
+        if( pv && pv->GetLogicalVolume() == lv ) count += 1 ; 
+    }
+    Clock::time_point t1 = Clock::now(); 
+
+    std::cout << grid.desc() << std::endl ; 
+    printf("test_mode %15s count %8d num %8d locate_time %10.4f \n", LVGrid::ModeName(mode), count, num, std::chrono::duration<double>(t1 - t0).count() ); 
+}
+
+int main(int argc, char** argv)
+{
+    const char* geom = ssys::getenvvar("GEOM", nullptr ); 
+    G4LogicalVolume* lv = geom ? PMTSim::GetLV(geom) : make_lv() ; 
+    assert(lv); 
+
+    int n = ssys::getenvint("N", 2) ; 
+    int num = ssys::getenvint("NUM", 100000) ; 
+    int layout = LVGrid::Layout(ssys::getenvvar("LAYOUT", "grid")) ; 
+
+    test_mode(lv, LVGrid::PLACEMENT,     layout, n, num ); 
+    test_mode(lv, LVGrid::PARAMETERISED, layout, n, num ); 
+    if( layout == LVGrid::GRID ) test_mode(lv, LVGrid::REPLICA, layout, n, num ); 
+
+    return 0 ; 
+}
@@ -0,0 +1,206 @@
+/**
+MaterialSvcArchiveTest.cc
+===========================
+
+Converts text property tables into the MaterialSvc archive, reloads it 
+and compares the properties and MPV from the archive with those from text, 
+reporting the times::
+
+    MaterialSvcArchiveTest
+    MaterialSvcArchiveTest Material.LS.RINDEX Material.Pyrex.RINDEX
+
+Requires JUNOTOP for the text tables, skipped when not defined. 
+test_duplicates_and_digest always runs with a table written below 
+a scratch JUNOTOP, checking duplicated energies and stale archive detection. 
+
+**/
+
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <unistd.h>
+#include <fstream>
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include <string>
+
+#include "NP.hh"
+#include "MaterialSvc.hh"
+#include "G4MaterialPropertyVector.hh"    // typedef 
+
+typedef std::chrono::high_resolution_clock Clock ; 
+
+double Seconds( Clock::time_point t0 )
+{
+    return std::chrono::duration<double>(Clock::now() - t0).count() ; 
+}
+
+G4MaterialPropertyVector* InsertMPV( const IMCParamsSvc::vec_d2d& props )
+{
+    G4MaterialPropertyVector* mpv = new G4MaterialPropertyVector(0,0,0);
+    for (unsigned i = 0; i < props.size(); ++i) mpv->InsertValues(props[i].get<0>(), props[i].get<1>() );
+    return mpv ; 
+}
+
+void write_table( const std::string& path, double last )
+{
+    std::ofstream fp(path.c_str(), std::ios::out); 
+    fp << "1.55 eV 1.30" << std::endl ; 
+    fp << "2.00 eV 1.31" << std::endl ; 
+    fp << "2.00 eV 1.32" << std::endl ; 
+    fp << "3.00 eV 1.33" << std::endl ; 
+    fp << "2.00 eV " << last << std::endl ; 
+    fp.close(); 
+}
+
+/**
+test_duplicates_and_digest
+----------------------------
+
+The table has energy 2 eV three times, InsertValues leaves those points 
+in reverse file order which ArchiveMPV must reproduce. 
+Editing the table after saving changes the digest so the archive is not loaded. 
+
+**/
+
+void test_duplicates_and_digest()
+{
+    std::string junotop0 = getenv("JUNOTOP") ? getenv("JUNOTOP") : "" ; 
+    std::string top = "/tmp/MaterialSvcArchiveTest_junotop" ; 
+    std::string tdir = top + "/data/Simulation/DetSim/Material/Demo" ; 
+    int rc = system( ("mkdir -p " + tdir).c_str() ); 
+    assert( rc == 0 ); 
+    std::string path = tdir + "/RINDEX" ; 
+    write_table(path, 1.34); 
+
+    std::string dir = "/tmp/MaterialSvcArchiveTest_dup" ; 
+    rc = system( ("mkdir -p " + dir).c_str() ); 
+    setenv("JUNOTOP", top.c_str(), 1 ); 
+    setenv(MaterialSvc::ARCHIVE_KEY, dir.c_str(), 1 ); 
+    unlink( (dir + "/" + MaterialSvc::ARCHIVE_NAME).c_str() ); 
+    MaterialSvc::ClearArchive(); 
+
+    const char* param = "Material.Demo.RINDEX" ; 
+    IMCParamsSvc::vec_d2d props ; 
+    MaterialSvc::GetProps(param, props); 
+    assert( props.size() == 5 ); 
+    G4MaterialPropertyVector* ma = InsertMPV(props) ; 
+    bool saved = MaterialSvc::SaveArchive(); 
+    assert(saved); 
+
+    MaterialSvc::ClearArchive(); 
+    G4MaterialPropertyVector* mb = MaterialSvc::ArchiveMPV(param) ; 
+    assert( mb && MaterialSvc::ARCHIVE_STATE == 1 ); 
+    assert( ma->GetVectorLength() == mb->GetVectorLength() ); 
+    for(size_t j=0 ; j < ma->GetVectorLength() ; j++) assert( ma->Energy(j) == mb->Energy(j) && (*ma)[j] == (*mb)[j] ); 
+    assert( (*mb)[1] == 1.34 && (*mb)[3] == 1.31 );   // reverse file order for the 2 eV duplicates 
+
+    write_table(path, 1.35); 
+    MaterialSvc::ClearArchive(); 
+    assert( MaterialSvc::LoadArchive() == false ); 
+    assert( MaterialSvc::ARCHIVE_STATE == 0 ); 
+    assert( MaterialSvc::ArchiveMPV(param) == nullptr ); 
+
+    std::cout << "test_duplicates_and_digest : " << MaterialSvc::DescArchive() << std::endl ; 
+
+    MaterialSvc::ClearArchive(); 
+    if(junotop0.empty()) unsetenv("JUNOTOP") ; else setenv("JUNOTOP", junotop0.c_str(), 1 ); 
+}
+
+int main(int argc, char** argv)
+{
+    test_duplicates_and_digest(); 
+
+    if(getenv("JUNOTOP") == nullptr) 
+    {
+        std::cout << "MaterialSvcArchiveTest.main JUNOTOP not defined : skip " << std::endl ; 
+        return 0 ; 
+    }
+
+    std::vector<std::string> params ; 
+    for(int i=1 ; i < argc ; i++) params.push_back(argv[i]) ; 
+    if( params.size() == 0 ) params = {
+        "Material.LS.RINDEX", 
+        "Material.LS.ABSLENGTH_v2", 
+        "Material.LS.FASTCOMPONENT", 
+        "Material.Water.RINDEX", 
+        "Material.Water.ABSLENGTH", 
+        "Material.Pyrex.RINDEX", 
+        "Material.Acrylic.RINDEX"
+      } ; 
+
+    std::string dir = "/tmp/MaterialSvcArchiveTest" ; 
+    setenv(MaterialSvc::ARCHIVE_KEY, dir.c_str(), 1 ); 
+    unlink( (dir + "/" + MaterialSvc::ARCHIVE_NAME).c_str() ); 
+    MaterialSvc::ClearArchive(); 
+
+    Clock::time_point t0 = Clock::now(); 
+    std::vector<IMCParamsSvc::vec_d2d> text(params.size()) ; 
+    std::vector<G4MaterialPropertyVector*> text_mpv(params.size()) ; 
+    for(unsigned i=0 ; i < params.size() ; i++) 
+    {
+        MaterialSvc::GetProps(params[i], text[i]) ;
+        text_mpv[i] = InsertMPV(text[i]) ; 
+    }
+    double dt_text = Seconds(t0); 
+
+    bool saved = MaterialSvc::SaveArchive(); 
+    assert(saved); 
+    MaterialSvc::ClearArchive(); 
+
+    Clock::time_point t1 = Clock::now(); 
+    std::vector<IMCParamsSvc::vec_d2d> arch(params.size()) ; 
+    std::vector<G4MaterialPropertyVector*> arch_mpv(params.size()) ; 
+    for(unsigned i=0 ; i < params.size() ; i++) 
+    {
+        bool found = MaterialSvc::ArchiveGet(params[i], arch[i]) ;
+        assert(found); 
+        arch_mpv[i] = MaterialSvc::ArchiveMPV(params[i]) ; 
+    }
+    double dt_arch = Seconds(t1); 
+
+    std::cout << MaterialSvc::DescArchive() << std::endl ; 
+    assert( MaterialSvc::ARCHIVE_STATE == 1 ); 
+
+    int mismatch = 0 ; 
+    for(unsigned i=0 ; i < params.size() ; i++) 
+    {
+        const IMCParamsSvc::vec_d2d& a = text[i] ; 
+        const IMCParamsSvc::vec_d2d& b = arch[i] ; 
+        if( a.size() != b.size() ) mismatch += 1 ; 
+        for(unsigned j=0 ; j < std::min(a.size(), b.size()) ; j++) 
+        {
+            if( a[j].get<0>() != b[j].get<0>() || a[j].get<1>() != b[j].get<1>() ) mismatch += 1 ; 
+        }
+
+        G4MaterialPropertyVector* ma = text_mpv[i] ; 
+        G4MaterialPropertyVector* mb = arch_mpv[i] ; 
+        if( ma->GetVectorLength() != mb->GetVectorLength() ) mismatch += 1 ; 
+        for(size_t j=0 ; j < std::min(ma->GetVectorLength(), mb->GetVectorLength()) ; j++)
+        {
+            if( ma->Energy(j) != mb->Energy(j) || (*ma)[j] != (*mb)[j] ) mismatch += 1 ; 
+        }
+
+        std::cout 
+            << std::setw(30) << params[i] 
+            << " text " << a.size() 
+            << " arch " << b.size() 
+            << " mpv " << mb->GetVectorLength() 
+            << std::endl 
+            ;
+    }
+
+    std::cout 
+        << "MaterialSvcArchiveTest.main"
+        << " num_param " << params.size()
+        << " text " << dt_text 
+        << " archive " << dt_arch 
+        << " mismatch " << mismatch 
+        << std::endl 
+        ;
+
+    assert( mismatch == 0 ); 
+    return 0 ; 
+}
@@ -0,0 +1,91 @@
+/**
+SpanTreeTest.cc
+=================
+
+Nested spans from several threads, checks the parent/depth structure 
+and saves the NP array and Chrome trace JSON. Then checks that spans 
+open across a clear are dropped rather than becoming parents::
+
+    SpanTreeTest
+    SpanTree_DIR=/tmp/$USER/SpanTreeTest SpanTreeTest
+
+**/
+
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "SpanTree.h"
+
+void Sleep(int ms){ std::this_thread::sleep_for(std::chrono::milliseconds(ms)) ; }
+
+void Work(int n)
+{
+    SpanTree::Span span("Work") ; 
+    for(int i=0 ; i < n ; i++)
+    {
+        SpanTree::Span inner("Work.step") ; 
+        Sleep(2); 
+    }
+}
+
+void test_clear()
+{
+    SpanTree* st = SpanTree::Get(); 
+    {
+        SpanTree::Span outer("outer") ; 
+        SpanTree::Span before("before") ; 
+        st->clear(); 
+        {
+            SpanTree::Span after("after") ; 
+            SpanTree::Span child("child") ; 
+        }
+    }
+    std::cout << st->desc() ; 
+    assert( st->recs.size() == 2 ); 
+    assert( st->recs[0].name == "after" && st->recs[0].parent == -1 && st->recs[0].depth == 0 ); 
+    assert( st->recs[1].name == "child" && st->recs[1].parent == 0 ); 
+}
+
+int main(int argc, char** argv)
+{
+    {
+        SpanTree::Span top("main") ; 
+        Work(3); 
+
+        std::vector<std::thread> pool ; 
+        for(int t=0 ; t < 4 ; t++) pool.push_back( std::thread(Work, 2) ); 
+        for(unsigned t=0 ; t < pool.size() ; t++) pool[t].join(); 
+    }
+
+    SpanTree* st = SpanTree::Get(); 
+    std::cout << st->desc() ; 
+
+    int num_span = 1 + 4 + 4*3 ; 
+    assert( int(st->recs.size()) == num_span ); 
+    assert( st->recs[0].name == "main" && st->recs[0].parent == -1 ); 
+
+    for(unsigned i=0 ; i < st->recs.size() ; i++)
+    {
+        const SpanTree::Rec& r = st->recs[i] ; 
+        assert( r.t1 >= r.t0 ); 
+        if( r.parent > -1 ) 
+        {
+            const SpanTree::Rec& p = st->recs[r.parent] ; 
+            assert( p.thread == r.thread ); 
+            assert( p.depth + 1 == r.depth ); 
+            assert( p.t0 <= r.t0 && r.t1 <= p.t1 ); 
+        }
+        if( r.name == "Work.step" ) assert( r.parent > -1 && st->recs[r.parent].name == "Work" ); 
+    }
+
+    NP* a = st->array() ; 
+    std::cout << "SpanTreeTest.main " << a->sstr() << std::endl ; 
+    assert( a->shape[0] == num_span ); 
+
+    SpanTree::SaveEnv(); 
+
+    test_clear(); 
+    return 0 ; 
+}
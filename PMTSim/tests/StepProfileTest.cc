@@ -0,0 +1,74 @@
+/**
+StepProfileTest.cc
+====================
+
+Charges synthetic step times from several threads to LVs, two of which
+share a name as with LVs of different manager instances, checking
+that the report merges the published per thread tables by LV name
+and that steps added after the publish are not reported::
+
+    StepProfileTest
+    StepProfile_DIR=/tmp/$USER/StepProfileTest StepProfileTest
+
+**/
+
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "G4NistManager.hh"
+#include "G4Box.hh"
+#include "G4LogicalVolume.hh"
+
+#include "StepProfile.h"
+
+G4LogicalVolume* make_lv(const char* name)
+{
+    G4Material* mat = G4NistManager::Instance()->FindOrBuildMaterial("G4_Galactic");
+    G4VSolid* box = new G4Box(name, 100., 100., 100. );
+    return new G4LogicalVolume( box, mat, name, 0, 0, 0 );
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<G4LogicalVolume*> lvs = {
+        make_lv("hama_inner1_log"),
+        make_lv("hama_inner2_log"),
+        make_lv("hama_inner2_log"),   // same name, different LV
+        make_lv("hama_dynode_tube_log")
+    };
+
+    StepProfile* sp = StepProfile::Get();
+
+    int nthread = 4 ;
+    int nstep = 1000 ;
+    std::vector<std::thread> pool ;
+    for(int t=0 ; t < nthread ; t++) pool.push_back( std::thread( [&](){
+        for(int i=0 ; i < nstep ; i++) sp->add( lvs[i % lvs.size()], nullptr, 1e-6*double(1 + i % lvs.size()) ) ;
+        sp->publish() ;
+        sp->add( lvs[0], nullptr, 1. ) ;   // not published
+    } ));
+    for(unsigned t=0 ; t < pool.size() ; t++) pool[t].join();
+
+    std::cout << sp->desc() ;
+
+    std::vector<StepProfile::Row> rr ;
+    sp->lv_rows(rr);
+    assert( rr.size() == 3 );
+    assert( rr[0].lv == "hama_inner2_log" );    // steps 2 and 3 of every 4
+    assert( rr[0].cell.count == (unsigned long long)(nthread*nstep/2) );
+
+    double total = 0. ;
+    for(unsigned i=0 ; i < rr.size() ; i++) total += rr[i].cell.seconds ;
+    double expect = 1e-6*double(nthread*nstep/4)*(1.+2.+3.+4.) ;
+    assert( std::abs(total - expect) < 1e-9 );
+
+    NP* a = sp->array() ;
+    std::cout << "StepProfileTest.main " << a->sstr() << std::endl ;
+    assert( a->shape[0] == 3 );
+
+    sp->save_env();
+    return 0 ;
+}
@@ -0,0 +1,66 @@
+/**
+ZProgramTest.cc
+=================
+
+Compares ZProgram batched classification with G4VSolid::Inside 
+of the original tree for random points around the solid, and times both::
+
+    ZProgramTest TenTubsUnion 
+    ZProgramTest hmskSolidMask
+    NUM=10000000 NTHREAD=8 ZProgramTest TenTubsUnion 
+
+**/
+
+#include <cassert>
+#include <cstdio>
+#include <iostream>
+#include <chrono>
+#include <vector>
+
+#include "ssys.h"
+#include "G4VSolid.hh"
+#include "PMTSim.hh"
+#include "ZSolid.h"
+#include "ZProgram.h"
+
+void test_classify(const char* name, size_t num, int nthread)
+{
+    G4VSolid* solid = PMTSim::GetSolid(name); 
+    assert(solid); 
+
+    ZProgram* prog = ZProgram::Compile(solid); 
+    std::cout << prog->desc() ; 
+
+    std::vector<double> xyz ; 
+    ZProgram::Sample(xyz, solid, num ); 
+    std::vector<unsigned char> cls(num) ; 
+
+    typedef std::chrono::high_resolution_clock Clock ; 
+
+    Clock::time_point t0 = Clock::now(); 
+    prog->classify( cls.data(), xyz.data(), num, nthread ); 
+    Clock::time_point t1 = Clock::now(); 
+    size_t mismatch = prog->compare( cls.data(), xyz.data(), num );   // compare does a G4 Inside loop 
+    Clock::time_point t2 = Clock::now(); 
+
+    double dt_prog = std::chrono::duration<double>(t1 - t0).count() ; 
+    double dt_g4   = std::chrono::duration<double>(t2 - t1).count() ; 
+
+    size_t count[4] = {0,0,0,0} ; 
+    for(size_t i=0 ; i < num ; i++) count[cls[i] & 3] += 1 ; 
+
+    printf("test_classify %30s num %zu nthread %d outside %zu surface %zu inside %zu mismatch %zu time g4 %10.4f prog %10.4f speedup %6.2f \n", 
+         name, num, nthread, count[0], count[1], count[2], mismatch, dt_g4, dt_prog, dt_prog > 0. ? dt_g4/dt_prog : 0. ); 
+
+    assert( count[ZProgram::UNRESOLVED] == 0 ); 
+    assert( mismatch == 0 ); 
+}
+
+int main(int argc, char** argv)
+{
+    const char* name = argc > 1 ? argv[1] : "TenTubsUnion" ; 
+    size_t num = ssys::getenvint("NUM", 1000000) ; 
+    int nthread = ssys::getenvint("NTHREAD", 0) ; 
+    test_classify(name, num, nthread); 
+    return 0 ; 
+}
@@ -0,0 +1,61 @@
+/**
+ZSolidBatchTest.cc
+====================
+
+Applies zcuts to several solids concurrently with ZSolid::ApplyZCutTreeBatch 
+and checks the results match serial ZSolid::ApplyZCutTree::
+
+    ZSolidBatchTest
+    NTHREAD=4 ZSolidBatchTest
+
+The solids are obtained serially as the managers use the global G4 stores. 
+
+**/
+
+#include <cassert>
+#include <cstdio>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include "ssys.h"
+#include "G4VSolid.hh"
+#include "PMTSim.hh"
+#include "ZSolid.h"
+
+int main(int argc, char** argv)
+{
+    int nthread = ssys::getenvint("NTHREAD", 0) ; 
+
+    std::vector<std::string> names = { "hmskSolidMask", "nmskSolidMask", "hmskSolidMaskTail", "nmskSolidMaskTail", "TenTubsUnion" } ; 
+    std::vector<double>      zcuts = { -39., -39., -39., -39., 0. } ; 
+
+    std::vector<ZSolid::Job> jobs ; 
+    for(unsigned i=0 ; i < names.size() ; i++)
+    {
+        G4VSolid* solid = PMTSim::GetSolid(names[i].c_str()) ; 
+        if( solid == nullptr ) continue ; 
+        ZSolid::Job job = { solid, zcuts[i], nullptr, 0., -1 } ; 
+        jobs.push_back(job); 
+    }
+
+    std::chrono::time_point<std::chrono::high_resolution_clock> t0 = std::chrono::high_resolution_clock::now(); 
+    ZSolid::ApplyZCutTreeBatch( jobs, nthread ); 
+    std::chrono::time_point<std::chrono::high_resolution_clock> t1 = std::chrono::high_resolution_clock::now(); 
+    std::cout << ZSolid::DescBatch(jobs) ; 
+
+    std::vector<G4VSolid*> serial ; 
+    for(unsigned i=0 ; i < jobs.size() ; i++) serial.push_back( ZSolid::ApplyZCutTree( jobs[i].original, jobs[i].zcut ) ); 
+    std::chrono::time_point<std::chrono::high_resolution_clock> t2 = std::chrono::high_resolution_clock::now(); 
+
+    printf("ZSolidBatchTest num_job %zu batch %10.6f serial %10.6f \n", jobs.size(), 
+          std::chrono::duration<double>(t1 - t0).count(), std::chrono::duration<double>(t2 - t1).count() ); 
+
+    for(unsigned i=0 ; i < jobs.size() ; i++)
+    {
+        assert( jobs[i].result ); 
+        assert( ZSolid::Digest(jobs[i].result) == ZSolid::Digest(serial[i]) ); 
+        assert( ZSolid::CompareInside(jobs[i].result, serial[i], 10000) == 0 ); 
+    }
+    return 0 ; 
+}
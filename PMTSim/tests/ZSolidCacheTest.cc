@@ -0,0 +1,133 @@
+/**
+ZSolidCacheTest.cc
+====================
+
+Checks that trees reconstructed by ZSolidCache match the originals 
+in structure (ZSolid::Digest) and in Inside classification, 
+both in memory and via a cache directory, that the options key 
+follows manager property envvars and that entries of another 
+ZSolidCache::VERSION are not loaded::
+
+    ZSolidCacheTest 
+    ZSolidCacheTest hmskSolidMask_zcut-183.2246
+
+**/
+
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+#include "NP.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4Box.hh"
+#include "G4Tubs.hh"
+#include "G4Ellipsoid.hh"
+#include "G4Polycone.hh"
+#include "G4UnionSolid.hh"
+#include "G4SubtractionSolid.hh"
+#include "G4RotationMatrix.hh"
+
+#include "PMTSim.hh"
+#include "ZSolid.h"
+#include "ZSolidCache.h"
+
+G4VSolid* make_tree()
+{
+    double z[3]    = { -100., 0., 100. } ; 
+    double rmin[3] = {    0., 0.,   0. } ; 
+    double rmax[3] = {   50., 80., 50. } ; 
+
+    G4VSolid* ell  = new G4Ellipsoid( "ell", 250., 250., 180., -180., 180. ); 
+    G4VSolid* pcon = new G4Polycone(  "pcon", 0., 2.*CLHEP::pi, 3, z, rmin, rmax ); 
+    G4VSolid* box  = new G4Box(       "box", 20., 30., 400. ); 
+    G4VSolid* hole = new G4Tubs(      "hole", 0., 10., 300., 0., 2.*CLHEP::pi ); 
+
+    G4RotationMatrix rot ; 
+    rot.rotateX( 30.*CLHEP::deg ); 
+
+    G4VSolid* ell_pcon = new G4UnionSolid( "ell_pcon", ell, pcon, 0, G4ThreeVector(0.,0.,-200.) ); 
+    G4VSolid* ell_pcon_box = new G4UnionSolid( "ell_pcon_box", ell_pcon, box, &rot, G4ThreeVector(0.,50.,0.) ); 
+    G4VSolid* tree = new G4SubtractionSolid( "tree", ell_pcon_box, hole, 0, G4ThreeVector(10.,0.,0.) ); 
+    return tree ; 
+}
+
+void check_same(const G4VSolid* a, const G4VSolid* b, int num)
+{
+    assert( b ); 
+    uint64_t da = ZSolid::Digest(a); 
+    uint64_t db = ZSolid::Digest(b); 
+    int mismatch = ZSolid::CompareInside(a, b, num ); 
+    printf("check_same %30s digest %016llx %016llx mismatch %d \n", a->GetName().c_str(), (unsigned long long)da, (unsigned long long)db, mismatch ); 
+    assert( da == db ); 
+    assert( mismatch == 0 ); 
+}
+
+void test_roundtrip(const G4VSolid* tree, int num)
+{
+    NP* nodes = nullptr ; 
+    NP* par = nullptr ; 
+    bool ok = ZSolidCache::Serialize( &nodes, &par, tree ); 
+    assert(ok); 
+    std::cout << " nodes " << nodes->sstr() << " par " << par->sstr() << std::endl ; 
+
+    G4VSolid* copy = ZSolidCache::Deserialize( nodes, par ); 
+    check_same( tree, copy, num ); 
+}
+
+void test_GetSolid(const char* name, int num)
+{
+    setenv("PMTSim_CACHE", "/tmp/ZSolidCacheTest", 1 ); 
+
+    G4VSolid* built = PMTSim::GetSolid(name) ;   // builds and saves, or loads from earlier run 
+    G4VSolid* loaded = ZSolidCache::Load(name) ; 
+    check_same( built, loaded, num ); 
+
+    std::cout << ZSolidCache::Desc() ; 
+}
+
+void test_OptionsKey(const char* name)
+{
+    std::string k0 = ZSolidCache::OptionsKey(name) ; 
+    setenv("hama_SimplificationLevel", "3", 1 ); 
+    std::string k1 = ZSolidCache::OptionsKey(name) ; 
+    unsetenv("hama_SimplificationLevel"); 
+    std::string k2 = ZSolidCache::OptionsKey(name) ; 
+
+    std::cout << "test_OptionsKey " << k0 << " " << k1 << " " << k2 << std::endl ; 
+    assert( k0 != k1 ); 
+    assert( k0 == k2 ); 
+}
+
+void test_Version(const char* name)
+{
+    setenv("PMTSim_CACHE", "/tmp/ZSolidCacheTest", 1 ); 
+    std::string path = ZSolidCache::Path(name) ; 
+    assert( NP::Exists( path.c_str(), "nodes.npy" ) );   // saved by test_GetSolid
+
+    NP* nodes = NP::Load( path.c_str(), "nodes.npy" ); 
+    assert( nodes->get_meta<int>("version", -1) == ZSolidCache::VERSION ); 
+    nodes->set_meta<int>("version", ZSolidCache::VERSION - 1 ); 
+    nodes->save( path.c_str(), "nodes.npy" ); 
+
+    G4VSolid* stale = ZSolidCache::Load(name) ; 
+    std::cout << "test_Version " << path << " stale " << stale << std::endl ; 
+    assert( stale == nullptr ); 
+
+    nodes->set_meta<int>("version", ZSolidCache::VERSION ); 
+    nodes->save( path.c_str(), "nodes.npy" ); 
+    assert( ZSolidCache::Load(name) != nullptr ); 
+    delete nodes ; 
+}
+
+int main(int argc, char** argv)
+{
+    int num = 100000 ; 
+    test_roundtrip( make_tree(), num ); 
+
+    const char* name = argc > 1 ? argv[1] : "TenTubsUnion" ; 
+    test_OptionsKey( name ); 
+    test_GetSolid( name, num ); 
+    test_Version( name ); 
+    return 0 ; 
+}
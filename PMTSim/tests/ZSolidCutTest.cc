@@ -0,0 +1,123 @@
+/**
+ZSolidCutTest.cc
+==================
+
+Applies ZCut plane and box cuts with ZSolid::ApplyCutTree 
+and checks that within the kept region the Inside classification 
+of the cut tree matches the original::
+
+    ZSolidCutTest 
+    ZSolidCutTest hmskSolidMask "zplane:-50"
+
+**/
+
+#include <cassert>
+#include <cstdio>
+#include <cmath>
+#include <random>
+
+#include "ssys.h"
+#include "G4SystemOfUnits.hh"
+#include "G4Box.hh"
+#include "G4Cons.hh"
+#include "G4Sphere.hh"
+#include "G4Tubs.hh"
+#include "G4UnionSolid.hh"
+#include "G4SubtractionSolid.hh"
+
+#include "PMTSim.hh"
+#include "ZCut.h"
+#include "ZSolid.h"
+
+G4VSolid* make_mixed()
+{
+    G4VSolid* box = new G4Box("box", 100., 100., 50. ); 
+    G4VSolid* cons = new G4Cons("cons", 0., 80., 0., 40., 60., 0., 2.*CLHEP::pi ); 
+    G4VSolid* sphere = new G4Sphere("sphere", 0., 70., 0., 2.*CLHEP::pi, 0., CLHEP::pi ); 
+    G4VSolid* tubs = new G4Tubs("tubs", 0., 20., 200., 0., 2.*CLHEP::pi ); 
+
+    G4VSolid* box_cons = new G4UnionSolid("box_cons", box, cons, 0, G4ThreeVector(0., 0., 110.) ); 
+    G4VSolid* box_cons_sphere = new G4UnionSolid("box_cons_sphere", box_cons, sphere, 0, G4ThreeVector(0., 0., -120.) ); 
+    G4VSolid* mixed = new G4SubtractionSolid("mixed", box_cons_sphere, tubs, 0, G4ThreeVector(50., 0., 0.) ); 
+    return mixed ; 
+}
+
+int check_cut(const G4VSolid* original, const char* spec, int num)
+{
+    ZCut cut ; 
+    bool ok = ZCut::Parse(cut, spec) ; 
+    assert(ok); 
+
+    G4VSolid* cutsolid = ZSolid::ApplyCutTree(original, cut ); 
+    assert(cutsolid); 
+
+    G4ThreeVector mn, mx ; 
+    original->BoundingLimits(mn, mx); 
+
+    std::mt19937 engine(0) ; 
+    std::uniform_real_distribution<double> ux(mn.x(), mx.x()) ; 
+    std::uniform_real_distribution<double> uy(mn.y(), mx.y()) ; 
+    std::uniform_real_distribution<double> uz(mn.z(), mx.z()) ; 
+
+    int kept = 0 ; 
+    int mismatch = 0 ; 
+    for(int i=0 ; i < num ; i++)
+    {
+        G4ThreeVector p( ux(engine), uy(engine), uz(engine) ); 
+        if( cut.classify(p, p) != ZCut::INCLUDE ) continue ; 
+        kept += 1 ; 
+        if( original->Inside(p) != cutsolid->Inside(p) ) mismatch += 1 ; 
+    }
+
+    printf("check_cut %30s %40s num_node %3d -> %3d kept %7d mismatch %d \n", 
+         original->GetName().c_str(), spec, ZSolid::NumNode_r(original,0), ZSolid::NumNode_r(cutsolid,0), kept, mismatch ); 
+
+    return mismatch ; 
+}
+
+void check_plane_scale()
+{
+    ZCut a, b ; 
+    bool ok_a = ZCut::Parse(a, "plane:0,0.707,0.707,10") ; 
+    bool ok_b = ZCut::Parse(b, "plane:0,7.07,7.07,100") ; 
+    assert( ok_a && ok_b ); 
+    printf("check_plane_scale a %s b %s \n", a.desc().c_str(), b.desc().c_str() ); 
+    assert( a.normal.isNear(b.normal, 1e-12) ); 
+    assert( std::abs(a.d - b.d) < 1e-9 ); 
+
+    ZCut z ; 
+    assert( ZCut::Parse(z, "plane:0,0,-2,-200") ); 
+    assert( z.normal == G4ThreeVector(0.,0.,-1.) && z.d == -100. ); 
+
+    ZCut zero ; 
+    assert( ZCut::Parse(zero, "plane:0,0,0,10") == false ); 
+}
+
+int main(int argc, char** argv)
+{
+    int num = ssys::getenvint("NUM", 100000) ; 
+    int rc = 0 ; 
+
+    if( argc > 2 )
+    {
+        G4VSolid* solid = PMTSim::GetSolid(argv[1]); 
+        rc += check_cut(solid, argv[2], num ); 
+    }
+    else
+    {
+        check_plane_scale(); 
+        G4VSolid* mixed = make_mixed(); 
+        std::vector<std::string> specs = { 
+             "zplane:-20", 
+             "zplane:75", 
+             "plane:0,0,-1,-100", 
+             "plane:0,0.707,0.707,10", 
+             "plane:0,2,2,30", 
+             "box:0,0,0,150,150,60", 
+             "box:0,0,100,40,40,200", 
+             "obox:0,0,0,120,120,80,0,0,1,30" 
+        } ; 
+        for(unsigned i=0 ; i < specs.size() ; i++) rc += check_cut(mixed, specs[i].c_str(), num ); 
+    }
+    return rc == 0 ? 0 : 1 ; 
+}
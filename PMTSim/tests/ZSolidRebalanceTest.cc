@@ -0,0 +1,54 @@
+/**
+ZSolidRebalanceTest.cc
+========================
+
+Compares tree height, Inside classification and navigation time 
+of solids before and after ZSolid::Rebalance::
+
+    ZSolidRebalanceTest TenTubsUnion 
+    ZSolidRebalanceTest hmskSolidMask
+
+**/
+
+#include <cassert>
+#include <cstdio>
+
+#include "ssys.h"
+#include "G4VSolid.hh"
+#include "PMTSim.hh"
+#include "ZSolid.h"
+
+void test_Rebalance(const char* name, int num)
+{
+    G4VSolid* solid = PMTSim::GetSolid(name); 
+    assert(solid); 
+
+    G4VSolid* rebal = ZSolid::Rebalance(solid); 
+
+    int h0 = ZSolid::Height_r(solid, 0); 
+    int h1 = ZSolid::Height_r(rebal, 0); 
+    int n0 = ZSolid::NumNode_r(solid, 0); 
+    int n1 = ZSolid::NumNode_r(rebal, 0); 
+
+    int mismatch = ZSolid::CompareInside(solid, rebal, num ); 
+
+    double t0 = ZSolid::TimeNavigation(solid, num ); 
+    double t1 = ZSolid::TimeNavigation(rebal, num ); 
+
+    printf("test_Rebalance %30s height %2d -> %2d num_node %3d -> %3d mismatch %d time %10.4f -> %10.4f \n", 
+          name, h0, h1, n0, n1, mismatch, t0, t1 ); 
+
+    assert( h1 <= h0 ); 
+    assert( mismatch == 0 ); 
+
+    ZSolid::Draw(solid, "before ZSolid::Rebalance"); 
+    ZSolid::Draw(rebal, "after ZSolid::Rebalance"); 
+}
+
+int main(int argc, char** argv)
+{
+    const char* name = argc > 1 ? argv[1] : "TenTubsUnion" ; 
+    int num = ssys::getenvint("NUM", 100000) ; 
+    test_Rebalance(name, num); 
+    return 0 ; 
+}
@@ -0,0 +1,75 @@
+/**
+ZSolidRegistryTest.cc
+=======================
+
+Checks ZSolid::Digest structural hashing and ZSolidRegistry subtree sharing 
+using trees that differ only by names or by one leaf. 
+
+**/
+
+#include <cassert>
+#include <cstdio>
+#include <iostream>
+
+#include "G4SystemOfUnits.hh"
+#include "G4Tubs.hh"
+#include "G4Ellipsoid.hh"
+#include "G4UnionSolid.hh"
+#include "G4SubtractionSolid.hh"
+
+#include "ZSolid.h"
+#include "ZSolidRegistry.h"
+
+G4VSolid* make_tree(const char* pfx, double tail_dz)
+{
+    std::string p = pfx ; 
+    G4VSolid* ell  = new G4Ellipsoid( p+"ell", 250., 250., 180., -180., 180. ); 
+    G4VSolid* neck = new G4Tubs(      p+"neck", 0., 60., 50., 0., 2.*CLHEP::pi ); 
+    G4VSolid* tail = new G4Tubs(      p+"tail", 0., 120., tail_dz, 0., 2.*CLHEP::pi ); 
+    G4VSolid* hole = new G4Tubs(      p+"hole", 0., 10., 300., 0., 2.*CLHEP::pi ); 
+
+    G4VSolid* ell_neck = new G4UnionSolid( p+"ell_neck", ell, neck, 0, G4ThreeVector(0.,0.,-200.) ); 
+    G4VSolid* ell_neck_tail = new G4UnionSolid( p+"ell_neck_tail", ell_neck, tail, 0, G4ThreeVector(0.,0.,-300.) ); 
+    G4VSolid* tree = new G4SubtractionSolid( p+"tree", ell_neck_tail, hole, 0, G4ThreeVector(0.,0.,0.) ); 
+    return tree ; 
+}
+
+int main(int argc, char** argv)
+{
+    G4VSolid* a = make_tree("a_", 100. ); 
+    G4VSolid* b = make_tree("b_", 100. ); 
+    G4VSolid* c = make_tree("c_", 150. ); 
+
+    uint64_t da = ZSolid::Digest(a); 
+    uint64_t db = ZSolid::Digest(b); 
+    uint64_t dc = ZSolid::Digest(c); 
+    printf("digest a %016llx b %016llx c %016llx \n", (unsigned long long)da, (unsigned long long)db, (unsigned long long)dc ); 
+    assert( da == db ); 
+    assert( da != dc ); 
+
+    const G4VSolid* c_ell_neck = ZSolid::Left(ZSolid::Left(c)) ; 
+    const G4VSolid* c_ell_neck_tail = ZSolid::Left(c) ; 
+
+    ZSolidRegistry* reg = ZSolidRegistry::Get(); 
+    G4VSolid* ia = reg->intern(a); 
+    G4VSolid* ib = reg->intern(b); 
+    G4VSolid* ic = reg->intern(c); 
+
+    assert( ia == a ); 
+    assert( ib == a );  // entire tree shared 
+    assert( ic != c );  // differs by tail, but shares ell_neck and leaves : so a copy referencing them
+    assert( ZSolid::Left(ZSolid::Left(ic)) == ZSolid::Left(ZSolid::Left(a)) ); 
+
+    // the trees passed in are not mutated, callers may keep holding them
+    assert( ZSolid::Left(c) == c_ell_neck_tail ); 
+    assert( ZSolid::Left(ZSolid::Left(c)) == c_ell_neck ); 
+    assert( ZSolid::Digest(c) == dc ); 
+    assert( reg->num_copy == 2 );   // c_ell_neck_tail and c_tree 
+
+    assert( reg->digest(ib) == da ); 
+    assert( ZSolid::Digest(ic) == dc ); 
+    assert( reg->intern(c) == ic );   // interning the original again gives the same canonical tree
+
+    std::cout << reg->desc() ; 
+    return 0 ; 
+}
@@ -0,0 +1,111 @@
+/**
+utilsParseBenchTest.cc
+========================
+
+Parses every file of the property tree with get_implv1 and get_implv2, 
+checking the results are identical and comparing the times::
+
+    utilsParseBenchTest                       # $JUNOTOP/data/Simulation/DetSim/Material 
+    utilsParseBenchTest /path/to/dir 10       # directory and repeats 
+
+Skipped when the directory does not exist. 
+
+**/
+
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <boost/filesystem.hpp>
+#include <boost/tuple/tuple.hpp>
+
+#include "utils.hh"
+
+typedef boost::tuple<double, double> elem_d2d ; 
+typedef std::vector<elem_d2d> vec_d2d ; 
+typedef std::chrono::high_resolution_clock Clock ; 
+
+double Seconds( Clock::time_point t0 )
+{
+    return std::chrono::duration<double>(Clock::now() - t0).count() ; 
+}
+
+int main(int argc, char** argv)
+{
+    namespace fs = boost::filesystem;
+
+    std::string dir ; 
+    if( argc > 1 ) 
+    {
+        dir = argv[1] ; 
+    }
+    else if( getenv("JUNOTOP") )
+    {
+        dir = std::string(getenv("JUNOTOP")) + "/data/Simulation/DetSim/Material" ; 
+    }
+    int repeat = argc > 2 ? atoi(argv[2]) : 10 ; 
+
+    if( dir.empty() || !fs::is_directory(dir) )
+    {
+        std::cout << "utilsParseBenchTest.main no directory [" << dir << "] : skip " << std::endl ; 
+        return 0 ; 
+    }
+
+    std::vector<std::string> paths ; 
+    for(fs::recursive_directory_iterator it(dir), end ; it != end ; ++it ) 
+    {
+        if(fs::is_regular_file(it->path())) paths.push_back(it->path().string()) ; 
+    }
+
+    // check identical results 
+    int mismatch = 0 ; 
+    size_t num_row = 0 ; 
+    for(unsigned i=0 ; i < paths.size() ; i++)
+    {
+        vec_d2d a, b ; 
+        bool ra = get_implv1(paths[i], a) ; 
+        bool rb = get_implv2(paths[i], b) ; 
+        bool same = ra == rb && a.size() == b.size() ; 
+        for(unsigned j=0 ; same && j < a.size() ; j++) same = a[j].get<0>() == b[j].get<0>() && a[j].get<1>() == b[j].get<1>() ; 
+        if(!same) 
+        {
+            mismatch += 1 ; 
+            std::cout << "utilsParseBenchTest.main MISMATCH " << paths[i] << " v1 " << a.size() << " v2 " << b.size() << std::endl ; 
+        }
+        num_row += a.size() ; 
+    }
+
+    Clock::time_point t0 = Clock::now(); 
+    for(int r=0 ; r < repeat ; r++) for(unsigned i=0 ; i < paths.size() ; i++) 
+    {
+        vec_d2d a ; 
+        get_implv1(paths[i], a) ; 
+    }
+    double dt1 = Seconds(t0)/repeat ; 
+
+    Clock::time_point t1 = Clock::now(); 
+    for(int r=0 ; r < repeat ; r++) for(unsigned i=0 ; i < paths.size() ; i++) 
+    {
+        vec_d2d b ; 
+        get_implv2(paths[i], b) ; 
+    }
+    double dt2 = Seconds(t1)/repeat ; 
+
+    std::cout 
+        << "utilsParseBenchTest.main"
+        << " dir " << dir 
+        << " num_file " << paths.size()
+        << " num_row " << num_row
+        << " mismatch " << mismatch
+        << std::endl 
+        << " get_implv1 " << std::fixed << std::setprecision(6) << dt1 
+        << " get_implv2 " << std::fixed << std::setprecision(6) << dt2 
+        << " speedup " << std::fixed << std::setprecision(2) << ( dt2 > 0. ? dt1/dt2 : 0. )
+        << std::endl 
+        ;
+
+    assert( mismatch == 0 ); 
+    return 0 ; 
+}
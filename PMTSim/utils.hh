@@ -7,8 +7,19 @@
 
 
 #include <cctype>
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
 #include <vector>
 #include <sstream>
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <boost/filesystem.hpp>
 #include <boost/tokenizer.hpp>
 #include "boost/tuple/tuple.hpp"
@@ -191,4 +202,228 @@ bool parse_implv1(const char* strcontent,
     return true;
 }
 
+/**
+get_implv2 : fast reader for double,double property tables
+------------------------------------------------------------
+
+Same results as get_implv1 (including the unit handling) without the 
+per line std::stringstream and std::string allocations:
+
+* the file is memory mapped and scanned in place 
+* numbers are converted with std::from_chars when available, otherwise strtod
+* unit strings are resolved once per column and reused while unchanged
+* props is reserved from the line count and filled directly 
+
+Lines that do not have the regular form "value [unit] value [unit] ..." 
+with fully numeric value tokens are handed to utils_detail::parse_line_v1 
+which repeats the get_implv1 stream logic, so irregular content is treated 
+exactly as before. 
+
+Types other than double,double use get_implv1. 
+
+**/
+
+template<typename T1, typename T2>
+bool get_implv2(const std::string& path, std::vector< boost::tuple<T1, T2> >& props)
+{
+    return get_implv1(path, props); 
+}
+
+namespace utils_detail
+{
+    /**
+    parse_line_v1 
+        get_implv1 logic for one line after comment removal, 
+        returns 1 : elem set, 0 : skip line, -1 : abandon file  
+    **/
+    inline int parse_line_v1(const std::string& temp_line, boost::tuple<double,double>& elem)
+    {
+        std::stringstream ss;
+        ss << temp_line;
+        ss >> elem.get<0>();
+        if (ss.fail()) return 0 ;
+
+        char c = ss.get();
+        while (isspace(c)) {
+            c = ss.get();
+            if (ss.fail()) return -1 ;
+        }
+        ss.unget();
+        if (!isdigit(c)) {
+            std::string unit_1st;
+            ss >> unit_1st;
+            if (!ss.fail()) with_units(elem.get<0>(), unit_1st);
+        }
+        ss >> elem.get<1>();
+        if (ss.fail()) return 0 ;
+        std::string unit_2nd;
+        ss >> unit_2nd;
+        if (!ss.fail()) with_units(elem.get<1>(), unit_2nd);
+        return 1 ;
+    }
+
+    inline bool is_space(char c){ return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f' ; }
+
+    /**
+    to_double
+        true when the whole token [b,e) is a finite number, as operator>> 
+        does not accept inf/nan and leading '+' is left to the slow path 
+    **/
+    inline bool to_double(const char* b, const char* e, double& v)
+    {
+        if( b == e ) return false ; 
+        char c = *b ; 
+        if(!( isdigit(c) || c == '-' || c == '.' )) return false ; 
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+        std::from_chars_result r = std::from_chars(b, e, v) ; 
+        if( r.ec != std::errc() || r.ptr != e ) return false ; 
+#else
+        char buf[64] ; 
+        size_t n = e - b ; 
+        if( n >= sizeof(buf) ) return false ; 
+        memcpy(buf, b, n); 
+        buf[n] = '\0' ; 
+        char* end = nullptr ; 
+        v = strtod(buf, &end); 
+        if( end != buf + n ) return false ; 
+#endif
+        return std::isfinite(v) ; 
+    }
+
+    /**
+    UnitCache
+        resolves a unit token as with_units does, reusing the value while 
+        the same token appears in the column 
+    **/
+    struct UnitCache
+    {
+        std::string token ; 
+        bool        op ; 
+        double      unit_val ; 
+
+        UnitCache() : op(true), unit_val(0.) {}
+
+        void apply(double& val, const char* b, const char* e)
+        {
+            size_t n = e - b ; 
+            if( token.size() != n || token.compare(0, n, b, n) != 0 )
+            {
+                token.assign(b, n); 
+                std::string unit = token ; 
+                op = true ; 
+                if (unit[0] == '*') {
+                    unit.erase(0, 1);
+                } else if (unit[0] == '/') {
+                    op = false;
+                    unit.erase(0, 1);
+                }
+                unit_val = unit2value.count(unit) ? unit2value[unit] : G4UnitDefinition::GetValueOf(unit) ; 
+                if(!unit_val){
+                   LogError<<"can't find unit "<<unit<<" in MCParamsFileSvc::unit2value. Please register it at first!!!"<<std::endl;
+                   exit(-1);
+                }
+            }
+            if (op) {
+                val *= unit_val;
+            } else {
+                val /= unit_val;
+            }
+        }
+    };
+
+    struct MappedFile
+    {
+        int         fd ; 
+        size_t      size ; 
+        const char* data ; 
+
+        MappedFile(const char* path) : fd(-1), size(0), data(nullptr)
+        {
+            fd = open(path, O_RDONLY); 
+            if( fd < 0 ) return ; 
+            struct stat st ; 
+            if( fstat(fd, &st) == 0 && st.st_size > 0 )
+            {
+                size = st.st_size ; 
+                void* p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0); 
+                if( p != MAP_FAILED ) data = (const char*)p ; 
+            }
+        }
+        ~MappedFile()
+        {
+            if( data ) munmap((void*)data, size); 
+            if( fd > -1 ) close(fd); 
+        }
+        bool good() const { return fd > -1 ; }
+    };
+}
+
+inline bool get_implv2(const std::string& path, std::vector< boost::tuple<double, double> >& props)
+{
+    utils_detail::MappedFile mf(path.c_str()); 
+    if(!mf.good()) return true ;   // as get_implv1 with a missing file 
+    if(mf.data == nullptr) return mf.size == 0 ? true : get_implv1(path, props) ; 
+
+    const char* p = mf.data ; 
+    const char* end = mf.data + mf.size ; 
+
+    size_t num_line = std::count(p, end, '\n') + 1 ; 
+    props.reserve( props.size() + num_line ); 
+
+    utils_detail::UnitCache unit[2] ; 
+    boost::tuple<double, double> elem ; 
+
+    while( p < end )
+    {
+        const char* eol = (const char*)memchr(p, '\n', end - p) ; 
+        if( eol == nullptr ) eol = end ; 
+        const char* hash = (const char*)memchr(p, '#', eol - p) ; 
+        const char* le = hash ? hash : eol ; 
+
+        // tokenize in place : at most 4 tokens are used  
+        const char* tb[4] ; 
+        const char* te[4] ; 
+        int num_tok = 0 ; 
+        const char* q = p ; 
+        while( q < le && num_tok < 4 )
+        {
+            while( q < le && utils_detail::is_space(*q) ) q++ ; 
+            if( q == le ) break ; 
+            tb[num_tok] = q ; 
+            while( q < le && !utils_detail::is_space(*q) ) q++ ; 
+            te[num_tok] = q ; 
+            num_tok++ ; 
+        }
+
+        int rc = -2 ;   // -2 : use slow path 
+        double v0, v1 ; 
+        if( num_tok == 0 )
+        {
+            rc = 0 ; 
+        }
+        else if( num_tok >= 2 && utils_detail::to_double(tb[0], te[0], v0) )
+        {
+            int i = 1 ; 
+            bool unit0 = !isdigit(*tb[1]) ; 
+            if( unit0 ) i++ ; 
+            if( i < num_tok && utils_detail::to_double(tb[i], te[i], v1) )
+            {
+                if( unit0 ) unit[0].apply(v0, tb[1], te[1]) ; 
+                if( i + 1 < num_tok ) unit[1].apply(v1, tb[i+1], te[i+1]) ; 
+                elem.get<0>() = v0 ; 
+                elem.get<1>() = v1 ; 
+                rc = 1 ; 
+            }
+        }
+
+        if( rc == -2 ) rc = utils_detail::parse_line_v1( std::string(p, le), elem ) ; 
+        if( rc == -1 ) return false ; 
+        if( rc == 1 ) props.push_back(elem); 
+
+        p = eol + 1 ; 
+    }
+    return true ; 
+}
+
+
 #endif
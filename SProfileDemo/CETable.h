@@ -0,0 +1,143 @@
+#pragma once
+/**
+CETable.h : dense uniform grid tables of collection efficiency curves
+=======================================================================
+
+The collection efficiency (CE) as a function of the local theta is
+evaluated per hit with G4DataInterpolation::CubicSplineInterpolation
+in junoSD_PMT_v2::get_ce and with TGraph::Eval in PMTAngular::get_pmt_ce,
+after string comparisons of the CE mode and volume name.
+
+Instead each curve is sampled once onto a uniform grid, eg 0.1 degree steps,
+from the function it replaces, and looked up with integer curve index and
+linear interpolation between the two neighbouring grid values::
+
+    CETable tab(0., CLHEP::pi, 1801) ;
+    unsigned curve = tab.add( [&](double th){ return spline(th) ; } ) ;
+    double ce = tab.get(curve, theta) ;
+
+Values outside the domain are clamped to the end values.
+
+Deviation
+-----------
+
+*add* compares the table with the function at *nsub* points within every
+grid interval and records the maximum absolute deviation of the curve,
+reported by *desc*. For the 9 knot CE splines at 0.1 degree the
+deviation is below 1e-4 within the 0-90 degree knot domain and up to 2e-3
+beyond it, where the extrapolated cubics have large curvature (see CETableTest.sh).
+
+**/
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct CETable
+{
+    typedef std::function<double(double)> Func ;
+
+    double   x0 ;
+    double   x1 ;
+    unsigned num ;
+    double   inv_dx ;
+
+    std::vector<double> values ;   // (num_curve, num)
+    std::vector<double> maxdev ;   // (num_curve,)
+    std::vector<std::string> labels ;
+
+    CETable(double x0, double x1, unsigned num);
+
+    unsigned num_curve() const ;
+    unsigned add( Func f, const char* label=nullptr, unsigned nsub=10 );
+    double   get( unsigned curve, double x ) const ;
+    double   max_deviation() const ;
+    size_t   bytes() const ;
+    std::string desc() const ;
+};
+
+inline CETable::CETable(double x0_, double x1_, unsigned num_)
+    :
+    x0(x0_),
+    x1(x1_),
+    num(std::max(num_, 2u)),
+    inv_dx(double(num - 1)/(x1_ - x0_))
+{
+}
+
+inline unsigned CETable::num_curve() const
+{
+    return unsigned(maxdev.size()) ;
+}
+
+/**
+CETable::add
+--------------
+
+Samples the function at the grid values and returns the index of the curve.
+
+**/
+
+inline unsigned CETable::add( Func f, const char* label, unsigned nsub )
+{
+    unsigned curve = num_curve() ;
+    double dx = (x1 - x0)/double(num - 1) ;
+    for(unsigned i=0 ; i < num ; i++) values.push_back( f( i == num - 1 ? x1 : x0 + dx*double(i) ) ) ;
+
+    double dev = 0. ;
+    for(unsigned i=0 ; i < num - 1 ; i++)
+    for(unsigned j=1 ; j < nsub ; j++)
+    {
+        double x = x0 + dx*( double(i) + double(j)/double(nsub) ) ;
+        dev = std::max( dev, std::abs( get(curve, x) - f(x) ) ) ;
+    }
+    maxdev.push_back(dev) ;
+
+    std::stringstream ss ;
+    if(label) ss << label ; else ss << curve ;
+    labels.push_back(ss.str()) ;
+    return curve ;
+}
+
+inline double CETable::get( unsigned curve, double x ) const
+{
+    double f = std::min( std::max( (x - x0)*inv_dx, 0. ), double(num - 1) ) ;
+    unsigned i = std::min( unsigned(f), num - 2 ) ;
+    double w = f - double(i) ;
+    const double* v = values.data() + size_t(curve)*num + i ;
+    return v[0] + w*(v[1] - v[0]) ;
+}
+
+inline double CETable::max_deviation() const
+{
+    double dev = 0. ;
+    for(unsigned i=0 ; i < maxdev.size() ; i++) dev = std::max( dev, maxdev[i] ) ;
+    return dev ;
+}
+
+inline size_t CETable::bytes() const
+{
+    return values.size()*sizeof(double) ;
+}
+
+inline std::string CETable::desc() const
+{
+    std::stringstream ss ;
+    ss << "CETable"
+       << " x0 " << x0
+       << " x1 " << x1
+       << " num " << num
+       << " curves " << num_curve()
+       << " bytes " << bytes()
+       << " max_deviation " << std::scientific << std::setprecision(3) << max_deviation()
+       << std::endl
+       ;
+    for(unsigned i=0 ; i < num_curve() ; i++)
+        ss << std::setw(4) << i << " " << std::setw(40) << labels[i] << " maxdev " << maxdev[i] << std::endl ;
+    std::string s = ss.str();
+    return s ;
+}
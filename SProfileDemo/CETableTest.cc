@@ -0,0 +1,129 @@
+/**
+CETableTest.cc
+================
+
+Compares CETable lookups at 0.1 degree resolution with the cubic splines
+of the junoSD_PMT_v2::get_ce CE curves, reporting the maximum deviation
+and the time per lookup::
+
+    ./CETableTest.sh
+
+The spline is the clamped cubic spline with zero end derivatives
+as used by G4DataInterpolation(x, y, n, 0., 0.)::CubicSplineInterpolation.
+
+**/
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "CETable.h"
+
+struct Spline
+{
+    std::vector<double> x, y, y2 ;
+
+    Spline( const double* x_, const double* y_, int n, double yp1, double ypn );
+    double operator()( double px ) const ;
+};
+
+Spline::Spline( const double* x_, const double* y_, int n, double yp1, double ypn )
+    :
+    x(x_, x_+n),
+    y(y_, y_+n),
+    y2(n)
+{
+    std::vector<double> u(n) ;
+    y2[0] = -0.5 ;
+    u[0] = (3./(x[1]-x[0]))*((y[1]-y[0])/(x[1]-x[0]) - yp1) ;
+    for(int i=1 ; i < n-1 ; i++)
+    {
+        double sig = (x[i]-x[i-1])/(x[i+1]-x[i-1]) ;
+        double p = sig*y2[i-1] + 2. ;
+        y2[i] = (sig - 1.)/p ;
+        u[i] = (y[i+1]-y[i])/(x[i+1]-x[i]) - (y[i]-y[i-1])/(x[i]-x[i-1]) ;
+        u[i] = (6.*u[i]/(x[i+1]-x[i-1]) - sig*u[i-1])/p ;
+    }
+    double qn = 0.5 ;
+    double un = (3./(x[n-1]-x[n-2]))*(ypn - (y[n-1]-y[n-2])/(x[n-1]-x[n-2])) ;
+    y2[n-1] = (un - qn*u[n-2])/(qn*y2[n-2] + 1.) ;
+    for(int k=n-2 ; k >= 0 ; k--) y2[k] = y2[k]*y2[k+1] + u[k] ;
+}
+
+double Spline::operator()( double px ) const
+{
+    int lo = 0 ;
+    int hi = int(x.size()) - 1 ;
+    while( hi - lo > 1 )
+    {
+        int k = (hi + lo) >> 1 ;
+        if( x[k] > px ) hi = k ; else lo = k ;
+    }
+    double h = x[hi] - x[lo] ;
+    double a = (x[hi] - px)/h ;
+    double b = (px - x[lo])/h ;
+    return a*y[lo] + b*y[hi] + ((a*a*a - a)*y2[lo] + (b*b*b - b)*y2[hi])*(h*h)/6. ;
+}
+
+int main(int argc, char** argv)
+{
+    const double deg = M_PI/180. ;
+    double theta_NNVT[9] = { 0., 14., 30., 42.5, 55., 67., 77.5, 85., 90. } ;
+    double theta_hama[9] = { 0., 13., 28., 41., 55., 66., 79., 85., 90. } ;
+    for(int i=0 ; i < 9 ; i++) { theta_NNVT[i] *= deg ; theta_hama[i] *= deg ; }
+
+    double ce_MCP[9]         = { 0.9, 0.9, 0.845, 0.801, 0.775, 0.802, 0.802, 0.771, 0.66 } ;
+    double ce_R12860[9]      = { 0.911, 0.911, 0.9222, 0.9294, 0.9235, 0.93, 0.9095, 0.6261, 0.2733 } ;
+    double ce_NNVT[9]        = { 1.0, 1.0, 0.9453, 0.9105, 0.8931, 0.9255, 0.9274, 0.8841, 0.734 } ;
+    double ce_NNVT_highQE[9] = { 1.0, 1.0, 0.9772, 0.9723, 0.9699, 0.9697, 0.9452, 0.9103, 0.734 } ;
+
+    std::vector<Spline> sp ;
+    sp.push_back( Spline(theta_NNVT, ce_MCP, 9, 0., 0.) ) ;
+    sp.push_back( Spline(theta_hama, ce_R12860, 9, 0., 0.) ) ;
+    sp.push_back( Spline(theta_NNVT, ce_NNVT, 9, 0., 0.) ) ;
+    sp.push_back( Spline(theta_NNVT, ce_NNVT_highQE, 9, 0., 0.) ) ;
+    const char* label[4] = { "s_ce_NNVT(20inch)", "s_ce_hamamatsu(R12860)", "s_ce_NNVT", "s_ce_NNVT_highQE" } ;
+
+    CETable tab(0., M_PI, 1801) ;
+    for(unsigned i=0 ; i < sp.size() ; i++)
+    {
+        const Spline& s = sp[i] ;
+        tab.add( [&s](double th){ return s(th) ; }, label[i] ) ;
+    }
+    printf("%s", tab.desc().c_str()) ;
+
+    // deviation within the knot domain, beyond 90 degrees the splines are extrapolated with large curvature
+    double dev90 = 0. ;
+    for(unsigned c=0 ; c < sp.size() ; c++)
+    for(unsigned i=0 ; i <= 90000 ; i++)
+    {
+        double th = 0.5*M_PI*double(i)/90000. ;
+        dev90 = std::max( dev90, std::abs( tab.get(c, th) - sp[c](th) ) ) ;
+    }
+    printf("CETableTest max deviation within 0-90 degrees %.3e\n", dev90 ) ;
+
+    typedef std::chrono::steady_clock Clock ;
+    unsigned num = 10000000 ;
+    double sum[2] = {0., 0.} ;
+    double sec[2] ;
+    for(int m=0 ; m < 2 ; m++)
+    {
+        Clock::time_point t0 = Clock::now() ;
+        for(unsigned i=0 ; i < num ; i++)
+        {
+            unsigned c = i % 4 ;
+            double th = 0.5*M_PI*double(i)/double(num) ;
+            sum[m] += m == 0 ? sp[c](th) : tab.get(c, th) ;
+        }
+        sec[m] = std::chrono::duration<double>(Clock::now() - t0).count() ;
+    }
+    printf("CETableTest num %u spline %.1f ns table %.1f ns speedup %.2f mean_diff %.3e\n",
+        num, 1e9*sec[0]/num, 1e9*sec[1]/num, sec[0]/sec[1], (sum[1]-sum[0])/num ) ;
+
+    assert( dev90 < 1e-4 ) ;
+    assert( tab.max_deviation() < 1e-2 ) ;
+    return 0 ;
+}
@@ -0,0 +1,29 @@
+#!/bin/bash -l 
+usage(){ cat << EOU
+CETableTest.sh
+=========================
+
+Builds and runs the comparison of CETable lookups with the CE splines::
+
+    ./CETableTest.sh 
+
+EOU
+}
+
+name=CETableTest 
+
+
+defarg="build_run"
+arg=${1:-$defarg}
+
+if [ "${arg/build}" != "$arg" ]; then 
+    gcc $name.cc -std=c++11 -O2 -lstdc++ -lm -I. -o /tmp/$name 
+    [ $? -ne 0 ] && echo $BASH_SOURCE build error && exit 1 
+fi 
+
+if [ "${arg/run}" != "$arg" ]; then 
+    /tmp/$name
+    [ $? -ne 0 ] && echo $BASH_SOURCE run error && exit 2 
+fi 
+
+exit 0 
@@ -0,0 +1,254 @@
+#pragma once
+/**
+PMTDetectBound.h : two stage detection efficiency acceptance
+===============================================================
+
+junoSD_PMT_v2::ProcessHits accepts a photon when u <= de with u uniform and
+de = qe(pmtid, energy)*ce(pmtid, theta). Evaluating de needs the local position
+and the QE and CE lookups (get_pmtid_ce ~0.6 us per call, see PMTSimParamSvcTest/results.rst)
+for every candidate, even though most are culled.
+
+With a per-PMT upper bound B >= de the same draw u decides in two stages::
+
+    stage 1 : u > B          reject without evaluating de   (u > B >= de, so culled anyway)
+    stage 2 : u <= B         evaluate de exactly, accept when u <= de
+
+As the same uniform draw is used and qe/ce consume no randoms the accepted
+photons and the random sequence are identical to the single stage acceptance.
+
+Bounds
+--------
+
+The PMTSimParamSvc lookups are linear interpolations of per category tables
+(G4MaterialPropertyVector::Value) clamped to the end values outside their domain,
+with qe scaled per PMT::
+
+    qe(pmtid, energy) = qe_scale(pmtid)*qe_cat(cat, energy)
+    ce(pmtid, theta)  = ce_cat(cat, theta)
+
+A piecewise linear function takes its maximum at a knot, so *KnotMax* over the
+table knots and the domain ends is the exact maximum, not a sample of it.
+The bounds of all PMTs are set with *set* before the first event from the
+per category maxima, costing one qe_scale lookup per PMT.
+*margin* only covers the rounding of the interpolation and of the product order.
+
+As a safeguard every stage 2 evaluation checks de <= B, when exceeded the
+violation is counted and the bound raised. A non-zero *violation* count in desc
+means the knots given do not match the tables, as candidates with B < u <= de
+before the raise would have been wrongly culled. PMTs without a bound get B = 1,
+which culls nothing, and are counted as *unbound*.
+
+Each junoSD_PMT_v2 instance is used by a single thread so no locking is needed.
+
+The stage timing reads the clock twice per candidate, which costs more than the
+stage 1 comparison it measures, so it is off by default. Set *timing* to
+report seconds1, seconds2 and the saved_estimate in desc, eg with
+junoSD_PMT_v2::getDetectBound()->timing = true after setDetectBound.
+
+**/
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct PMTDetectBound
+{
+    typedef std::function<double(double)> Func ;   // energy or theta
+    typedef std::chrono::steady_clock Clock ;
+
+    double margin ;
+    bool   timing ;         // default false : clock reads per candidate for seconds1, seconds2 
+
+    std::unordered_map<int, double> bound ;
+    double* last ;          // bound of the last stage 1 candidate, element references are stable
+
+    size_t num_unbound ;    // PMTs without a bound from set
+    size_t num_candidate ;
+    size_t num_reject1 ;    // culled by the bound
+    size_t num_eval ;       // exact de evaluated
+    size_t num_accept ;
+    size_t num_violation ;
+    double seconds_bound ;  // setting bounds
+    double seconds1 ;       // stage 1
+    double seconds2 ;       // stage 2 : local position, qe, ce
+
+    static double KnotMax( const Func& f, const std::vector<double>& knots, double x0, double x1 );
+
+    PMTDetectBound();
+
+    void   set( int pmtid, double b );
+    double& get( int pmtid );
+    bool   stage1( int pmtid, double u );
+    bool   stage2( int pmtid, double u, double de );
+
+    double now() const ;
+    void   add1( double t0 );
+    void   add2( double t0 );
+
+    void clear_counts();
+    std::string desc() const ;
+};
+
+/**
+PMTDetectBound::KnotMax
+-------------------------
+
+Maximum of f over the knots within [x0, x1] and the ends x0 and x1.
+For f linear between the knots and constant beyond the end knots this is
+the maximum of f over [x0, x1].
+
+**/
+
+inline double PMTDetectBound::KnotMax( const Func& f, const std::vector<double>& knots, double x0, double x1 ) // static
+{
+    double mx = std::max( f(x0), f(x1) ) ;
+    for(size_t i=0 ; i < knots.size() ; i++)
+    {
+        if( knots[i] > x0 && knots[i] < x1 ) mx = std::max( mx, f(knots[i]) ) ;
+    }
+    return mx ;
+}
+
+inline PMTDetectBound::PMTDetectBound()
+    :
+    margin(1. + 1e-9),
+    timing(false),
+    last(nullptr),
+    num_unbound(0),
+    seconds_bound(0.)
+{
+    clear_counts();
+}
+
+/**
+PMTDetectBound::set
+---------------------
+
+Bound of the PMT from its maximum detection efficiency, capped at 1 as u <= 1.
+Bounds are retained across events.
+
+**/
+
+inline void PMTDetectBound::set( int pmtid, double b )
+{
+    bound[pmtid] = std::min( 1., margin*b ) ;
+}
+
+/**
+PMTDetectBound::get
+---------------------
+
+Bound of the PMT, PMTs not given to set get 1 which culls nothing.
+
+**/
+
+inline double& PMTDetectBound::get( int pmtid )
+{
+    std::unordered_map<int, double>::iterator it = bound.find(pmtid) ;
+    if( it != bound.end() ) return it->second ;
+    num_unbound += 1 ;
+    double& b = bound[pmtid] ;
+    b = 1. ;
+    return b ;
+}
+
+/**
+PMTDetectBound::stage1
+------------------------
+
+Returns false when the candidate is culled by the bound.
+
+**/
+
+inline bool PMTDetectBound::stage1( int pmtid, double u )
+{
+    num_candidate += 1 ;
+    last = &get(pmtid) ;
+    bool pass = u <= *last ;
+    if(!pass) num_reject1 += 1 ;
+    return pass ;
+}
+
+/**
+PMTDetectBound::stage2
+------------------------
+
+Exact acceptance u <= de of the last stage 1 survivor, with the bound check.
+
+**/
+
+inline bool PMTDetectBound::stage2( int pmtid, double u, double de )
+{
+    num_eval += 1 ;
+    double& b = last ? *last : get(pmtid) ;
+    if( de > b )
+    {
+        num_violation += 1 ;
+        b = std::min( 1., margin*de ) ;
+    }
+    bool accept = u <= de ;
+    if(accept) num_accept += 1 ;
+    return accept ;
+}
+
+inline double PMTDetectBound::now() const
+{
+    return timing ? std::chrono::duration<double>(Clock::now().time_since_epoch()).count() : 0. ;
+}
+inline void PMTDetectBound::add1( double t0 )
+{
+    if(timing) seconds1 += now() - t0 ;
+}
+inline void PMTDetectBound::add2( double t0 )
+{
+    if(timing) seconds2 += now() - t0 ;
+}
+
+inline void PMTDetectBound::clear_counts()
+{
+    num_candidate = 0 ;
+    num_reject1 = 0 ;
+    num_eval = 0 ;
+    num_accept = 0 ;
+    num_violation = 0 ;
+    seconds1 = 0. ;
+    seconds2 = 0. ;
+}
+
+/**
+PMTDetectBound::desc
+----------------------
+
+The saving is estimated from the mean stage 2 time of the evaluated
+candidates times the number culled at stage 1.
+
+**/
+
+inline std::string PMTDetectBound::desc() const
+{
+    double mean2 = num_eval > 0 ? seconds2/double(num_eval) : 0. ;
+    std::stringstream ss ;
+    ss << "PMTDetectBound"
+       << " pmts " << bound.size()
+       << " unbound " << num_unbound
+       << " candidate " << num_candidate
+       << " reject1 " << num_reject1
+       << " eval " << num_eval
+       << " accept " << num_accept
+       << " violation " << num_violation
+       << " frac_eval " << ( num_candidate > 0 ? double(num_eval)/double(num_candidate) : 0. )
+       << " seconds_bound " << seconds_bound
+       ;
+    if(timing) ss
+       << " seconds1 " << seconds1
+       << " seconds2 " << seconds2
+       << " mean2_us " << 1e6*mean2
+       << " saved_estimate " << mean2*double(num_reject1)
+       ;
+    std::string s = ss.str();
+    return s ;
+}
@@ -0,0 +1,32 @@
+#!/bin/bash -l 
+usage(){ cat << EOU
+PMTDetectBoundTest.sh
+=========================
+
+Builds and runs the comparison of single and two stage acceptance::
+
+    ./PMTDetectBoundTest.sh 
+    NUM=10000000 QE_NS=0 CE_NS=0 ./PMTDetectBoundTest.sh
+
+EOU
+}
+
+name=PMTDetectBoundTest 
+
+num=1000000
+export NUM=${NUM:-$num}
+
+defarg="build_run"
+arg=${1:-$defarg}
+
+if [ "${arg/build}" != "$arg" ]; then 
+    gcc $name.cc -std=c++11 -O2 -lstdc++ -lm -I. -o /tmp/$name 
+    [ $? -ne 0 ] && echo $BASH_SOURCE build error && exit 1 
+fi 
+
+if [ "${arg/run}" != "$arg" ]; then 
+    /tmp/$name
+    [ $? -ne 0 ] && echo $BASH_SOURCE run error && exit 2 
+fi 
+
+exit 0 
@@ -0,0 +1,254 @@
+#pragma once
+/**
+PMTHitBulk.h : bulk multi-threaded decode, partition and merge of an array of hits
+=====================================================================================
+
+junoSD_PMT_v2_Opticks::EndOfEvent_Simulate converts the GPU hits one at a time::
+
+    for idx in hits : U4HitGet::FromEvt(hit, idx) ; collectHit(hit) -> doMerge or convertHit + saveHit
+
+Here the same result is obtained in stages:
+
+1. decode (parallel)
+   each thread decodes a contiguous chunk of the hit array into records,
+   so the array is read once
+
+2. partition (parallel count, parallel stable scatter)
+   record indices are grouped by PMT partition (pmtid % num_threads),
+   keeping index order within each partition
+
+3. merge (parallel)
+   each thread merges the hits of its PMTs with PMTHitMergerFlat on
+   lightweight slots (pmtid, time, count, idx) in index order.
+   As merging only involves hits of the same PMT the slots are identical
+   to those the serial loop would give
+
+4. create (serial, caller thread)
+   the slots of all partitions are visited in index order of their first hit,
+   a hit object is created from the record of the first hit with the merged
+   count and time and handed to *insert*, giving the same collection order
+   as the serial loop
+
+Hit objects are created on the calling thread as junoHit_PMT allocation is thread
+local (G4Allocator) and the hits are deleted on the event thread.
+
+The decode function is called concurrently and must only read shared state.
+
+**/
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "PMTHitMergerFlat.h"
+
+template<typename REC, typename HIT>
+struct PMTHitBulk
+{
+    typedef std::function<void(REC&, size_t)> Decode ;          // decode hit idx, called concurrently
+    typedef std::function<int(const REC&)> PMTID ;
+    typedef std::function<double(const REC&)> Time ;
+    typedef std::function<HIT*(const REC&, int, double)> Create ;   // (record, count, time) called serially
+    typedef std::function<void(HIT*)> Insert ;
+    typedef std::chrono::steady_clock Clock ;
+
+    struct Slot
+    {
+        int    pmtid ;
+        double time ;
+        int    count ;
+        int    idx ;     // index of first hit
+
+        int    GetPMTID() const { return pmtid ; }
+        double GetTime() const { return time ; }
+        void   SetTime(double t) { time = t ; }
+        int    GetCount() const { return count ; }
+        void   SetCount(int c) { count = c ; }
+    };
+
+    struct SlotCollection
+    {
+        std::vector<Slot*> v ;
+        size_t insert(Slot* s){ v.push_back(s) ; return v.size() ; }
+        size_t entries() const { return v.size() ; }
+        Slot* operator[](size_t i) const { return v[i] ; }
+    };
+
+    typedef PMTHitMergerFlat<SlotCollection, Slot> Merger ;
+
+    unsigned num_threads ;
+    bool     merge ;
+    double   time_window ;
+
+    std::vector<REC>      recs ;
+    std::vector<int>      order ;       // record indices grouped by partition
+    std::vector<size_t>   begin ;       // (num_threads+1,) partition offsets into order
+    std::vector<std::vector<Slot>> slots ;   // per partition, in index order
+    std::vector<Merger*>  mergers ;     // per partition, retained across events
+
+    size_t num_hit ;
+    size_t num_saved ;
+    double seconds[4] ;    // decode, partition, merge, create
+
+    static unsigned DefaultThreads();
+    template<typename F> static void Parallel( unsigned n, F fn );
+
+    PMTHitBulk(unsigned num_threads=0);
+    ~PMTHitBulk();
+
+    size_t run( size_t num, Decode decode, PMTID pmtid, Time time, Create create, Insert insert );
+    std::string desc() const ;
+};
+
+template<typename REC, typename HIT>
+inline unsigned PMTHitBulk<REC,HIT>::DefaultThreads() // static
+{
+    unsigned n = std::thread::hardware_concurrency() ;
+    return n > 0 ? n : 1 ;
+}
+
+template<typename REC, typename HIT>
+template<typename F>
+inline void PMTHitBulk<REC,HIT>::Parallel( unsigned n, F fn ) // static
+{
+    std::vector<std::thread> tt ;
+    for(unsigned t=1 ; t < n ; t++) tt.push_back( std::thread(fn, t) ) ;
+    fn(0) ;
+    for(size_t i=0 ; i < tt.size() ; i++) tt[i].join() ;
+}
+
+template<typename REC, typename HIT>
+inline PMTHitBulk<REC,HIT>::PMTHitBulk(unsigned num_threads_)
+    :
+    num_threads(num_threads_ > 0 ? num_threads_ : DefaultThreads()),
+    merge(false),
+    time_window(1.),
+    num_hit(0),
+    num_saved(0)
+{
+    for(unsigned t=0 ; t < num_threads ; t++) mergers.push_back( new Merger ) ;
+    for(int i=0 ; i < 4 ; i++) seconds[i] = 0. ;
+}
+
+template<typename REC, typename HIT>
+inline PMTHitBulk<REC,HIT>::~PMTHitBulk()
+{
+    for(size_t i=0 ; i < mergers.size() ; i++) delete mergers[i] ;
+}
+
+template<typename REC, typename HIT>
+inline size_t PMTHitBulk<REC,HIT>::run( size_t num, Decode decode, PMTID pmtid, Time time, Create create, Insert insert )
+{
+    const unsigned T = num_threads ;
+    num_hit = num ;
+    recs.resize(num) ;
+    order.resize(num) ;
+    slots.resize(T) ;
+
+    // 1. decode : contiguous chunks
+    Clock::time_point t0 = Clock::now() ;
+    std::vector<size_t> chunk(T+1) ;
+    for(unsigned t=0 ; t <= T ; t++) chunk[t] = num*t/T ;
+    Parallel(T, [&](unsigned t){ for(size_t i=chunk[t] ; i < chunk[t+1] ; i++) decode(recs[i], i) ; } ) ;
+
+    // 2. partition : per chunk counts, then stable scatter
+    Clock::time_point t1 = Clock::now() ;
+    std::vector<size_t> count(T*T, 0) ;     // (chunk, partition)
+    std::vector<unsigned> part(num) ;
+    Parallel(T, [&](unsigned t){
+        for(size_t i=chunk[t] ; i < chunk[t+1] ; i++)
+        {
+            unsigned p = unsigned(pmtid(recs[i])) % T ;
+            part[i] = p ;
+            count[t*T+p] += 1 ;
+        }
+    }) ;
+    std::vector<size_t> offset(T*T) ;
+    begin.assign(T+1, 0) ;
+    size_t tot = 0 ;
+    for(unsigned p=0 ; p < T ; p++)
+    {
+        begin[p] = tot ;
+        for(unsigned t=0 ; t < T ; t++) { offset[t*T+p] = tot ; tot += count[t*T+p] ; }
+    }
+    begin[T] = tot ;
+    Parallel(T, [&](unsigned t){
+        for(size_t i=chunk[t] ; i < chunk[t+1] ; i++) order[offset[t*T+part[i]]++] = int(i) ;
+    }) ;
+
+    // 3. merge : each partition in index order
+    Clock::time_point t2 = Clock::now() ;
+    Parallel(T, [&](unsigned p){
+        std::vector<Slot>& ss = slots[p] ;
+        ss.clear() ;
+        ss.reserve(begin[p+1] - begin[p]) ;    // no reallocation : the merger holds pointers
+        SlotCollection sc ;
+        Merger* m = mergers[p] ;
+        m->setMergeFlag(merge) ;
+        m->setTimeWindow(time_window) ;
+        m->init(&sc) ;
+        for(size_t k=begin[p] ; k < begin[p+1] ; k++)
+        {
+            int i = order[k] ;
+            const REC& r = recs[i] ;
+            int id = pmtid(r) ;
+            double ti = time(r) ;
+            if( merge && m->doMerge(id, ti) ) continue ;
+            Slot s ;
+            s.pmtid = id ;
+            s.time = ti ;
+            s.count = 1 ;
+            s.idx = i ;
+            ss.push_back(s) ;
+            m->saveHit( &ss.back() ) ;
+        }
+    }) ;
+
+    // 4. create : k-way merge of the partitions by index of first hit
+    Clock::time_point t3 = Clock::now() ;
+    std::vector<size_t> head(T, 0) ;
+    num_saved = 0 ;
+    for(;;)
+    {
+        int best = -1 ;
+        for(unsigned p=0 ; p < T ; p++)
+        {
+            if( head[p] == slots[p].size() ) continue ;
+            if( best < 0 || slots[p][head[p]].idx < slots[best][head[best]].idx ) best = p ;
+        }
+        if( best < 0 ) break ;
+        const Slot& s = slots[best][head[best]++] ;
+        insert( create( recs[s.idx], s.count, s.time ) ) ;
+        num_saved += 1 ;
+    }
+    Clock::time_point t4 = Clock::now() ;
+
+    seconds[0] = std::chrono::duration<double>(t1 - t0).count() ;
+    seconds[1] = std::chrono::duration<double>(t2 - t1).count() ;
+    seconds[2] = std::chrono::duration<double>(t3 - t2).count() ;
+    seconds[3] = std::chrono::duration<double>(t4 - t3).count() ;
+    return num_saved ;
+}
+
+template<typename REC, typename HIT>
+inline std::string PMTHitBulk<REC,HIT>::desc() const
+{
+    std::stringstream ss ;
+    ss << "PMTHitBulk"
+       << " threads " << num_threads
+       << " merge " << merge
+       << " time_window " << time_window
+       << " hits " << num_hit
+       << " saved " << num_saved
+       << " decode " << seconds[0]
+       << " partition " << seconds[1]
+       << " merge " << seconds[2]
+       << " create " << seconds[3]
+       ;
+    std::string s = ss.str();
+    return s ;
+}
@@ -0,0 +1,177 @@
+/**
+PMTHitBulkTest.cc
+===================
+
+Synthetic test of PMTHitBulk without GPU : an array of hits with the
+4x4 float layout of sphoton is converted into hit objects with the serial
+per-hit loop of junoSD_PMT_v2_Opticks::EndOfEvent_Simulate (using PMTHitMergerFlat
+in place of PMTHitMerger, see PMTHitMergerFlatTest.sh for their equivalence)
+and with PMTHitBulk, checking that the hit collections are identical::
+
+    ./PMTHitBulkTest.sh
+    NUM=1000000 THREADS=4 MERGE=0 ./PMTHitBulkTest.sh
+
+**/
+
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "PMTHitBulk.h"
+
+struct Rec        // decoded hit, standin for U4Hit
+{
+    double pos[3], dir[3], pol[3] ;
+    double time, wavelength, weight, energy, theta, phi ;
+    int    pmtid ;
+    unsigned flag ;
+};
+
+struct Hit        // standin for junoHit_PMT
+{
+    Rec    r ;
+    int    count ;
+
+    int    GetPMTID() const { return r.pmtid ; }
+    double GetTime() const { return r.time ; }
+    void   SetTime(double t) { r.time = t ; }
+    int    GetCount() const { return count ; }
+    void   SetCount(int c) { count = c ; }
+};
+
+struct Collection
+{
+    std::vector<Hit*> hits ;
+    ~Collection(){ for(size_t i=0 ; i < hits.size() ; i++) delete hits[i] ; }
+    size_t insert(Hit* h){ hits.push_back(h) ; return hits.size() ; }
+    size_t entries() const { return hits.size() ; }
+    Hit* operator[](size_t i) const { return hits[i] ; }
+};
+
+void make_hits( std::vector<float>& a, size_t num, unsigned seed )
+{
+    std::mt19937_64 rng(seed) ;
+    std::uniform_real_distribution<double> uni(0., 1.) ;
+    std::exponential_distribution<double> tail(1./30.) ;
+    int num_pmt = 17612 ;
+    std::vector<double> t0(num_pmt) ;
+    for(int i=0 ; i < num_pmt ; i++) t0[i] = 100.*uni(rng) ;
+
+    a.resize(num*16) ;
+    for(size_t i=0 ; i < num ; i++)
+    {
+        float* q = a.data() + 16*i ;
+        int pmtid = int(num_pmt*uni(rng)) ;
+        for(int j=0 ; j < 3 ; j++) q[j] = float(19500.*(2.*uni(rng) - 1.)) ;
+        q[3] = float(t0[pmtid] + tail(rng)) ;
+        for(int j=4 ; j < 7 ; j++) q[j] = float(2.*uni(rng) - 1.) ;
+        q[7] = 1.f ;
+        for(int j=8 ; j < 11 ; j++) q[j] = float(2.*uni(rng) - 1.) ;
+        q[11] = float(300. + 300.*uni(rng)) ;
+        unsigned u[4] = { unsigned(pmtid), unsigned(i), 0x40u, 0u } ;
+        for(int j=0 ; j < 4 ; j++) memcpy( q + 12 + j, u + j, sizeof(unsigned) ) ;
+    }
+}
+
+void decode( Rec& r, const float* a, size_t idx )
+{
+    const float* q = a + 16*idx ;
+    double n[2] = { 0., 0. } ;
+    for(int j=0 ; j < 3 ; j++)
+    {
+        r.pos[j] = q[j] ;
+        r.dir[j] = q[4+j] ;
+        r.pol[j] = q[8+j] ;
+        n[0] += r.dir[j]*r.dir[j] ;
+        n[1] += r.pol[j]*r.pol[j] ;
+    }
+    for(int j=0 ; j < 3 ; j++) { r.dir[j] /= std::sqrt(n[0]) ; r.pol[j] /= std::sqrt(n[1]) ; }
+    r.time = q[3] ;
+    r.weight = q[7] ;
+    r.wavelength = q[11] ;
+    r.energy = 2.*M_PI*197.3269804e-6/r.wavelength ;   // MeV for wavelength in nm
+    double rho = std::sqrt(r.pos[0]*r.pos[0] + r.pos[1]*r.pos[1]) ;
+    r.theta = std::atan2(rho, r.pos[2]) ;
+    r.phi = std::atan2(r.pos[1], r.pos[0]) ;
+    unsigned u[2] ;
+    memcpy( u, q + 12, 2*sizeof(unsigned) ) ;
+    r.pmtid = int(u[0]) ;
+    memcpy( &r.flag, q + 14, sizeof(unsigned) ) ;
+}
+
+Hit* create( const Rec& r, int count, double time )
+{
+    Hit* h = new Hit ;
+    h->r = r ;
+    h->count = count ;
+    h->r.time = time ;
+    return h ;
+}
+
+bool same( const Hit* a, const Hit* b )
+{
+    return a->r.pmtid == b->r.pmtid && a->r.time == b->r.time && a->count == b->count
+        && a->r.energy == b->r.energy && a->r.theta == b->r.theta && a->r.pos[0] == b->r.pos[0] ;
+}
+
+int main(int argc, char** argv)
+{
+    const char* num_ = getenv("NUM") ;
+    const char* threads_ = getenv("THREADS") ;
+    const char* merge_ = getenv("MERGE") ;
+    size_t num = num_ ? strtoul(num_, nullptr, 10) : 10000000 ;
+    unsigned threads = threads_ ? atoi(threads_) : 0 ;
+    bool merge = merge_ ? atoi(merge_) != 0 : true ;
+
+    std::vector<float> a ;
+    make_hits(a, num, 42u ) ;
+    const float* aa = a.data() ;
+
+    typedef std::chrono::steady_clock Clock ;
+
+    // serial per-hit loop
+    Collection hc0 ;
+    PMTHitMergerFlat<Collection, Hit> m0 ;
+    m0.setMergeFlag(merge) ;
+    m0.setTimeWindow(1.) ;
+    m0.init(&hc0) ;
+    Clock::time_point t0 = Clock::now() ;
+    for(size_t i=0 ; i < num ; i++)
+    {
+        Rec r ;
+        decode(r, aa, i) ;
+        if( merge && m0.doMerge(r.pmtid, r.time) ) continue ;
+        m0.saveHit( create(r, 1, r.time) ) ;
+    }
+    double s0 = std::chrono::duration<double>(Clock::now() - t0).count() ;
+
+    // bulk
+    Collection hc1 ;
+    PMTHitBulk<Rec, Hit> bulk(threads) ;
+    bulk.merge = merge ;
+    bulk.time_window = 1. ;
+    Clock::time_point t1 = Clock::now() ;
+    bulk.run( num,
+              [aa](Rec& r, size_t i){ decode(r, aa, i) ; },
+              [](const Rec& r){ return r.pmtid ; },
+              [](const Rec& r){ return r.time ; },
+              create,
+              [&hc1](Hit* h){ hc1.insert(h) ; } ) ;
+    double s1 = std::chrono::duration<double>(Clock::now() - t1).count() ;
+
+    bool ok = hc0.entries() == hc1.entries() ;
+    for(size_t i=0 ; ok && i < hc0.entries() ; i++) ok = same( hc0[i], hc1[i] ) ;
+
+    printf("PMTHitBulkTest hits %zu merge %d saved %zu same %d\n", num, merge, hc0.entries(), ok ) ;
+    printf("  serial %8.3f s\n", s0 ) ;
+    printf("  bulk   %8.3f s  speedup %.2f\n", s1, s0/s1 ) ;
+    printf("  %s\n", bulk.desc().c_str() ) ;
+
+    assert( ok ) ;
+    return ok ? 0 : 1 ;
+}
@@ -0,0 +1,32 @@
+#!/bin/bash -l 
+usage(){ cat << EOU
+PMTHitBulkTest.sh
+=========================
+
+Builds and runs the comparison of serial and bulk hit conversion::
+
+    ./PMTHitBulkTest.sh 
+    NUM=1000000 THREADS=4 MERGE=0 ./PMTHitBulkTest.sh
+
+EOU
+}
+
+name=PMTHitBulkTest 
+
+num=10000000
+export NUM=${NUM:-$num}
+
+defarg="build_run"
+arg=${1:-$defarg}
+
+if [ "${arg/build}" != "$arg" ]; then 
+    gcc $name.cc -std=c++11 -O2 -lstdc++ -lm -lpthread -I. -o /tmp/$name 
+    [ $? -ne 0 ] && echo $BASH_SOURCE build error && exit 1 
+fi 
+
+if [ "${arg/run}" != "$arg" ]; then 
+    /tmp/$name
+    [ $? -ne 0 ] && echo $BASH_SOURCE run error && exit 2 
+fi 
+
+exit 0 
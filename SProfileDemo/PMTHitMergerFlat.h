@@ -0,0 +1,233 @@
+#pragma once
+/**
+PMTHitMergerFlat.h : hit merger with dense per-PMT time ordered buckets
+==========================================================================
+
+Same merge semantics and API as PMTHitMerger (junosw Simulation/DetSimV2/PMTSim)
+which for every photon looks up the hits of the PMT in a std::multimap
+and scans them in insertion order for the first with time within the window.
+For muon events with 10^7 photons that lookup is the hot spot.
+
+Here each PMT identifier is mapped to a slot of a dense array using
+a few contiguous identifier ranges (LPMT, WP, SPMT by default),
+identifiers outside the ranges fall back to a hash map.
+Each slot holds a small vector of (time, index) entries kept ordered by time,
+so only the entries within the window are examined::
+
+    doMerge(pmtid, t)
+        candidates : entries with |t - time| < window, found by binary search
+        choose the candidate with the smallest index (the earliest saved hit),
+        which is the one the multimap scan in insertion order finds,
+        increment its count and set its time to the earliest, moving
+        the entry to keep the bucket ordered
+
+    saveHit(hit)
+        inserts into the collection and the bucket of the PMT
+
+The bucket vectors keep their capacity across events, so after the
+first event merge-or-insert does not allocate.
+
+HC is the hit collection type, eg junoHit_PMT_Collection, providing
+insert(HIT*), entries() and operator[] returning HIT*.
+HIT provides GetPMTID, GetTime, SetTime, GetCount, SetCount.
+
+See PMTHitMergerFlatTest.sh for the benchmark against the multimap approach.
+
+**/
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+template<typename HC, typename HIT>
+struct PMTHitMergerFlat
+{
+    struct Entry
+    {
+        double time ;
+        int    idx ;     // index into collection
+    };
+
+    struct Range
+    {
+        int first ;     // first pmtid
+        int num ;       // number of pmtid
+    };
+
+    typedef std::vector<Entry> Bucket ;
+
+    static std::vector<Range> DefaultRanges();
+
+    bool                m_merge_flag ;
+    double              m_time_window ;
+    HC*                 m_hc ;
+    std::vector<Range>  m_ranges ;
+    std::vector<int>    m_offsets ;
+    std::vector<Bucket> m_buckets ;
+    std::vector<int>    m_touched ;     // slots with entries, for clearing without touching every slot
+    std::unordered_map<int, Bucket> m_sparse ;
+
+    size_t m_num_merge ;
+    size_t m_num_save ;
+
+    PMTHitMergerFlat( const std::vector<Range>& ranges=DefaultRanges() );
+
+    bool init(HC* hc);
+    bool getMergeFlag() const { return m_merge_flag ; }
+    void setMergeFlag(bool f) { m_merge_flag = f ; }
+    double getTimeWindow() const { return m_time_window ; }
+    void setTimeWindow(double t) { m_time_window = t ; }
+
+    Bucket* bucket(int pmtid, bool create);
+    bool doMerge(int pmtid, double hittime);
+    bool saveHit(HIT* hit);
+
+    std::string desc() const ;
+};
+
+/**
+PMTHitMergerFlat::DefaultRanges
+---------------------------------
+
+JUNO PMT identifiers, with some margin::
+
+    0      : 17612 LPMT
+    30000  : 2400  WP PMT
+    300000 : 25600 SPMT
+
+**/
+
+template<typename HC, typename HIT>
+inline std::vector<typename PMTHitMergerFlat<HC,HIT>::Range> PMTHitMergerFlat<HC,HIT>::DefaultRanges() // static
+{
+    std::vector<Range> rr = { {0, 20000}, {30000, 5000}, {300000, 30000} } ;
+    return rr ;
+}
+
+template<typename HC, typename HIT>
+inline PMTHitMergerFlat<HC,HIT>::PMTHitMergerFlat( const std::vector<Range>& ranges )
+    :
+    m_merge_flag(false),
+    m_time_window(1.),
+    m_hc(nullptr),
+    m_ranges(ranges),
+    m_num_merge(0),
+    m_num_save(0)
+{
+    int tot = 0 ;
+    for(size_t i=0 ; i < m_ranges.size() ; i++)
+    {
+        m_offsets.push_back(tot) ;
+        tot += m_ranges[i].num ;
+    }
+    m_buckets.resize(tot) ;
+}
+
+template<typename HC, typename HIT>
+inline bool PMTHitMergerFlat<HC,HIT>::init(HC* hc)
+{
+    m_hc = hc ;
+    for(size_t i=0 ; i < m_touched.size() ; i++) m_buckets[m_touched[i]].clear() ;
+    m_touched.clear() ;
+    m_sparse.clear() ;
+    m_num_merge = 0 ;
+    m_num_save = 0 ;
+    return true ;
+}
+
+template<typename HC, typename HIT>
+inline typename PMTHitMergerFlat<HC,HIT>::Bucket* PMTHitMergerFlat<HC,HIT>::bucket(int pmtid, bool create)
+{
+    for(size_t i=0 ; i < m_ranges.size() ; i++)
+    {
+        const Range& r = m_ranges[i] ;
+        if( pmtid >= r.first && pmtid < r.first + r.num )
+        {
+            int slot = m_offsets[i] + pmtid - r.first ;
+            Bucket& b = m_buckets[slot] ;
+            if( create && b.empty() ) m_touched.push_back(slot) ;
+            return &b ;
+        }
+    }
+    if( !create )
+    {
+        typename std::unordered_map<int, Bucket>::iterator it = m_sparse.find(pmtid) ;
+        return it == m_sparse.end() ? nullptr : &it->second ;
+    }
+    return &m_sparse[pmtid] ;
+}
+
+template<typename HC, typename HIT>
+inline bool PMTHitMergerFlat<HC,HIT>::doMerge(int pmtid, double hittime)
+{
+    Bucket* b = bucket(pmtid, false) ;
+    if( b == nullptr || b->empty() ) return false ;
+    Bucket& v = *b ;
+    const double w = m_time_window ;
+
+    size_t n = v.size() ;
+    size_t k = std::lower_bound( v.begin(), v.end(), hittime - w, [](const Entry& e, double t){ return e.time < t ; } ) - v.begin() ;
+    while( k > 0 && std::abs(hittime - v[k-1].time) < w ) k-- ;   // exact window test at the edge
+
+    size_t best = n ;
+    for( ; k < n && v[k].time <= hittime + w ; k++ )
+    {
+        if( std::abs(hittime - v[k].time) < w && ( best == n || v[k].idx < v[best].idx ) ) best = k ;
+    }
+    if( best == n ) return false ;
+
+    HIT* hit = (*m_hc)[v[best].idx] ;
+    hit->SetCount( hit->GetCount() + 1 ) ;
+    if( hittime < v[best].time )
+    {
+        hit->SetTime(hittime) ;
+        Entry e = v[best] ;
+        e.time = hittime ;
+        size_t j = best ;
+        while( j > 0 && v[j-1].time > e.time ) { v[j] = v[j-1] ; j-- ; }
+        v[j] = e ;
+    }
+    m_num_merge += 1 ;
+    return true ;
+}
+
+template<typename HC, typename HIT>
+inline bool PMTHitMergerFlat<HC,HIT>::saveHit(HIT* hit)
+{
+    int idx = int(m_hc->entries()) ;
+    m_hc->insert(hit) ;
+    m_num_save += 1 ;
+    if( m_merge_flag )
+    {
+        Entry e ;
+        e.time = hit->GetTime() ;
+        e.idx = idx ;
+        Bucket& v = *bucket(hit->GetPMTID(), true) ;
+        typename Bucket::iterator it = std::upper_bound( v.begin(), v.end(), e.time, [](double t, const Entry& a){ return t < a.time ; } ) ;
+        v.insert(it, e) ;
+    }
+    return true ;
+}
+
+template<typename HC, typename HIT>
+inline std::string PMTHitMergerFlat<HC,HIT>::desc() const
+{
+    size_t max_bucket = 0 ;
+    for(size_t i=0 ; i < m_touched.size() ; i++) max_bucket = std::max( max_bucket, m_buckets[m_touched[i]].size() ) ;
+    std::stringstream ss ;
+    ss << "PMTHitMergerFlat"
+       << " merge_flag " << m_merge_flag
+       << " time_window " << m_time_window
+       << " slots " << m_buckets.size()
+       << " touched " << m_touched.size()
+       << " sparse " << m_sparse.size()
+       << " save " << m_num_save
+       << " merge " << m_num_merge
+       << " max_bucket " << max_bucket
+       ;
+    std::string s = ss.str();
+    return s ;
+}
@@ -0,0 +1,176 @@
+/**
+PMTHitMergerFlatTest.cc
+=========================
+
+Benchmark of PMTHitMergerFlat against the std::multimap lookup of PMTHitMerger
+on synthetic muon-like events, checking that both give identical hits::
+
+    ./PMTHitMergerFlatTest.sh
+    NUM=10000000 WINDOW=1 ./PMTHitMergerFlatTest.sh
+
+The photon times on each PMT are a first arrival time spread over
+the detector plus a scintillation-like exponential tail.
+
+**/
+
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "PMTHitMergerFlat.h"
+
+struct Hit
+{
+    int    pmtid ;
+    double time ;
+    int    count ;
+
+    int    GetPMTID() const { return pmtid ; }
+    double GetTime() const { return time ; }
+    void   SetTime(double t) { time = t ; }
+    int    GetCount() const { return count ; }
+    void   SetCount(int c) { count = c ; }
+};
+
+struct Collection
+{
+    std::vector<Hit*> hits ;
+    ~Collection(){ for(size_t i=0 ; i < hits.size() ; i++) delete hits[i] ; }
+    size_t insert(Hit* h){ hits.push_back(h) ; return hits.size() ; }
+    size_t entries() const { return hits.size() ; }
+    Hit* operator[](size_t i) const { return hits[i] ; }
+};
+
+/**
+MultimapMerger
+----------------
+
+The PMTHitMerger approach : multimap from pmtid to collection index
+scanned in insertion order.
+
+**/
+
+struct MultimapMerger
+{
+    typedef std::multimap<int, int> PMTID2COLIDS ;
+    typedef std::pair< PMTID2COLIDS::iterator, PMTID2COLIDS::iterator > PMTITER ;
+
+    double        m_time_window ;
+    Collection*   m_hc ;
+    PMTID2COLIDS  m_pmtid2idincol ;
+
+    MultimapMerger() : m_time_window(1.), m_hc(nullptr) {}
+    bool init(Collection* hc){ m_hc = hc ; m_pmtid2idincol.clear() ; return true ; }
+
+    bool doMerge(int pmtid, double hittime)
+    {
+        if( m_pmtid2idincol.count(pmtid) == 0 ) return false ;
+        PMTITER it = m_pmtid2idincol.equal_range(pmtid) ;
+        for(PMTID2COLIDS::iterator i = it.first ; i != it.second ; ++i)
+        {
+            Hit* hit = (*m_hc)[i->second] ;
+            double pretime = hit->GetTime() ;
+            if( std::abs(hittime - pretime) < m_time_window )
+            {
+                hit->SetCount( hit->GetCount() + 1 ) ;
+                if( hittime < pretime ) hit->SetTime(hittime) ;
+                return true ;
+            }
+        }
+        return false ;
+    }
+
+    bool saveHit(Hit* hit)
+    {
+        int idx = int(m_hc->entries()) ;
+        m_hc->insert(hit) ;
+        m_pmtid2idincol.insert( std::make_pair(hit->GetPMTID(), idx) ) ;
+        return true ;
+    }
+};
+
+void make_event( std::vector<int>& pmtid, std::vector<double>& time, size_t num, unsigned seed )
+{
+    std::mt19937_64 rng(seed) ;
+    std::uniform_real_distribution<double> uni(0., 1.) ;
+    std::exponential_distribution<double> tail(1./30.) ;   // 30 ns decay
+
+    int num_lpmt = 17612 ;
+    int num_spmt = 25600 ;
+    std::vector<double> t0(num_lpmt + num_spmt) ;
+    for(size_t i=0 ; i < t0.size() ; i++) t0[i] = 100.*uni(rng) ;
+
+    pmtid.resize(num) ;
+    time.resize(num) ;
+    for(size_t i=0 ; i < num ; i++)
+    {
+        int j = int( uni(rng) < 0.97 ? num_lpmt*uni(rng) : num_lpmt + num_spmt*uni(rng) ) ;
+        pmtid[i] = j < num_lpmt ? j : 300000 + j - num_lpmt ;
+        time[i] = t0[j] + tail(rng) ;
+    }
+}
+
+template<typename M>
+double run( M& merger, Collection& hc, const std::vector<int>& pmtid, const std::vector<double>& time )
+{
+    typedef std::chrono::high_resolution_clock Clock ;
+    Clock::time_point t0 = Clock::now() ;
+    merger.init(&hc) ;
+    for(size_t i=0 ; i < pmtid.size() ; i++)
+    {
+        if( merger.doMerge(pmtid[i], time[i]) ) continue ;
+        Hit* hit = new Hit ;
+        hit->pmtid = pmtid[i] ;
+        hit->time = time[i] ;
+        hit->count = 1 ;
+        merger.saveHit(hit) ;
+    }
+    return std::chrono::duration<double>(Clock::now() - t0).count() ;
+}
+
+int main(int argc, char** argv)
+{
+    const char* num_ = getenv("NUM") ;
+    const char* window_ = getenv("WINDOW") ;
+    size_t num = num_ ? strtoul(num_, nullptr, 10) : 10000000 ;
+    double window = window_ ? atof(window_) : 1. ;
+
+    std::vector<int> pmtid ;
+    std::vector<double> time ;
+    make_event(pmtid, time, num, 42u ) ;
+
+    Collection hc0 ;
+    MultimapMerger m0 ;
+    m0.m_time_window = window ;
+    double t_multimap = run(m0, hc0, pmtid, time) ;
+
+    Collection hc1 ;
+    PMTHitMergerFlat<Collection, Hit> m1 ;
+    m1.setMergeFlag(true) ;
+    m1.setTimeWindow(window) ;
+    double t_flat = run(m1, hc1, pmtid, time) ;
+
+    bool same = hc0.entries() == hc1.entries() ;
+    size_t total = 0 ;
+    for(size_t i=0 ; same && i < hc0.entries() ; i++)
+    {
+        const Hit* a = hc0[i] ;
+        const Hit* b = hc1[i] ;
+        same = a->pmtid == b->pmtid && a->time == b->time && a->count == b->count ;
+        total += a->count ;
+    }
+
+    printf("PMTHitMergerFlatTest photons %zu window %.2f hits %zu same %d\n", num, window, hc0.entries(), same ) ;
+    printf("  multimap %8.3f s  %6.1f ns/photon\n", t_multimap, 1e9*t_multimap/double(num) ) ;
+    printf("  flat     %8.3f s  %6.1f ns/photon  speedup %.2f\n", t_flat, 1e9*t_flat/double(num), t_multimap/t_flat ) ;
+    printf("  %s\n", m1.desc().c_str() ) ;
+
+    assert( same ) ;
+    assert( total == num ) ;
+    return same ? 0 : 1 ;
+}
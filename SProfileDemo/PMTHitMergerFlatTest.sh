@@ -0,0 +1,34 @@
+#!/bin/bash -l 
+usage(){ cat << EOU
+PMTHitMergerFlatTest.sh
+=========================
+
+Builds and runs the PMTHitMergerFlat benchmark against the multimap merger::
+
+    ./PMTHitMergerFlatTest.sh 
+    NUM=1000000 WINDOW=5 ./PMTHitMergerFlatTest.sh
+
+EOU
+}
+
+name=PMTHitMergerFlatTest 
+
+num=10000000
+window=1
+export NUM=${NUM:-$num}
+export WINDOW=${WINDOW:-$window}
+
+defarg="build_run"
+arg=${1:-$defarg}
+
+if [ "${arg/build}" != "$arg" ]; then 
+    gcc $name.cc -std=c++11 -O2 -lstdc++ -lm -I. -o /tmp/$name 
+    [ $? -ne 0 ] && echo $BASH_SOURCE build error && exit 1 
+fi 
+
+if [ "${arg/run}" != "$arg" ]; then 
+    /tmp/$name
+    [ $? -ne 0 ] && echo $BASH_SOURCE run error && exit 2 
+fi 
+
+exit 0 
@@ -0,0 +1,452 @@
+#pragma once
+/**
+PMTWaveformStore.h : per-PMT fixed bin time histograms of muon hits
+======================================================================
+
+In muon mode (junoSD_PMT_v2 hit type 2) SaveMuonHit creates a junoHit_PMT_muon
+for every accepted photon, merging only updates the time and count of an
+existing hit after a per-photon lookup. For showering muons most PMTs see
+thousands of photons.
+
+Here each PMT instead accumulates a histogram of the hit times with fixed
+bins of width *bin* from *t0*, keeping the earliest hit time exactly together
+with the local theta and phi of that hit::
+
+    PMTWaveformStore ws(1., 1000000, 4096) ;   // 1 ns bins, window 1 ms, dense span 4 us
+    ws.add(pmtid, time, theta, phi) ;      // per accepted photon
+    ws.visit( [](const PMTWaveformStore::Wave& w, double time, unsigned count){ ... } ) ;   // per non-empty bin
+    NP* w = ws.waves() ; NP* b = ws.bins() ;
+
+Times in the window [t0, t0 + num_bin*bin) are binned, later or earlier times
+are only counted in the overflow and underflow of the PMT.
+
+The dense bins of a PMT span from its earliest to its latest occupied bin,
+growing at either end as hits arrive in any order, so a PMT with a 1 us
+wide pulse at 1 ns resolution takes 4 kB whatever the number of photons.
+Growing to earlier bins doubles the span (within the cap) so a sequence of
+earlier hits costs amortized constant time, the zero bins this leaves at the start
+are skipped by the compact form (*Skip*).
+The span is capped at *max_span* bins : a bin that would stretch it further,
+like a late hit 200 us after the pulse, is counted in the sparse *far* bins
+of the PMT instead. So the memory per PMT is at most max_span bins plus one
+entry per distinct far bin, whatever the spread of the hit times.
+The dense span is placed by the first hit added, if that is an outlier
+the pulse goes to the far bins : still exact but slower and larger.
+
+PMT identifiers are mapped to waves with the dense ranges of PMTHitMergerFlat
+(LPMT, WP, SPMT) and a hash map fallback. The waves and their bin vectors are
+retained by *clear*, so after the first event filling does not allocate.
+
+NP arrays
+-----------
+
+*waves* : (num_pmt, 12) double, sorted by pmtid, columns::
+
+    pmtid, first, theta, phi, count, underflow, overflow, lo, num, offset, far_num, far_offset
+
+   bins of the PMT are bins()[offset:offset+num] with times t0 + (lo + i)*bin,
+   its far bins are farbins()[far_offset:far_offset+far_num],
+   metadata t0, bin, num_bin and max_span
+
+*bins* : (total,) uint32 bin contents of all PMTs
+
+*farbins* : (total_far, 2) uint32 bin index and content of the far bins of all PMTs
+
+**/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "NP.hh"
+
+struct PMTWaveformStore
+{
+    struct Range
+    {
+        int first ;
+        int num ;
+    };
+
+    struct Wave
+    {
+        int      pmtid ;
+        double   first ;       // exact earliest hit time
+        double   theta ;       // local direction of the earliest hit
+        double   phi ;
+        unsigned count ;       // all hits, including under/overflow
+        unsigned underflow ;
+        unsigned overflow ;
+        int      lo ;          // bin index of bins[0]
+        std::vector<uint32_t> bins ;
+        std::map<int, uint32_t> far ;   // bins beyond the dense span cap, never within [lo, lo+bins.size())
+    };
+
+    static constexpr const int NUM_COL = 12 ;
+    static constexpr const char* COLS = "pmtid,first,theta,phi,count,underflow,overflow,lo,num,offset,far_num,far_offset" ;
+
+    static std::vector<Range> DefaultRanges();
+    static size_t Skip( const Wave& w );
+
+    double   t0 ;
+    double   bin ;
+    unsigned num_bin ;
+    unsigned max_span ;
+
+    std::vector<Range>   ranges ;
+    std::vector<int>     offsets ;
+    std::vector<int>     dense ;     // dense slot -> wave index, -1 : none
+    std::unordered_map<int, int> sparse ;
+    std::vector<Wave>    pool ;      // waves [0:num_wave] are in use
+    unsigned             num_wave ;
+    size_t               num_hit ;
+
+    PMTWaveformStore( double bin=1., unsigned num_bin=1000000, unsigned max_span=4096, double t0=0., const std::vector<Range>& ranges=DefaultRanges() );
+
+    int    slot( int pmtid ) const ;
+    Wave&  wave( int pmtid );
+    void   add( int pmtid, double time, double theta, double phi );
+    void   clear();
+
+    template<typename F> void visit( F fn ) const ;
+
+    size_t num_nonzero() const ;
+    size_t total_bins() const ;
+    size_t total_far() const ;
+    size_t bytes() const ;
+    void   sorted( std::vector<const Wave*>& ww ) const ;
+    NP*    waves() const ;
+    NP*    bins() const ;
+    NP*    farbins() const ;
+    std::string desc() const ;
+};
+
+/**
+PMTWaveformStore::DefaultRanges
+---------------------------------
+
+Same as PMTHitMergerFlat::DefaultRanges::
+
+    0      : 17612 LPMT
+    30000  : 2400  WP PMT
+    300000 : 25600 SPMT
+
+**/
+
+inline std::vector<PMTWaveformStore::Range> PMTWaveformStore::DefaultRanges() // static
+{
+    std::vector<Range> rr = { {0, 20000}, {30000, 5000}, {300000, 30000} } ;
+    return rr ;
+}
+
+/**
+PMTWaveformStore::Skip
+------------------------
+
+Number of leading zero bins of the wave, left by growing to earlier bins.
+
+**/
+
+inline size_t PMTWaveformStore::Skip( const Wave& w ) // static
+{
+    size_t j = 0 ;
+    while( j < w.bins.size() && w.bins[j] == 0 ) j++ ;
+    return j ;
+}
+
+inline PMTWaveformStore::PMTWaveformStore( double bin_, unsigned num_bin_, unsigned max_span_, double t0_, const std::vector<Range>& ranges_ )
+    :
+    t0(t0_),
+    bin(bin_),
+    num_bin(num_bin_),
+    max_span(std::max(max_span_, 1u)),
+    ranges(ranges_),
+    num_wave(0),
+    num_hit(0)
+{
+    int tot = 0 ;
+    for(size_t i=0 ; i < ranges.size() ; i++)
+    {
+        offsets.push_back(tot) ;
+        tot += ranges[i].num ;
+    }
+    dense.assign(tot, -1) ;
+}
+
+inline int PMTWaveformStore::slot( int pmtid ) const
+{
+    for(size_t i=0 ; i < ranges.size() ; i++)
+    {
+        int j = pmtid - ranges[i].first ;
+        if( j >= 0 && j < ranges[i].num ) return offsets[i] + j ;
+    }
+    return -1 ;
+}
+
+/**
+PMTWaveformStore::wave
+------------------------
+
+Returns the wave of the PMT, taking the next wave of the pool at its first hit.
+
+**/
+
+inline PMTWaveformStore::Wave& PMTWaveformStore::wave( int pmtid )
+{
+    int s = slot(pmtid) ;
+    int* idx = nullptr ;
+    if( s > -1 )
+    {
+        idx = &dense[s] ;
+    }
+    else
+    {
+        std::unordered_map<int,int>::iterator it = sparse.find(pmtid) ;
+        idx = it != sparse.end() ? &it->second : &(sparse[pmtid] = -1) ;
+    }
+    if( *idx > -1 ) return pool[*idx] ;
+
+    if( num_wave == pool.size() ) pool.push_back(Wave()) ;
+    *idx = int(num_wave) ;
+    Wave& w = pool[num_wave++] ;
+    w.pmtid = pmtid ;
+    w.first = 0. ;
+    w.theta = 0. ;
+    w.phi = 0. ;
+    w.count = 0 ;
+    w.underflow = 0 ;
+    w.overflow = 0 ;
+    w.lo = 0 ;
+    w.bins.clear() ;
+    w.far.clear() ;
+    return w ;
+}
+
+inline void PMTWaveformStore::add( int pmtid, double time, double theta, double phi )
+{
+    Wave& w = wave(pmtid) ;
+    if( w.count == 0 || time < w.first )
+    {
+        w.first = time ;
+        w.theta = theta ;
+        w.phi = phi ;
+    }
+    w.count += 1 ;
+    num_hit += 1 ;
+
+    double f = std::floor( (time - t0)/bin ) ;
+    if( f < 0. )             { w.underflow += 1 ; return ; }
+    if( f >= double(num_bin) ) { w.overflow += 1 ; return ; }
+    int k = int(f) ;
+
+    int n = int(w.bins.size()) ;
+    int hi = w.lo + n ;
+    int cap = int(max_span) ;
+    if( n == 0 )
+    {
+        w.lo = k ;
+        w.bins.push_back(1) ;
+    }
+    else if( k >= w.lo && k < hi )
+    {
+        w.bins[k - w.lo] += 1 ;
+    }
+    else if( k < w.lo && hi - k <= cap )
+    {
+        int lo = std::max( std::max( w.lo - std::max(w.lo - k, n), hi - cap ), 0 ) ;   // lo <= k
+        w.bins.insert( w.bins.begin(), size_t(w.lo - lo), 0u ) ;
+        w.lo = lo ;
+        w.bins[k - lo] += 1 ;
+    }
+    else if( k >= hi && k - w.lo < cap )
+    {
+        w.bins.resize( size_t(k - w.lo + 1), 0u ) ;
+        w.bins[k - w.lo] += 1 ;
+    }
+    else
+    {
+        w.far[k] += 1 ;
+    }
+}
+
+inline void PMTWaveformStore::clear()
+{
+    for(unsigned i=0 ; i < num_wave ; i++)
+    {
+        int s = slot(pool[i].pmtid) ;
+        if( s > -1 ) dense[s] = -1 ;
+    }
+    sparse.clear() ;
+    num_wave = 0 ;
+    num_hit = 0 ;
+}
+
+/**
+PMTWaveformStore::visit
+-------------------------
+
+Calls fn(wave, time, count) for every non-empty bin in order of the waves
+and within a wave in time order, the dense and far bins together.
+The time is the lower edge of the bin except for the bin holding the
+earliest hit which gets the exact first time. Under and overflow hits
+are visited as one entry each at the first time and the lower edge of
+the overflow respectively.
+
+**/
+
+template<typename F>
+inline void PMTWaveformStore::visit( F fn ) const
+{
+    for(unsigned i=0 ; i < num_wave ; i++)
+    {
+        const Wave& w = pool[i] ;
+        if( w.underflow > 0 ) fn( w, w.first, w.underflow ) ;
+        int first_bin = w.underflow > 0 ? -1 : int(std::floor( (w.first - t0)/bin )) ;
+        std::map<int, uint32_t>::const_iterator it = w.far.begin() ;
+        for( ; it != w.far.end() && it->first < w.lo ; it++ ) fn( w, it->first == first_bin ? w.first : t0 + double(it->first)*bin, it->second ) ;
+        for(size_t j=0 ; j < w.bins.size() ; j++)
+        {
+            if( w.bins[j] == 0 ) continue ;
+            int k = w.lo + int(j) ;
+            fn( w, k == first_bin ? w.first : t0 + double(k)*bin, w.bins[j] ) ;
+        }
+        for( ; it != w.far.end() ; it++ ) fn( w, t0 + double(it->first)*bin, it->second ) ;
+        if( w.overflow > 0 ) fn( w, t0 + double(num_bin)*bin, w.overflow ) ;
+    }
+}
+
+inline size_t PMTWaveformStore::num_nonzero() const
+{
+    size_t n = 0 ;
+    visit( [&n](const Wave&, double, unsigned){ n += 1 ; } ) ;
+    return n ;
+}
+
+inline size_t PMTWaveformStore::total_bins() const
+{
+    size_t n = 0 ;
+    for(unsigned i=0 ; i < num_wave ; i++) n += pool[i].bins.size() - Skip(pool[i]) ;
+    return n ;
+}
+
+inline size_t PMTWaveformStore::total_far() const
+{
+    size_t n = 0 ;
+    for(unsigned i=0 ; i < num_wave ; i++) n += pool[i].far.size() ;
+    return n ;
+}
+
+/**
+PMTWaveformStore::bytes
+-------------------------
+
+Bytes of the compact form : the waves rows, the bins and the far bins.
+
+**/
+
+inline size_t PMTWaveformStore::bytes() const
+{
+    return size_t(num_wave)*NUM_COL*sizeof(double) + total_bins()*sizeof(uint32_t) + total_far()*2*sizeof(uint32_t) ;
+}
+
+inline void PMTWaveformStore::sorted( std::vector<const Wave*>& ww ) const
+{
+    ww.clear() ;
+    for(unsigned i=0 ; i < num_wave ; i++) ww.push_back( &pool[i] ) ;
+    std::sort( ww.begin(), ww.end(), [](const Wave* a, const Wave* b){ return a->pmtid < b->pmtid ; } ) ;
+}
+
+inline NP* PMTWaveformStore::waves() const
+{
+    std::vector<const Wave*> ww ;
+    sorted(ww) ;
+
+    int ni = int(ww.size()) ;
+    NP* a = NP::Make<double>( ni, NUM_COL ) ;
+    double* aa = a->values<double>() ;
+    size_t offset = 0 ;
+    size_t far_offset = 0 ;
+    for(int i=0 ; i < ni ; i++)
+    {
+        const Wave& w = *ww[i] ;
+        size_t skip = Skip(w) ;
+        double* row = aa + i*NUM_COL ;
+        row[0] = double(w.pmtid) ;
+        row[1] = w.first ;
+        row[2] = w.theta ;
+        row[3] = w.phi ;
+        row[4] = double(w.count) ;
+        row[5] = double(w.underflow) ;
+        row[6] = double(w.overflow) ;
+        row[7] = double(w.lo + int(skip)) ;
+        row[8] = double(w.bins.size() - skip) ;
+        row[9] = double(offset) ;
+        row[10] = double(w.far.size()) ;
+        row[11] = double(far_offset) ;
+        offset += w.bins.size() - skip ;
+        far_offset += w.far.size() ;
+    }
+    a->set_meta<std::string>("cols", COLS ) ;
+    a->set_meta<double>("t0", t0 ) ;
+    a->set_meta<double>("bin", bin ) ;
+    a->set_meta<int>("num_bin", int(num_bin) ) ;
+    a->set_meta<int>("max_span", int(max_span) ) ;
+    return a ;
+}
+
+inline NP* PMTWaveformStore::bins() const
+{
+    std::vector<const Wave*> ww ;
+    sorted(ww) ;
+
+    NP* b = NP::Make<uint32_t>( int(total_bins()) ) ;
+    uint32_t* bb = b->values<uint32_t>() ;
+    for(size_t i=0 ; i < ww.size() ; i++)
+    {
+        const std::vector<uint32_t>& v = ww[i]->bins ;
+        bb = std::copy( v.begin() + Skip(*ww[i]), v.end(), bb ) ;
+    }
+    return b ;
+}
+
+inline NP* PMTWaveformStore::farbins() const
+{
+    std::vector<const Wave*> ww ;
+    sorted(ww) ;
+
+    NP* f = NP::Make<uint32_t>( int(total_far()), 2 ) ;
+    uint32_t* ff = f->values<uint32_t>() ;
+    for(size_t i=0 ; i < ww.size() ; i++)
+    {
+        const std::map<int, uint32_t>& m = ww[i]->far ;
+        for(std::map<int, uint32_t>::const_iterator it=m.begin() ; it != m.end() ; it++)
+        {
+            *ff++ = uint32_t(it->first) ;
+            *ff++ = it->second ;
+        }
+    }
+    return f ;
+}
+
+inline std::string PMTWaveformStore::desc() const
+{
+    std::stringstream ss ;
+    ss << "PMTWaveformStore"
+       << " bin " << bin
+       << " t0 " << t0
+       << " num_bin " << num_bin
+       << " max_span " << max_span
+       << " hits " << num_hit
+       << " pmts " << num_wave
+       << " bins " << total_bins()
+       << " far " << total_far()
+       << " bytes " << bytes()
+       ;
+    std::string s = ss.str();
+    return s ;
+}
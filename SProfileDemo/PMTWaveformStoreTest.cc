@@ -0,0 +1,193 @@
+/**
+PMTWaveformStoreTest.cc
+=========================
+
+Fills PMTWaveformStore with synthetic muon-like photon hits, checking the
+first times, counts and bin contents against brute force, and compares the
+memory and time with creating a hit object per photon as SaveMuonHit does::
+
+    ./PMTWaveformStoreTest.sh
+    NUM=50000000 BIN=4 ./PMTWaveformStoreTest.sh
+
+The photon times on each PMT are a first arrival time spread over
+the detector plus a scintillation-like exponential tail, as in PMTHitMergerFlatTest.
+Outliers check the window and the dense span cap : late hits 200 us after the
+pulse, one of them the first hit added to its PMT, and an overflow beyond the window.
+
+**/
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "PMTWaveformStore.h"
+
+/**
+MuonHit
+---------
+
+The fields SaveMuonHit sets on junoHit_PMT_muon.
+
+**/
+
+struct MuonHit
+{
+    int    pmtid ;
+    double time ;
+    int    count ;
+    double theta ;
+    double phi ;
+};
+
+struct Photon
+{
+    int    pmtid ;
+    double time ;
+    double theta ;
+    double phi ;
+};
+
+void make_event( std::vector<Photon>& pp, size_t num, unsigned seed )
+{
+    std::mt19937_64 rng(seed) ;
+    std::uniform_real_distribution<double> uni(0., 1.) ;
+    std::exponential_distribution<double> tail(1./30.) ;   // 30 ns decay
+
+    int num_lpmt = 17612 ;
+    int num_spmt = 25600 ;
+    std::vector<double> t0(num_lpmt + num_spmt) ;
+    for(size_t i=0 ; i < t0.size() ; i++) t0[i] = 100.*uni(rng) ;
+
+    pp.resize(num) ;
+    pp[0] = Photon{ 9, 200000., 0.3, 0.4 } ;            // late outlier added first to its PMT
+    for(size_t i=1 ; i < num ; i++)
+    {
+        int j = int( uni(rng) < 0.97 ? num_lpmt*uni(rng) : num_lpmt + num_spmt*uni(rng) ) ;
+        Photon& p = pp[i] ;
+        p.pmtid = j < num_lpmt ? j : 300000 + j - num_lpmt ;
+        p.time = t0[j] + tail(rng) ;
+        p.theta = M_PI*uni(rng) ;
+        p.phi = 2.*M_PI*uni(rng) ;
+    }
+    pp.push_back( Photon{ 123456, 50., 0.1, 0.2 } ) ;     // outside the dense ranges
+    pp.push_back( Photon{ 5, 1e9, 0.1, 0.2 } ) ;          // overflow
+    pp.push_back( Photon{ 5, 200000., 0.1, 0.2 } ) ;      // late outlier, far bin
+    pp.push_back( Photon{ 5, 200000.5, 0.1, 0.2 } ) ;
+    pp.push_back( Photon{ 5, 250000., 0.1, 0.2 } ) ;
+}
+
+int main(int argc, char** argv)
+{
+    typedef std::chrono::steady_clock Clock ;
+    const char* num_ = getenv("NUM") ;
+    const char* bin_ = getenv("BIN") ;
+    size_t num = num_ ? strtoul(num_, nullptr, 10) : 10000000 ;
+    double bin = bin_ ? atof(bin_) : 1. ;
+
+    std::vector<Photon> pp ;
+    make_event(pp, num, 42u ) ;
+
+    // hit object per photon
+    Clock::time_point t0 = Clock::now() ;
+    std::vector<MuonHit*> hits ;
+    for(size_t i=0 ; i < pp.size() ; i++)
+    {
+        const Photon& p = pp[i] ;
+        MuonHit* h = new MuonHit ;
+        h->pmtid = p.pmtid ;
+        h->time = p.time ;
+        h->count = 1 ;
+        h->theta = p.theta ;
+        h->phi = p.phi ;
+        hits.push_back(h) ;
+    }
+    double t_hits = std::chrono::duration<double>(Clock::now() - t0).count() ;
+    size_t bytes_hits = hits.size()*(sizeof(MuonHit) + sizeof(MuonHit*)) ;
+    for(size_t i=0 ; i < hits.size() ; i++) delete hits[i] ;
+
+    // waveform store, second event is the steady state with retained waves
+    PMTWaveformStore ws(bin, 1000000, 4096) ;   // window 1 ms at 1 ns
+    double t_ws = 0. ;
+    for(int ev=0 ; ev < 2 ; ev++)
+    {
+        ws.clear() ;
+        Clock::time_point t1 = Clock::now() ;
+        for(size_t i=0 ; i < pp.size() ; i++) ws.add( pp[i].pmtid, pp[i].time, pp[i].theta, pp[i].phi ) ;
+        t_ws = std::chrono::duration<double>(Clock::now() - t1).count() ;
+    }
+
+    // brute force check
+    std::map<int, const Photon*> first ;
+    std::map<std::pair<int,int>, unsigned> bins ;
+    for(size_t i=0 ; i < pp.size() ; i++)
+    {
+        const Photon& p = pp[i] ;
+        if( first.count(p.pmtid) == 0 || p.time < first[p.pmtid]->time ) first[p.pmtid] = &p ;
+        int k = int(std::floor(p.time/bin)) ;
+        if( k < int(ws.num_bin) ) bins[std::make_pair(p.pmtid, k)] += 1 ;
+    }
+    assert( ws.num_wave == first.size() );
+    size_t total = 0 ;
+    size_t nonzero = 0 ;
+    size_t max_dense = 0 ;
+    for(unsigned i=0 ; i < ws.num_wave ; i++)
+    {
+        const PMTWaveformStore::Wave& w = ws.pool[i] ;
+        const Photon* f = first[w.pmtid] ;
+        assert( w.first == f->time && w.theta == f->theta && w.phi == f->phi );
+        total += w.count ;
+        max_dense = std::max( max_dense, w.bins.size() ) ;
+        for(size_t j=0 ; j < w.bins.size() ; j++)
+        {
+            if( w.bins[j] == 0 ) continue ;
+            assert( bins[std::make_pair(w.pmtid, w.lo + int(j))] == w.bins[j] );
+            nonzero += 1 ;
+        }
+        for(std::map<int, uint32_t>::const_iterator it=w.far.begin() ; it != w.far.end() ; it++)
+        {
+            assert( it->first < w.lo || it->first >= w.lo + int(w.bins.size()) );
+            assert( bins[std::make_pair(w.pmtid, it->first)] == it->second );
+            nonzero += 1 ;
+        }
+    }
+    assert( total == pp.size() );
+    assert( nonzero + 1 == ws.num_nonzero() );   // + overflow entry
+    assert( max_dense <= ws.max_span );
+
+    // the late outliers of PMT 5 do not stretch its dense span
+    const PMTWaveformStore::Wave& w5 = ws.wave(5) ;
+    assert( w5.far.size() == 2 && w5.overflow == 1 );
+
+    assert( bins.size() + 1 == ws.num_nonzero() );
+
+    // visit is in time order within each wave
+    int prev_pmtid = -1 ;
+    double prev_time = 0. ;
+    ws.visit( [&prev_pmtid, &prev_time](const PMTWaveformStore::Wave& w, double time, unsigned)
+        {
+            if( w.pmtid == prev_pmtid ) assert( time >= prev_time );
+            prev_pmtid = w.pmtid ;
+            prev_time = time ;
+        } ) ;
+
+    size_t visited = 0 ;
+    ws.visit( [&visited](const PMTWaveformStore::Wave&, double, unsigned c){ visited += c ; } ) ;
+    assert( visited == pp.size() );
+
+    NP* w = ws.waves() ;
+    NP* b = ws.bins() ;
+    NP* f = ws.farbins() ;
+    assert( w->shape[0] == int(ws.num_wave) && b->shape[0] == int(ws.total_bins()) && f->shape[0] == int(ws.total_far()) );
+
+    printf("PMTWaveformStoreTest photons %zu bin %.2f ns pmts %u nonzero bins %zu max dense span %zu far bins %zu\n", pp.size(), bin, ws.num_wave, ws.num_nonzero(), max_dense, ws.total_far() );
+    printf("  hits  %8.3f s  %6.1f ns/photon  %8.1f MB\n", t_hits, 1e9*t_hits/double(pp.size()), double(bytes_hits)/(1024.*1024.) );
+    printf("  waves %8.3f s  %6.1f ns/photon  %8.1f MB  reduction %.1f\n", t_ws, 1e9*t_ws/double(pp.size()), double(ws.bytes())/(1024.*1024.), double(bytes_hits)/double(ws.bytes()) );
+    printf("  %s\n", ws.desc().c_str() );
+    return 0 ;
+}
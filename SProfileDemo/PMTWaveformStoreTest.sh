@@ -0,0 +1,33 @@
+#!/bin/bash -l 
+usage(){ cat << EOU
+PMTWaveformStoreTest.sh
+=======================
+
+Builds and runs the PMTWaveformStore checks and comparison with hit objects, 
+needs NP.hh from https://github.com/simoncblyth/np::
+
+    ./PMTWaveformStoreTest.sh 
+    NUM=50000000 BIN=4 ./PMTWaveformStoreTest.sh
+
+EOU
+}
+
+name=PMTWaveformStoreTest 
+
+num=10000000
+export NUM=${NUM:-$num}
+
+defarg="build_run"
+arg=${1:-$defarg}
+
+if [ "${arg/build}" != "$arg" ]; then 
+    gcc $name.cc -std=c++11 -O2 -lstdc++ -lm -lpthread -I. -I$HOME/np -o /tmp/$name 
+    [ $? -ne 0 ] && echo $BASH_SOURCE build error && exit 1 
+fi 
+
+if [ "${arg/run}" != "$arg" ]; then 
+    /tmp/$name
+    [ $? -ne 0 ] && echo $BASH_SOURCE run error && exit 2 
+fi 
+
+exit 0 
@@ -0,0 +1,440 @@
+#pragma once
+/**
+SProfileHist.h : online per-thread latency histograms of profile stamp intervals
+==================================================================================
+
+SProfile<N> keeps the stamps of every profiled call in the static SProfile<N>::RECORD
+vector, saved per event and analysed offline. That grows with the number of calls,
+so profiling a muon event holds tens of millions of records.
+
+SProfileHist<N> has the same zero/stamp/add interface but *add* only increments
+log-linear histograms of the configured stamp-to-stamp intervals, so memory is
+constant whatever the number of calls::
+
+    SProfileHist<16>* h = new SProfileHist<16> ;
+    h->define(1, 2, "pmtid") ;     // interval from stamp 1 to stamp 2
+    h->define(0, -1, "total") ;    // -1 : the last stamp set
+
+    h->zero() ; h->stamp(0) ; ... h->stamp(5) ; h->add() ;
+
+An interval is only counted when both its stamps were set, so early returns
+that skip stamps do not pollute the later intervals.
+
+Stamps are steady clock nanoseconds, rather than the microseconds of SProfile,
+as most intervals are well below a microsecond.
+
+Histograms
+------------
+
+Values below SUB ns have exact buckets, above that each power of two is split
+into SUB buckets, so the relative bucket width is at most 1/SUB (6%) up to 2^64 ns.
+With 976 buckets per interval that is 8 kB per interval per thread.
+Percentiles are interpolated within the bucket holding the rank.
+
+Threads
+---------
+
+Each instance is used by a single thread without locking (eg one junoSD_PMT_v2 per
+worker thread) and registers itself so *Array* and *Desc* can merge all threads
+by interval name. The owning thread copies its counts under the lock with *publish*,
+eg at its end of event, and only these snapshots are merged, so merging while
+other threads are still adding is safe and gives the counts up to their last publish.
+Instances destroyed before the report have their current counts kept.
+Only *Clear* when no thread is adding, eg at end of run.
+
+NP array
+----------
+
+Shape (num_interval, 6) with columns count, mean_ns, p50_ns, p90_ns, p99_ns, max_ns
+and the interval names.
+
+**/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "NP.hh"
+
+template<int N>
+struct SProfileHist
+{
+    static constexpr const int SUB = 16 ;
+    static constexpr const int SUB_BITS = 4 ;
+    static constexpr const int NUM_BUCKET = SUB + (64 - SUB_BITS)*SUB ;
+    static constexpr const int NUM_COL = 6 ;
+    static constexpr const char* COLS = "count,mean_ns,p50_ns,p90_ns,p99_ns,max_ns" ;
+
+    struct Hist
+    {
+        uint64_t count[NUM_BUCKET] ;
+        uint64_t num ;
+        double   sum ;
+        uint64_t max ;
+
+        Hist();
+        void   clear();
+        void   add( uint64_t ns );
+        void   merge( const Hist& other );
+        double mean() const ;
+        double percentile( double q ) const ;
+    };
+
+    struct Interval
+    {
+        int a ;
+        int b ;    // -1 : last stamp set
+        std::string name ;
+    };
+
+    uint64_t t[N] ;
+    std::vector<Interval> intervals ;
+    std::vector<Hist>     hists ;
+    std::vector<Hist>     published ;   // snapshot of hists, guarded by Mutex
+
+    static std::mutex& Mutex();
+    static std::vector<SProfileHist<N>*>& Registry();
+    static std::map<std::string, Hist>& Retired();
+
+    static uint64_t Now();
+    static int      Bucket( uint64_t ns );
+    static double   Lower( int bucket );
+    static double   Width( int bucket );
+
+    static bool     Enabled();
+    static void     Merged( std::vector<std::string>& names, std::vector<Hist>& hh );
+    static NP*      Array();
+    static std::string Desc();
+    static void     Clear();
+
+    SProfileHist();
+    ~SProfileHist();
+
+    void define( int a, int b, const char* name );
+    void zero();
+    void stamp( int i );
+    void add();
+    void publish();
+};
+
+
+template<int N>
+inline SProfileHist<N>::Hist::Hist()
+{
+    clear();
+}
+
+template<int N>
+inline void SProfileHist<N>::Hist::clear()
+{
+    for(int i=0 ; i < NUM_BUCKET ; i++) count[i] = 0 ;
+    num = 0 ;
+    sum = 0. ;
+    max = 0 ;
+}
+
+template<int N>
+inline void SProfileHist<N>::Hist::add( uint64_t ns )
+{
+    count[Bucket(ns)] += 1 ;
+    num += 1 ;
+    sum += double(ns) ;
+    if( ns > max ) max = ns ;
+}
+
+template<int N>
+inline void SProfileHist<N>::Hist::merge( const Hist& other )
+{
+    for(int i=0 ; i < NUM_BUCKET ; i++) count[i] += other.count[i] ;
+    num += other.num ;
+    sum += other.sum ;
+    if( other.max > max ) max = other.max ;
+}
+
+template<int N>
+inline double SProfileHist<N>::Hist::mean() const
+{
+    return num > 0 ? sum/double(num) : 0. ;
+}
+
+/**
+SProfileHist::Hist::percentile
+--------------------------------
+
+Value below which a fraction q of the entries lie, interpolated linearly
+within the bucket containing the rank and capped at the maximum.
+
+**/
+
+template<int N>
+inline double SProfileHist<N>::Hist::percentile( double q ) const
+{
+    if( num == 0 ) return 0. ;
+    double rank = q*double(num) ;
+    double cum = 0. ;
+    for(int i=0 ; i < NUM_BUCKET ; i++)
+    {
+        if( count[i] == 0 ) continue ;
+        double c = double(count[i]) ;
+        if( cum + c >= rank )
+        {
+            double f = (rank - cum)/c ;
+            return std::min( Lower(i) + f*Width(i), double(max) ) ;
+        }
+        cum += c ;
+    }
+    return double(max) ;
+}
+
+
+template<int N>
+inline std::mutex& SProfileHist<N>::Mutex() // static
+{
+    static std::mutex mtx ;
+    return mtx ;
+}
+
+template<int N>
+inline std::vector<SProfileHist<N>*>& SProfileHist<N>::Registry() // static
+{
+    static std::vector<SProfileHist<N>*> REGISTRY ;
+    return REGISTRY ;
+}
+
+template<int N>
+inline std::map<std::string, typename SProfileHist<N>::Hist>& SProfileHist<N>::Retired() // static
+{
+    static std::map<std::string, Hist> RETIRED ;
+    return RETIRED ;
+}
+
+template<int N>
+inline uint64_t SProfileHist<N>::Now() // static
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count() ;
+}
+
+template<int N>
+inline int SProfileHist<N>::Bucket( uint64_t ns ) // static
+{
+    if( ns < uint64_t(SUB) ) return int(ns) ;
+    int e = 63 - __builtin_clzll(ns) ;    // e >= SUB_BITS
+    int sub = int( ns >> (e - SUB_BITS) ) - SUB ;
+    return SUB + (e - SUB_BITS)*SUB + sub ;
+}
+
+template<int N>
+inline double SProfileHist<N>::Lower( int bucket ) // static
+{
+    if( bucket < SUB ) return double(bucket) ;
+    int sub = (bucket - SUB) % SUB ;
+    return double(SUB + sub)*Width(bucket) ;
+}
+
+template<int N>
+inline double SProfileHist<N>::Width( int bucket ) // static
+{
+    if( bucket < SUB ) return 1. ;
+    int e = (bucket - SUB)/SUB + SUB_BITS ;
+    return double( uint64_t(1) << (e - SUB_BITS) ) ;
+}
+
+template<int N>
+inline bool SProfileHist<N>::Enabled() // static
+{
+    std::lock_guard<std::mutex> lock(Mutex());
+    return Registry().size() > 0 || Retired().size() > 0 ;
+}
+
+/**
+SProfileHist::Merged
+----------------------
+
+Sums the published histograms of live instances and the histograms
+of destroyed instances by interval name, in order of first definition.
+
+**/
+
+template<int N>
+inline void SProfileHist<N>::Merged( std::vector<std::string>& names, std::vector<Hist>& hh ) // static
+{
+    names.clear();
+    hh.clear();
+    std::map<std::string, size_t> index ;
+    std::lock_guard<std::mutex> lock(Mutex());
+
+    std::vector<SProfileHist<N>*>& reg = Registry() ;
+    for(size_t r=0 ; r < reg.size() ; r++)
+    for(size_t i=0 ; i < reg[r]->intervals.size() ; i++)
+    {
+        const std::string& name = reg[r]->intervals[i].name ;
+        if( index.count(name) == 0 ) { index[name] = names.size() ; names.push_back(name) ; hh.push_back(Hist()) ; }
+        hh[index[name]].merge( reg[r]->published[i] ) ;
+    }
+
+    std::map<std::string, Hist>& ret = Retired() ;
+    for(typename std::map<std::string, Hist>::const_iterator it=ret.begin() ; it != ret.end() ; it++)
+    {
+        const std::string& name = it->first ;
+        if( index.count(name) == 0 ) { index[name] = names.size() ; names.push_back(name) ; hh.push_back(Hist()) ; }
+        hh[index[name]].merge( it->second ) ;
+    }
+}
+
+template<int N>
+inline NP* SProfileHist<N>::Array() // static
+{
+    std::vector<std::string> names ;
+    std::vector<Hist> hh ;
+    Merged(names, hh);
+
+    int ni = int(hh.size()) ;
+    NP* a = NP::Make<double>( ni, NUM_COL );
+    double* aa = a->values<double>() ;
+    for(int i=0 ; i < ni ; i++)
+    {
+        const Hist& h = hh[i] ;
+        aa[i*NUM_COL+0] = double(h.num) ;
+        aa[i*NUM_COL+1] = h.mean() ;
+        aa[i*NUM_COL+2] = h.percentile(0.50) ;
+        aa[i*NUM_COL+3] = h.percentile(0.90) ;
+        aa[i*NUM_COL+4] = h.percentile(0.99) ;
+        aa[i*NUM_COL+5] = double(h.max) ;
+        a->names.push_back( names[i] ) ;
+    }
+    a->set_meta<std::string>("cols", COLS ) ;
+    a->set_meta<int>("SUB", SUB ) ;
+    return a ;
+}
+
+template<int N>
+inline std::string SProfileHist<N>::Desc() // static
+{
+    std::vector<std::string> names ;
+    std::vector<Hist> hh ;
+    Merged(names, hh);
+
+    std::stringstream ss ;
+    ss << "SProfileHist::Desc"
+       << " intervals " << hh.size()
+       << std::endl
+       << std::setw(12) << "interval"
+       << " " << std::setw(12) << "count"
+       << " " << std::setw(10) << "mean_ns"
+       << " " << std::setw(10) << "p50_ns"
+       << " " << std::setw(10) << "p90_ns"
+       << " " << std::setw(10) << "p99_ns"
+       << " " << std::setw(12) << "max_ns"
+       << std::endl
+       ;
+    for(size_t i=0 ; i < hh.size() ; i++)
+    {
+        const Hist& h = hh[i] ;
+        ss << std::setw(12) << names[i]
+           << " " << std::setw(12) << h.num
+           << std::fixed << std::setprecision(1)
+           << " " << std::setw(10) << h.mean()
+           << " " << std::setw(10) << h.percentile(0.50)
+           << " " << std::setw(10) << h.percentile(0.90)
+           << " " << std::setw(10) << h.percentile(0.99)
+           << " " << std::setw(12) << h.max
+           << std::endl
+           ;
+    }
+    std::string s = ss.str();
+    return s ;
+}
+
+template<int N>
+inline void SProfileHist<N>::Clear() // static
+{
+    std::lock_guard<std::mutex> lock(Mutex());
+    std::vector<SProfileHist<N>*>& reg = Registry() ;
+    for(size_t r=0 ; r < reg.size() ; r++)
+    for(size_t i=0 ; i < reg[r]->hists.size() ; i++)
+    {
+        reg[r]->hists[i].clear() ;
+        reg[r]->published[i].clear() ;
+    }
+    Retired().clear();
+}
+
+
+template<int N>
+inline SProfileHist<N>::SProfileHist()
+{
+    zero();
+    std::lock_guard<std::mutex> lock(Mutex());
+    Registry().push_back(this);
+}
+
+template<int N>
+inline SProfileHist<N>::~SProfileHist()
+{
+    std::lock_guard<std::mutex> lock(Mutex());
+    std::vector<SProfileHist<N>*>& reg = Registry() ;
+    reg.erase( std::remove(reg.begin(), reg.end(), this), reg.end() );
+    for(size_t i=0 ; i < intervals.size() ; i++) Retired()[intervals[i].name].merge( hists[i] ) ;
+}
+
+template<int N>
+inline void SProfileHist<N>::define( int a, int b, const char* name )
+{
+    Interval iv ;
+    iv.a = a ;
+    iv.b = b ;
+    iv.name = name ;
+    intervals.push_back(iv);
+    hists.push_back(Hist());
+    std::lock_guard<std::mutex> lock(Mutex());
+    published.push_back(Hist());
+}
+
+template<int N>
+inline void SProfileHist<N>::zero()
+{
+    for(int i=0 ; i < N ; i++) t[i] = 0 ;
+}
+
+template<int N>
+inline void SProfileHist<N>::stamp( int i )
+{
+    t[i] = Now() ;
+}
+
+template<int N>
+inline void SProfileHist<N>::add()
+{
+    uint64_t last = 0 ;
+    for(int i=0 ; i < N ; i++) if( t[i] > last ) last = t[i] ;
+
+    for(size_t i=0 ; i < intervals.size() ; i++)
+    {
+        const Interval& iv = intervals[i] ;
+        uint64_t ta = t[iv.a] ;
+        uint64_t tb = iv.b < 0 ? last : t[iv.b] ;
+        if( ta == 0 || tb < ta ) continue ;    // unset stamps
+        hists[i].add( tb - ta ) ;
+    }
+}
+
+/**
+SProfileHist::publish
+-----------------------
+
+Snapshot of the counts for merging, only call from the thread that adds.
+
+**/
+
+template<int N>
+inline void SProfileHist<N>::publish()
+{
+    std::lock_guard<std::mutex> lock(Mutex());
+    published = hists ;
+}
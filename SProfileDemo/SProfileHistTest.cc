@@ -0,0 +1,226 @@
+/**
+SProfileHistTest.cc
+=====================
+
+Checks the SProfileHist buckets and percentiles against exact percentiles
+of synthetic interval samples, the merging of per-thread instances, also
+while they are adding, and
+compares the cost and memory of histogramming with recording every profile::
+
+    ./SProfileHistTest.sh
+    NUM=10000000 THREADS=8 ./SProfileHistTest.sh
+
+**/
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "SProfileHist.h"
+
+typedef SProfileHist<16> Hist16 ;
+
+/**
+Record
+--------
+
+The SProfile<16> layout : idx and 16 stamps, appended per call to a vector.
+
+**/
+
+struct Record
+{
+    uint64_t idx ;
+    uint64_t t[16] ;
+};
+
+double exact_percentile( std::vector<uint64_t>& v, double q )
+{
+    std::sort(v.begin(), v.end());
+    size_t k = std::min( v.size() - 1, size_t(std::ceil(q*double(v.size()))) - 1 ) ;
+    return double(v[k]) ;
+}
+
+void test_buckets()
+{
+    std::mt19937_64 rng(1) ;
+    for(int i=0 ; i < 1000000 ; i++)
+    {
+        uint64_t v = rng() >> (rng() % 64) ;
+        int b = Hist16::Bucket(v) ;
+        assert( b >= 0 && b < Hist16::NUM_BUCKET );
+        assert( Hist16::Lower(b) <= double(v) && double(v) < Hist16::Lower(b) + Hist16::Width(b) );
+    }
+    assert( Hist16::Bucket(~uint64_t(0)) == Hist16::NUM_BUCKET - 1 );
+    printf("test_buckets : ok\n");
+}
+
+/**
+make_stamps
+-------------
+
+Stamps 0..5 with lognormal intervals like the junoSD_PMT_v2 intervals,
+a fraction of the calls return early after stamp 1 as for culled photons.
+
+**/
+
+void make_stamps( uint64_t* t, std::mt19937_64& rng )
+{
+    static const double MU[5] = { 4.5, 5.0, 2.0, 6.0, 5.5 } ;   // log(ns)
+    std::normal_distribution<double> gaus(0., 0.5) ;
+    std::uniform_real_distribution<double> uni(0., 1.) ;
+    for(int i=0 ; i < 16 ; i++) t[i] = 0 ;
+    t[0] = 1000000 ;
+    int last = uni(rng) < 0.7 ? 1 : 5 ;
+    for(int i=1 ; i <= last ; i++) t[i] = t[i-1] + uint64_t(std::exp(MU[i-1] + gaus(rng))) ;
+}
+
+void define( Hist16& h )
+{
+    h.define(0, 1, "a") ;
+    h.define(1, 2, "b") ;
+    h.define(2, 3, "c") ;
+    h.define(3, 5, "d") ;
+    h.define(0, -1, "total") ;
+}
+
+void test_merge( size_t num, unsigned threads )
+{
+    Hist16::Clear();
+    std::vector<Hist16*> hh(threads) ;
+    for(unsigned i=0 ; i < threads ; i++) { hh[i] = new Hist16 ; define(*hh[i]) ; }
+
+    std::vector<std::vector<uint64_t>> exact(5) ;
+    std::vector<std::thread> tt ;
+    std::vector<std::vector<std::vector<uint64_t>>> per(threads, std::vector<std::vector<uint64_t>>(5)) ;
+    for(unsigned i=0 ; i < threads ; i++) tt.push_back( std::thread( [&, i]()
+        {
+            std::mt19937_64 rng(100 + i) ;
+            Hist16& h = *hh[i] ;
+            for(size_t j=i ; j < num ; j += threads)
+            {
+                make_stamps(h.t, rng) ;
+                h.add() ;
+                if( j % 10000 == i ) h.publish() ;    // like each end of event
+                const uint64_t* t = h.t ;
+                uint64_t last = t[5] > 0 ? t[5] : t[1] ;
+                per[i][0].push_back(t[1] - t[0]) ;
+                if( t[5] > 0 )
+                {
+                    per[i][1].push_back(t[2] - t[1]) ;
+                    per[i][2].push_back(t[3] - t[2]) ;
+                    per[i][3].push_back(t[5] - t[3]) ;
+                }
+                per[i][4].push_back(last - t[0]) ;
+            }
+            h.publish() ;
+        })) ;
+
+    // merging while the threads add only reads the published snapshots
+    size_t num_report = 0 ;
+    for(int r=0 ; r < 20 ; r++)
+    {
+        NP* a = Hist16::Array() ;
+        num_report += a->shape[0] > 0 ;
+        delete a ;
+    }
+    for(unsigned i=0 ; i < threads ; i++) tt[i].join() ;
+    for(unsigned i=0 ; i < threads ; i++)
+    for(int k=0 ; k < 5 ; k++) exact[k].insert( exact[k].end(), per[i][k].begin(), per[i][k].end() ) ;
+
+    delete hh[0] ;    // counts retained
+
+    std::vector<std::string> names ;
+    std::vector<Hist16::Hist> merged ;
+    Hist16::Merged(names, merged);
+    assert( names.size() == 5 );
+
+    // the exact percentile and the interpolation share a bucket, so the deviation
+    // is within the bucket width : 1 ns for the exact buckets below SUB ns
+    // and at most 1/SUB relative above
+    double maxdev = 0. ;
+    const double Q[3] = { 0.5, 0.9, 0.99 } ;
+    for(int k=0 ; k < 5 ; k++)
+    {
+        assert( merged[k].num == exact[k].size() );
+        for(int q=0 ; q < 3 ; q++)
+        {
+            double e = exact_percentile(exact[k], Q[q]) ;
+            double p = merged[k].percentile(Q[q]) ;
+            maxdev = std::max( maxdev, std::abs(p - e)/std::max(e, double(Hist16::SUB)) ) ;
+        }
+    }
+
+    NP* a = Hist16::Array() ;
+    assert( a->shape[0] == 5 && a->shape[1] == Hist16::NUM_COL );
+
+    printf("test_merge : calls %zu threads %u reports while adding %zu max percentile deviation %.4f (relative, absolute/SUB below SUB ns)\n", num, threads, num_report, maxdev );
+    printf("%s", Hist16::Desc().c_str() );
+    assert( maxdev <= 1./double(Hist16::SUB) );
+
+    for(unsigned i=1 ; i < threads ; i++) delete hh[i] ;
+    Hist16::Clear();
+}
+
+/**
+test_cost
+-----------
+
+Same stamps taken with the clock, either appended to a vector of records
+as SProfile<16>::add does or histogrammed.
+
+**/
+
+void test_cost( size_t num )
+{
+    typedef std::chrono::steady_clock Clock ;
+
+    std::vector<Record> record ;
+    Record r = {} ;
+    Clock::time_point t0 = Clock::now() ;
+    for(size_t i=0 ; i < num ; i++)
+    {
+        for(int j=0 ; j < 16 ; j++) r.t[j] = 0 ;
+        r.idx = i ;
+        for(int j=0 ; j < 6 ; j++) r.t[j] = Hist16::Now() ;
+        record.push_back(r) ;
+    }
+    double t_record = std::chrono::duration<double>(Clock::now() - t0).count() ;
+    size_t mb_record = record.capacity()*sizeof(Record)/(1024*1024) ;
+
+    Hist16 h ;
+    define(h) ;
+    Clock::time_point t1 = Clock::now() ;
+    for(size_t i=0 ; i < num ; i++)
+    {
+        h.zero() ;
+        for(int j=0 ; j < 6 ; j++) h.stamp(j) ;
+        h.add() ;
+    }
+    double t_hist = std::chrono::duration<double>(Clock::now() - t1).count() ;
+    size_t kb_hist = h.hists.size()*sizeof(Hist16::Hist)/1024 ;
+
+    printf("test_cost : calls %zu\n", num );
+    printf("  record %8.3f s %6.1f ns/call  %zu MB\n", t_record, 1e9*t_record/double(num), mb_record );
+    printf("  hist   %8.3f s %6.1f ns/call  %zu kB\n", t_hist, 1e9*t_hist/double(num), kb_hist );
+    assert( h.hists[4].num == num );
+}
+
+int main(int argc, char** argv)
+{
+    const char* num_ = getenv("NUM") ;
+    const char* threads_ = getenv("THREADS") ;
+    size_t num = num_ ? strtoul(num_, nullptr, 10) : 1000000 ;
+    unsigned threads = threads_ ? atoi(threads_) : 4 ;
+
+    test_buckets();
+    test_merge(num, threads);
+    test_cost(num);
+    return 0 ;
+}
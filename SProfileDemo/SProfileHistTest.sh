@@ -0,0 +1,33 @@
+#!/bin/bash -l 
+usage(){ cat << EOU
+SProfileHistTest.sh
+===================
+
+Builds and runs the SProfileHist percentile, merge and cost checks, 
+needs NP.hh from https://github.com/simoncblyth/np::
+
+    ./SProfileHistTest.sh 
+    NUM=10000000 THREADS=8 ./SProfileHistTest.sh
+
+EOU
+}
+
+name=SProfileHistTest 
+
+num=1000000
+export NUM=${NUM:-$num}
+
+defarg="build_run"
+arg=${1:-$defarg}
+
+if [ "${arg/build}" != "$arg" ]; then 
+    gcc $name.cc -std=c++11 -O2 -lstdc++ -lm -lpthread -I. -I$HOME/np -o /tmp/$name 
+    [ $? -ne 0 ] && echo $BASH_SOURCE build error && exit 1 
+fi 
+
+if [ "${arg/run}" != "$arg" ]; then 
+    /tmp/$name
+    [ $? -ne 0 ] && echo $BASH_SOURCE run error && exit 2 
+fi 
+
+exit 0 
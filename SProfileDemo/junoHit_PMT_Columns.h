@@ -0,0 +1,332 @@
+#pragma once
+/**
+junoHit_PMT_Columns.h : columnar (structure of arrays) store of the hits of one event
+========================================================================================
+
+Alternative to creating a junoHit_PMT object for every accepted photon
+in junoSD_PMT_v2::SaveNormHit. Hits are appended to contiguous arrays per field.
+The hot fields that downstream mostly reads are always stored, the cold
+groups only when enabled by the flags:
+
+HOT (always)
+    pmtid, time, count, weight, kinetic energy (wavelength is derived)
+
+LOCAL
+    local position, momentum and polarization (theta/phi are derived)
+
+GLOBAL
+    global position, momentum and polarization
+
+TRUTH
+    producerID, cerenkov/reemission/originalOP bits, original OP start time,
+    boundary position
+
+With all groups a hit takes 209 bytes of columns, with only HOT it takes 28 bytes,
+compared with sizeof(junoHit_PMT) plus the allocation and collection overhead.
+
+Merging of hits on the same PMT within a time window is done on the columns
+by *merge*, as done by PMTHitMerger::doMerge for hit objects : the count of
+the first matching hit is incremented and its time set to the earliest.
+
+junoHit_PMT objects are only materialized when a consumer needs them,
+individually with *hit(i)*, through the hit merger with *saveHits* or
+directly into a collection with *materialize*. As with SaveNormHit the hits
+should go through the merger when there is one, so that its index covers
+them for any later doMerge, eg of the hits collected from the GPU.
+Fields of disabled groups are left at their junoHit_PMT defaults.
+
+With junoHit_PMT_Columns_STANDALONE the includer defines junoHit_PMT and
+junoHit_PMT_Collection, see junoHit_PMT_ColumnsTest.cc
+
+**/
+
+#include <cmath>
+#include <cstddef>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "G4ThreeVector.hh"
+#include "G4PhysicalConstants.hh"
+#ifndef junoHit_PMT_Columns_STANDALONE
+#include "junoHit_PMT.hh"
+#endif
+
+struct junoHit_PMT_Columns
+{
+    enum { HOT=0, LOCAL=1<<0, GLOBAL=1<<1, TRUTH=1<<2, ALL=LOCAL|GLOBAL|TRUTH } ;
+    enum { CERENKOV=1<<0, REEMISSION=1<<1, ORIGINAL_OP=1<<2 } ;
+
+    unsigned flags ;
+
+    // HOT
+    std::vector<int>     pmtid ;
+    std::vector<double>  time ;
+    std::vector<int>     count ;
+    std::vector<float>   weight ;
+    std::vector<double>  energy ;
+
+    // LOCAL : 3 values per hit
+    std::vector<double>  lpos, lmom, lpol ;
+
+    // GLOBAL : 3 values per hit
+    std::vector<double>  gpos, gmom, gpol ;
+
+    // TRUTH
+    std::vector<int>            producer ;
+    std::vector<unsigned char>  bits ;
+    std::vector<double>         tstart ;
+    std::vector<double>         bpos ;     // 3 values per hit
+
+    std::unordered_map<int, std::vector<unsigned>> pmt_index ;   // only maintained when merging
+
+    static std::string FlagsDesc(unsigned flags);
+    static void Push3( std::vector<double>& v, const G4ThreeVector& a );
+    static G4ThreeVector Get3( const std::vector<double>& v, size_t i );
+
+    junoHit_PMT_Columns(unsigned flags=ALL);
+
+    size_t size() const ;
+    void   clear();
+    void   reserve(size_t n);
+
+    size_t add( int pmtID, double hittime, double weight, double edep,
+                const G4ThreeVector& local_pos, const G4ThreeVector& local_dir, const G4ThreeVector& local_pol,
+                const G4ThreeVector& global_pos, const G4ThreeVector& global_dir, const G4ThreeVector& global_pol,
+                int producerID, bool is_from_cerenkov, bool is_reemission, bool is_original_op,
+                double t_start, const G4ThreeVector& boundary_pos );
+
+    bool   merge( int pmtID, double hittime, double window );
+    void   index( int pmtID, size_t i );
+
+    junoHit_PMT* hit( size_t i ) const ;
+    size_t materialize( junoHit_PMT_Collection* hc ) const ;
+    template<typename MERGER> size_t saveHits( MERGER* merger ) const ;
+
+    size_t bytes() const ;
+    std::string desc() const ;
+};
+
+inline std::string junoHit_PMT_Columns::FlagsDesc(unsigned flags) // static
+{
+    std::stringstream ss ;
+    ss << "HOT" ;
+    if( flags & LOCAL )  ss << "|LOCAL" ;
+    if( flags & GLOBAL ) ss << "|GLOBAL" ;
+    if( flags & TRUTH )  ss << "|TRUTH" ;
+    std::string s = ss.str();
+    return s ;
+}
+
+inline void junoHit_PMT_Columns::Push3( std::vector<double>& v, const G4ThreeVector& a ) // static
+{
+    v.push_back(a.x()) ;
+    v.push_back(a.y()) ;
+    v.push_back(a.z()) ;
+}
+
+inline G4ThreeVector junoHit_PMT_Columns::Get3( const std::vector<double>& v, size_t i ) // static
+{
+    return G4ThreeVector( v[3*i+0], v[3*i+1], v[3*i+2] ) ;
+}
+
+inline junoHit_PMT_Columns::junoHit_PMT_Columns(unsigned flags_)
+    :
+    flags(flags_)
+{
+}
+
+inline size_t junoHit_PMT_Columns::size() const
+{
+    return pmtid.size() ;
+}
+
+/**
+junoHit_PMT_Columns::clear
+----------------------------
+
+Capacity is retained, so after the first large event the
+columns do not allocate.
+
+**/
+
+inline void junoHit_PMT_Columns::clear()
+{
+    pmtid.clear(); time.clear(); count.clear(); weight.clear(); energy.clear();
+    lpos.clear(); lmom.clear(); lpol.clear();
+    gpos.clear(); gmom.clear(); gpol.clear();
+    producer.clear(); bits.clear(); tstart.clear(); bpos.clear();
+    pmt_index.clear();
+}
+
+inline void junoHit_PMT_Columns::reserve(size_t n)
+{
+    pmtid.reserve(n); time.reserve(n); count.reserve(n); weight.reserve(n); energy.reserve(n);
+    if( flags & LOCAL )  { lpos.reserve(3*n); lmom.reserve(3*n); lpol.reserve(3*n); }
+    if( flags & GLOBAL ) { gpos.reserve(3*n); gmom.reserve(3*n); gpol.reserve(3*n); }
+    if( flags & TRUTH )  { producer.reserve(n); bits.reserve(n); tstart.reserve(n); bpos.reserve(3*n); }
+}
+
+inline size_t junoHit_PMT_Columns::add( int pmtID, double hittime, double weight_, double edep,
+                const G4ThreeVector& local_pos, const G4ThreeVector& local_dir, const G4ThreeVector& local_pol,
+                const G4ThreeVector& global_pos, const G4ThreeVector& global_dir, const G4ThreeVector& global_pol,
+                int producerID, bool is_from_cerenkov, bool is_reemission, bool is_original_op,
+                double t_start, const G4ThreeVector& boundary_pos )
+{
+    size_t i = pmtid.size() ;
+    pmtid.push_back(pmtID) ;
+    time.push_back(hittime) ;
+    count.push_back(1) ;
+    weight.push_back(float(weight_)) ;
+    energy.push_back(edep) ;
+
+    if( flags & LOCAL )
+    {
+        Push3(lpos, local_pos) ;
+        Push3(lmom, local_dir) ;
+        Push3(lpol, local_pol) ;
+    }
+    if( flags & GLOBAL )
+    {
+        Push3(gpos, global_pos) ;
+        Push3(gmom, global_dir) ;
+        Push3(gpol, global_pol) ;
+    }
+    if( flags & TRUTH )
+    {
+        unsigned char b = ( is_from_cerenkov ? CERENKOV : 0 ) | ( is_reemission ? REEMISSION : 0 ) | ( is_original_op ? ORIGINAL_OP : 0 ) ;
+        producer.push_back(producerID) ;
+        bits.push_back(b) ;
+        tstart.push_back(t_start) ;
+        Push3(bpos, boundary_pos) ;
+    }
+    return i ;
+}
+
+/**
+junoHit_PMT_Columns::merge
+----------------------------
+
+Returns true when the hit was merged into an existing hit of the same PMT
+with time within the window, otherwise the caller should *add* the hit
+and then *index* it.
+
+**/
+
+inline bool junoHit_PMT_Columns::merge( int pmtID, double hittime, double window )
+{
+    std::unordered_map<int, std::vector<unsigned>>::iterator it = pmt_index.find(pmtID) ;
+    if( it == pmt_index.end() ) return false ;
+    const std::vector<unsigned>& ii = it->second ;
+    for(size_t k=0 ; k < ii.size() ; k++)
+    {
+        unsigned j = ii[k] ;
+        if( std::abs(hittime - time[j]) < window )
+        {
+            count[j] += 1 ;
+            if( hittime < time[j] ) time[j] = hittime ;
+            return true ;
+        }
+    }
+    return false ;
+}
+
+inline void junoHit_PMT_Columns::index( int pmtID, size_t i )
+{
+    pmt_index[pmtID].push_back(unsigned(i)) ;
+}
+
+inline junoHit_PMT* junoHit_PMT_Columns::hit( size_t i ) const
+{
+    junoHit_PMT* hit_photon = new junoHit_PMT();
+    hit_photon->SetPMTID(pmtid[i]);
+    hit_photon->SetWeight(weight[i]);
+    hit_photon->SetTime(time[i]);
+    hit_photon->SetWavelength(CLHEP::twopi*CLHEP::hbarc/energy[i]);
+    hit_photon->SetKineticEnergy(energy[i]);
+    hit_photon->SetCount(count[i]);
+
+    if( flags & LOCAL )
+    {
+        G4ThreeVector local_pos = Get3(lpos, i) ;
+        hit_photon->SetPosition(local_pos);
+        hit_photon->SetTheta(local_pos.theta());
+        hit_photon->SetPhi(local_pos.phi());
+        hit_photon->SetMomentum(Get3(lmom, i));
+        hit_photon->SetPolarization(Get3(lpol, i));
+    }
+    if( flags & GLOBAL )
+    {
+        hit_photon->SetGlobalPosition(Get3(gpos, i));
+        hit_photon->SetGlobalMomentum(Get3(gmom, i));
+        hit_photon->SetGlobalPolarization(Get3(gpol, i));
+    }
+    if( flags & TRUTH )
+    {
+        hit_photon->SetProducerID(producer[i]);
+        hit_photon->SetFromCerenkov( (bits[i] & CERENKOV) != 0 );
+        hit_photon->SetReemission(   (bits[i] & REEMISSION) != 0 );
+        hit_photon->SetOriginalOP(   (bits[i] & ORIGINAL_OP) != 0 );
+        hit_photon->SetOriginalOPStartT(tstart[i]);
+        hit_photon->SetBoundaryPosition(Get3(bpos, i));
+    }
+    return hit_photon ;
+}
+
+/**
+junoHit_PMT_Columns::materialize
+----------------------------------
+
+Inserts the hits directly into the collection, bypassing any merger.
+
+**/
+
+inline size_t junoHit_PMT_Columns::materialize( junoHit_PMT_Collection* hc ) const
+{
+    size_t n = size() ;
+    for(size_t i=0 ; i < n ; i++) hc->insert( hit(i) ) ;
+    return n ;
+}
+
+/**
+junoHit_PMT_Columns::saveHits
+-------------------------------
+
+Hands the hits in order to merger->saveHit as SaveNormHit does for each
+hit object, the merger inserts them into its collection and indexes them
+when merging is enabled. MERGER is PMTHitMerger or PMTHitMergerFlat.
+
+**/
+
+template<typename MERGER>
+inline size_t junoHit_PMT_Columns::saveHits( MERGER* merger ) const
+{
+    size_t n = size() ;
+    for(size_t i=0 ; i < n ; i++) merger->saveHit( hit(i) ) ;
+    return n ;
+}
+
+inline size_t junoHit_PMT_Columns::bytes() const
+{
+    size_t b = 0 ;
+    b += pmtid.capacity()*sizeof(int) + time.capacity()*sizeof(double) + count.capacity()*sizeof(int) ;
+    b += weight.capacity()*sizeof(float) + energy.capacity()*sizeof(double) ;
+    b += ( lpos.capacity() + lmom.capacity() + lpol.capacity() )*sizeof(double) ;
+    b += ( gpos.capacity() + gmom.capacity() + gpol.capacity() )*sizeof(double) ;
+    b += producer.capacity()*sizeof(int) + bits.capacity() + tstart.capacity()*sizeof(double) + bpos.capacity()*sizeof(double) ;
+    return b ;
+}
+
+inline std::string junoHit_PMT_Columns::desc() const
+{
+    std::stringstream ss ;
+    ss << "junoHit_PMT_Columns"
+       << " flags " << FlagsDesc(flags)
+       << " hits " << size()
+       << " merged_pmts " << pmt_index.size()
+       << " MB " << double(bytes())/(1024.*1024.)
+       ;
+    std::string s = ss.str();
+    return s ;
+}
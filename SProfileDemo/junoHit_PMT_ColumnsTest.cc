@@ -0,0 +1,286 @@
+/**
+junoHit_PMT_ColumnsTest.cc
+============================
+
+Round trip of junoHit_PMT_Columns against the hit object path of
+junoSD_PMT_v2::SaveNormHit : the same synthetic photons are merged and saved
+as hit objects through the merger, and added to the columns which are then
+handed to the merger with saveHits. The two collections must be identical
+field by field. PMTHitMergerFlat stands in for PMTHitMerger, see
+PMTHitMergerFlatTest.sh for their equivalence::
+
+    ./junoHit_PMT_ColumnsTest.sh
+    NUM=1000000 MERGE=0 ./junoHit_PMT_ColumnsTest.sh
+
+After saveHits later photons still merge with the materialized hits,
+as the GPU hits do in junoSD_PMT_v2_Opticks.
+
+The timings compare the hit objects with the columns as kept for a columnar
+consumer, without materialization. Only the HOT columns save memory, about 6x,
+and time when not merging. With merging the per-PMT scan of *merge* is
+slower than PMTHitMergerFlat for large events, and materializing with saveHits
+is always slower than creating the hit objects directly.
+
+**/
+
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "G4ThreeVector.hh"
+
+/**
+junoHit_PMT
+-------------
+
+Standin with the fields and accessors of junosw junoHit_PMT used by SaveNormHit.
+
+**/
+
+struct junoHit_PMT
+{
+    int pmtid = -1 ; double weight = 0., time = 0., wavelength = 0., energy = 0., theta = 0., phi = 0. ; int count = 0 ;
+    G4ThreeVector pos, mom, pol, gpos, gmom, gpol, bpos ;
+    int producer = -1 ; bool cerenkov = false, reemission = false, original = false ; double tstart = 0. ;
+
+    void SetPMTID(int v){ pmtid = v ; }                 int    GetPMTID() const { return pmtid ; }
+    void SetWeight(double v){ weight = v ; }
+    void SetTime(double v){ time = v ; }                double GetTime() const { return time ; }
+    void SetWavelength(double v){ wavelength = v ; }
+    void SetKineticEnergy(double v){ energy = v ; }
+    void SetCount(int v){ count = v ; }                 int    GetCount() const { return count ; }
+    void SetPosition(const G4ThreeVector& v){ pos = v ; }
+    void SetTheta(double v){ theta = v ; }
+    void SetPhi(double v){ phi = v ; }
+    void SetMomentum(const G4ThreeVector& v){ mom = v ; }
+    void SetPolarization(const G4ThreeVector& v){ pol = v ; }
+    void SetGlobalPosition(const G4ThreeVector& v){ gpos = v ; }
+    void SetGlobalMomentum(const G4ThreeVector& v){ gmom = v ; }
+    void SetGlobalPolarization(const G4ThreeVector& v){ gpol = v ; }
+    void SetProducerID(int v){ producer = v ; }
+    void SetFromCerenkov(bool v){ cerenkov = v ; }
+    void SetReemission(bool v){ reemission = v ; }
+    void SetOriginalOP(bool v){ original = v ; }
+    void SetOriginalOPStartT(double v){ tstart = v ; }
+    void SetBoundaryPosition(const G4ThreeVector& v){ bpos = v ; }
+};
+
+struct junoHit_PMT_Collection
+{
+    std::vector<junoHit_PMT*> hits ;
+    ~junoHit_PMT_Collection(){ for(size_t i=0 ; i < hits.size() ; i++) delete hits[i] ; }
+    size_t insert(junoHit_PMT* h){ hits.push_back(h) ; return hits.size() ; }
+    size_t entries() const { return hits.size() ; }
+    junoHit_PMT* operator[](size_t i) const { return hits[i] ; }
+};
+
+#define junoHit_PMT_Columns_STANDALONE 1
+#include "junoHit_PMT_Columns.h"
+#include "PMTHitMergerFlat.h"
+
+typedef PMTHitMergerFlat<junoHit_PMT_Collection, junoHit_PMT> Merger ;
+
+struct Photon
+{
+    int pmtid ;
+    double time, edep, t_start ;
+    G4ThreeVector local_pos, local_dir, local_pol, global_pos, global_dir, global_pol, boundary_pos ;
+    int producerID ;
+    bool cerenkov, reemission, original ;
+};
+
+G4ThreeVector random_dir( std::mt19937_64& rng )
+{
+    std::normal_distribution<double> gaus(0., 1.) ;
+    G4ThreeVector v( gaus(rng), gaus(rng), gaus(rng) ) ;
+    return v.unit() ;
+}
+
+void make_photons( std::vector<Photon>& pp, size_t num, unsigned seed )
+{
+    std::mt19937_64 rng(seed) ;
+    std::uniform_real_distribution<double> uni(0., 1.) ;
+    std::exponential_distribution<double> tail(1./30.) ;
+    int num_pmt = 17612 ;
+    std::vector<double> t0(num_pmt) ;
+    for(int i=0 ; i < num_pmt ; i++) t0[i] = 100.*uni(rng) ;
+
+    pp.resize(num) ;
+    for(size_t i=0 ; i < num ; i++)
+    {
+        Photon& p = pp[i] ;
+        p.pmtid = int(num_pmt*uni(rng)) ;
+        p.time = t0[p.pmtid] + tail(rng) ;
+        p.edep = (2. + 2.*uni(rng))*1e-6 ;        // MeV
+        p.t_start = 10.*uni(rng) ;
+        p.local_pos = 250.*random_dir(rng) ;
+        p.local_dir = random_dir(rng) ;
+        p.local_pol = random_dir(rng) ;
+        p.global_pos = 19500.*random_dir(rng) ;
+        p.global_dir = random_dir(rng) ;
+        p.global_pol = random_dir(rng) ;
+        p.boundary_pos = 17700.*random_dir(rng) ;
+        p.producerID = int(1000*uni(rng)) ;
+        p.cerenkov = uni(rng) < 0.1 ;
+        p.reemission = uni(rng) < 0.3 ;
+        p.original = uni(rng) < 0.5 ;
+    }
+}
+
+/**
+save_row
+----------
+
+The hit object creation of junoSD_PMT_v2::SaveNormHit.
+
+**/
+
+void save_row( Merger& m, const Photon& p )
+{
+    junoHit_PMT* hit_photon = new junoHit_PMT();
+    hit_photon->SetPMTID(p.pmtid);
+    hit_photon->SetWeight(1.0);
+    hit_photon->SetTime(p.time);
+    hit_photon->SetWavelength(CLHEP::twopi*CLHEP::hbarc/p.edep);
+    hit_photon->SetKineticEnergy(p.edep);
+    hit_photon->SetPosition(p.local_pos);
+    hit_photon->SetTheta(p.local_pos.theta());
+    hit_photon->SetPhi(p.local_pos.phi());
+    hit_photon->SetMomentum(p.local_dir);
+    hit_photon->SetPolarization(p.local_pol);
+    hit_photon->SetGlobalPosition(p.global_pos);
+    hit_photon->SetGlobalMomentum(p.global_dir);
+    hit_photon->SetGlobalPolarization(p.global_pol);
+    hit_photon->SetCount(1);
+    hit_photon->SetProducerID(p.producerID);
+    hit_photon->SetFromCerenkov(p.cerenkov);
+    hit_photon->SetReemission(p.reemission);
+    hit_photon->SetOriginalOP(p.original);
+    hit_photon->SetOriginalOPStartT(p.t_start);
+    hit_photon->SetBoundaryPosition(p.boundary_pos);
+    m.saveHit(hit_photon);
+}
+
+/**
+fill
+------
+
+The columns path of junoSD_PMT_v2::ProcessHits and SaveNormHit.
+
+**/
+
+void fill( junoHit_PMT_Columns& cols, const std::vector<Photon>& pp, size_t num, bool merge, double window )
+{
+    for(size_t i=0 ; i < num ; i++)
+    {
+        const Photon& p = pp[i] ;
+        if( merge && cols.merge(p.pmtid, p.time, window) ) continue ;
+        size_t idx = cols.add( p.pmtid, p.time, 1.0, p.edep,
+                               p.local_pos, p.local_dir, p.local_pol,
+                               p.global_pos, p.global_dir, p.global_pol,
+                               p.producerID, p.cerenkov, p.reemission, p.original,
+                               p.t_start, p.boundary_pos ) ;
+        if( merge ) cols.index(p.pmtid, idx) ;
+    }
+}
+
+bool same( const junoHit_PMT* a, const junoHit_PMT* b )
+{
+    return a->pmtid == b->pmtid && a->weight == b->weight && a->time == b->time && a->wavelength == b->wavelength
+        && a->energy == b->energy && a->theta == b->theta && a->phi == b->phi && a->count == b->count
+        && a->pos == b->pos && a->mom == b->mom && a->pol == b->pol
+        && a->gpos == b->gpos && a->gmom == b->gmom && a->gpol == b->gpol && a->bpos == b->bpos
+        && a->producer == b->producer && a->cerenkov == b->cerenkov && a->reemission == b->reemission
+        && a->original == b->original && a->tstart == b->tstart ;
+}
+
+int main(int argc, char** argv)
+{
+    typedef std::chrono::steady_clock Clock ;
+    const char* num_ = getenv("NUM") ;
+    const char* merge_ = getenv("MERGE") ;
+    size_t num = num_ ? strtoul(num_, nullptr, 10) : 1000000 ;
+    bool merge = merge_ ? atoi(merge_) != 0 : true ;
+    double window = 1. ;
+
+    std::vector<Photon> pp ;
+    make_photons(pp, num, 42u ) ;
+    size_t half = num/2 ;    // second half arrives after materialization, like GPU hits
+
+    // hit objects
+    junoHit_PMT_Collection hc0 ;
+    Merger m0 ;
+    m0.setMergeFlag(merge) ;
+    m0.setTimeWindow(window) ;
+    m0.init(&hc0) ;
+    Clock::time_point t0 = Clock::now() ;
+    for(size_t i=0 ; i < half ; i++)
+    {
+        const Photon& p = pp[i] ;
+        if( merge && m0.doMerge(p.pmtid, p.time) ) continue ;
+        save_row(m0, p) ;
+    }
+    double s0 = std::chrono::duration<double>(Clock::now() - t0).count() ;
+
+    // columns, then saveHits through the merger
+    junoHit_PMT_Collection hc1 ;
+    Merger m1 ;
+    m1.setMergeFlag(merge) ;
+    m1.setTimeWindow(window) ;
+    m1.init(&hc1) ;
+    junoHit_PMT_Columns cols(junoHit_PMT_Columns::ALL) ;
+    Clock::time_point t1 = Clock::now() ;
+    fill(cols, pp, half, merge, window) ;
+    size_t saved = cols.saveHits(&m1) ;
+    double s1 = std::chrono::duration<double>(Clock::now() - t1).count() ;
+    assert( saved == cols.size() );
+
+    // columns kept for a columnar consumer : no hit objects, with all groups and with HOT only
+    double s2[2] ;
+    size_t b2[2] ;
+    unsigned ff[2] = { junoHit_PMT_Columns::ALL, junoHit_PMT_Columns::HOT } ;
+    for(int k=0 ; k < 2 ; k++)
+    {
+        junoHit_PMT_Columns cc(ff[k]) ;
+        Clock::time_point t2 = Clock::now() ;
+        fill(cc, pp, half, merge, window) ;
+        s2[k] = std::chrono::duration<double>(Clock::now() - t2).count() ;
+        b2[k] = cc.bytes() ;
+    }
+    size_t b0 = hc0.entries()*(sizeof(junoHit_PMT) + sizeof(junoHit_PMT*)) ;   // before the later hits are added
+
+    // later hits merge with the materialized ones in both
+    for(size_t i=half ; i < num ; i++)
+    {
+        const Photon& p = pp[i] ;
+        if( !(merge && m0.doMerge(p.pmtid, p.time)) ) save_row(m0, p) ;
+        if( !(merge && m1.doMerge(p.pmtid, p.time)) ) save_row(m1, p) ;
+    }
+
+    bool ok = hc0.entries() == hc1.entries() ;
+    for(size_t i=0 ; ok && i < hc0.entries() ; i++) ok = same( hc0[i], hc1[i] ) ;
+
+    // HOT only leaves the cold fields at their defaults
+    junoHit_PMT_Columns hot(junoHit_PMT_Columns::HOT) ;
+    const Photon& p = pp[0] ;
+    hot.add( p.pmtid, p.time, 1.0, p.edep, p.local_pos, p.local_dir, p.local_pol, p.global_pos, p.global_dir, p.global_pol,
+             p.producerID, p.cerenkov, p.reemission, p.original, p.t_start, p.boundary_pos ) ;
+    junoHit_PMT* h = hot.hit(0) ;
+    bool hot_ok = h->pmtid == p.pmtid && h->time == p.time && h->energy == p.edep && h->producer == -1 && h->pos == G4ThreeVector() ;
+    delete h ;
+
+    printf("junoHit_PMT_ColumnsTest photons %zu merge %d hits %zu columns %zu same %d hot %d\n", num, merge, hc0.entries(), cols.size(), ok, hot_ok ) ;
+    printf("  objects            %8.3f s %8.1f MB (sizeof junoHit_PMT standin %zu)\n", s0, double(b0)/(1024.*1024.), sizeof(junoHit_PMT) ) ;
+    printf("  columns + saveHits %8.3f s\n", s1 ) ;
+    printf("  columns ALL        %8.3f s %8.1f MB (no hit objects)\n", s2[0], double(b2[0])/(1024.*1024.) ) ;
+    printf("  columns HOT        %8.3f s %8.1f MB (no hit objects)\n", s2[1], double(b2[1])/(1024.*1024.) ) ;
+    printf("  %s\n", cols.desc().c_str() ) ;
+
+    assert( ok ) ;
+    assert( hot_ok ) ;
+    return ok && hot_ok ? 0 : 1 ;
+}
@@ -0,0 +1,43 @@
+#!/bin/bash -l 
+usage(){ cat << EOU
+junoHit_PMT_ColumnsTest.sh
+=============================
+
+Builds and runs the round trip of junoHit_PMT_Columns against the 
+hit object path, needs the CLHEP headers for G4ThreeVector::
+
+    ./junoHit_PMT_ColumnsTest.sh 
+    NUM=1000000 MERGE=0 ./junoHit_PMT_ColumnsTest.sh
+
+EOU
+}
+
+name=junoHit_PMT_ColumnsTest 
+
+num=1000000
+export NUM=${NUM:-$num}
+
+clhep-
+g4-
+
+defarg="build_run"
+arg=${1:-$defarg}
+
+if [ "${arg/build}" != "$arg" ]; then 
+    gcc $name.cc -std=c++11 -O2 -lstdc++ -lm -I. \
+         -I$(clhep-prefix)/include \
+         -I$(g4-prefix)/include/Geant4 \
+         -L$(clhep-prefix)/lib \
+         -lCLHEP-$(clhep-ver) \
+         -o /tmp/$name 
+    [ $? -ne 0 ] && echo $BASH_SOURCE build error && exit 1 
+fi 
+
+if [ "${arg/run}" != "$arg" ]; then 
+    /tmp/$name
+    [ $? -ne 0 ] && echo $BASH_SOURCE run error && exit 2 
+    MERGE=0 /tmp/$name
+    [ $? -ne 0 ] && echo $BASH_SOURCE run MERGE=0 error && exit 3 
+fi 
+
+exit 0
@@ -18,6 +18,9 @@
 #include "G4SDManager.hh"
 #include "G4UnitsTable.hh"
 #include <cassert>
+#include <chrono>
+#include <map>
+#include <sstream>
 #include "NormalTrackInfo.hh"
 #include "G4OpticalPhoton.hh"
 #include "Randomize.hh"
@@ -34,6 +37,11 @@
 #include "junoSD_PMT_v2_Opticks.hh"
 #include "PMTEfficiency.hh"
 #include "PMTEfficiencyTable.hh"
+#include "junoHit_PMT_Columns.h"
+#include "PMTDetectBound.h"
+#include "CETable.h"
+#include "PMTWaveformStore.h"
+#include "NPFold.h"
 
 #ifdef WITH_G4CXOPTICKS_DEBUG
 #include "U4Touchable.h"
@@ -55,7 +63,9 @@ using namespace CLHEP;
 #include "C4Track.h"
 #include "SLOG.hh"
 #include "SEvt.hh"
+#include "ssys.h"
 #include "SProfile.h"
+#include "SProfileHist.h"
 #include "U4Touchable.h"
 
 template<>
@@ -81,8 +91,16 @@ junoSD_PMT_v2::junoSD_PMT_v2(const std::string& name, int opticksMode)
     m_eph(EPH::UNSET), 
     m_label_id(-1),
     m_profile(new SProfile<16>),
+    m_profile_hist(nullptr),
 #endif
-    m_jpmt_opticks(new junoSD_PMT_v2_Opticks(this))
+    m_jpmt_opticks(new junoSD_PMT_v2_Opticks(this)),
+    m_hit_columns(nullptr),
+    m_hit_columns_materialize(false),
+    m_detect_bound(nullptr),
+    m_ce_table(nullptr),
+    m_ce_table_enabled(false),
+    m_muon_waves(nullptr),
+    m_muon_waves_materialize(false)
 {
     G4String HCname;
     collectionName.insert(HCname="hitCollection");
@@ -141,6 +159,10 @@ junoSD_PMT_v2::junoSD_PMT_v2(const std::string& name, int opticksMode)
 
     m_ce_func = 0;
     m_merge_count = 0 ; 
+
+#ifdef WITH_G4CXOPTICKS
+    setProfileHist( ssys::getenvbool("junoSD_PMT_v2__PROFILE_HIST") ); 
+#endif
 }
 
 junoSD_PMT_v2::~junoSD_PMT_v2()
@@ -148,9 +170,117 @@ junoSD_PMT_v2::~junoSD_PMT_v2()
     delete m_PMTEfficiency ;
     delete m_PMTEfficiencyTable ;
     delete m_jpmt_opticks ;
+    delete m_hit_columns ;
+    delete m_detect_bound ;
+    delete m_ce_table ;
+    delete m_muon_waves ;
+#ifdef WITH_G4CXOPTICKS
+    delete m_profile_hist ;
+#endif
 }
 
+/**
+junoSD_PMT_v2::setHitColumns
+------------------------------
+
+Switches normal hits (hit type 1) to the columnar store, see junoHit_PMT_Columns.h.
+The flags select the cold field groups stored in addition to the hot fields, 
+eg junoHit_PMT_Columns::HOT for pmtid/time/count/weight/energy only. 
+
+This is for a columnar consumer that reads getHitColumns, by default no 
+junoHit_PMT are created for the normal hits, which is where the time and 
+memory is saved : with only the HOT fields the columns take 28 bytes per hit. 
+When merging is enabled it is done on the columns using the merge flag and 
+time window of the PMTHitMerger, so the result is the same as its doMerge. 
+
+Consumers that need the hitCollection can use setHitColumnsMaterialize(true), 
+the hits are then handed at EndOfEvent to the PMTHitMerger saveHit as 
+SaveNormHit does, or inserted into hitCollection when there is no merger, 
+so consumers of the collection and later merges see no difference. 
+That is slower than creating the hit objects directly, see junoHit_PMT_ColumnsTest.cc 
+
+**/
+
+void junoSD_PMT_v2::setHitColumns(unsigned flags)
+{
+    delete m_hit_columns ; 
+    m_hit_columns = new junoHit_PMT_Columns(flags) ; 
+}
+
+
+
+/**
+junoSD_PMT_v2::setDetectBound
+-------------------------------
+
+Enables two stage acceptance of candidates in ProcessHits when using PMTSimParamSvc,
+see PMTDetectBound.h. The hits and random sequence are the same as without it, 
+only the QE and CE lookups of candidates culled by the per-PMT bound are skipped. 
 
+The bounds of all PMTs are set here, so call after setPMTSimParamSvc and setEnableOpticalModel. 
+The QE and CE maxima of each category are taken over the knots of the QE_shape and CE 
+tables that PMTSimParamSvc interpolates, loaded from $NP_PROP_BASE/PMTProperty as in JPMT.h.
+The energy domain is that of the QE_shape tables and theta extends to 180 degrees 
+as local_pos.theta() can exceed the 90 degrees of the CE tables.  
+Categories without a CE table (HZC) have CE 1. 
+
+**/
+
+void junoSD_PMT_v2::setDetectBound(bool enable)
+{
+    delete m_detect_bound ; 
+    m_detect_bound = nullptr ; 
+    if(!enable) return ; 
+    if(!m_PMTSimParsvc)
+    {
+        G4cout << "junoSD_PMT_v2::setDetectBound PMTSimParamSvc is required, set it before enabling the bound " << G4endl ; 
+        return ; 
+    }
+
+    typedef std::chrono::steady_clock Clock ;
+    Clock::time_point t0 = Clock::now() ; 
+
+    NPFold* prop = NPFold::LoadProp("PMTProperty") ; 
+    const int cats[] = { kPMT_Unknown, kPMT_NNVT, kPMT_Hamamatsu, kPMT_HZC, kPMT_NNVT_HighQE } ; 
+    const char* names[] = { "WP_PMT", "NNVTMCP", "R12860", "HZC_3inch", "NNVTMCP_HiQE" } ; 
+    std::map<int, double> qe_max ; 
+    std::map<int, double> ce_max ; 
+
+    for(int i=0 ; i < 5 ; i++)
+    {
+        int cat = cats[i] ; 
+        NPFold* f = prop ? prop->get_subfold(names[i]) : nullptr ; 
+        const NP* qe_shape = f ? f->get("QE_shape") : nullptr ; 
+        const NP* ce_table = f ? f->get("CE") : nullptr ; 
+
+        std::vector<double> energy ; 
+        std::vector<double> theta ; 
+        if(qe_shape) for(int j=0 ; j < qe_shape->shape[0] ; j++) energy.push_back( qe_shape->get<double>(j, 0) ) ; 
+        if(ce_table) for(int j=0 ; j < ce_table->shape[0] ; j++) theta.push_back( ce_table->get<double>(j, 0) ) ; 
+
+        PMTDetectBound::Func qe = [this, cat](double e){ return m_PMTSimParsvc->get_pmtcat_qe(cat, e) ; } ; 
+        PMTDetectBound::Func ce = [this, cat](double th){ return m_PMTSimParsvc->get_pmtcat_ce(cat, th) ; } ; 
+
+        // without knots no bound : 1 culls nothing  
+        qe_max[cat] = qe_shape ? PMTDetectBound::KnotMax(qe, energy, 1.55*CLHEP::eV, 15.5*CLHEP::eV ) : 1. ;  
+        ce_max[cat] = cat == kPMT_HZC ? 1. : ( ce_table ? PMTDetectBound::KnotMax(ce, theta, 0., CLHEP::pi ) : 1. ) ; 
+    }
+
+    m_detect_bound = new PMTDetectBound ; 
+    const std::vector<int>& pmtids = m_PMTSimParsvc->get_all_pmtID() ; 
+    for(size_t i=0 ; i < pmtids.size() ; i++)
+    {
+        int pmtID = pmtids[i] ; 
+        int cat = m_PMTSimParsvc->getPMTCategory(pmtID) ; 
+        if( qe_max.count(cat) == 0 ) continue ;   // left unbound 
+        double qe = (m_enable_optical_model && PMT::Is20inch(pmtID)) ? 1.0 : m_PMTSimParsvc->get_pmt_qe_scale(pmtID)*qe_max[cat] ; 
+        m_detect_bound->set( pmtID, qe*ce_max[cat] ) ; 
+    }
+    m_detect_bound->seconds_bound = std::chrono::duration<double>(Clock::now() - t0).count() ;
+    delete prop ; 
+
+    G4cout << "junoSD_PMT_v2::setDetectBound " << m_detect_bound->desc() << G4endl ; 
+}
 
 void junoSD_PMT_v2::Initialize(G4HCofThisEvent *HCE)
 {
@@ -161,6 +291,22 @@ void junoSD_PMT_v2::Initialize(G4HCofThisEvent *HCE)
     if (m_debug) {
         G4cout << "junoSD_PMT_v2::Initialize eventID " << m_eventID << G4endl;
     }
+
+    if (m_hit_columns) {
+        m_hit_columns->clear();
+    }
+
+    if (m_detect_bound) {
+        m_detect_bound->clear_counts();
+    }
+
+    if (m_muon_waves) {
+        m_muon_waves->clear();
+    }
+
+    if (m_ce_table_enabled && m_ce_table == nullptr) {
+        initCETable();   // after the CE mode and function are configured, not at the first hit  
+    }
     hitCollection = new junoHit_PMT_Collection(SensitiveDetectorName,collectionName[0]);
     hitCollection_muon = new junoHit_PMT_muon_Collection(SensitiveDetectorName,collectionName[1]);
 
@@ -375,8 +521,15 @@ G4bool junoSD_PMT_v2::ProcessHits(G4Step* step,G4TouchableHistory*)
     G4Track* track = step->GetTrack() ;    
     m_label_id = C4Track::GetLabelID(track); 
 
-    m_profile->zero(); 
-    m_profile->idx = m_label_id ; 
+    if(m_profile_hist)
+    {
+        m_profile_hist->zero(); 
+    }
+    else
+    {
+        m_profile->zero(); 
+        m_profile->idx = m_label_id ; 
+    }
 
     G4bool is_hit = ProcessHits_(step, nullptr) ; 
     m_jpmt_dbg->add( m_eph, is_hit ); 
@@ -386,7 +539,7 @@ G4bool junoSD_PMT_v2::ProcessHits(G4Step* step,G4TouchableHistory*)
 
     LOG_IF(LEVEL, (m_label_id % 1000) == 0) << " label " << C4Track::Desc(track)  << " m_eph " << EPH::Name(m_eph) ; 
 
-    m_profile->add(); 
+    if(m_profile_hist) m_profile_hist->add(); else m_profile->add(); 
     SEvt::AddProcessHitsStamp(1); 
     return is_hit ; 
 }
@@ -396,6 +549,55 @@ junoSD_PMT_v2_Debug* junoSD_PMT_v2::getProcessHitsDebug() const
     return m_jpmt_dbg ; 
 }
 
+/**
+junoSD_PMT_v2::setProfileHist
+-------------------------------
+
+Switches the ProcessHits profile from recording every call into SProfile<16>::RECORD,
+which grows with the number of calls, to the constant memory per-thread histograms 
+of SProfileHist<16> for the intervals between the stamps::
+
+    0 : start of ProcessHits_
+    1 : after edep, boundary and detection status checks
+    2 : after pmtid from the touchable (3,4 follow immediately)  
+    6 : after two stage bound, local position and QE/CE, before the DE cull
+    7 : after the merge attempt 
+    5 : after SaveNormHit/SaveMuonHit
+
+Intervals are only counted for calls that set both stamps, so "detect" only 
+counts photons reaching the QE/CE lookups and "save" only unmerged hits. 
+Each EndOfEvent publishes a snapshot of the histograms of this thread. The merged percentiles 
+of the snapshots of all threads are saved by junoSD_PMT_v2_Opticks::EndOfEvent_Debug 
+into junoSD_PMT_v2_SProfileHist.npy, cumulative over the run. With worker threads that 
+excludes the events other threads have in progress, the complete run summary is 
+SProfileHist<16>::Array() once the workers are joined and their SD deleted.
+
+Enabled from the ctor with envvar junoSD_PMT_v2__PROFILE_HIST. 
+Stamps 6 and 7 only go to the histograms, the SProfile<16>::RECORD layout 
+of junoSD_PMT_v2_SProfile.npy keeps stamps 0 to 5 as before. 
+
+**/
+
+void junoSD_PMT_v2::setProfileHist(bool enable)
+{
+    delete m_profile_hist ; 
+    m_profile_hist = nullptr ; 
+    if(!enable) return ; 
+
+    m_profile_hist = new SProfileHist<16> ; 
+    m_profile_hist->define(0, 1, "status") ; 
+    m_profile_hist->define(1, 2, "pmtid") ; 
+    m_profile_hist->define(4, 6, "detect") ; 
+    m_profile_hist->define(6, 7, "merge") ; 
+    m_profile_hist->define(7, 5, "save") ; 
+    m_profile_hist->define(0, -1, "total") ; 
+}
+
+inline void junoSD_PMT_v2::profile_stamp(int i)
+{
+    if(m_profile_hist) m_profile_hist->stamp(i) ; else if(i < 6) m_profile->stamp(i) ; 
+}
+
 
 #endif 
 
@@ -406,7 +608,7 @@ G4bool junoSD_PMT_v2::ProcessHits(G4Step * step,G4TouchableHistory*)
 #endif
 {
 #ifdef WITH_G4CXOPTICKS
-    m_profile->stamp(0); 
+    profile_stamp(0); 
 #endif
 
     if (m_disable) {
@@ -487,8 +689,6 @@ G4bool junoSD_PMT_v2::ProcessHits(G4Step * step,G4TouchableHistory*)
 
     const G4ThreeVector& global_pos = postStepPoint->GetPosition();
 
-    G4ThreeVector local_pos = trans.TransformPoint(global_pos);
-
     double qe = 1;
     double ce = 1;
     // == get the copy number -> pmt id
@@ -497,7 +697,7 @@ G4bool junoSD_PMT_v2::ProcessHits(G4Step * step,G4TouchableHistory*)
 
 
 #ifdef WITH_G4CXOPTICKS
-    m_profile->stamp(1); 
+    profile_stamp(1); 
 #endif
 
     const G4VTouchable* touch = track->GetTouchable();
@@ -506,7 +706,7 @@ G4bool junoSD_PMT_v2::ProcessHits(G4Step * step,G4TouchableHistory*)
     int pmtID = pmtID_1 ;  
 
 #ifdef WITH_G4CXOPTICKS
-    m_profile->stamp(2); 
+    profile_stamp(2); 
 #endif
 
 #ifdef WITH_G4CXOPTICKS
@@ -514,13 +714,13 @@ G4bool junoSD_PMT_v2::ProcessHits(G4Step * step,G4TouchableHistory*)
 #endif
 
 #ifdef WITH_G4CXOPTICKS
-    m_profile->stamp(3); 
+    profile_stamp(3); 
 #endif
 
     //int pmtID = get_pmtid(track);
 
 #ifdef WITH_G4CXOPTICKS
-    m_profile->stamp(4); 
+    profile_stamp(4); 
 #endif
 
     /**
@@ -565,6 +765,25 @@ G4bool junoSD_PMT_v2::ProcessHits(G4Step * step,G4TouchableHistory*)
     
 
 
+    // = two stage acceptance, see PMTDetectBound.h : the same uniform draw is compared 
+    //   first with the bound of the PMT and then, for survivors only, with the exact DE
+    double u = G4UniformRand() ; 
+    bool use_bound = m_detect_bound && m_use_pmtsimsvc ; 
+    if (use_bound) {
+        double t1 = m_detect_bound->now() ; 
+        bool pass = m_detect_bound->stage1(pmtID, u) ; 
+        m_detect_bound->add1(t1) ; 
+        if (!pass) {
+#ifdef WITH_G4CXOPTICKS
+            m_eph = EPH::NDECULL ;  
+#endif
+            return false;
+        }
+    }
+    double t2 = use_bound ? m_detect_bound->now() : 0. ; 
+
+    G4ThreeVector local_pos = trans.TransformPoint(global_pos);
+
     // = final DE = QE * CE, 
     // but QE is already applied (this is old implementation,
     // Now we use PMTSimParamSvc to get real QE and CE ), so only CE is important.
@@ -576,8 +795,7 @@ G4bool junoSD_PMT_v2::ProcessHits(G4Step * step,G4TouchableHistory*)
 
      }
      else{
-        std::string volname = track->GetVolume()->GetName();		
-	GetQEandCEByOldWay(qe , ce , pmtID,  volname, local_pos);
+	GetQEandCEByOldWay(qe , ce , pmtID,  track->GetVolume(), local_pos);
      }
 
 
@@ -587,7 +805,13 @@ G4bool junoSD_PMT_v2::ProcessHits(G4Step * step,G4TouchableHistory*)
     if (de>1.0){
         std::cout<<"junoSD_PMT_v2:: de is larger than 1.0"<<std::endl;
     }
-    bool de_cull = G4UniformRand() > de ; 
+    bool de_cull = use_bound ? !m_detect_bound->stage2(pmtID, u, de) : u > de ; 
+    if (use_bound) {
+        m_detect_bound->add2(t2) ; 
+    }
+#ifdef WITH_G4CXOPTICKS
+    profile_stamp(6); 
+#endif
 
 
 
@@ -633,17 +857,24 @@ G4bool junoSD_PMT_v2::ProcessHits(G4Step * step,G4TouchableHistory*)
     //   + the flags such as producerID, is from cerenkov, is from scintillation,
     //     is reemission, is original op will be not right
     // ========================================================================
-    // = check the merge flag first
-    if (m_pmthitmerger and m_pmthitmerger->getMergeFlag()) {
+    // = check the merge flag first, muon hits into the waveform store are not merged, see setMuonWaveforms
+    bool muon_waves = m_muon_waves && m_hit_type == 2 ; 
+    if (m_pmthitmerger and m_pmthitmerger->getMergeFlag() and not muon_waves) {
         // == if merged, just return true. That means just update the hit
         // NOTE: only the time and count will be update here, the others 
         //       will not filled.
-        bool ok = m_pmthitmerger->doMerge(pmtID, hittime);
+        bool ok = m_hit_columns && m_hit_type == 1 
+                ? 
+                    m_hit_columns->merge(pmtID, hittime, m_pmthitmerger->getTimeWindow()) 
+                :
+                    m_pmthitmerger->doMerge(pmtID, hittime)
+                ;
         if (ok) {
             m_merge_count += 1 ; 
 
 #ifdef WITH_G4CXOPTICKS
             m_eph = EPH::YMERGE ;  
+            profile_stamp(7); 
 #endif
             return true;
         }
@@ -651,6 +882,10 @@ G4bool junoSD_PMT_v2::ProcessHits(G4Step * step,G4TouchableHistory*)
 
 
 
+#ifdef WITH_G4CXOPTICKS
+    profile_stamp(7); 
+#endif
+
    // = save the hit in the collection
    
     if (m_hit_type == 1) { 
@@ -661,7 +896,7 @@ G4bool junoSD_PMT_v2::ProcessHits(G4Step * step,G4TouchableHistory*)
 
 
 #ifdef WITH_G4CXOPTICKS
-    m_profile->stamp(5); 
+    profile_stamp(5); 
 #endif
 
     return true;  
@@ -735,6 +970,7 @@ int junoSD_PMT_v2::get_pmtid(G4Track* track) {
 // == change the Collection Efficiency Mode
 void junoSD_PMT_v2::setCEMode(const std::string& mode) {
     m_ce_mode = mode;
+    resetCETable();
 }
 
 /**
@@ -978,7 +1214,7 @@ note: when you use --no-use-pmtsimsvc, you must add --disable-pmt-optical-model
 
 */
 
-bool junoSD_PMT_v2::GetQEandCEByOldWay(double & qe , double & ce , int pmtID,std::string volname, G4ThreeVector local_pos){
+bool junoSD_PMT_v2::GetQEandCEByOldWay(double & qe , double & ce , int pmtID, const G4VPhysicalVolume* pv, G4ThreeVector local_pos){
     
     // calculate QE from PDE from svc
    // double qe =1.;
@@ -1008,7 +1244,11 @@ bool junoSD_PMT_v2::GetQEandCEByOldWay(double & qe , double & ce , int pmtID,std
         pmt_type = m_PMTParamsvc->isHamamatsu(pmtID) ;
         qe_type = m_PMTParamsvc->isHighQENNVT(pmtID) ;
     }
-    ce = get_ce(volname, local_pos, pmt_type, qe_type, ce_cat );          
+    if (m_ce_table) {
+        ce = get_ce_table(pv, local_pos.theta(), pmt_type, qe_type, ce_cat );
+    } else {
+        ce = get_ce(pv->GetName(), local_pos, pmt_type, qe_type, ce_cat );          
+    }
 
 
     return true ;                                               
@@ -1061,6 +1301,18 @@ void junoSD_PMT_v2::SaveNormHit(int pmtID, G4ThreeVector local_pos, G4ThreeVecto
 
 
 
+    if (m_hit_columns) {
+        size_t idx = m_hit_columns->add(pmtID, hittime, 1.0, edep, 
+                                        local_pos, local_dir, local_pol, 
+                                        global_pos, track->GetMomentum(), track->GetPolarization(), 
+                                        producerID, is_from_cerenkov, is_reemission, is_original_op, 
+                                        t_start, boundary_pos ); 
+        if (m_pmthitmerger and m_pmthitmerger->getMergeFlag()) {
+            m_hit_columns->index(pmtID, idx);
+        }
+        return ; 
+    }
+
     junoHit_PMT* hit_photon = new junoHit_PMT();
     hit_photon->SetPMTID(pmtID);
     hit_photon->SetWeight(1.0);
@@ -1110,6 +1362,11 @@ void junoSD_PMT_v2::SaveMuonHit(int pmtID, G4ThreeVector local_pos,double hittim
              
     // save the muon only
  
+    if (m_muon_waves) {
+        m_muon_waves->add(pmtID, hittime, local_pos.theta(), local_pos.phi());
+        return ;
+    }
+
     junoHit_PMT_muon* hit_photon = new junoHit_PMT_muon();
     hit_photon->SetPMTID(pmtID);
     hit_photon->SetTime(hittime);
@@ -1123,6 +1380,66 @@ void junoSD_PMT_v2::SaveMuonHit(int pmtID, G4ThreeVector local_pos,double hittim
 }
 
                      
+/**
+junoSD_PMT_v2::setMuonWaveforms
+---------------------------------
+
+Switches muon hits (hit type 2) from a junoHit_PMT_muon per photon, optionally merged, 
+to per-PMT histograms of the hit times with *bin* ns resolution, see PMTWaveformStore.h. 
+The earliest hit time of each PMT is kept exactly with the theta and phi of that hit.
+A bin of zero or less disables. Hits later than num_bin bins are only counted as overflow, 
+the dense bins of each PMT span at most max_span bins with sparse bins for hits beyond that, 
+so late outliers do not allocate the bins in between. 
+
+The compact form is exported per event with PMTWaveformStore::waves, bins and farbins. 
+For debugging with Opticks they are saved as junoSD_PMT_v2_MuonWaves.npy, 
+junoSD_PMT_v2_MuonWaveBins.npy and junoSD_PMT_v2_MuonWaveFarBins.npy 
+when envvar junoSD_PMT_v2__SaveMuonWaves is set. 
+
+By default nothing is added to hitCollection_muon, consumers use getMuonWaveforms directly. 
+With setMuonWaveformsMaterialize(true) it is materialized at EndOfEvent with one hit 
+per non-empty bin, so existing consumers see hits merged on the fixed bins. 
+PMTWaveformStoreTest measures the store at about 17x less memory than a hit object 
+per photon for a muon-like event, materializing allocates a hit object per bin 
+again and gives up most of that, so only use it for consumers not yet reading 
+the waveforms. 
+
+**/
+
+void junoSD_PMT_v2::setMuonWaveforms(double bin, unsigned num_bin, unsigned max_span)
+{
+    delete m_muon_waves ; 
+    m_muon_waves = bin > 0. ? new PMTWaveformStore(bin, num_bin, max_span) : nullptr ; 
+}
+
+/**
+junoSD_PMT_v2::materializeMuonWaveforms
+-----------------------------------------
+
+Creates a junoHit_PMT_muon for each non-empty bin with the bin count, the time of the 
+lower bin edge, or the exact first time for the bin of the earliest hit, and the 
+theta and phi of the earliest hit of the PMT. 
+
+**/
+
+size_t junoSD_PMT_v2::materializeMuonWaveforms()
+{
+    size_t num = 0 ; 
+    m_muon_waves->visit( [this, &num](const PMTWaveformStore::Wave& w, double time, unsigned count)
+        {
+            junoHit_PMT_muon* hit = new junoHit_PMT_muon();
+            hit->SetPMTID(w.pmtid);
+            hit->SetTime(time);
+            hit->SetCount(count);
+            hit->SetTheta(w.theta);
+            hit->SetPhi(w.phi);
+            hitCollection_muon->insert(hit);
+            num += 1 ; 
+        }); 
+    return num ; 
+}
+
+                     
 void
 junoSD_PMT_v2::setCEFunc(const std::string& func, const std::vector<double>& param)
 {
@@ -1144,6 +1461,139 @@ junoSD_PMT_v2::setCEFunc(const std::string& func, const std::vector<double>& par
         m_ce_func->SetParameter(i, param[i]);
     }
     std::cout << std::endl;
+    resetCETable();
+}
+
+/**
+junoSD_PMT_v2::setCETable
+---------------------------
+
+When enabled the collection efficiency of the old way (--no-use-pmtsimsvc) 
+is looked up from dense tables (see CETable.h) with integer dispatch 
+instead of the string comparisons of the CE mode and volume name and the 
+spline or TF1 evaluation of get_ce. 
+
+The tables are built by Initialize at the start of the first event after the 
+CE mode and function are configured (setCEMode and setCEFunc reset them), 
+so the sampling is not charged to ProcessHits. They sample get_ce itself 
+at 0.1 degree steps over 0 to 180 degrees. 
+So all code paths of get_ce are reproduced, including the quirk that 
+volname PMT_20inch_body_phys with pmt_type true (ce_cat 2) uses the NNVT 
+spline as the hamamatsu s_di is shadowed within its block.  
+The maximum deviation of the tables from get_ce is reported when built.
+
+**/
+
+void junoSD_PMT_v2::setCETable(bool enable)
+{
+    m_ce_table_enabled = enable ; 
+    resetCETable(); 
+}
+
+void junoSD_PMT_v2::resetCETable()
+{
+    delete m_ce_table ; 
+    m_ce_table = nullptr ; 
+    m_ce_table_curve.clear(); 
+    m_ce_table_cat.clear(); 
+}
+
+const char* junoSD_PMT_v2::CE_VOLNAME[NUM_CE_VOLNAME] = {
+    "PMT_20inch_body_phys",
+    "HamamatsuR12860_PMT_20inch_body_phys",
+    "NNVTMCPPMT_PMT_20inch_body_phys",
+    "R12860TorusPMTManager_body_phys",
+    "MCP20inchPMTManager_body_phys",
+    "Ham8inchPMTManager_body_phys",
+    "MCP8inchPMTManager_body_phys",
+    "HZC9inchPMTManager_body_phys",
+    "other"
+};
+
+/**
+junoSD_PMT_v2::initCETable
+----------------------------
+
+For every (volname, pmt_type, qe_type) combination the code path of get_ce 
+is identified by its ce_cat, each distinct ce_cat is sampled into one curve. 
+Returns false leaving the string dispatched get_ce in use when the CE mode 
+is unknown or the 20inchfunc function is not defined.   
+
+**/
+
+bool junoSD_PMT_v2::initCETable()
+{
+    bool known_mode = m_ce_mode == "None" || m_ce_mode == "20inch" || m_ce_mode == "20inchflat" || m_ce_mode == "flat" || m_ce_mode == "20inchfunc" ; 
+    bool func_ok = m_ce_mode != "20inchfunc" || m_ce_func != 0 ; 
+    if (!known_mode || !func_ok) {
+        G4cout << "junoSD_PMT_v2::initCETable not using CE tables for ce_mode " << m_ce_mode << G4endl;
+        m_ce_table_enabled = false ; 
+        return false ; 
+    }
+
+    m_ce_table = new CETable(0., CLHEP::pi, 1801) ; 
+    m_ce_table_curve.assign(4*NUM_CE_VOLNAME, -1) ; 
+    m_ce_table_cat.assign(4*NUM_CE_VOLNAME, 0) ; 
+    std::map<int, int> cat2curve ; 
+
+    for (int kind = 0; kind < NUM_CE_VOLNAME; ++kind) {
+        for (int k = 0; k < 4; ++k) {
+            std::string volname = CE_VOLNAME[kind] ; 
+            bool pmt_type = (k & 2) != 0 ; 
+            bool qe_type  = (k & 1) != 0 ; 
+            int ce_cat = 0 ; 
+            get_ce(volname, G4ThreeVector(0., 0., 1.), pmt_type, qe_type, ce_cat ); 
+
+            if (cat2curve.count(ce_cat) == 0) {
+                std::stringstream ss ; 
+                ss << "ce_cat " << ce_cat << " " << volname ; 
+                std::string label = ss.str(); 
+                CETable::Func f = [this, volname, pmt_type, qe_type](double theta) {
+                    G4ThreeVector localpos ; 
+                    localpos.setRThetaPhi(1., theta, 0.); 
+                    int cat = 0 ; 
+                    return get_ce(volname, localpos, pmt_type, qe_type, cat ); 
+                } ; 
+                cat2curve[ce_cat] = m_ce_table->add(f, label.c_str()); 
+            }
+            m_ce_table_curve[4*kind+k] = cat2curve[ce_cat] ; 
+            m_ce_table_cat[4*kind+k] = ce_cat ; 
+        }
+    }
+    G4cout << "junoSD_PMT_v2::initCETable ce_mode " << m_ce_mode << " " << m_ce_table->desc() << G4endl;
+    return true ; 
+}
+
+/**
+junoSD_PMT_v2::get_ce_volname_kind
+------------------------------------
+
+Index into CE_VOLNAME, cached by physical volume so the names are only compared once. 
+
+**/
+
+int junoSD_PMT_v2::get_ce_volname_kind(const G4VPhysicalVolume* pv)
+{
+    std::unordered_map<const G4VPhysicalVolume*, int>::const_iterator it = m_ce_volname_kind.find(pv) ; 
+    if (it != m_ce_volname_kind.end()) return it->second ; 
+
+    const std::string& volname = pv->GetName() ; 
+    int kind = NUM_CE_VOLNAME - 1 ; 
+    for (int i = 0; i < NUM_CE_VOLNAME - 1; ++i) {
+        if (volname == CE_VOLNAME[i]) {
+            kind = i ; 
+            break ; 
+        }
+    }
+    m_ce_volname_kind[pv] = kind ; 
+    return kind ; 
+}
+
+double junoSD_PMT_v2::get_ce_table(const G4VPhysicalVolume* pv, double theta, bool pmt_type, bool qe_type, int& ce_cat)
+{
+    int key = 4*get_ce_volname_kind(pv) + 2*int(pmt_type) + int(qe_type) ; 
+    ce_cat = m_ce_table_cat[key] ; 
+    return m_ce_table->get( m_ce_table_curve[key], theta ) ; 
 }
 
 
@@ -1244,10 +1694,37 @@ PMTEfficiencyTable* junoSD_PMT_v2::getPMTEfficiencyTable() const
 
 void junoSD_PMT_v2::EndOfEvent(G4HCofThisEvent* HCE)
 {
+    if (m_hit_columns && m_hit_columns_materialize) {
+        // through the merger as SaveNormHit, so later hits such as those from the GPU merge with them 
+        if (m_pmthitmerger) {
+            m_hit_columns->saveHits(m_pmthitmerger);
+        } else {
+            m_hit_columns->materialize(hitCollection);
+        }
+    }
+    if (m_muon_waves && m_muon_waves_materialize) {
+        materializeMuonWaveforms();
+    }
 #ifdef WITH_G4CXOPTICKS
+    if (m_muon_waves && ssys::getenvbool("junoSD_PMT_v2__SaveMuonWaves")) {
+        SEvt::SaveExtra("junoSD_PMT_v2_MuonWaves.npy", m_muon_waves->waves() ); 
+        SEvt::SaveExtra("junoSD_PMT_v2_MuonWaveBins.npy", m_muon_waves->bins() ); 
+        SEvt::SaveExtra("junoSD_PMT_v2_MuonWaveFarBins.npy", m_muon_waves->farbins() ); 
+    }
+#endif
+#ifdef WITH_G4CXOPTICKS
+    if (m_profile_hist) {
+        m_profile_hist->publish();   // snapshot for the merge in junoSD_PMT_v2_Opticks::EndOfEvent_Debug 
+    }
     m_jpmt_opticks->EndOfEvent(HCE, m_eventID );    
 #endif
     G4cout << "junoSD_PMT_v2::EndOfEvent" << desc() << G4endl ; 
+    if (m_detect_bound) {
+        G4cout << "junoSD_PMT_v2::EndOfEvent " << m_detect_bound->desc() << G4endl ; 
+    }
+    if (m_muon_waves) {
+        G4cout << "junoSD_PMT_v2::EndOfEvent " << m_muon_waves->desc() << G4endl ; 
+    }
 }
 
 bool junoSD_PMT_v2::gpu_simulation() const { return m_jpmt_opticks->gpu_simulation() ;  }
@@ -1261,6 +1738,7 @@ std::string junoSD_PMT_v2::desc() const
        << " hcMuon " << hitCollection_muon->entries()  
        << " hcOpticks " << (hitCollection_opticks?hitCollection_opticks->entries():-1)
        << " GPU " << ( gpu_simulation() ? "YES" : "NO" )
+       << " columns " << ( m_hit_columns ? m_hit_columns->desc() : "NO" )
        ;
     std::string str = ss.str(); 
     return str ; 
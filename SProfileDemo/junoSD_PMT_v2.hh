@@ -18,6 +18,7 @@
 #include "IToolForSD_PMT.h"
 #include "PMTHitMerger.hh"
 #include <map>
+#include <unordered_map>
 #include <vector>
 #include <string>
 #include <TF1.h>
@@ -35,6 +36,11 @@ class PMTEfficiency ;
 class PMTEfficiencyTable ; 
 
 class junoSD_PMT_v2_Opticks ; 
+struct junoHit_PMT_Columns ; 
+struct PMTDetectBound ; 
+struct CETable ; 
+struct PMTWaveformStore ; 
+class G4VPhysicalVolume ; 
 
 #ifdef WITH_G4CXOPTICKS
 #include <string>
@@ -43,6 +49,7 @@ class junoSD_PMT_v2_Opticks ;
 #include "plog/Severity.h"
 struct junoSD_PMT_v2_Debug ;
 template<int N> struct SProfile ; 
+template<int N> struct SProfileHist ; 
 #endif
 
 
@@ -72,6 +79,7 @@ class junoSD_PMT_v2 : public G4VSensitiveDetector, public IToolForSD_PMT
         void setCEFlatValue(double v) {m_ce_flat_value = v;}
         void setMergeFlag(bool f) { m_merge_flag = f; }
         void setMergeWindows(double t) { m_time_window = t; }
+        double getMergeWindows() const { return m_time_window; }
         void setMerger(PMTHitMerger* phm) { m_pmthitmerger=phm; }
         void setMergerOpticks(PMTHitMerger* phm) { m_pmthitmerger_opticks=phm; }
         void setPMTParamSvc(PMTParamSvc* para){ m_PMTParamsvc=para; }
@@ -97,7 +105,7 @@ class junoSD_PMT_v2 : public G4VSensitiveDetector, public IToolForSD_PMT
         int get_pmtid(G4Track*);
         double get_ce(const std::string& volname, const G4ThreeVector& localpos, bool pmt_type, bool qe_type, int& ce_cat);
 
-        bool GetQEandCEByOldWay(double & qe , double & ce , int pmtID, std::string volname, G4ThreeVector local_pos);
+        bool GetQEandCEByOldWay(double & qe , double & ce , int pmtID, const G4VPhysicalVolume* pv, G4ThreeVector local_pos);
 	
         void SaveNormHit(int pmtID, G4ThreeVector local_pos, G4ThreeVector global_pos,double hittime , G4Track *  track ,double edep);
 	
@@ -180,8 +188,48 @@ class junoSD_PMT_v2 : public G4VSensitiveDetector, public IToolForSD_PMT
         int                  m_eph  ;  // ProcessHits enumeration
         int                  m_label_id ;  // photon label  
         SProfile<16>*        m_profile ; 
+        SProfileHist<16>*    m_profile_hist ;  // nullptr : profiles recorded into SProfile<16>::RECORD
+        void                 profile_stamp(int i); 
+    public:
+        void                 setProfileHist(bool enable); 
+    private:
 #endif
         junoSD_PMT_v2_Opticks* m_jpmt_opticks ; 
+        junoHit_PMT_Columns*   m_hit_columns ;               // nullptr : hit objects mode  
+        bool                   m_hit_columns_materialize ;   // default false : materialize into hitCollection at EndOfEvent 
+    public:
+        void                 setHitColumns(unsigned flags); 
+        void                 setHitColumnsMaterialize(bool f){ m_hit_columns_materialize = f ; } 
+        junoHit_PMT_Columns* getHitColumns() const { return m_hit_columns ; }
+    private:
+        PMTDetectBound*        m_detect_bound ;              // nullptr : single stage acceptance
+    public:
+        void                 setDetectBound(bool enable); 
+        PMTDetectBound*      getDetectBound() const { return m_detect_bound ; }
+    private:
+        enum { NUM_CE_VOLNAME = 9 } ; 
+        static const char*     CE_VOLNAME[NUM_CE_VOLNAME] ;  // volnames distinguished by get_ce, the last is any other 
+        CETable*               m_ce_table ;                  // nullptr : string dispatched get_ce 
+        bool                   m_ce_table_enabled ; 
+        std::vector<int>       m_ce_table_curve ;            // (volname kind, pmt_type, qe_type) -> curve
+        std::vector<int>       m_ce_table_cat ;              // (volname kind, pmt_type, qe_type) -> ce_cat
+        std::unordered_map<const G4VPhysicalVolume*, int> m_ce_volname_kind ; 
+
+        bool                 initCETable(); 
+        void                 resetCETable(); 
+        int                  get_ce_volname_kind(const G4VPhysicalVolume* pv); 
+        double               get_ce_table(const G4VPhysicalVolume* pv, double theta, bool pmt_type, bool qe_type, int& ce_cat); 
+    public:
+        void                 setCETable(bool enable); 
+        CETable*             getCETable() const { return m_ce_table ; }
+    private:
+        PMTWaveformStore*      m_muon_waves ;                // nullptr : junoHit_PMT_muon per photon 
+        bool                   m_muon_waves_materialize ;    // default false, true : materialize into hitCollection_muon at EndOfEvent
+        size_t               materializeMuonWaveforms(); 
+    public:
+        void                 setMuonWaveforms(double bin, unsigned num_bin=1000000, unsigned max_span=4096); 
+        void                 setMuonWaveformsMaterialize(bool f){ m_muon_waves_materialize = f ; } 
+        PMTWaveformStore*    getMuonWaveforms() const { return m_muon_waves ; }
     public:
         double              getQuantumEfficiency(int pmtID) const ;
         double              getCollectionEfficiency(double theta, int pmtID) const ;  
@@ -1,7 +1,10 @@
 
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
+#include <functional>
 #include <iomanip>
+#include <memory>
 #include <sstream>
 
 #include "junoSD_PMT_v2.hh"
@@ -18,6 +21,7 @@ using CLHEP::MeV ;
 
 #include "junoHit_PMT.hh"
 #include "PMTHitMerger.hh"
+#include "PMTHitBulk.h"
 
 
 #ifdef WITH_G4CXOPTICKS
@@ -33,6 +37,7 @@ using CLHEP::MeV ;
 #include "U4HitGet.h"
 #include "U4Recorder.hh"
 #include "SProfile.h"
+#include "SProfileHist.h"
 #include "NP.hh"
 
 const plog::Severity junoSD_PMT_v2_Opticks::LEVEL = SLOG::EnvLevel("junoSD_PMT_v2_Opticks", "DEBUG") ; 
@@ -214,6 +219,12 @@ void junoSD_PMT_v2_Opticks::EndOfEvent_Debug(int eventID )
     SEvt::SaveExtra( "junoSD_PMT_v2_SProfile.npy", SProfile<16>::Array() ); 
     SProfile<16>::Clear(); 
 
+    if( SProfileHist<16>::Enabled() )  // junoSD_PMT_v2::setProfileHist, merges the published snapshots of all threads, cumulative over the run 
+    {
+        SEvt::SaveExtra( "junoSD_PMT_v2_SProfileHist.npy", SProfileHist<16>::Array() ); 
+        LOG(LEVEL) << SProfileHist<16>::Desc() ; 
+    }
+
 #ifdef WITH_G4CXOPTICKS_DEBUG
     U4Debug::Save(eventID);   
 
@@ -257,11 +268,21 @@ void junoSD_PMT_v2_Opticks::EndOfEvent_Simulate(int eventID )
     U4Hit hit ;
     U4HitExtra hit_extra ;
     U4HitExtra* hit_extra_ptr = way_enabled ? &hit_extra : nullptr ;
-    for(int idx=0 ; idx < int(num_hit) ; idx++)
+    int bulk_threads = ssys::getenvint("junoSD_PMT_v2_Opticks__BULK", 0) ; 
+
+    if( bulk_threads > 0 && hit_extra_ptr == nullptr )
+    {
+        CollectHitsBulk(m_pmthitmerger_opticks, num_hit, bulk_threads, merged_count, savehit_count, 
+             [this](const U4Hit* h){ return convertHit(h, nullptr) ; }, LEVEL ); 
+    }
+    else
     {
-        U4HitGet::FromEvt(hit, idx);   
-        collectHit(&hit, hit_extra_ptr, merged_count, savehit_count );
-        if(idx < 20 && LEVEL == info) ss << descHit(idx, &hit, hit_extra_ptr ) << std::endl ;
+        for(int idx=0 ; idx < int(num_hit) ; idx++)
+        {
+            U4HitGet::FromEvt(hit, idx);   
+            collectHit(&hit, hit_extra_ptr, merged_count, savehit_count );
+            if(idx < 20 && LEVEL == info) ss << descHit(idx, &hit, hit_extra_ptr ) << std::endl ;
+        }
     }
 
     LOG_IF(LEVEL, LEVEL == info) << std::endl << ss.str() ;   
@@ -345,6 +366,58 @@ void junoSD_PMT_v2_Opticks::collectHit(const U4Hit* hit, const U4HitExtra* hit_e
 }
 
 
+/**
+CollectHitsBulk
+-----------------
+
+Alternative to the per-hit collectHit loop enabled with envvar junoSD_PMT_v2_Opticks__BULK 
+set to the number of threads. See PMTHitBulk.h : the hit array is decoded with U4HitGet::FromEvt 
+and merged per PMT in parallel, the junoHit_PMT are then created with *convert* 
+(junoSD_PMT_v2_Opticks::convertHit) and handed to the merger with saveHit serially on 
+the calling thread in the same order as collectHit would, so the hit collection is unchanged.  
+
+Merging uses the merge flag and time window of the *merger* among the GPU hits only, 
+as does collectHit when the opticks collection holds no CPU hits (opticksMode 1 and 3).
+Only used without U4HitExtra. 
+
+A file static helper rather than a method so junoSD_PMT_v2_Opticks.hh is unchanged. 
+The PMTHitBulk and its retained buffers are thread_local, the SD of each worker 
+thread has its own, created at first use and deleted at thread exit. 
+
+**/
+
+static void CollectHitsBulk(PMTHitMerger* merger, unsigned num_hit, int num_threads, int& merged_count, int& savehit_count, 
+     std::function<junoHit_PMT*(const U4Hit*)> convert, plog::Severity level ) // static
+{
+    assert( merger ); 
+    typedef PMTHitBulk<U4Hit, junoHit_PMT> Bulk ; 
+    static thread_local std::unique_ptr<Bulk> hit_bulk ; 
+    if( !hit_bulk || int(hit_bulk->num_threads) != num_threads ) hit_bulk.reset( new Bulk(num_threads) ) ; 
+
+    Bulk* bulk = hit_bulk.get() ; 
+    bulk->merge = merger->getMergeFlag() ; 
+    bulk->time_window = merger->getTimeWindow() ; 
+
+    size_t num_saved = bulk->run( num_hit, 
+        [](U4Hit& h, size_t idx){ U4HitGet::FromEvt(h, idx) ; }, 
+        [](const U4Hit& h){ return int(h.sensor_identifier) ; }, 
+        [](const U4Hit& h){ return double(h.time) ; }, 
+        [&convert](const U4Hit& h, int count, double time)
+            {
+                junoHit_PMT* hit_photon = convert(&h); 
+                hit_photon->SetCount(count); 
+                hit_photon->SetTime(time); 
+                return hit_photon ; 
+            }, 
+        [merger](junoHit_PMT* hit_photon){ merger->saveHit(hit_photon) ; } 
+        ); 
+
+    savehit_count += int(num_saved) ; 
+    merged_count += int(num_hit - num_saved) ; 
+    LOG(level) << bulk->desc() ; 
+}
+
+
 /**
 junoSD_PMT_v2_Opticks::convertHit
 ----------------------------------